@@ -343,11 +343,22 @@ void cliprdr_process_format_data_response(cliprdrPlugin* cliprdr, STREAM* s, uin
 	cb_event = (RDP_CB_DATA_RESPONSE_EVENT*) freerdp_event_new(RDP_EVENT_CLASS_CLIPRDR,
 		RDP_EVENT_TYPE_CB_DATA_RESPONSE, NULL, NULL);
 
+	if (dataLen > (uint32) stream_get_left(s))
+	{
+		DEBUG_WARN("dataLen %d exceeds the PDU", dataLen);
+		dataLen = stream_get_left(s);
+	}
+
 	if (dataLen > 0)
 	{
+		/**
+		 * Clipboard data can be very large, so the received buffer is handed
+		 * over instead of copied. Only the PDU header in front is dropped.
+		 */
 		cb_event->size = dataLen;
-		cb_event->data = (uint8*) xmalloc(dataLen);
-		memcpy(cb_event->data, stream_get_tail(s), dataLen);
+		cb_event->data = stream_get_head(s);
+		memmove(cb_event->data, stream_get_tail(s), dataLen);
+		stream_detach(s);
 	}
 
 	svc_plugin_send_event((rdpSvcPlugin*) cliprdr, (RDP_EVENT*) cb_event);
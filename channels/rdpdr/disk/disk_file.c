@@ -19,6 +19,7 @@
  */
 
 #ifndef _WIN32
+#define _GNU_SOURCE
 #define __USE_LARGEFILE64
 #define _LARGEFILE_SOURCE
 #define _LARGEFILE64_SOURCE
@@ -299,6 +300,72 @@ DISK_FILE* disk_file_new(const char* base_path, const char* path, uint32 id,
 	return file;
 }
 
+static void disk_file_free_entries(DISK_FILE* file)
+{
+	int i;
+
+	for (i = 0; i < file->num_entries; i++)
+		xfree(file->entries[i].name);
+
+	xfree(file->entries);
+	file->entries = NULL;
+	file->num_entries = 0;
+	file->entry_index = 0;
+}
+
+/**
+ * Reads the whole directory at once, the matching entries are stat'ed and
+ * converted to UTF-16 here instead of once per directory control request.
+ */
+static void disk_file_snapshot_dir(DISK_FILE* file)
+{
+	struct dirent* ent;
+	char* ent_path;
+	DISK_DIR_ENTRY* entry;
+	UNICONV* uniconv;
+	int max_entries;
+	int fullpath_len;
+
+	disk_file_free_entries(file);
+
+	fullpath_len = strlen(file->fullpath);
+	ent_path = NULL;
+	max_entries = 0;
+
+	uniconv = freerdp_uniconv_new();
+	rewinddir(file->dir);
+
+	while ((ent = readdir(file->dir)) != NULL)
+	{
+		if (file->pattern && !disk_file_wildcard_match(file->pattern, ent->d_name))
+			continue;
+
+		if (file->num_entries >= max_entries)
+		{
+			max_entries = (max_entries > 0) ? max_entries * 2 : 64;
+			file->entries = (DISK_DIR_ENTRY*) xrealloc(file->entries, sizeof(DISK_DIR_ENTRY) * max_entries);
+		}
+
+		entry = &file->entries[file->num_entries++];
+
+		ent_path = (char*) xrealloc(ent_path, fullpath_len + strlen(ent->d_name) + 2);
+		sprintf(ent_path, "%s/%s", file->fullpath, ent->d_name);
+
+		memset(&entry->st, 0, sizeof(struct STAT));
+		if (STAT(ent_path, &entry->st) != 0)
+		{
+			DEBUG_WARN("stat %s failed. errno = %d", ent_path, errno);
+		}
+
+		DEBUG_SVC("  pattern %s matched %s", file->pattern, ent_path);
+
+		entry->name = freerdp_uniconv_out(uniconv, ent->d_name, &entry->length);
+	}
+
+	freerdp_uniconv_free(uniconv);
+	xfree(ent_path);
+}
+
 void disk_file_free(DISK_FILE* file)
 {
 	if (file->fd != -1)
@@ -314,53 +381,82 @@ void disk_file_free(DISK_FILE* file)
 			unlink(file->fullpath);
 	}
 
+	disk_file_free_entries(file);
 	xfree(file->pattern);
 	xfree(file->fullpath);
 	xfree(file);
 }
 
-boolean disk_file_seek(DISK_FILE* file, uint64 Offset)
+static void disk_file_track_access(DISK_FILE* file, uint64 Offset, uint32 Length)
 {
-	if (file->is_dir || file->fd == -1)
-		return false;
-
-	if (LSEEK(file->fd, Offset, SEEK_SET) == (off_t)-1)
-		return false;
+	if (Offset == file->next_offset)
+	{
+		file->sequential++;
+	}
+	else
+	{
+		file->sequential = 0;
+		file->flush_offset = Offset;
+	}
 
-	return true;
+	file->next_offset = Offset + Length;
 }
 
-boolean disk_file_read(DISK_FILE* file, uint8* buffer, uint32* Length)
+boolean disk_file_read(DISK_FILE* file, uint8* buffer, uint32* Length, uint64 Offset)
 {
 	ssize_t r;
 
 	if (file->is_dir || file->fd == -1)
 		return false;
 
-	r = read(file->fd, buffer, *Length);
+	r = PREAD(file->fd, buffer, *Length, Offset);
 	if (r < 0)
 		return false;
 	*Length = (uint32)r;
 
+	disk_file_track_access(file, Offset, *Length);
+
+#ifdef FADVISE
+	/* let the kernel fetch what the next requests will ask for */
+	if (file->sequential == DISK_FILE_SEQUENTIAL)
+		FADVISE(file->fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+	if (file->sequential >= DISK_FILE_SEQUENTIAL && *Length > 0)
+		FADVISE(file->fd, file->next_offset, DISK_FILE_READ_AHEAD, POSIX_FADV_WILLNEED);
+#endif
+
 	return true;
 }
 
-boolean disk_file_write(DISK_FILE* file, uint8* buffer, uint32 Length)
+boolean disk_file_write(DISK_FILE* file, uint8* buffer, uint32 Length, uint64 Offset)
 {
 	ssize_t r;
+	uint32 written = 0;
 
 	if (file->is_dir || file->fd == -1)
 		return false;
 
-	while (Length > 0)
+	while (written < Length)
 	{
-		r = write(file->fd, buffer, Length);
+		r = PWRITE(file->fd, buffer + written, Length - written, Offset + written);
 		if (r == -1)
 			return false;
-		Length -= r;
-		buffer += r;
+		written += r;
 	}
 
+	disk_file_track_access(file, Offset, Length);
+
+#ifdef SYNC_FILE_RANGE_WRITE
+	/* start writing back sequential data early instead of all of it on close */
+	if (file->sequential >= DISK_FILE_SEQUENTIAL &&
+		file->next_offset - file->flush_offset >= DISK_FILE_WRITE_BEHIND)
+	{
+		sync_file_range(file->fd, file->flush_offset, file->next_offset - file->flush_offset,
+			SYNC_FILE_RANGE_WRITE);
+		file->flush_offset = file->next_offset;
+	}
+#endif
+
 	return true;
 }
 
@@ -514,10 +610,9 @@ boolean disk_file_set_information(DISK_FILE* file, uint32 FsInformationClass, ui
 boolean disk_file_query_directory(DISK_FILE* file, uint32 FsInformationClass, uint8 InitialQuery,
 	const char* path, STREAM* output)
 {
-	struct dirent* ent;
+	DISK_DIR_ENTRY* entry;
 	char* ent_path;
 	struct STAT st;
-	UNICONV* uniconv;
 	size_t len;
 	boolean ret;
 
@@ -532,33 +627,21 @@ boolean disk_file_query_directory(DISK_FILE* file, uint32 FsInformationClass, ui
 
 	if (InitialQuery != 0)
 	{
-		rewinddir(file->dir);
 		xfree(file->pattern);
 
 		if (path[0])
 			file->pattern = strdup(strrchr(path, '\\') + 1);
 		else
 			file->pattern = NULL;
-	}
 
-	if (file->pattern)
-	{
-		do
-		{
-			ent = readdir(file->dir);
-			if (ent == NULL)
-				continue;
-
-			if (disk_file_wildcard_match(file->pattern, ent->d_name))
-				break;
-		} while (ent);
+		disk_file_snapshot_dir(file);
 	}
-	else
+	else if (file->entries == NULL)
 	{
-		ent = readdir(file->dir);
+		disk_file_snapshot_dir(file);
 	}
 
-	if (ent == NULL)
+	if (file->entry_index >= file->num_entries)
 	{
 		DEBUG_SVC("  pattern %s not found.", file->pattern);
 		stream_write_uint32(output, 0); /* Length */
@@ -566,20 +649,10 @@ boolean disk_file_query_directory(DISK_FILE* file, uint32 FsInformationClass, ui
 		return false;
 	}
 
-	memset(&st, 0, sizeof(struct STAT));
-	ent_path = xmalloc(strlen(file->fullpath) + strlen(ent->d_name) + 2);
-	sprintf(ent_path, "%s/%s", file->fullpath, ent->d_name);
-	if (STAT(ent_path, &st) != 0)
-	{
-		DEBUG_WARN("stat %s failed. errno = %d", ent_path, errno);
-	}
-
-	DEBUG_SVC("  pattern %s matched %s", file->pattern, ent_path);
-	xfree(ent_path);
-
-	uniconv = freerdp_uniconv_new();
-	ent_path = freerdp_uniconv_out(uniconv, ent->d_name, &len);
-	freerdp_uniconv_free(uniconv);
+	entry = &file->entries[file->entry_index++];
+	st = entry->st;
+	ent_path = entry->name;
+	len = entry->length;
 
 	ret = true;
 	switch (FsInformationClass)
@@ -658,7 +731,5 @@ boolean disk_file_query_directory(DISK_FILE* file, uint32 FsInformationClass, ui
 			break;
 	}
 
-	xfree(ent_path);
-
 	return ret;
 }
@@ -35,12 +35,16 @@
 #define LSEEK lseek
 #define FSTAT fstat
 #define STATVFS statvfs
+#define PREAD pread
+#define PWRITE pwrite
 #elif defined(__APPLE__) || defined(__FreeBSD__)
 #define STAT stat
 #define OPEN open
 #define LSEEK lseek
 #define FSTAT fstat
 #define STATVFS statvfs
+#define PREAD pread
+#define PWRITE pwrite
 #define O_LARGEFILE 0
 #else
 #define STAT stat64
@@ -48,8 +52,16 @@
 #define LSEEK lseek64
 #define FSTAT fstat64
 #define STATVFS statvfs64
+#define PREAD pread64
+#define PWRITE pwrite64
+#define FADVISE posix_fadvise64
 #endif
 
+/* sequential access is assumed after this many requests at the previous end */
+#define DISK_FILE_SEQUENTIAL	2
+#define DISK_FILE_READ_AHEAD	(1024 * 1024)
+#define DISK_FILE_WRITE_BEHIND	(1024 * 1024)
+
 #define EPOCH_DIFF 11644473600LL
 
 #define FILE_TIME_SYSTEM_TO_RDP(_t) \
@@ -63,10 +75,23 @@
 	(_f->delete_pending ? FILE_ATTRIBUTE_TEMPORARY : 0) | \
 	(st.st_mode & S_IWUSR ? 0 : FILE_ATTRIBUTE_READONLY))
 
+/**
+ * A directory listing taken on the initial query, the following queries
+ * only hand out the next entry.
+ */
+typedef struct _DISK_DIR_ENTRY DISK_DIR_ENTRY;
+struct _DISK_DIR_ENTRY
+{
+	char* name; /* UTF-16 */
+	size_t length;
+	struct STAT st;
+};
+
 typedef struct _DISK_FILE DISK_FILE;
 struct _DISK_FILE
 {
 	uint32 id;
+	DISK_FILE* next; /* hash bucket chain */
 	boolean is_dir;
 	int fd;
 	int err;
@@ -76,15 +101,22 @@ struct _DISK_FILE
 	char* filename;
 	char* pattern;
 	boolean delete_pending;
+
+	uint64 next_offset;
+	uint64 flush_offset;
+	uint32 sequential;
+
+	int num_entries;
+	int entry_index;
+	DISK_DIR_ENTRY* entries;
 };
 
 DISK_FILE* disk_file_new(const char* base_path, const char* path, uint32 id,
 	uint32 DesiredAccess, uint32 CreateDisposition, uint32 CreateOptions);
 void disk_file_free(DISK_FILE* file);
 
-boolean disk_file_seek(DISK_FILE* file, uint64 Offset);
-boolean disk_file_read(DISK_FILE* file, uint8* buffer, uint32* Length);
-boolean disk_file_write(DISK_FILE* file, uint8* buffer, uint32 Length);
+boolean disk_file_read(DISK_FILE* file, uint8* buffer, uint32* Length, uint64 Offset);
+boolean disk_file_write(DISK_FILE* file, uint8* buffer, uint32 Length, uint64 Offset);
 boolean disk_file_query_information(DISK_FILE* file, uint32 FsInformationClass, STREAM* output);
 boolean disk_file_set_information(DISK_FILE* file, uint32 FsInformationClass, uint32 Length, STREAM* input);
 boolean disk_file_query_directory(DISK_FILE* file, uint32 FsInformationClass, uint8 InitialQuery,
@@ -36,6 +36,7 @@
 #include <freerdp/utils/stream.h>
 #include <freerdp/utils/unicode.h>
 #include <freerdp/utils/list.h>
+#include <freerdp/utils/mutex.h>
 #include <freerdp/utils/thread.h>
 #include <freerdp/utils/svc_plugin.h>
 
@@ -43,16 +44,51 @@
 #include "rdpdr_types.h"
 #include "disk_file.h"
 
+#define DISK_DEFAULT_WORKERS	4
+#define DISK_MAX_WORKERS	32
+
+/* power of two, the table doubles when there are twice as many open files */
+#define DISK_FILE_TABLE_SIZE	256
+
+/* Windows reads at most 64 KB at a time, anything far beyond is bogus */
+#define DISK_MAX_READ_LENGTH	0x1000000
+
 typedef struct _DISK_DEVICE DISK_DEVICE;
+typedef struct _DISK_WORKER DISK_WORKER;
+
+/**
+ * IRPs on a file are queued behind the ones still pending on it on the
+ * same worker, so the requests on one file complete in order while
+ * requests on different files run in parallel.
+ */
+struct _DISK_WORKER
+{
+	DISK_DEVICE* disk;
+
+	LIST* irp_list;
+	boolean busy;
+	boolean busy_file;
+	uint32 busy_file_id;
+
+	freerdp_thread* thread;
+};
+
 struct _DISK_DEVICE
 {
 	DEVICE device;
 
 	char* path;
-	LIST* files;
 
-	LIST* irp_list;
-	freerdp_thread* thread;
+	/* open files hashed by id, chained through DISK_FILE next */
+	DISK_FILE** files;
+	int files_size;
+	int num_files;
+
+	/* protects files, the worker queues and the busy state */
+	freerdp_mutex mutex;
+
+	int num_workers;
+	DISK_WORKER* workers;
 
 	DEVMAN* devman;
 	pcRegisterDevice UnregisterDevice;
@@ -91,18 +127,82 @@ disk_map_posix_err(int fs_errno)
 	return rc;
 }
 
+#define DISK_FILE_HASH(_disk, _id)	((_id) & ((_disk)->files_size - 1))
+
 static DISK_FILE* disk_get_file_by_id(DISK_DEVICE* disk, uint32 id)
 {
-	LIST_ITEM* item;
 	DISK_FILE* file;
 
-	for (item = disk->files->head; item; item = item->next)
+	freerdp_mutex_lock(disk->mutex);
+
+	for (file = disk->files[DISK_FILE_HASH(disk, id)]; file; file = file->next)
 	{
-		file = (DISK_FILE*)item->data;
 		if (file->id == id)
-			return file;
+			break;
+	}
+
+	freerdp_mutex_unlock(disk->mutex);
+
+	return file;
+}
+
+static void disk_grow_files(DISK_DEVICE* disk)
+{
+	int i;
+	uint32 hash;
+	DISK_FILE* file;
+	DISK_FILE** files;
+	int files_size;
+
+	files = disk->files;
+	files_size = disk->files_size;
+
+	disk->files_size = files_size * 2;
+	disk->files = (DISK_FILE**) xzalloc(sizeof(DISK_FILE*) * disk->files_size);
+
+	for (i = 0; i < files_size; i++)
+	{
+		while ((file = files[i]) != NULL)
+		{
+			files[i] = file->next;
+			hash = DISK_FILE_HASH(disk, file->id);
+			file->next = disk->files[hash];
+			disk->files[hash] = file;
+		}
+	}
+
+	xfree(files);
+}
+
+/* the caller holds the mutex */
+static void disk_add_file(DISK_DEVICE* disk, DISK_FILE* file)
+{
+	uint32 hash;
+
+	if (disk->num_files >= disk->files_size * 2)
+		disk_grow_files(disk);
+
+	hash = DISK_FILE_HASH(disk, file->id);
+	file->next = disk->files[hash];
+	disk->files[hash] = file;
+	disk->num_files++;
+}
+
+/* the caller holds the mutex */
+static void disk_remove_file(DISK_DEVICE* disk, DISK_FILE* file)
+{
+	DISK_FILE** prev;
+
+	for (prev = &disk->files[DISK_FILE_HASH(disk, file->id)]; *prev; prev = &(*prev)->next)
+	{
+		if (*prev == file)
+		{
+			*prev = file->next;
+			file->next = NULL;
+			disk->num_files--;
+			break;
+		}
 	}
-	return NULL;
 }
 
 static void disk_process_irp_create(DISK_DEVICE* disk, IRP* irp)
@@ -127,7 +227,9 @@ static void disk_process_irp_create(DISK_DEVICE* disk, IRP* irp)
 	path = freerdp_uniconv_in(uniconv, stream_get_tail(irp->input), PathLength);
 	freerdp_uniconv_free(uniconv);
 
+	freerdp_mutex_lock(disk->mutex);
 	FileId = irp->devman->id_sequence++;
+	freerdp_mutex_unlock(disk->mutex);
 
 	file = disk_file_new(disk->path, path, FileId,
 		DesiredAccess, CreateDisposition, CreateOptions);
@@ -151,7 +253,9 @@ static void disk_process_irp_create(DISK_DEVICE* disk, IRP* irp)
 	}
 	else
 	{
-		list_enqueue(disk->files, file);
+		freerdp_mutex_lock(disk->mutex);
+		disk_add_file(disk, file);
+		freerdp_mutex_unlock(disk->mutex);
 
 		switch (CreateDisposition)
 		{
@@ -198,7 +302,10 @@ static void disk_process_irp_close(DISK_DEVICE* disk, IRP* irp)
 	{
 		DEBUG_SVC("%s(%d) closed.", file->fullpath, file->id);
 
-		list_remove(disk->files, file);
+		freerdp_mutex_lock(disk->mutex);
+		disk_remove_file(disk, file);
+		freerdp_mutex_unlock(disk->mutex);
+
 		disk_file_free(file);
 	}
 
@@ -212,11 +319,27 @@ static void disk_process_irp_read(DISK_DEVICE* disk, IRP* irp)
 	DISK_FILE* file;
 	uint32 Length;
 	uint64 Offset;
-	uint8* buffer = NULL;
+	uint8* buffer;
+	int pos;
 
 	stream_read_uint32(irp->input, Length);
 	stream_read_uint64(irp->input, Offset);
 
+	if (Length > DISK_MAX_READ_LENGTH)
+	{
+		DEBUG_WARN("read length %u too large.", Length);
+
+		irp->IoStatus = STATUS_INVALID_PARAMETER;
+		stream_write_uint32(irp->output, 0);
+		irp->Complete(irp);
+		return;
+	}
+
+	/* the data is read straight into the reply, behind its Length field */
+	pos = stream_get_pos(irp->output);
+	stream_check_size(irp->output, (int) Length + 4);
+	buffer = stream_get_tail(irp->output) + 4;
+
 	file = disk_get_file_by_id(disk, irp->FileId);
 
 	if (file == NULL)
@@ -226,38 +349,20 @@ static void disk_process_irp_read(DISK_DEVICE* disk, IRP* irp)
 
 		DEBUG_WARN("FileId %d not valid.", irp->FileId);
 	}
-	else if (!disk_file_seek(file, Offset))
+	else if (!disk_file_read(file, buffer, &Length, Offset))
 	{
 		irp->IoStatus = STATUS_UNSUCCESSFUL;
 		Length = 0;
 
-		DEBUG_WARN("seek %s(%d) failed.", file->fullpath, file->id);
+		DEBUG_WARN("read %s(%d) failed.", file->fullpath, file->id);
 	}
 	else
 	{
-		buffer = (uint8*)xmalloc(Length);
-		if (!disk_file_read(file, buffer, &Length))
-		{
-			irp->IoStatus = STATUS_UNSUCCESSFUL;
-			xfree(buffer);
-			buffer = NULL;
-			Length = 0;
-
-			DEBUG_WARN("read %s(%d) failed.", file->fullpath, file->id);
-		}
-		else
-		{
-			DEBUG_SVC("read %llu-%llu from %s(%d).", Offset, Offset + Length, file->fullpath, file->id);
-		}
+		DEBUG_SVC("read %llu-%llu from %s(%d).", Offset, Offset + Length, file->fullpath, file->id);
 	}
 
 	stream_write_uint32(irp->output, Length);
-	if (Length > 0)
-	{
-		stream_check_size(irp->output, Length);
-		stream_write(irp->output, buffer, Length);
-	}
-	xfree(buffer);
+	stream_set_pos(irp->output, pos + 4 + Length);
 
 	irp->Complete(irp);
 }
@@ -281,14 +386,7 @@ static void disk_process_irp_write(DISK_DEVICE* disk, IRP* irp)
 
 		DEBUG_WARN("FileId %d not valid.", irp->FileId);
 	}
-	else if (!disk_file_seek(file, Offset))
-	{
-		irp->IoStatus = STATUS_UNSUCCESSFUL;
-		Length = 0;
-
-		DEBUG_WARN("seek %s(%d) failed.", file->fullpath, file->id);
-	}
-	else if (!disk_file_write(file, stream_get_tail(irp->input), Length))
+	else if (!disk_file_write(file, stream_get_tail(irp->input), Length, Offset))
 	{
 		irp->IoStatus = STATUS_UNSUCCESSFUL;
 		Length = 0;
@@ -572,73 +670,144 @@ static void disk_process_irp(DISK_DEVICE* disk, IRP* irp)
 	}
 }
 
-static void disk_process_irp_list(DISK_DEVICE* disk)
+static DISK_WORKER* disk_select_worker(DISK_DEVICE* disk, IRP* irp)
+{
+	int i;
+	int load;
+	int min_load = 0;
+	LIST_ITEM* item;
+	DISK_WORKER* worker;
+	DISK_WORKER* idle = NULL;
+
+	for (i = 0; i < disk->num_workers; i++)
+	{
+		worker = &disk->workers[i];
+
+		/* a create does not refer to an open file yet */
+		if (irp->MajorFunction != IRP_MJ_CREATE)
+		{
+			if (worker->busy && worker->busy_file && worker->busy_file_id == irp->FileId)
+				return worker;
+
+			for (item = worker->irp_list->head; item; item = item->next)
+			{
+				if (((IRP*)item->data)->MajorFunction != IRP_MJ_CREATE &&
+					((IRP*)item->data)->FileId == irp->FileId)
+					return worker;
+			}
+		}
+
+		load = list_size(worker->irp_list) + (worker->busy ? 1 : 0);
+
+		if (idle == NULL || load < min_load)
+		{
+			idle = worker;
+			min_load = load;
+		}
+	}
+
+	return idle;
+}
+
+static void disk_process_irp_list(DISK_WORKER* worker)
 {
 	IRP* irp;
+	DISK_DEVICE* disk = worker->disk;
 
 	while (1)
 	{
-		if (freerdp_thread_is_stopped(disk->thread))
+		if (freerdp_thread_is_stopped(worker->thread))
 			break;
 
-		freerdp_thread_lock(disk->thread);
-		irp = (IRP*)list_dequeue(disk->irp_list);
-		freerdp_thread_unlock(disk->thread);
+		freerdp_mutex_lock(disk->mutex);
+		irp = (IRP*)list_dequeue(worker->irp_list);
+		worker->busy = (irp != NULL);
+		if (irp != NULL)
+		{
+			worker->busy_file = (irp->MajorFunction != IRP_MJ_CREATE);
+			worker->busy_file_id = irp->FileId;
+		}
+		freerdp_mutex_unlock(disk->mutex);
 
 		if (irp == NULL)
 			break;
 
+		/* the IRP is freed once completed */
 		disk_process_irp(disk, irp);
+
+		freerdp_mutex_lock(disk->mutex);
+		worker->busy = false;
+		freerdp_mutex_unlock(disk->mutex);
 	}
 }
 
 static void* disk_thread_func(void* arg)
 {
-	DISK_DEVICE* disk = (DISK_DEVICE*)arg;
+	DISK_WORKER* worker = (DISK_WORKER*)arg;
 
 	while (1)
 	{
-		freerdp_thread_wait(disk->thread);
+		freerdp_thread_wait(worker->thread);
 
-		if (freerdp_thread_is_stopped(disk->thread))
+		if (freerdp_thread_is_stopped(worker->thread))
 			break;
 
-		freerdp_thread_reset(disk->thread);
-		disk_process_irp_list(disk);
+		freerdp_thread_reset(worker->thread);
+		disk_process_irp_list(worker);
 	}
 
-	freerdp_thread_quit(disk->thread);
+	freerdp_thread_quit(worker->thread);
 
 	return NULL;
 }
 
 static void disk_irp_request(DEVICE* device, IRP* irp)
 {
+	DISK_WORKER* worker;
 	DISK_DEVICE* disk = (DISK_DEVICE*)device;
 
-	freerdp_thread_lock(disk->thread);
-	list_enqueue(disk->irp_list, irp);
-	freerdp_thread_unlock(disk->thread);
+	freerdp_mutex_lock(disk->mutex);
+	worker = disk_select_worker(disk, irp);
+	list_enqueue(worker->irp_list, irp);
+	freerdp_mutex_unlock(disk->mutex);
 
-	freerdp_thread_signal(disk->thread);
+	freerdp_thread_signal(worker->thread);
 }
 
 static void disk_free(DEVICE* device)
 {
-	DISK_DEVICE* disk = (DISK_DEVICE*)device;
+	int i;
 	IRP* irp;
 	DISK_FILE* file;
+	DISK_WORKER* worker;
+	DISK_DEVICE* disk = (DISK_DEVICE*)device;
+
+	for (i = 0; i < disk->num_workers; i++)
+		freerdp_thread_stop(disk->workers[i].thread);
 
-	freerdp_thread_stop(disk->thread);
-	freerdp_thread_free(disk->thread);
+	for (i = 0; i < disk->num_workers; i++)
+	{
+		worker = &disk->workers[i];
 
-	while ((irp = (IRP*)list_dequeue(disk->irp_list)) != NULL)
-		irp->Discard(irp);
-	list_free(disk->irp_list);
+		freerdp_thread_free(worker->thread);
 
-	while ((file = (DISK_FILE*)list_dequeue(disk->files)) != NULL)
-		disk_file_free(file);
-	list_free(disk->files);
+		while ((irp = (IRP*)list_dequeue(worker->irp_list)) != NULL)
+			irp->Discard(irp);
+		list_free(worker->irp_list);
+	}
+	xfree(disk->workers);
+
+	for (i = 0; i < disk->files_size; i++)
+	{
+		while ((file = disk->files[i]) != NULL)
+		{
+			disk->files[i] = file->next;
+			disk_file_free(file);
+		}
+	}
+	xfree(disk->files);
+
+	freerdp_mutex_free(disk->mutex);
 	xfree(disk);
 }
 
@@ -667,14 +836,31 @@ int DeviceServiceEntry(PDEVICE_SERVICE_ENTRY_POINTS pEntryPoints)
 			stream_write_uint8(disk->device.data, name[i] < 0 ? '_' : name[i]);
 
 		disk->path = path;
-		disk->files = list_new();
-
-		disk->irp_list = list_new();
-		disk->thread = freerdp_thread_new();
+		disk->files_size = DISK_FILE_TABLE_SIZE;
+		disk->files = (DISK_FILE**) xzalloc(sizeof(DISK_FILE*) * disk->files_size);
+		disk->mutex = freerdp_mutex_new();
+
+		/* optional fourth field, disk:<name>:<path>:<workers> */
+		disk->num_workers = DISK_DEFAULT_WORKERS;
+		if (pEntryPoints->plugin_data->data[3] != NULL)
+			disk->num_workers = atoi((char*)pEntryPoints->plugin_data->data[3]);
+		if (disk->num_workers < 1)
+			disk->num_workers = 1;
+		if (disk->num_workers > DISK_MAX_WORKERS)
+			disk->num_workers = DISK_MAX_WORKERS;
+
+		disk->workers = (DISK_WORKER*)xzalloc(sizeof(DISK_WORKER) * disk->num_workers);
+		for (i = 0; i < disk->num_workers; i++)
+		{
+			disk->workers[i].disk = disk;
+			disk->workers[i].irp_list = list_new();
+			disk->workers[i].thread = freerdp_thread_new();
+		}
 
 		pEntryPoints->RegisterDevice(pEntryPoints->devman, (DEVICE*)disk);
 
-		freerdp_thread_start(disk->thread, disk_thread_func, disk);
+		for (i = 0; i < disk->num_workers; i++)
+			freerdp_thread_start(disk->workers[i].thread, disk_thread_func, &disk->workers[i]);
 	}
 
 	return 0;
@@ -482,6 +482,24 @@ static void rdpsnd_pulse_start(rdpsndDevicePlugin* device)
 	pa_stream_trigger(pulse->stream, NULL, NULL);
 }
 
+static uint32 rdpsnd_pulse_get_latency(rdpsndDevicePlugin* device)
+{
+	rdpsndPulsePlugin* pulse = (rdpsndPulsePlugin*)device;
+	pa_usec_t usec;
+	int negative;
+	uint32 latency = 0;
+
+	if (!pulse->stream)
+		return 0;
+
+	pa_threaded_mainloop_lock(pulse->mainloop);
+	if (pa_stream_get_latency(pulse->stream, &usec, &negative) == 0 && !negative)
+		latency = (uint32) (usec / 1000);
+	pa_threaded_mainloop_unlock(pulse->mainloop);
+
+	return latency;
+}
+
 int FreeRDPRdpsndDeviceEntry(PFREERDP_RDPSND_DEVICE_ENTRY_POINTS pEntryPoints)
 {
 	rdpsndPulsePlugin* pulse;
@@ -497,6 +515,7 @@ int FreeRDPRdpsndDeviceEntry(PFREERDP_RDPSND_DEVICE_ENTRY_POINTS pEntryPoints)
 	pulse->device.Start = rdpsnd_pulse_start;
 	pulse->device.Close = rdpsnd_pulse_close;
 	pulse->device.Free = rdpsnd_pulse_free;
+	pulse->device.GetLatency = rdpsnd_pulse_get_latency;
 
 	data = pEntryPoints->plugin_data;
 	if (data && strcmp((char*)data->data[0], "pulse") == 0)
@@ -31,16 +31,27 @@
 #include <freerdp/utils/stream.h>
 #include <freerdp/utils/list.h>
 #include <freerdp/utils/load_plugin.h>
+#include <freerdp/utils/thread.h>
 #include <freerdp/utils/svc_plugin.h>
 
 #include "rdpsnd_main.h"
 
+/* the jitter buffer holds back playback by at least this much */
+#define RDPSND_MIN_BUFFER_MS	20
+#define RDPSND_MAX_BUFFER_MS	500
+
+/* waves beyond this are dropped while the device is stalled */
+#define RDPSND_MAX_QUEUE_MS	2000
+
+#define RDPSND_ITEM_WAVE	1
+#define RDPSND_ITEM_FORMAT	2
+#define RDPSND_ITEM_VOLUME	3
+#define RDPSND_ITEM_CLOSE	4
+
 struct rdpsnd_plugin
 {
 	rdpSvcPlugin plugin;
 
-	LIST* data_out_list;
-
 	uint8 cBlockNo;
 	rdpsndFormat* supported_formats;
 	int n_supported_formats;
@@ -52,16 +63,49 @@ struct rdpsnd_plugin
 	uint32 wTimeStamp; /* server timestamp */
 	uint32 wave_timestamp; /* client timestamp */
 
-	boolean is_open;
-	uint32 close_timestamp;
-
 	uint16 fixed_format;
 	uint16 fixed_channel;
 	uint32 fixed_rate;
 	int latency;
 
-	/* Device plugin */
+	/* Device plugin, only used by the playback thread once connected */
 	rdpsndDevicePlugin* device;
+
+	/**
+	 * Playback thread. The channel thread queues the waves along with
+	 * format, volume and close requests, the playback thread owns the
+	 * device and sends the WaveConfirm once a wave has been played.
+	 */
+	freerdp_thread* thread;
+	LIST* playback_list; /* protected by the thread lock */
+	uint32 queued_ms; /* waves in playback_list, protected by the thread lock */
+
+	LIST* confirm_list;
+	rdpsndFormat playback_format;
+	boolean is_open;
+	uint32 close_timestamp;
+
+	/* jitter buffer */
+	boolean buffering;
+	int jitter; /* interarrival jitter in 1/16 ms */
+	uint32 last_recv_timestamp;
+	uint32 last_duration;
+	uint32 play_end_timestamp; /* when the device runs dry, if GetLatency is not there */
+	uint32 last_confirm_timestamp;
+};
+
+struct rdpsnd_playback_item
+{
+	int type;
+
+	STREAM* data;
+	uint16 wTimeStamp;
+	uint8 cBlockNo;
+	uint32 recv_timestamp;
+	uint32 duration;
+
+	rdpsndFormat format;
+	uint32 volume;
 };
 
 struct data_out_item
@@ -79,47 +123,354 @@ static uint32 get_mstime(void)
 	return (tp.tv_sec * 1000) + (tp.tv_usec / 1000);
 }
 
-/* process the linked list of data that has queued to be sent */
-static void rdpsnd_process_interval(rdpSvcPlugin* plugin)
+static void rdpsnd_playback_item_free(struct rdpsnd_playback_item* item)
 {
-	rdpsndPlugin* rdpsnd = (rdpsndPlugin*)plugin;
-	struct data_out_item* item;
-	uint32 cur_time;
+	if (item->data != NULL)
+		stream_free(item->data);
+	xfree(item->format.data);
+	xfree(item);
+}
+
+static STREAM* rdpsnd_wave_confirm_new(uint16 wTimeStamp, uint8 cConfirmedBlockNo)
+{
+	STREAM* data_out;
+
+	data_out = stream_new(8);
+	stream_write_uint8(data_out, SNDC_WAVECONFIRM);
+	stream_write_uint8(data_out, 0);
+	stream_write_uint16(data_out, 4);
+	stream_write_uint16(data_out, wTimeStamp);
+	stream_write_uint8(data_out, cConfirmedBlockNo); /* cConfirmedBlockNo */
+	stream_write_uint8(data_out, 0); /* bPad */
+
+	return data_out;
+}
+
+/* playing time of a wave in milliseconds */
+static uint32 rdpsnd_wave_duration(rdpsndFormat* format, int size)
+{
+	uint32 frames;
+	uint32 samples_per_block;
+
+	if (format->nChannels < 1 || format->nSamplesPerSec < 1)
+		return 0;
 
-	while (list_size(rdpsnd->data_out_list) > 0)
+	switch (format->wFormatTag)
 	{
-		item = (struct data_out_item*)list_peek(rdpsnd->data_out_list) ;
-		cur_time = get_mstime();
-		if (!item || cur_time <= item->out_timestamp)
+		case 2: /* MS ADPCM */
+			/* every block starts with a 7 byte header per channel */
+			if (format->nBlockAlign < 7 * format->nChannels)
+				return 0;
+			samples_per_block = (format->nBlockAlign - 7 * format->nChannels) * 2 / format->nChannels + 2;
+			frames = size / format->nBlockAlign * samples_per_block;
 			break;
 
-		item = (struct data_out_item*)list_dequeue(rdpsnd->data_out_list);
-		svc_plugin_send(plugin, item->data_out);
-		xfree(item);
+		case 0x11: /* IMA ADPCM */
+			/* every block starts with a 4 byte header per channel */
+			if (format->nBlockAlign < 4 * format->nChannels)
+				return 0;
+			samples_per_block = (format->nBlockAlign - 4 * format->nChannels) * 2 / format->nChannels + 1;
+			frames = size / format->nBlockAlign * samples_per_block;
+			break;
 
-		DEBUG_SVC("processed data_out");
+		default:
+			frames = (format->wBitsPerSample > 0) ?
+				size / (format->nChannels * ((format->wBitsPerSample + 7) / 8)) : 0;
+			break;
 	}
 
-	if (rdpsnd->is_open && rdpsnd->close_timestamp > 0)
+	return frames * 1000 / format->nSamplesPerSec;
+}
+
+/* milliseconds of audio the device still has to play */
+static uint32 rdpsnd_playback_latency(rdpsndPlugin* rdpsnd, uint32 now)
+{
+	if (rdpsnd->device && rdpsnd->device->GetLatency)
+		return rdpsnd->device->GetLatency(rdpsnd->device);
+
+	if ((int) (rdpsnd->play_end_timestamp - now) > 0)
+		return rdpsnd->play_end_timestamp - now;
+
+	return 0;
+}
+
+static uint32 rdpsnd_playback_target(rdpsndPlugin* rdpsnd)
+{
+	uint32 target;
+
+	target = RDPSND_MIN_BUFFER_MS + 2 * rdpsnd->jitter / 16;
+
+	if (target > RDPSND_MAX_BUFFER_MS)
+		target = RDPSND_MAX_BUFFER_MS;
+
+	return target;
+}
+
+/**
+ * Called with the thread lock held. When the device stalls the oldest
+ * waves are dropped, they are still confirmed so the server keeps going.
+ */
+static void rdpsnd_playback_drop(rdpsndPlugin* rdpsnd)
+{
+	struct rdpsnd_playback_item* item;
+	uint32 delay_ms;
+
+	while (rdpsnd->queued_ms > RDPSND_MAX_QUEUE_MS)
+	{
+		item = (struct rdpsnd_playback_item*) list_peek(rdpsnd->playback_list);
+
+		if (item == NULL || item->type != RDPSND_ITEM_WAVE)
+			break;
+
+		list_dequeue(rdpsnd->playback_list);
+		rdpsnd->queued_ms -= item->duration;
+
+		DEBUG_WARN("playback stalled, dropping wave %d", item->cBlockNo);
+
+		delay_ms = get_mstime() - item->recv_timestamp;
+		svc_plugin_send((rdpSvcPlugin*) rdpsnd,
+			rdpsnd_wave_confirm_new(item->wTimeStamp + delay_ms, item->cBlockNo));
+
+		rdpsnd_playback_item_free(item);
+	}
+}
+
+/* called on the channel thread, never blocks on the device */
+static void rdpsnd_playback_push(rdpsndPlugin* rdpsnd, struct rdpsnd_playback_item* item)
+{
+	freerdp_thread_lock(rdpsnd->thread);
+
+	list_enqueue(rdpsnd->playback_list, item);
+
+	if (item->type == RDPSND_ITEM_WAVE)
+	{
+		rdpsnd->queued_ms += item->duration;
+		rdpsnd_playback_drop(rdpsnd);
+	}
+
+	freerdp_thread_unlock(rdpsnd->thread);
+
+	freerdp_thread_signal(rdpsnd->thread);
+}
+
+static void rdpsnd_playback_wave(rdpsndPlugin* rdpsnd, struct rdpsnd_playback_item* item)
+{
+	int delay;
+	uint32 now;
+	uint32 latency;
+	struct data_out_item* confirm;
+
+	if (!rdpsnd->is_open)
+	{
+		if (rdpsnd->device)
+			IFCALL(rdpsnd->device->Open, rdpsnd->device, &rdpsnd->playback_format, rdpsnd->latency);
+		rdpsnd->is_open = true;
+	}
+
+	rdpsnd->close_timestamp = 0;
+
+	if (rdpsnd->device)
+		IFCALL(rdpsnd->device->Play, rdpsnd->device, stream_get_head(item->data), stream_get_size(item->data));
+
+	now = get_mstime();
+
+	if ((int) (rdpsnd->play_end_timestamp - now) < 0)
+		rdpsnd->play_end_timestamp = now;
+	rdpsnd->play_end_timestamp += item->duration;
+
+	/* the wave is confirmed when the device is done with it */
+	latency = rdpsnd_playback_latency(rdpsnd, now);
+
+	confirm = xnew(struct data_out_item);
+	confirm->out_timestamp = now + latency;
+	if ((int) (confirm->out_timestamp - rdpsnd->last_confirm_timestamp) < 0)
+		confirm->out_timestamp = rdpsnd->last_confirm_timestamp;
+	rdpsnd->last_confirm_timestamp = confirm->out_timestamp;
+
+	delay = confirm->out_timestamp - item->recv_timestamp;
+	confirm->data_out = rdpsnd_wave_confirm_new(item->wTimeStamp + delay, item->cBlockNo);
+
+	DEBUG_SVC("data_size %d latency %u delay %d", stream_get_size(item->data), latency, delay);
+
+	list_enqueue(rdpsnd->confirm_list, confirm);
+}
+
+static void rdpsnd_playback_update_jitter(rdpsndPlugin* rdpsnd, struct rdpsnd_playback_item* item)
+{
+	int d;
+
+	if (rdpsnd->last_recv_timestamp != 0)
 	{
-		cur_time = get_mstime();
-		if (cur_time > rdpsnd->close_timestamp)
+		d = (int) (item->recv_timestamp - rdpsnd->last_recv_timestamp) - (int) rdpsnd->last_duration;
+		if (d < 0)
+			d = -d;
+		rdpsnd->jitter += d - (rdpsnd->jitter + 8) / 16;
+	}
+
+	rdpsnd->last_recv_timestamp = item->recv_timestamp;
+	rdpsnd->last_duration = item->duration;
+}
+
+static void rdpsnd_playback_process(rdpsndPlugin* rdpsnd)
+{
+	uint32 now;
+	struct data_out_item* confirm;
+	struct rdpsnd_playback_item* item;
+
+	while (1)
+	{
+		now = get_mstime();
+
+		freerdp_thread_lock(rdpsnd->thread);
+
+		item = (struct rdpsnd_playback_item*) list_peek(rdpsnd->playback_list);
+
+		if (item != NULL && item->type == RDPSND_ITEM_WAVE)
+		{
+			/* the device ran dry, fill the jitter buffer again before going on */
+			if (!rdpsnd->buffering && rdpsnd->is_open && rdpsnd_playback_latency(rdpsnd, now) == 0)
+				rdpsnd->buffering = true;
+
+			if (rdpsnd->buffering)
+			{
+				if (rdpsnd->queued_ms < rdpsnd_playback_target(rdpsnd) &&
+					now - item->recv_timestamp < rdpsnd_playback_target(rdpsnd))
+				{
+					item = NULL;
+				}
+				else
+				{
+					rdpsnd->buffering = false;
+				}
+			}
+		}
+
+		if (item != NULL)
 		{
-			if (rdpsnd->device)
-				IFCALL(rdpsnd->device->Close, rdpsnd->device);
-			rdpsnd->is_open = false;
-			rdpsnd->close_timestamp = 0;
+			list_dequeue(rdpsnd->playback_list);
+			if (item->type == RDPSND_ITEM_WAVE)
+				rdpsnd->queued_ms -= item->duration;
+		}
+
+		freerdp_thread_unlock(rdpsnd->thread);
 
-			DEBUG_SVC("processed close");
+		if (item == NULL)
+			break;
+
+		switch (item->type)
+		{
+			case RDPSND_ITEM_WAVE:
+				rdpsnd_playback_update_jitter(rdpsnd, item);
+				rdpsnd_playback_wave(rdpsnd, item);
+				break;
+
+			case RDPSND_ITEM_FORMAT:
+				xfree(rdpsnd->playback_format.data);
+				rdpsnd->playback_format = item->format;
+				item->format.data = NULL;
+				if (rdpsnd->is_open && rdpsnd->device)
+					IFCALL(rdpsnd->device->SetFormat, rdpsnd->device, &rdpsnd->playback_format, rdpsnd->latency);
+				break;
+
+			case RDPSND_ITEM_VOLUME:
+				if (rdpsnd->device)
+					IFCALL(rdpsnd->device->SetVolume, rdpsnd->device, item->volume);
+				break;
+
+			case RDPSND_ITEM_CLOSE:
+				if (rdpsnd->device)
+					IFCALL(rdpsnd->device->Start, rdpsnd->device);
+				rdpsnd->close_timestamp = now + 2000;
+				rdpsnd->last_recv_timestamp = 0;
+				break;
 		}
+
+		rdpsnd_playback_item_free(item);
+	}
+
+	now = get_mstime();
+
+	while ((confirm = (struct data_out_item*) list_peek(rdpsnd->confirm_list)) != NULL)
+	{
+		if ((int) (confirm->out_timestamp - now) > 0)
+			break;
+
+		list_dequeue(rdpsnd->confirm_list);
+		svc_plugin_send((rdpSvcPlugin*) rdpsnd, confirm->data_out);
+		xfree(confirm);
+
+		DEBUG_SVC("processed data_out");
 	}
 
-	if (list_size(rdpsnd->data_out_list) == 0 && !rdpsnd->is_open)
+	if (rdpsnd->is_open && rdpsnd->close_timestamp > 0 && (int) (now - rdpsnd->close_timestamp) >= 0)
 	{
-		rdpsnd->plugin.interval_ms = 0;
+		if (rdpsnd->device)
+			IFCALL(rdpsnd->device->Close, rdpsnd->device);
+		rdpsnd->is_open = false;
+		rdpsnd->close_timestamp = 0;
+		rdpsnd->buffering = true;
+
+		DEBUG_SVC("processed close");
 	}
 }
 
+static void rdpsnd_playback_deadline(int* timeout, int t)
+{
+	if (t < 0)
+		t = 0;
+
+	if (*timeout < 0 || t < *timeout)
+		*timeout = t;
+}
+
+/* how long the playback thread may sleep, -1 until something is queued */
+static int rdpsnd_playback_timeout(rdpsndPlugin* rdpsnd)
+{
+	int timeout = -1;
+	uint32 now;
+	struct data_out_item* confirm;
+	struct rdpsnd_playback_item* item;
+
+	now = get_mstime();
+
+	confirm = (struct data_out_item*) list_peek(rdpsnd->confirm_list);
+	if (confirm != NULL)
+		rdpsnd_playback_deadline(&timeout, (int) (confirm->out_timestamp - now));
+
+	if (rdpsnd->is_open && rdpsnd->close_timestamp > 0)
+		rdpsnd_playback_deadline(&timeout, (int) (rdpsnd->close_timestamp - now));
+
+	freerdp_thread_lock(rdpsnd->thread);
+	item = (struct rdpsnd_playback_item*) list_peek(rdpsnd->playback_list);
+	if (item != NULL)
+		rdpsnd_playback_deadline(&timeout, (int) (item->recv_timestamp + rdpsnd_playback_target(rdpsnd) - now));
+	freerdp_thread_unlock(rdpsnd->thread);
+
+	return timeout;
+}
+
+static void* rdpsnd_playback_thread_func(void* arg)
+{
+	rdpsndPlugin* rdpsnd = (rdpsndPlugin*) arg;
+
+	rdpsnd->buffering = true;
+
+	while (1)
+	{
+		freerdp_thread_wait_timeout(rdpsnd->thread, rdpsnd_playback_timeout(rdpsnd));
+
+		if (freerdp_thread_is_stopped(rdpsnd->thread))
+			break;
+
+		freerdp_thread_reset(rdpsnd->thread);
+		rdpsnd_playback_process(rdpsnd);
+	}
+
+	freerdp_thread_quit(rdpsnd->thread);
+
+	return NULL;
+}
+
 static void rdpsnd_free_supported_formats(rdpsndPlugin* rdpsnd)
 {
 	uint16 i;
@@ -148,6 +499,7 @@ static void rdpsnd_process_message_formats(rdpsndPlugin* rdpsnd, STREAM* data_in
 	int pos;
 
 	rdpsnd_free_supported_formats(rdpsnd);
+	rdpsnd->current_format = -1;
 
 	stream_seek_uint32(data_in); /* dwFlags */
 	stream_seek_uint32(data_in); /* dwVolume */
@@ -277,6 +629,8 @@ static void rdpsnd_process_message_training(rdpsndPlugin* rdpsnd, STREAM* data_i
 static void rdpsnd_process_message_wave_info(rdpsndPlugin* rdpsnd, STREAM* data_in, uint16 BodySize)
 {
 	uint16 wFormatNo;
+	rdpsndFormat* format;
+	struct rdpsnd_playback_item* item;
 
 	stream_read_uint16(data_in, rdpsnd->wTimeStamp);
 	stream_read_uint16(data_in, wFormatNo);
@@ -289,80 +643,79 @@ static void rdpsnd_process_message_wave_info(rdpsndPlugin* rdpsnd, STREAM* data_
 
 	DEBUG_SVC("waveDataSize %d wFormatNo %d", rdpsnd->waveDataSize, wFormatNo);
 
-	rdpsnd->close_timestamp = 0;
-	if (!rdpsnd->is_open)
+	if (wFormatNo >= rdpsnd->n_supported_formats)
 	{
-		rdpsnd->current_format = wFormatNo;
-		rdpsnd->is_open = true;
-		if (rdpsnd->device)
-			IFCALL(rdpsnd->device->Open, rdpsnd->device, &rdpsnd->supported_formats[wFormatNo],
-				rdpsnd->latency);
+		DEBUG_WARN("invalid wFormatNo %d", wFormatNo);
+		return;
 	}
-	else if (wFormatNo != rdpsnd->current_format)
+
+	if (wFormatNo != rdpsnd->current_format)
 	{
 		rdpsnd->current_format = wFormatNo;
-		if (rdpsnd->device)
-			IFCALL(rdpsnd->device->SetFormat, rdpsnd->device, &rdpsnd->supported_formats[wFormatNo],
-				rdpsnd->latency);
+		format = &rdpsnd->supported_formats[wFormatNo];
+
+		item = xnew(struct rdpsnd_playback_item);
+		item->type = RDPSND_ITEM_FORMAT;
+		item->format = *format;
+		if (format->cbSize > 0)
+		{
+			item->format.data = xmalloc(format->cbSize);
+			memcpy(item->format.data, format->data, format->cbSize);
+		}
+
+		rdpsnd_playback_push(rdpsnd, item);
 	}
 }
 
-/* header is not removed from data in this function */
-static void rdpsnd_process_message_wave(rdpsndPlugin* rdpsnd, STREAM* data_in)
+/* header is not removed from data in this function, the wave is queued as it is */
+static boolean rdpsnd_process_message_wave(rdpsndPlugin* rdpsnd, STREAM* data_in)
 {
-	uint16 wTimeStamp;
-	uint32 delay_ms;
-	uint32 process_ms;
-	struct data_out_item* item;
+	struct rdpsnd_playback_item* item;
 
 	rdpsnd->expectingWave = 0;
 	memcpy(stream_get_head(data_in), rdpsnd->waveData, 4);
 	if (stream_get_size(data_in) != rdpsnd->waveDataSize)
 	{
 		DEBUG_WARN("size error");
-		return;
+		return false;
 	}
-	if (rdpsnd->device)
-		IFCALL(rdpsnd->device->Play, rdpsnd->device, stream_get_head(data_in), stream_get_size(data_in));
-
-	process_ms = get_mstime() - rdpsnd->wave_timestamp;
-	delay_ms = 250;
-	wTimeStamp = rdpsnd->wTimeStamp + delay_ms;
-
-	DEBUG_SVC("data_size %d delay_ms %u process_ms %u",
-		stream_get_size(data_in), delay_ms, process_ms);
-
-	item = xnew(struct data_out_item);
-	item->data_out = stream_new(8);
-	stream_write_uint8(item->data_out, SNDC_WAVECONFIRM);
-	stream_write_uint8(item->data_out, 0);
-	stream_write_uint16(item->data_out, 4);
-	stream_write_uint16(item->data_out, wTimeStamp);
-	stream_write_uint8(item->data_out, rdpsnd->cBlockNo); /* cConfirmedBlockNo */
-	stream_write_uint8(item->data_out, 0); /* bPad */
-	item->out_timestamp = rdpsnd->wave_timestamp + delay_ms;
-
-	list_enqueue(rdpsnd->data_out_list, item);
-	rdpsnd->plugin.interval_ms = 10;
+	if (rdpsnd->current_format < 0)
+		return false;
+
+	item = xnew(struct rdpsnd_playback_item);
+	item->type = RDPSND_ITEM_WAVE;
+	item->data = data_in;
+	item->wTimeStamp = rdpsnd->wTimeStamp;
+	item->cBlockNo = rdpsnd->cBlockNo;
+	item->recv_timestamp = rdpsnd->wave_timestamp;
+	item->duration = rdpsnd_wave_duration(&rdpsnd->supported_formats[rdpsnd->current_format],
+		stream_get_size(data_in));
+
+	rdpsnd_playback_push(rdpsnd, item);
+
+	return true;
 }
 
 static void rdpsnd_process_message_close(rdpsndPlugin* rdpsnd)
 {
+	struct rdpsnd_playback_item* item;
+
 	DEBUG_SVC("server closes.");
-	if (rdpsnd->device)
-		IFCALL(rdpsnd->device->Start, rdpsnd->device);
-	rdpsnd->close_timestamp = get_mstime() + 2000;
-	rdpsnd->plugin.interval_ms = 10;
+
+	item = xnew(struct rdpsnd_playback_item);
+	item->type = RDPSND_ITEM_CLOSE;
+	rdpsnd_playback_push(rdpsnd, item);
 }
 
 static void rdpsnd_process_message_setvolume(rdpsndPlugin* rdpsnd, STREAM* data_in)
 {
-	uint32 dwVolume;
+	struct rdpsnd_playback_item* item;
 
-	stream_read_uint32(data_in, dwVolume);
-	DEBUG_SVC("dwVolume 0x%X", dwVolume);
-	if (rdpsnd->device)
-		IFCALL(rdpsnd->device->SetVolume, rdpsnd->device, dwVolume);
+	item = xnew(struct rdpsnd_playback_item);
+	item->type = RDPSND_ITEM_VOLUME;
+	stream_read_uint32(data_in, item->volume);
+	DEBUG_SVC("dwVolume 0x%X", item->volume);
+	rdpsnd_playback_push(rdpsnd, item);
 }
 
 static void rdpsnd_process_receive(rdpSvcPlugin* plugin, STREAM* data_in)
@@ -373,8 +726,8 @@ static void rdpsnd_process_receive(rdpSvcPlugin* plugin, STREAM* data_in)
 
 	if (rdpsnd->expectingWave)
 	{
-		rdpsnd_process_message_wave(rdpsnd, data_in);
-		stream_free(data_in);
+		if (!rdpsnd_process_message_wave(rdpsnd, data_in))
+			stream_free(data_in);
 		return;
 	}
 
@@ -483,10 +836,8 @@ static void rdpsnd_process_connect(rdpSvcPlugin* plugin)
 
 	DEBUG_SVC("connecting");
 
-	plugin->interval_callback = rdpsnd_process_interval;
-
-	rdpsnd->data_out_list = list_new();
 	rdpsnd->latency = -1;
+	rdpsnd->current_format = -1;
 
 	data = (RDP_PLUGIN_DATA*)plugin->channel_entry_points.pExtendedData;
 
@@ -527,6 +878,11 @@ static void rdpsnd_process_connect(rdpSvcPlugin* plugin)
 	{
 		DEBUG_WARN("no sound device.");
 	}
+
+	rdpsnd->playback_list = list_new();
+	rdpsnd->confirm_list = list_new();
+	rdpsnd->thread = freerdp_thread_new();
+	freerdp_thread_start(rdpsnd->thread, rdpsnd_playback_thread_func, rdpsnd);
 }
 
 static void rdpsnd_process_event(rdpSvcPlugin* plugin, RDP_EVENT* event)
@@ -537,17 +893,30 @@ static void rdpsnd_process_event(rdpSvcPlugin* plugin, RDP_EVENT* event)
 static void rdpsnd_process_terminate(rdpSvcPlugin* plugin)
 {
 	rdpsndPlugin* rdpsnd = (rdpsndPlugin*)plugin;
-	struct data_out_item* item;
+	struct data_out_item* confirm;
+	struct rdpsnd_playback_item* item;
+
+	if (rdpsnd->thread)
+	{
+		freerdp_thread_stop(rdpsnd->thread);
+		freerdp_thread_free(rdpsnd->thread);
+
+		while ((item = list_dequeue(rdpsnd->playback_list)) != NULL)
+			rdpsnd_playback_item_free(item);
+		list_free(rdpsnd->playback_list);
+
+		while ((confirm = list_dequeue(rdpsnd->confirm_list)) != NULL)
+		{
+			stream_free(confirm->data_out);
+			xfree(confirm);
+		}
+		list_free(rdpsnd->confirm_list);
+	}
 
 	if (rdpsnd->device)
 		IFCALL(rdpsnd->device->Free, rdpsnd->device);
 
-	while ((item = list_dequeue(rdpsnd->data_out_list)) != NULL)
-	{
-		stream_free(item->data_out);
-		xfree(item);
-	}
-	list_free(rdpsnd->data_out_list);
+	xfree(rdpsnd->playback_format.data);
 
 	rdpsnd_free_supported_formats(rdpsnd);
 
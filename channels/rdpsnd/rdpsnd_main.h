@@ -34,6 +34,7 @@ typedef void (*pcPlay) (rdpsndDevicePlugin* device, uint8* data, int size);
 typedef void (*pcStart) (rdpsndDevicePlugin* device);
 typedef void (*pcClose) (rdpsndDevicePlugin* device);
 typedef void (*pcFree) (rdpsndDevicePlugin* device);
+typedef uint32 (*pcGetLatency) (rdpsndDevicePlugin* device);
 
 struct rdpsnd_device_plugin
 {
@@ -45,6 +46,9 @@ struct rdpsnd_device_plugin
 	pcStart Start;
 	pcClose Close;
 	pcFree Free;
+
+	/* optional, milliseconds of audio the device has yet to play */
+	pcGetLatency GetLatency;
 };
 
 #define RDPSND_DEVICE_EXPORT_FUNC_NAME "FreeRDPRdpsndDeviceEntry"
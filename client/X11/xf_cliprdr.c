@@ -17,9 +17,11 @@
  * limitations under the License.
  */
 
+#include <time.h>
 #include <stdlib.h>
 #include <X11/Xlib.h>
 #include <X11/Xatom.h>
+#include <freerdp/utils/list.h>
 #include <freerdp/utils/event.h>
 #include <freerdp/utils/stream.h>
 #include <freerdp/utils/unicode.h>
@@ -34,6 +36,42 @@ struct clipboard_format_mapping
 	uint32 format_id;
 };
 
+/**
+ * Data received from the server for one format. It is kept as the server
+ * sent it and only converted while it is handed to X: the header goes
+ * first, then the bytes from start to end.
+ */
+typedef struct clipboard_data clipboardData;
+struct clipboard_data
+{
+	uint32 format;
+	uint32 alt_format;
+	uint8* data;
+	int length;
+	uint8 header[14];
+	int header_length;
+	int start;
+	int end;
+};
+
+/* seconds an INCR requestor may leave a chunk unread before it is dropped */
+#define XF_CLIPRDR_TRANSFER_TIMEOUT	30
+
+/**
+ * An INCR transfer of server data to another X client. Every time the
+ * requestor deletes the property the next chunk is converted into it.
+ */
+typedef struct clipboard_transfer clipboardTransfer;
+struct clipboard_transfer
+{
+	Window requestor;
+	Atom property;
+	Atom target;
+	clipboardData* data;
+	int position;
+	time_t time;
+};
+
 typedef struct clipboard_context clipboardContext;
 struct clipboard_context
 {
@@ -51,12 +89,19 @@ struct clipboard_context
 	int num_formats;
 	Atom targets[20];
 	int num_targets;
-	uint8* data;
 	uint32 data_format;
 	uint32 data_alt_format;
-	int data_length;
 	XEvent* respond;
 
+	/**
+	 * Every format fetched since the last format list. Repeated pastes and
+	 * requestors asking for several targets are served from here.
+	 */
+	LIST* cache;
+	LIST* transfers;
+	uint8* chunk;
+	int max_chunk;
+
 	/* client->server data */
 	Window owner;
 	int request_index;
@@ -136,16 +181,34 @@ void xf_cliprdr_init(xfInfo* xfi, rdpChannels* chanman)
 	cb->num_targets = 2;
 
 	cb->incr_atom = XInternAtom(xfi->display, "INCR", false);
+
+	/* anything larger than a request goes out with INCR */
+	cb->max_chunk = XMaxRequestSize(xfi->display) * 4 - 1024;
+	cb->cache = list_new();
+	cb->transfers = list_new();
 }
 
 void xf_cliprdr_uninit(xfInfo* xfi)
 {
+	clipboardData* data;
+	clipboardTransfer* transfer;
 	clipboardContext* cb = (clipboardContext*) xfi->clipboard_context;
 
 	if (cb)
 	{
+		while ((transfer = (clipboardTransfer*) list_dequeue(cb->transfers)) != NULL)
+			xfree(transfer);
+		list_free(cb->transfers);
+
+		while ((data = (clipboardData*) list_dequeue(cb->cache)) != NULL)
+		{
+			xfree(data->data);
+			xfree(data);
+		}
+		list_free(cb->cache);
+
 		xfree(cb->formats);
-		xfree(cb->data);
+		xfree(cb->chunk);
 		xfree(cb->respond);
 		xfree(cb->incr_data);
 		xfree(cb);
@@ -188,28 +251,6 @@ static uint8* lf2crlf(uint8* data, int* size)
 	return outbuf;
 }
 
-static void crlf2lf(uint8* data, int* size)
-{
-	uint8 c;
-	uint8* out;
-	uint8* in;
-	uint8* in_end;
-
-	out = data;
-	in = data;
-	in_end = data + (*size);
-
-	while (in < in_end)
-	{
-		c = *in++;
-
-		if (c != '\r')
-			*out++ = c;
-	}
-
-	*size = out - data;
-}
-
 static void be2le(uint8* data, int size)
 {
 	uint8 c;
@@ -812,31 +853,419 @@ static void xf_cliprdr_provide_targets(xfInfo* xfi, XEvent* respond)
 	}
 }
 
-static void xf_cliprdr_provide_data(xfInfo* xfi, XEvent* respond)
+/**
+ * Converts UTF-16LE to UTF-8 as long as the output has room for another
+ * character, dropping the carriage returns.
+ */
+static int xf_cliprdr_convert_unicodetext(uint8** pin, uint8* end, uint8* out, int size)
+{
+	uint32 wc;
+	uint32 low;
+	uint8* in = *pin;
+	uint8* p = out;
+
+	while ((end - in >= 2) && (out + size - p >= 4))
+	{
+		wc = in[0] | (in[1] << 8);
+		in += 2;
+
+		if (wc >= 0xD800 && wc <= 0xDBFF && end - in >= 2)
+		{
+			low = in[0] | (in[1] << 8);
+
+			if (low >= 0xDC00 && low <= 0xDFFF)
+			{
+				wc = 0x10000 + ((wc - 0xD800) << 10) + (low - 0xDC00);
+				in += 2;
+			}
+		}
+
+		if (wc == '\r')
+		{
+			continue;
+		}
+		else if (wc <= 0x7F)
+		{
+			*p++ = (uint8) wc;
+		}
+		else if (wc <= 0x07FF)
+		{
+			*p++ = (uint8) (0xC0 | (wc >> 6));
+			*p++ = (uint8) (0x80 | (wc & 0x3F));
+		}
+		else if (wc <= 0xFFFF)
+		{
+			*p++ = (uint8) (0xE0 | (wc >> 12));
+			*p++ = (uint8) (0x80 | ((wc >> 6) & 0x3F));
+			*p++ = (uint8) (0x80 | (wc & 0x3F));
+		}
+		else
+		{
+			*p++ = (uint8) (0xF0 | (wc >> 18));
+			*p++ = (uint8) (0x80 | ((wc >> 12) & 0x3F));
+			*p++ = (uint8) (0x80 | ((wc >> 6) & 0x3F));
+			*p++ = (uint8) (0x80 | (wc & 0x3F));
+		}
+	}
+
+	*pin = in;
+
+	return p - out;
+}
+
+/**
+ * Converts the server data from position on into out, writing at most
+ * size bytes. Returns the number of bytes written, 0 once done.
+ */
+static int xf_cliprdr_convert_data(clipboardData* data, int* position, uint8* out, int size)
+{
+	int n;
+	uint8* in;
+	uint8* end;
+	int length = 0;
+
+	if (*position < data->header_length)
+	{
+		n = MIN(data->header_length - *position, size);
+		memcpy(out, &data->header[*position], n);
+		*position += n;
+		length += n;
+
+		if (*position < data->header_length)
+			return length;
+	}
+
+	in = data->data + data->start + (*position - data->header_length);
+	end = data->data + data->end;
+
+	switch (data->format)
+	{
+		case CB_FORMAT_TEXT:
+		case CB_FORMAT_HTML:
+			while (in < end && length < size)
+			{
+				if (*in != '\r')
+					out[length++] = *in;
+				in++;
+			}
+			break;
+
+		case CB_FORMAT_UNICODETEXT:
+			length += xf_cliprdr_convert_unicodetext(&in, end, out + length, size - length);
+			break;
+
+		default:
+			n = MIN(end - in, size - length);
+			memcpy(out + length, in, n);
+			in += n;
+			length += n;
+			break;
+	}
+
+	*position = data->header_length + (in - data->data - data->start);
+
+	return length;
+}
+
+/**
+ * Image formats are handed to X as they are, without any copy.
+ */
+static boolean xf_cliprdr_data_is_raw(clipboardData* data)
+{
+	if (data->header_length > 0)
+		return false;
+
+	switch (data->format)
+	{
+		case CB_FORMAT_TEXT:
+		case CB_FORMAT_UNICODETEXT:
+		case CB_FORMAT_HTML:
+			return false;
+
+		default:
+			return true;
+	}
+}
+
+static int xf_cliprdr_get_data_bound(clipboardData* data)
+{
+	int length;
+
+	length = data->end - data->start;
+
+	/* a UTF-16 unit becomes at most 3 bytes of UTF-8 */
+	if (data->format == CB_FORMAT_UNICODETEXT)
+		length = length / 2 * 3 + 4;
+
+	return data->header_length + length;
+}
+
+static int xf_cliprdr_get_chunk(clipboardContext* cb, clipboardData* data, int* position, uint8** chunk)
+{
+	int length;
+
+	if (xf_cliprdr_data_is_raw(data))
+	{
+		length = MIN(data->end - data->start - *position, cb->max_chunk);
+		*chunk = data->data + data->start + *position;
+		*position += length;
+		return length;
+	}
+
+	if (cb->chunk == NULL)
+		cb->chunk = (uint8*) xmalloc(cb->max_chunk);
+
+	*chunk = cb->chunk;
+
+	return xf_cliprdr_convert_data(data, position, cb->chunk, cb->max_chunk);
+}
+
+static boolean xf_cliprdr_requestor_error = false;
+static int (*xf_cliprdr_def_error_handler)(Display*, XErrorEvent*);
+
+static int xf_cliprdr_error_handler(Display* display, XErrorEvent* event)
+{
+	xf_cliprdr_requestor_error = true;
+	return 0;
+}
+
+/**
+ * Requestor windows belong to other clients and may be gone by the time
+ * we write to them, the BadWindow errors are trapped instead of aborting.
+ */
+static void xf_cliprdr_trap_errors(xfInfo* xfi)
+{
+	xf_cliprdr_requestor_error = false;
+	XSync(xfi->display, False);
+	xf_cliprdr_def_error_handler = XSetErrorHandler(xf_cliprdr_error_handler);
+}
+
+static boolean xf_cliprdr_untrap_errors(xfInfo* xfi)
 {
+	XSync(xfi->display, False);
+	XSetErrorHandler(xf_cliprdr_def_error_handler);
+
+	return xf_cliprdr_requestor_error;
+}
+
+/**
+ * Drops the transfers to a requestor window that is gone, without
+ * making any more calls on it.
+ */
+static boolean xf_cliprdr_drop_transfers(xfInfo* xfi, Window requestor)
+{
+	boolean dropped = false;
+	clipboardTransfer* transfer;
 	clipboardContext* cb = (clipboardContext*) xfi->clipboard_context;
 
-	if (respond->xselection.property != None)
+	transfer = (clipboardTransfer*) list_peek(cb->transfers);
+
+	while (transfer != NULL)
 	{
-		XChangeProperty(xfi->display,
-			respond->xselection.requestor,
-			respond->xselection.property,
-			respond->xselection.target, 8, PropModeReplace,
-			(uint8*) cb->data, cb->data_length);
+		if (transfer->requestor == requestor)
+		{
+			DEBUG_X11_CLIPRDR("drop transfer to 0x%lx", requestor);
+			list_remove(cb->transfers, transfer);
+			xfree(transfer);
+			dropped = true;
+			transfer = (clipboardTransfer*) list_peek(cb->transfers);
+		}
+		else
+		{
+			transfer = (clipboardTransfer*) list_next(cb->transfers, transfer);
+		}
 	}
+
+	return dropped;
 }
 
-static void xf_cliprdr_process_cb_format_list_event(xfInfo* xfi, RDP_CB_FORMAT_LIST_EVENT* event)
+static void xf_cliprdr_end_transfer(xfInfo* xfi, clipboardTransfer* transfer)
 {
-	int i, j;
+	clipboardTransfer* other;
+	clipboardContext* cb = (clipboardContext*) xfi->clipboard_context;
+
+	list_remove(cb->transfers, transfer);
+
+	/* keep listening while another transfer goes to the same window */
+	for (other = (clipboardTransfer*) list_peek(cb->transfers); other != NULL;
+		other = (clipboardTransfer*) list_next(cb->transfers, other))
+	{
+		if (other->requestor == transfer->requestor)
+			break;
+	}
+
+	if (other == NULL)
+	{
+		xf_cliprdr_trap_errors(xfi);
+		XSelectInput(xfi->display, transfer->requestor, NoEventMask);
+		xf_cliprdr_untrap_errors(xfi);
+	}
+
+	xfree(transfer);
+}
+
+/**
+ * Ends the transfers whose requestor stopped reading, a client that hangs
+ * or never deletes the property would otherwise keep its data forever.
+ */
+static void xf_cliprdr_expire_transfers(xfInfo* xfi)
+{
+	time_t now;
+	clipboardTransfer* transfer;
+	clipboardContext* cb = (clipboardContext*) xfi->clipboard_context;
+
+	now = time(NULL);
+	transfer = (clipboardTransfer*) list_peek(cb->transfers);
+
+	while (transfer != NULL)
+	{
+		if (now - transfer->time > XF_CLIPRDR_TRANSFER_TIMEOUT)
+		{
+			DEBUG_X11_CLIPRDR("transfer to 0x%lx timed out", transfer->requestor);
+			xf_cliprdr_end_transfer(xfi, transfer);
+			transfer = (clipboardTransfer*) list_peek(cb->transfers);
+		}
+		else
+		{
+			transfer = (clipboardTransfer*) list_next(cb->transfers, transfer);
+		}
+	}
+}
+
+static clipboardData* xf_cliprdr_find_data(clipboardContext* cb, uint32 format, uint32 alt_format)
+{
+	clipboardData* data;
+
+	for (data = (clipboardData*) list_peek(cb->cache); data != NULL;
+		data = (clipboardData*) list_next(cb->cache, data))
+	{
+		if (data->format == format && data->alt_format == alt_format)
+			return data;
+	}
+
+	return NULL;
+}
+
+/**
+ * Frees the cached server data once the server announces new formats.
+ * Transfers still running are ended with an empty chunk, the requestors
+ * get what was sent so far.
+ */
+static void xf_cliprdr_free_data(xfInfo* xfi)
+{
+	clipboardData* data;
+	clipboardTransfer* transfer;
+	clipboardContext* cb = (clipboardContext*) xfi->clipboard_context;
+
+	while ((transfer = (clipboardTransfer*) list_peek(cb->transfers)) != NULL)
+	{
+		xf_cliprdr_trap_errors(xfi);
+		XChangeProperty(xfi->display, transfer->requestor, transfer->property,
+			transfer->target, 8, PropModeReplace, NULL, 0);
+
+		if (xf_cliprdr_untrap_errors(xfi))
+			xf_cliprdr_drop_transfers(xfi, transfer->requestor);
+		else
+			xf_cliprdr_end_transfer(xfi, transfer);
+	}
+
+	while ((data = (clipboardData*) list_dequeue(cb->cache)) != NULL)
+	{
+		xfree(data->data);
+		xfree(data);
+	}
+}
+
+/**
+ * Converts the data into the requestor property, the caller traps the
+ * errors of the requestor window.
+ */
+static void xf_cliprdr_provide_data(xfInfo* xfi, clipboardData* data, XEvent* respond)
+{
+	long length;
+	int position;
+	uint8* chunk;
+	clipboardTransfer* transfer;
+	clipboardContext* cb = (clipboardContext*) xfi->clipboard_context;
+
+	if (respond->xselection.property == None)
+		return;
+
+	if (xf_cliprdr_get_data_bound(data) > cb->max_chunk)
+	{
+		DEBUG_X11_CLIPRDR("INCR transfer of %d bytes", data->length);
+
+		transfer = xnew(clipboardTransfer);
+		transfer->requestor = respond->xselection.requestor;
+		transfer->property = respond->xselection.property;
+		transfer->target = respond->xselection.target;
+		transfer->data = data;
+		transfer->time = time(NULL);
+		list_enqueue(cb->transfers, transfer);
+
+		/* the size announced with INCR is only a lower bound */
+		length = data->end - data->start;
+		XSelectInput(xfi->display, transfer->requestor, PropertyChangeMask | StructureNotifyMask);
+		XChangeProperty(xfi->display, transfer->requestor, transfer->property,
+			cb->incr_atom, 32, PropModeReplace, (uint8*) &length, 1);
+
+		return;
+	}
+
+	position = 0;
+	length = xf_cliprdr_get_chunk(cb, data, &position, &chunk);
+
+	XChangeProperty(xfi->display,
+		respond->xselection.requestor,
+		respond->xselection.property,
+		respond->xselection.target, 8, PropModeReplace,
+		chunk, length);
+}
+
+static boolean xf_cliprdr_continue_transfer(xfInfo* xfi, XEvent* xevent)
+{
+	int length;
+	uint8* chunk;
+	clipboardTransfer* transfer;
 	clipboardContext* cb = (clipboardContext*) xfi->clipboard_context;
 
-	if (cb->data)
+	for (transfer = (clipboardTransfer*) list_peek(cb->transfers); transfer != NULL;
+		transfer = (clipboardTransfer*) list_next(cb->transfers, transfer))
 	{
-		xfree(cb->data);
-		cb->data = NULL;
+		if (transfer->requestor == xevent->xproperty.window &&
+			transfer->property == xevent->xproperty.atom)
+			break;
 	}
 
+	if (transfer == NULL)
+		return false;
+
+	/* the requestor deletes the property when it is ready for the next chunk */
+	if (xevent->xproperty.state != PropertyDelete)
+		return true;
+
+	length = xf_cliprdr_get_chunk(cb, transfer->data, &transfer->position, &chunk);
+	transfer->time = time(NULL);
+
+	xf_cliprdr_trap_errors(xfi);
+	XChangeProperty(xfi->display, transfer->requestor, transfer->property,
+		transfer->target, 8, PropModeReplace, chunk, length);
+
+	if (xf_cliprdr_untrap_errors(xfi))
+		xf_cliprdr_drop_transfers(xfi, transfer->requestor);
+	else if (length == 0) /* the empty chunk ends the transfer */
+		xf_cliprdr_end_transfer(xfi, transfer);
+
+	return true;
+}
+
+static void xf_cliprdr_process_cb_format_list_event(xfInfo* xfi, RDP_CB_FORMAT_LIST_EVENT* event)
+{
+	int i, j;
+	clipboardContext* cb = (clipboardContext*) xfi->clipboard_context;
+
+	xf_cliprdr_free_data(xfi);
+
 	if (cb->formats)
 		xfree(cb->formats);
 
@@ -869,26 +1298,36 @@ static void xf_cliprdr_process_cb_format_list_event(xfInfo* xfi, RDP_CB_FORMAT_L
 	XFlush(xfi->display);
 }
 
-static void xf_cliprdr_process_text(clipboardContext* cb, uint8* data, int size)
+/**
+ * The process functions only look at the data received from the server,
+ * it is converted later on, while it is handed to X.
+ */
+
+static boolean xf_cliprdr_process_text(clipboardData* cb_data, uint8* data, int size)
 {
-	cb->data = (uint8*) xmalloc(size);
-	memcpy(cb->data, data, size);
-	cb->data_length = size;
-	crlf2lf(cb->data, &cb->data_length);
+	uint8* end;
+
+	end = (uint8*) memchr(data, 0, size);
+	cb_data->end = (end ? end - data : size);
+
+	return true;
 }
 
-static void xf_cliprdr_process_unicodetext(clipboardContext* cb, uint8* data, int size)
+static boolean xf_cliprdr_process_unicodetext(clipboardData* cb_data, uint8* data, int size)
 {
-	UNICONV* uniconv;
+	int i;
 
-	uniconv = freerdp_uniconv_new();
-	cb->data = (uint8*) freerdp_uniconv_in(uniconv, data, size);
-	freerdp_uniconv_free(uniconv);
-	cb->data_length = strlen((char*) cb->data);
-	crlf2lf(cb->data, &cb->data_length);
+	for (i = 0; i + 1 < size; i += 2)
+	{
+		if (data[i] == 0 && data[i + 1] == 0)
+			break;
+	}
+	cb_data->end = i;
+
+	return true;
 }
 
-static void xf_cliprdr_process_dib(clipboardContext* cb, uint8* data, int size)
+static boolean xf_cliprdr_process_dib(clipboardData* cb_data, uint8* data, int size)
 {
 	STREAM* s;
 	uint16 bpp;
@@ -899,7 +1338,7 @@ static void xf_cliprdr_process_dib(clipboardContext* cb, uint8* data, int size)
 	if (size < 40)
 	{
 		DEBUG_X11_CLIPRDR("dib size %d too short", size);
-		return;
+		return false;
 	}
 
 	s = stream_new(0);
@@ -913,21 +1352,22 @@ static void xf_cliprdr_process_dib(clipboardContext* cb, uint8* data, int size)
 
 	DEBUG_X11_CLIPRDR("offset=%d bpp=%d ncolors=%d", offset, bpp, ncolors);
 
-	s = stream_new(14 + size);
+	/* the BMP file header goes in front of the DIB */
+	s = stream_new(0);
+	stream_attach(s, cb_data->header, sizeof(cb_data->header));
 	stream_write_uint8(s, 'B');
 	stream_write_uint8(s, 'M');
 	stream_write_uint32(s, 14 + size);
 	stream_write_uint32(s, 0);
 	stream_write_uint32(s, offset);
-	stream_write(s, data, size);
-
-	cb->data = stream_get_head(s);
-	cb->data_length = stream_get_length(s);
+	cb_data->header_length = stream_get_length(s);
 	stream_detach(s);
 	stream_free(s);
+
+	return true;
 }
 
-static void xf_cliprdr_process_html(clipboardContext* cb, uint8* data, int size)
+static boolean xf_cliprdr_process_html(clipboardData* cb_data, uint8* data, int size)
 {
 	char* start_str;
 	char* end_str;
@@ -939,24 +1379,26 @@ static void xf_cliprdr_process_html(clipboardContext* cb, uint8* data, int size)
 	if (start_str == NULL || end_str == NULL)
 	{
 		DEBUG_X11_CLIPRDR("invalid HTML clipboard format");
-		return;
+		return false;
 	}
 	start = atoi(start_str + 10);
 	end = atoi(end_str + 8);
 	if (start > size || end > size || start >= end)
 	{
 		DEBUG_X11_CLIPRDR("invalid HTML offset");
-		return;
+		return false;
 	}
 
-	cb->data = (uint8*) xmalloc(size - start + 1);
-	memcpy(cb->data, data + start, end - start);
-	cb->data_length = end - start;
-	crlf2lf(cb->data, &cb->data_length);
+	cb_data->start = start;
+	cb_data->end = end;
+
+	return true;
 }
 
 static void xf_cliprdr_process_cb_data_response_event(xfInfo* xfi, RDP_CB_DATA_RESPONSE_EVENT* event)
 {
+	boolean status;
+	clipboardData* data = NULL;
 	clipboardContext* cb = (clipboardContext*) xfi->clipboard_context;
 
 	DEBUG_X11_CLIPRDR("size=%d", event->size);
@@ -973,48 +1415,70 @@ static void xf_cliprdr_process_cb_data_response_event(xfInfo* xfi, RDP_CB_DATA_R
 	}
 	else
 	{
-		if (cb->data)
-		{
-			xfree(cb->data);
-			cb->data = NULL;
-		}
-		switch (cb->data_format)
+		/* the data stays as received, no copy is made */
+		data = xnew(clipboardData);
+		data->format = cb->data_format;
+		data->alt_format = cb->data_alt_format;
+		data->data = event->data;
+		data->length = event->size;
+		data->end = event->size;
+		event->data = NULL;
+		event->size = 0;
+
+		switch (data->format)
 		{
 			case CB_FORMAT_RAW:
 			case CB_FORMAT_PNG:
 			case CB_FORMAT_JPEG:
 			case CB_FORMAT_GIF:
-				cb->data = event->data;
-				cb->data_length = event->size;
-				event->data = NULL;
-				event->size = 0;
+				status = true;
 				break;
 
 			case CB_FORMAT_TEXT:
-				xf_cliprdr_process_text(cb, event->data, event->size);
+				status = xf_cliprdr_process_text(data, data->data, data->length);
 				break;
 
 			case CB_FORMAT_UNICODETEXT:
-				xf_cliprdr_process_unicodetext(cb, event->data, event->size);
+				status = xf_cliprdr_process_unicodetext(data, data->data, data->length);
 				break;
 
 			case CB_FORMAT_DIB:
-				xf_cliprdr_process_dib(cb, event->data, event->size);
+				status = xf_cliprdr_process_dib(data, data->data, data->length);
 				break;
 
 			case CB_FORMAT_HTML:
-				xf_cliprdr_process_html(cb, event->data, event->size);
+				status = xf_cliprdr_process_html(data, data->data, data->length);
 				break;
 
 			default:
-				cb->respond->xselection.property = None;
+				status = false;
 				break;
 		}
-		xf_cliprdr_provide_data(xfi, cb->respond);
+
+		if (status)
+		{
+			list_enqueue(cb->cache, data);
+		}
+		else
+		{
+			xfree(data->data);
+			xfree(data);
+			data = NULL;
+			cb->respond->xselection.property = None;
+		}
 	}
 
+	/* the requestor may have gone away while the server was asked */
+	xf_cliprdr_trap_errors(xfi);
+
+	if (cb->respond->xselection.property != None)
+		xf_cliprdr_provide_data(xfi, data, cb->respond);
+
 	XSendEvent(xfi->display, cb->respond->xselection.requestor, 0, 0, cb->respond);
-	XFlush(xfi->display);
+
+	if (xf_cliprdr_untrap_errors(xfi))
+		xf_cliprdr_drop_transfers(xfi, cb->respond->xselection.requestor);
+
 	xfree(cb->respond);
 	cb->respond = NULL;
 }
@@ -1079,6 +1543,7 @@ boolean xf_cliprdr_process_selection_request(xfInfo* xfi, XEvent* xevent)
 	uint32 alt_format;
 	uint8* data = NULL;
 	boolean delay_respond;
+	clipboardData* cb_data;
 	unsigned long length, bytes_left;
 	clipboardContext* cb = (clipboardContext*) xfi->clipboard_context;
 
@@ -1100,6 +1565,9 @@ boolean xf_cliprdr_process_selection_request(xfInfo* xfi, XEvent* xevent)
 	respond->xselection.target = xevent->xselectionrequest.target;
 	respond->xselection.time = xevent->xselectionrequest.time;
 
+	xf_cliprdr_expire_transfers(xfi);
+	xf_cliprdr_trap_errors(xfi);
+
 	if (xevent->xselectionrequest.target == cb->targets[0]) /* TIMESTAMP */
 	{
 		/* TODO */
@@ -1137,11 +1605,12 @@ boolean xf_cliprdr_process_selection_request(xfInfo* xfi, XEvent* xevent)
 				}
 			}
 			DEBUG_X11_CLIPRDR("provide format 0x%04x alt_format 0x%04x", format, alt_format);
-			if ((cb->data != 0) && (format == cb->data_format) && (alt_format == cb->data_alt_format))
+			cb_data = xf_cliprdr_find_data(cb, format, alt_format);
+			if (cb_data != NULL)
 			{
 				/* Cached clipboard data available. Send it now */
 				respond->xselection.property = xevent->xselectionrequest.property;
-				xf_cliprdr_provide_data(xfi, respond);
+				xf_cliprdr_provide_data(xfi, cb_data, respond);
 			}
 			else if (cb->respond)
 			{
@@ -1153,12 +1622,6 @@ boolean xf_cliprdr_process_selection_request(xfInfo* xfi, XEvent* xevent)
 				 * Send clipboard data request to the server.
 				 * Response will be postponed after receiving the data
 				 */
-				if (cb->data)
-				{
-					xfree(cb->data);
-					cb->data = NULL;
-				}
-
 				respond->xselection.property = xevent->xselectionrequest.property;
 				cb->respond = respond;
 				cb->data_format = format;
@@ -1173,10 +1636,12 @@ boolean xf_cliprdr_process_selection_request(xfInfo* xfi, XEvent* xevent)
 	if (delay_respond == false)
 	{
 		XSendEvent(xfi->display, xevent->xselectionrequest.requestor, 0, 0, respond);
-		XFlush(xfi->display);
 		xfree(respond);
 	}
 
+	if (xf_cliprdr_untrap_errors(xfi))
+		xf_cliprdr_drop_transfers(xfi, xevent->xselectionrequest.requestor);
+
 	return true;
 }
 
@@ -1196,6 +1661,11 @@ boolean xf_cliprdr_process_property_notify(xfInfo* xfi, XEvent* xevent)
 {
 	clipboardContext* cb = (clipboardContext*) xfi->clipboard_context;
 
+	xf_cliprdr_expire_transfers(xfi);
+
+	if (xf_cliprdr_continue_transfer(xfi, xevent))
+		return true;
+
 	if (xevent->xproperty.atom != cb->property_atom)
 		return false; /* Not cliprdr-related */
 
@@ -1216,6 +1686,12 @@ boolean xf_cliprdr_process_property_notify(xfInfo* xfi, XEvent* xevent)
 	return true;
 }
 
+boolean xf_cliprdr_process_destroy_notify(xfInfo* xfi, XEvent* xevent)
+{
+	/* the window is gone, its transfers end without touching it again */
+	return xf_cliprdr_drop_transfers(xfi, xevent->xdestroywindow.window);
+}
+
 void xf_cliprdr_check_owner(xfInfo* xfi)
 {
 	Window owner;
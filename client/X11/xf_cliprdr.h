@@ -29,6 +29,7 @@ boolean xf_cliprdr_process_selection_notify(xfInfo* xfi, XEvent* xevent);
 boolean xf_cliprdr_process_selection_request(xfInfo* xfi, XEvent* xevent);
 boolean xf_cliprdr_process_selection_clear(xfInfo* xfi, XEvent* xevent);
 boolean xf_cliprdr_process_property_notify(xfInfo* xfi, XEvent* xevent);
+boolean xf_cliprdr_process_destroy_notify(xfInfo* xfi, XEvent* xevent);
 void xf_cliprdr_check_owner(xfInfo* xfi);
 
 #ifdef WITH_DEBUG_X11_CLIPRDR
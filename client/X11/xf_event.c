@@ -534,6 +534,10 @@ static boolean xf_event_MapNotify(xfInfo* xfi, XEvent* event, boolean app)
 	rdpUpdate* update = xfi->instance->update;
 	rdpRail* rail = ((rdpContext*) xfi->context)->rail;
 
+	/* clipboard requestors report their structure too, only the main window counts */
+	if (app != true && event->xany.window != xfi->drawable)
+		return true;
+
 	if (app != true)
 	{
 		if (xfi->suppress_output == true)
@@ -571,6 +575,10 @@ static boolean xf_event_UnmapNotify(xfInfo* xfi, XEvent* event, boolean app)
 	rdpUpdate* update = xfi->instance->update;
 	rdpRail* rail = ((rdpContext*) xfi->context)->rail;
 
+	/* clipboard requestors report their structure too, only the main window counts */
+	if (app != true && event->xany.window != xfi->drawable)
+		return true;
+
 	xf_kbd_release_all_keypress(xfi);
 
 	if (app != true)
@@ -628,6 +636,17 @@ static boolean xf_event_SelectionClear(xfInfo* xfi, XEvent* event, boolean app)
 	return true;
 }
 
+static boolean xf_event_DestroyNotify(xfInfo* xfi, XEvent* event, boolean app)
+{
+	if (app != true)
+	{
+		if (xf_cliprdr_process_destroy_notify(xfi, event))
+			return true;
+	}
+
+	return true;
+}
+
 static boolean xf_event_PropertyNotify(xfInfo* xfi, XEvent* event, boolean app)
 {
 	//This section handles sending the appropriate commands to the rail server
@@ -898,6 +917,10 @@ boolean xf_event_process(freerdp* instance, XEvent* event)
 			status = xf_event_UnmapNotify(xfi, event, xfi->remote_app);
 			break;
 
+		case DestroyNotify:
+			status = xf_event_DestroyNotify(xfi, event, xfi->remote_app);
+			break;
+
 		case ReparentNotify:
 			break;
 
@@ -31,6 +31,7 @@
 #include <freerdp/codec/bitmap.h>
 
 #include "xf_gdi.h"
+#include "xf_shm.h"
 
 static const uint8 xf_rop2_table[] =
 {
@@ -465,6 +466,47 @@ void xf_gdi_opaque_rect(rdpContext* context, OPAQUE_RECT_ORDER* opaque_rect)
 	}
 }
 
+void xf_gdi_opaque_rect_batch(rdpContext* context, OPAQUE_RECT_ORDER* opaque_rect, int count)
+{
+	int i, j, k;
+	uint32 color;
+	XRectangle rectangles[PRIMARY_ORDER_BATCH_SIZE];
+	xfContext* context_ = (xfContext*) context;
+	xfInfo* xfi = context_->xfi;
+
+	XSetFunction(xfi->display, xfi->gc, GXcopy);
+	XSetFillStyle(xfi->display, xfi->gc, FillSolid);
+
+	for (i = 0; i < count; i = j)
+	{
+		/* each run of rectangles of the same color is a single request */
+		for (j = i; (j < count) && (opaque_rect[j].color == opaque_rect[i].color); j++)
+		{
+			rectangles[j - i].x = opaque_rect[j].nLeftRect;
+			rectangles[j - i].y = opaque_rect[j].nTopRect;
+			rectangles[j - i].width = opaque_rect[j].nWidth;
+			rectangles[j - i].height = opaque_rect[j].nHeight;
+		}
+
+		color = freerdp_color_convert_var(opaque_rect[i].color, context_->settings->color_depth, xfi->bpp, xfi->clrconv);
+		XSetForeground(xfi->display, xfi->gc, color);
+
+		XFillRectangles(xfi->display, xfi->drawing, xfi->gc, rectangles, j - i);
+
+		if (xfi->drawing == xfi->primary)
+		{
+			if (xfi->remote_app != true)
+				XFillRectangles(xfi->display, xfi->drawable, xfi->gc, rectangles, j - i);
+
+			for (k = i; k < j; k++)
+			{
+				gdi_InvalidateRegion(xfi->hdc, opaque_rect[k].nLeftRect, opaque_rect[k].nTopRect,
+						opaque_rect[k].nWidth, opaque_rect[k].nHeight);
+			}
+		}
+	}
+}
+
 void xf_gdi_multi_opaque_rect(rdpContext* context, MULTI_OPAQUE_RECT_ORDER* multi_opaque_rect)
 {
 	int i;
@@ -636,6 +678,43 @@ void xf_gdi_memblt(rdpContext* context, MEMBLT_ORDER* memblt)
 	XSetFunction(xfi->display, xfi->gc, GXcopy);
 }
 
+void xf_gdi_memblt_batch(rdpContext* context, MEMBLT_ORDER* memblt, int count)
+{
+	int i;
+	xfBitmap* bitmap;
+	xfInfo* xfi = ((xfContext*) context)->xfi;
+
+	/* all orders of a batch share the ROP */
+	xf_set_rop3(xfi, gdi_rop3_code(memblt[0].bRop));
+
+	for (i = 0; i < count; i++)
+	{
+		bitmap = (xfBitmap*) memblt[i].bitmap;
+
+		if (bitmap == NULL)
+			continue;
+
+		XCopyArea(xfi->display, bitmap->pixmap, xfi->drawing, xfi->gc,
+				memblt[i].nXSrc, memblt[i].nYSrc, memblt[i].nWidth, memblt[i].nHeight,
+				memblt[i].nLeftRect, memblt[i].nTopRect);
+
+		if (xfi->drawing == xfi->primary)
+		{
+			if (xfi->remote_app != true)
+			{
+				XCopyArea(xfi->display, bitmap->pixmap, xfi->drawable, xfi->gc,
+					memblt[i].nXSrc, memblt[i].nYSrc, memblt[i].nWidth, memblt[i].nHeight,
+					memblt[i].nLeftRect, memblt[i].nTopRect);
+			}
+
+			gdi_InvalidateRegion(xfi->hdc, memblt[i].nLeftRect, memblt[i].nTopRect,
+					memblt[i].nWidth, memblt[i].nHeight);
+		}
+	}
+
+	XSetFunction(xfi->display, xfi->gc, GXcopy);
+}
+
 void xf_gdi_mem3blt(rdpContext* context, MEM3BLT_ORDER* mem3blt)
 {
 	rdpBrush* brush;
@@ -972,6 +1051,7 @@ uint8* xf_gdi_surface_bitmap_flip(SURFACE_BITS_COMMAND* command, uint8* src_data
 void xf_gdi_surface_rfx_process(rdpContext* context, SURFACE_BITS_COMMAND* command, void* pContext)
 {
 	int i;
+	int slot;
 	int tx, ty;
 	xfInfo* xfi = ((xfContext*) context)->xfi;
 	RECTANGLE_16 dest_rect;
@@ -996,12 +1076,29 @@ void xf_gdi_surface_rfx_process(rdpContext* context, SURFACE_BITS_COMMAND* comma
 	/* Draw the tiles to primary surface, each is 64x64. */
 	for (i = 0; i < message->num_tiles; i++)
 	{
-		image = XCreateImage(xfi->display, xfi->visual, 24, ZPixmap, 0,
-			(char*) message->tiles[i]->data, 64, 64, 32, 0);
-
 		tx = message->tiles[i]->x + command->destLeft;
 		ty = message->tiles[i]->y + command->destTop;
 
+		if (xfi->tiles_image)
+		{
+			/* stage tiles in the shared strip, waiting only when it wraps around */
+			slot = i % XF_SHM_TILE_COUNT;
+
+			if (slot == 0)
+				IFCALL(xfi->AsyncDrawingLock, xfi);
+
+			memcpy(xfi->tiles_image->data + slot * 64 * 64 * 4, message->tiles[i]->data, 64 * 64 * 4);
+			xf_shm_put_image(xfi, xfi->primary, xfi->tiles_image, 0, slot * 64, tx, ty, 64, 64);
+
+			if ((slot == XF_SHM_TILE_COUNT - 1) || (i == message->num_tiles - 1))
+				IFCALL(xfi->AsyncDrawingUnlock, xfi);
+
+			continue;
+		}
+
+		image = XCreateImage(xfi->display, xfi->visual, 24, ZPixmap, 0,
+			(char*) message->tiles[i]->data, 64, 64, 32, 0);
+
 		XPutImage(xfi->display, xfi->primary, xfi->gc, image, 0, 0, tx, ty, 64, 64);
 		XFree(image);
 	}
@@ -1143,6 +1240,8 @@ void xf_gdi_register_update_callbacks(rdpUpdate* update)
 	primary->PolygonCB = xf_gdi_polygon_cb;
 	primary->EllipseSC = xf_gdi_ellipse_sc;
 	primary->EllipseCB = xf_gdi_ellipse_cb;
+	primary->OpaqueRectBatch = xf_gdi_opaque_rect_batch;
+	primary->MemBltBatch = xf_gdi_memblt_batch;
 
 	update->SurfaceBits = xf_gdi_surface_bits;
 	update->SurfaceFrameMarker = xf_gdi_surface_frame_marker;
@@ -0,0 +1,255 @@
+/**
+ * FreeRDP: A Remote Desktop Protocol Client
+ * X11 Asynchronous Presentation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * The software GDI decodes into the primary buffer on the session thread.
+ * Instead of pushing every EndPaint to the X server, damage is accumulated
+ * and a present thread uploads the union at a fixed rate, so intermediate
+ * frames are dropped when the server sends faster than we can display.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <X11/Xlib.h>
+#include <freerdp/utils/memory.h>
+#include <freerdp/utils/thread.h>
+
+#include "xf_present.h"
+
+uint64 xf_present_get_time(void)
+{
+	struct timeval tp;
+
+	gettimeofday(&tp, 0);
+
+	return ((uint64) tp.tv_sec) * 1000000 + tp.tv_usec;
+}
+
+static void xf_present_add_rect(xfPresent* present, sint32 x, sint32 y, uint32 w, uint32 h)
+{
+	int i;
+	int x1, y1, x2, y2;
+	XRectangle* rect;
+
+	if (w < 1 || h < 1)
+		return;
+
+	for (i = 0; i < present->ndamage; i++)
+	{
+		rect = &present->damage[i];
+
+		if ((x >= rect->x) && (y >= rect->y) &&
+			(x + w <= rect->x + rect->width) && (y + h <= rect->y + rect->height))
+			return;
+	}
+
+	if (present->ndamage >= XF_PRESENT_MAX_RECTS)
+	{
+		/* too fragmented, collapse everything into the bounding box */
+		x1 = x;
+		y1 = y;
+		x2 = x + w;
+		y2 = y + h;
+
+		for (i = 0; i < present->ndamage; i++)
+		{
+			rect = &present->damage[i];
+			x1 = MIN(x1, rect->x);
+			y1 = MIN(y1, rect->y);
+			x2 = MAX(x2, rect->x + rect->width);
+			y2 = MAX(y2, rect->y + rect->height);
+		}
+
+		x = x1;
+		y = y1;
+		w = x2 - x1;
+		h = y2 - y1;
+		present->ndamage = 0;
+	}
+
+	rect = &present->damage[present->ndamage++];
+	rect->x = x;
+	rect->y = y;
+	rect->width = w;
+	rect->height = h;
+}
+
+/**
+ * The damage is taken under the present mutex, then uploaded with only the
+ * display lock held: the session thread may need the display while it paints,
+ * and the window can be recreated by a fullscreen toggle under that lock.
+ * A paint racing with the upload adds its damage again for the next tick.
+ */
+
+static void xf_present_flush(xfPresent* present)
+{
+	int i;
+	int ndamage;
+	uint64 latency;
+	XRectangle* rect;
+	XRectangle damage[XF_PRESENT_MAX_RECTS];
+	xfInfo* xfi = present->xfi;
+	rdpGdi* gdi = xfi->instance->context->gdi;
+
+	freerdp_thread_lock(present->thread);
+
+	ndamage = present->ndamage;
+
+	if (ndamage < 1)
+	{
+		freerdp_thread_unlock(present->thread);
+		return;
+	}
+
+	memcpy(damage, present->damage, sizeof(XRectangle) * ndamage);
+
+	latency = xf_present_get_time() - present->frame_arrival_time;
+
+	present->frames_presented++;
+	present->frames_coalesced += present->paints - 1;
+	present->latency_total += latency;
+
+	if (latency > present->latency_max)
+		present->latency_max = latency;
+
+	present->ndamage = 0;
+	present->paints = 0;
+
+	freerdp_thread_unlock(present->thread);
+
+	IFCALL(xfi->PrimarySurfaceLock, xfi);
+	IFCALL(xfi->AsyncDrawingLock, xfi);
+
+	for (i = 0; i < ndamage; i++)
+	{
+		rect = &damage[i];
+
+		/* the desktop may have been resized since the damage was taken */
+		if (rect->x >= gdi->width || rect->y >= gdi->height)
+			continue;
+
+		xf_sw_put_image(xfi, gdi, rect->x, rect->y,
+			MIN(rect->width, gdi->width - rect->x), MIN(rect->height, gdi->height - rect->y));
+	}
+
+	IFCALL(xfi->AsyncDrawingUnlock, xfi);
+	IFCALL(xfi->PrimarySurfaceUnlock, xfi);
+
+	XFlush(xfi->display);
+}
+
+static void* xf_present_thread_func(void* arg)
+{
+	xfPresent* present = (xfPresent*) arg;
+
+	while (1)
+	{
+		freerdp_thread_wait_timeout(present->thread, present->interval_ms);
+
+		if (freerdp_thread_is_stopped(present->thread))
+			break;
+
+		freerdp_thread_reset(present->thread);
+		xf_present_flush(present);
+	}
+
+	freerdp_thread_quit(present->thread);
+
+	return NULL;
+}
+
+/**
+ * Records when the session thread woke up for incoming data,
+ * this is the reference point for the present latency.
+ */
+void xf_present_mark_arrival(xfPresent* present)
+{
+	present->arrival_time = xf_present_get_time();
+}
+
+void xf_present_begin_paint(xfPresent* present)
+{
+	/* a failed update may skip EndPaint, keep the mutex balanced */
+	if (present->painting)
+		return;
+
+	freerdp_thread_lock(present->thread);
+	present->painting = true;
+}
+
+void xf_present_end_paint(xfPresent* present, HGDI_RGN rects, int nrects)
+{
+	int i;
+
+	if (present->painting != true)
+		freerdp_thread_lock(present->thread);
+
+	if (nrects > 0)
+	{
+		if (present->paints == 0)
+			present->frame_arrival_time = present->arrival_time;
+
+		for (i = 0; i < nrects; i++)
+			xf_present_add_rect(present, rects[i].x, rects[i].y, rects[i].w, rects[i].h);
+
+		present->paints++;
+	}
+
+	present->painting = false;
+	freerdp_thread_unlock(present->thread);
+}
+
+xfPresent* xf_present_new(xfInfo* xfi, uint32 fps)
+{
+	xfPresent* present;
+
+	present = xnew(xfPresent);
+	present->xfi = xfi;
+	present->interval_ms = (fps > 0) ? 1000 / fps : 16;
+	present->thread = freerdp_thread_new();
+
+	freerdp_thread_start(present->thread, xf_present_thread_func, present);
+
+	return present;
+}
+
+void xf_present_free(xfPresent* present)
+{
+	if (present == NULL)
+		return;
+
+	if (present->painting)
+	{
+		present->painting = false;
+		freerdp_thread_unlock(present->thread);
+	}
+
+	freerdp_thread_stop(present->thread);
+	freerdp_thread_free(present->thread);
+
+	if (present->frames_presented > 0)
+	{
+		DEBUG_X11("%u frames presented, %u coalesced, latency avg %u us max %u us",
+			present->frames_presented, present->frames_coalesced,
+			(uint32) (present->latency_total / present->frames_presented),
+			(uint32) present->latency_max);
+	}
+
+	xfree(present);
+}
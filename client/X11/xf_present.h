@@ -0,0 +1,59 @@
+/**
+ * FreeRDP: A Remote Desktop Protocol Client
+ * X11 Asynchronous Presentation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __XF_PRESENT_H
+#define __XF_PRESENT_H
+
+#include <freerdp/utils/thread.h>
+
+#include "xfreerdp.h"
+
+#define XF_PRESENT_MAX_RECTS	64
+#define XF_PRESENT_MAX_FPS	240
+
+struct xf_present
+{
+	xfInfo* xfi;
+	freerdp_thread* thread;
+	uint32 interval_ms;
+	boolean painting;
+
+	/* damage accumulated since the last present, guarded by the thread mutex */
+	int ndamage;
+	XRectangle damage[XF_PRESENT_MAX_RECTS];
+	uint32 paints;
+	uint64 arrival_time;
+	uint64 frame_arrival_time;
+
+	/* statistics, microseconds */
+	uint32 frames_presented;
+	uint32 frames_coalesced;
+	uint64 latency_total;
+	uint64 latency_max;
+};
+typedef struct xf_present xfPresent;
+
+uint64 xf_present_get_time(void);
+
+xfPresent* xf_present_new(xfInfo* xfi, uint32 fps);
+void xf_present_free(xfPresent* present);
+
+void xf_present_begin_paint(xfPresent* present);
+void xf_present_end_paint(xfPresent* present, HGDI_RGN rects, int nrects);
+void xf_present_mark_arrival(xfPresent* present);
+
+#endif /* __XF_PRESENT_H */
@@ -0,0 +1,257 @@
+/**
+ * FreeRDP: A Remote Desktop Protocol Client
+ * X11 MIT-SHM Surfaces
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <X11/extensions/XShm.h>
+#include <freerdp/utils/memory.h>
+
+#include "xf_shm.h"
+
+#ifdef WITH_XSHM
+
+static boolean xf_shm_attach_failed;
+
+static int xf_shm_error_handler(Display* display, XErrorEvent* event)
+{
+	xf_shm_attach_failed = true;
+	return 0;
+}
+
+/**
+ * MIT-SHM only works when the X server can map our segment, which
+ * excludes TCP displays and forwarded (ssh -X) connections.
+ */
+static boolean xf_shm_display_is_local(Display* display)
+{
+	char* name = DisplayString(display);
+
+	if (name == NULL)
+		return false;
+
+	if (name[0] == ':' || strncmp(name, "unix:", 5) == 0)
+		return true;
+
+	return false;
+}
+
+XImage* xf_shm_image_new(xfInfo* xfi, XShmSegmentInfo* shminfo, int depth, int width, int height)
+{
+	XImage* image;
+	int (*handler)(Display*, XErrorEvent*);
+
+	shminfo->shmid = -1;
+	shminfo->shmaddr = (char*) -1;
+
+	image = XShmCreateImage(xfi->display, xfi->visual, depth,
+			ZPixmap, NULL, shminfo, width, height);
+
+	if (image == NULL)
+	{
+		DEBUG_X11("XShmCreateImage failed");
+		return NULL;
+	}
+
+	shminfo->shmid = shmget(IPC_PRIVATE, image->bytes_per_line * image->height, IPC_CREAT | 0600);
+
+	if (shminfo->shmid == -1)
+	{
+		DEBUG_X11("shmget failed");
+		XDestroyImage(image);
+		return NULL;
+	}
+
+	shminfo->readOnly = False;
+	shminfo->shmaddr = image->data = shmat(shminfo->shmid, 0, 0);
+
+	if (shminfo->shmaddr == ((char*) -1))
+	{
+		DEBUG_X11("shmat failed");
+		shmctl(shminfo->shmid, IPC_RMID, 0);
+		image->data = NULL;
+		XDestroyImage(image);
+		return NULL;
+	}
+
+	/* a failed attach is reported asynchronously, trap it instead of aborting */
+	xf_shm_attach_failed = false;
+	XSync(xfi->display, False);
+	handler = XSetErrorHandler(xf_shm_error_handler);
+	XShmAttach(xfi->display, shminfo);
+	XSync(xfi->display, False);
+	XSetErrorHandler(handler);
+
+	/* the segment is released as soon as both sides have detached */
+	shmctl(shminfo->shmid, IPC_RMID, 0);
+
+	if (xf_shm_attach_failed)
+	{
+		DEBUG_X11("XShmAttach failed");
+		shmdt(shminfo->shmaddr);
+		image->data = NULL;
+		XDestroyImage(image);
+		return NULL;
+	}
+
+	return image;
+}
+
+void xf_shm_image_free(xfInfo* xfi, XImage* image, XShmSegmentInfo* shminfo)
+{
+	if (image == NULL)
+		return;
+
+	XShmDetach(xfi->display, shminfo);
+	XSync(xfi->display, False);
+	shmdt(shminfo->shmaddr);
+
+	image->data = NULL;
+	XDestroyImage(image);
+}
+
+void xf_shm_put_image(xfInfo* xfi, Drawable drawable, XImage* image,
+		int src_x, int src_y, int dst_x, int dst_y, int width, int height)
+{
+	XShmPutImage(xfi->display, drawable, xfi->gc, image,
+			src_x, src_y, dst_x, dst_y, width, height, False);
+}
+
+boolean xf_shm_init(xfInfo* xfi)
+{
+	rdpGdi* gdi = xfi->instance->context->gdi;
+	rdpSettings* settings = xfi->instance->settings;
+
+	if (xfi->use_xshm != true)
+		return false;
+
+	if (XShmQueryExtension(xfi->display) != True || !xf_shm_display_is_local(xfi->display))
+	{
+		printf("MIT-SHM not available, using XPutImage\n");
+		xfi->use_xshm = false;
+		return false;
+	}
+
+	if (xfi->sw_gdi)
+	{
+		xfi->image = xf_shm_image_new(xfi, &xfi->image_shm_info, xfi->depth, xfi->width, xfi->height);
+
+		/* the primary buffer is copied row by row, formats must agree */
+		if (xfi->image && (xfi->image->bits_per_pixel != gdi->bytesPerPixel * 8))
+		{
+			xf_shm_image_free(xfi, xfi->image, &xfi->image_shm_info);
+			xfi->image = NULL;
+		}
+
+		if (xfi->image == NULL)
+		{
+			xfi->use_xshm = false;
+			return false;
+		}
+	}
+	else if (settings->rfx_codec)
+	{
+		/* RemoteFX tiles are decoded as 64x64 32bpp, same as the XCreateImage path */
+		xfi->tiles_image = xf_shm_image_new(xfi, &xfi->tiles_shm_info, 24, 64, 64 * XF_SHM_TILE_COUNT);
+
+		if (xfi->tiles_image && (xfi->tiles_image->bytes_per_line != 64 * 4))
+		{
+			xf_shm_image_free(xfi, xfi->tiles_image, &xfi->tiles_shm_info);
+			xfi->tiles_image = NULL;
+		}
+
+		if (xfi->tiles_image == NULL)
+		{
+			xfi->use_xshm = false;
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void xf_shm_uninit(xfInfo* xfi)
+{
+	if (xfi->use_xshm != true)
+		return;
+
+	IFCALL(xfi->AsyncDrawingLock, xfi);
+
+	if (xfi->image)
+	{
+		xf_shm_image_free(xfi, xfi->image, &xfi->image_shm_info);
+		xfi->image = NULL;
+	}
+
+	if (xfi->tiles_image)
+	{
+		xf_shm_image_free(xfi, xfi->tiles_image, &xfi->tiles_shm_info);
+		xfi->tiles_image = NULL;
+	}
+}
+
+#else /* WITH_XSHM */
+
+XImage* xf_shm_image_new(xfInfo* xfi, XShmSegmentInfo* shminfo, int depth, int width, int height)
+{
+	return NULL;
+}
+
+void xf_shm_image_free(xfInfo* xfi, XImage* image, XShmSegmentInfo* shminfo)
+{
+}
+
+void xf_shm_put_image(xfInfo* xfi, Drawable drawable, XImage* image,
+		int src_x, int src_y, int dst_x, int dst_y, int width, int height)
+{
+	XPutImage(xfi->display, drawable, xfi->gc, image,
+			src_x, src_y, dst_x, dst_y, width, height);
+}
+
+boolean xf_shm_init(xfInfo* xfi)
+{
+	xfi->use_xshm = false;
+	return false;
+}
+
+void xf_shm_uninit(xfInfo* xfi)
+{
+}
+
+#endif /* WITH_XSHM */
+
+void xf_shm_image_copy(XImage* image, uint8* src, int src_stride, int x, int y, int width, int height)
+{
+	int i;
+	uint8* srcp;
+	uint8* dstp;
+	int bytes_per_pixel = image->bits_per_pixel / 8;
+
+	srcp = src + (y * src_stride) + (x * bytes_per_pixel);
+	dstp = (uint8*) image->data + (y * image->bytes_per_line) + (x * bytes_per_pixel);
+
+	for (i = 0; i < height; i++)
+	{
+		memcpy(dstp, srcp, width * bytes_per_pixel);
+		srcp += src_stride;
+		dstp += image->bytes_per_line;
+	}
+}
@@ -0,0 +1,35 @@
+/**
+ * FreeRDP: A Remote Desktop Protocol Client
+ * X11 MIT-SHM Surfaces
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __XF_SHM_H
+#define __XF_SHM_H
+
+#include "xfreerdp.h"
+
+/* number of 64x64 RemoteFX tiles staged in the shared tile strip */
+#define XF_SHM_TILE_COUNT	64
+
+boolean xf_shm_init(xfInfo* xfi);
+void xf_shm_uninit(xfInfo* xfi);
+
+XImage* xf_shm_image_new(xfInfo* xfi, XShmSegmentInfo* shminfo, int depth, int width, int height);
+void xf_shm_image_free(xfInfo* xfi, XImage* image, XShmSegmentInfo* shminfo);
+void xf_shm_image_copy(XImage* image, uint8* src, int src_stride, int x, int y, int width, int height);
+void xf_shm_put_image(xfInfo* xfi, Drawable drawable, XImage* image,
+		int src_x, int src_y, int dst_x, int dst_y, int width, int height);
+
+#endif /* __XF_SHM_H */
@@ -819,6 +819,9 @@ void xf_SetWindowVisibilityRects(xfInfo* xfi, xfWindow* window, RECTANGLE_16* re
 void xf_UpdateWindowArea(xfInfo* xfi, xfWindow* window, int x, int y, int width, int height)
 {
 	int ax, ay;
+	int sx, sy;
+	int sw, sh;
+	rdpGdi* gdi;
 	rdpWindow* wnd;
 	wnd = window->window;
 
@@ -848,8 +851,19 @@ void xf_UpdateWindowArea(xfInfo* xfi, xfWindow* window, int x, int y, int width,
 	
 	if (xfi->sw_gdi)
 	{
-		XPutImage(xfi->display, xfi->primary, window->gc, xfi->image,
-			ax, ay, ax, ay, width, height);
+		/* the window may reach past the desktop, only the part inside is backed */
+		gdi = ((rdpContext*) xfi->context)->gdi;
+		sx = MAX(ax, 0);
+		sy = MAX(ay, 0);
+		sw = MIN(ax + width, gdi->width) - sx;
+		sh = MIN(ay + height, gdi->height) - sy;
+
+		if (sw > 0 && sh > 0)
+		{
+			IFCALL(xfi->AsyncDrawingLock, xfi);
+			xf_sw_put_primary(xfi, gdi, sx, sy, sw, sh);
+			IFCALL(xfi->AsyncDrawingUnlock, xfi);
+		}
 	}
 
 	XCopyArea(xfi->display, xfi->primary, window->handle, window->gc,
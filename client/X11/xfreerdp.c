@@ -59,6 +59,8 @@
 #include <freerdp/rail.h>
 
 #include "xf_gdi.h"
+#include "xf_shm.h"
+#include "xf_present.h"
 #include "xf_rail.h"
 #include "xf_tsmf.h"
 #include "xf_event.h"
@@ -98,10 +100,39 @@ void xf_context_free(freerdp* instance, rdpContext* context)
 void xf_sw_begin_paint(rdpContext* context)
 {
 	rdpGdi* gdi = context->gdi;
+	xfInfo* xfi = ((xfContext*) context)->xfi;
+
+	if (xfi->present)
+		xf_present_begin_paint((xfPresent*) xfi->present);
+
 	gdi->primary->hdc->hwnd->invalid->null = 1;
 	gdi->primary->hdc->hwnd->ninvalid = 0;
 }
 
+/**
+ * Puts a rectangle of the primary buffer into the primary pixmap. With
+ * XShm the staging image is refreshed from the primary buffer first.
+ */
+void xf_sw_put_primary(xfInfo* xfi, rdpGdi* gdi, sint32 x, sint32 y, uint32 w, uint32 h)
+{
+	if (xfi->use_xshm)
+	{
+		xf_shm_image_copy(xfi->image, gdi->primary_buffer, gdi->width * gdi->bytesPerPixel, x, y, w, h);
+		xf_shm_put_image(xfi, xfi->primary, xfi->image, x, y, x, y, w, h);
+	}
+	else
+	{
+		XPutImage(xfi->display, xfi->primary, xfi->gc, xfi->image, x, y, x, y, w, h);
+	}
+}
+
+void xf_sw_put_image(xfInfo* xfi, rdpGdi* gdi, sint32 x, sint32 y, uint32 w, uint32 h)
+{
+	xf_sw_put_primary(xfi, gdi, x, y, w, h);
+
+	XCopyArea(xfi->display, xfi->primary, xfi->window->handle, xfi->gc, x, y, w, h, x, y);
+}
+
 void xf_sw_end_paint(rdpContext* context)
 {
 	rdpGdi* gdi;
@@ -112,6 +143,29 @@ void xf_sw_end_paint(rdpContext* context)
 	xfi = ((xfContext*) context)->xfi;
 	gdi = context->gdi;
 
+	if (xfi->present)
+	{
+		xfPresent* present = (xfPresent*) xfi->present;
+
+		/* the present thread picks the damage up on its next tick */
+		if (xfi->remote_app != true)
+		{
+			if (xfi->complex_regions != true)
+			{
+				xf_present_end_paint(present, gdi->primary->hdc->hwnd->invalid,
+					gdi->primary->hdc->hwnd->invalid->null ? 0 : 1);
+			}
+			else
+			{
+				xf_present_end_paint(present, gdi->primary->hdc->hwnd->cinvalid,
+					gdi->primary->hdc->hwnd->ninvalid);
+			}
+			return;
+		}
+
+		xf_present_end_paint(present, NULL, 0);
+	}
+
 	if (xfi->remote_app != true)
 	{
 		if (xfi->complex_regions != true)
@@ -124,8 +178,9 @@ void xf_sw_end_paint(rdpContext* context)
 			w = gdi->primary->hdc->hwnd->invalid->w;
 			h = gdi->primary->hdc->hwnd->invalid->h;
 
-			XPutImage(xfi->display, xfi->primary, xfi->gc, xfi->image, x, y, x, y, w, h);
-			XCopyArea(xfi->display, xfi->primary, xfi->window->handle, xfi->gc, x, y, w, h, x, y);
+			IFCALL(xfi->AsyncDrawingLock, xfi);
+			xf_sw_put_image(xfi, gdi, x, y, w, h);
+			IFCALL(xfi->AsyncDrawingUnlock, xfi);
 		}
 		else
 		{
@@ -139,6 +194,8 @@ void xf_sw_end_paint(rdpContext* context)
 			ninvalid = gdi->primary->hdc->hwnd->ninvalid;
 			cinvalid = gdi->primary->hdc->hwnd->cinvalid;
 
+			IFCALL(xfi->AsyncDrawingLock, xfi);
+
 			for (i = 0; i < ninvalid; i++)
 			{
 				x = cinvalid[i].x;
@@ -146,10 +203,11 @@ void xf_sw_end_paint(rdpContext* context)
 				w = cinvalid[i].w;
 				h = cinvalid[i].h;
 
-				XPutImage(xfi->display, xfi->primary, xfi->gc, xfi->image, x, y, x, y, w, h);
-				XCopyArea(xfi->display, xfi->primary, xfi->window->handle, xfi->gc, x, y, w, h, x, y);
+				xf_sw_put_image(xfi, gdi, x, y, w, h);
 			}
 
+			IFCALL(xfi->AsyncDrawingUnlock, xfi);
+
 			XFlush(xfi->display);
 		}
 	}
@@ -178,14 +236,47 @@ void xf_sw_desktop_resize(rdpContext* context)
 	if (xfi->fullscreen != true)
 	{
 		rdpGdi* gdi = context->gdi;
+
+		if (xfi->present)
+			xf_present_begin_paint((xfPresent*) xfi->present);
+
+		/* the present thread uploads from the image with only the display locked */
+		IFCALL(xfi->PrimarySurfaceLock, xfi);
+
 		gdi_resize(gdi, xfi->width, xfi->height);
 
 		if (xfi->image)
 		{
-			xfi->image->data = NULL;
-			XDestroyImage(xfi->image);
-			xfi->image = XCreateImage(xfi->display, xfi->visual, xfi->depth, ZPixmap, 0,
-					(char*) gdi->primary_buffer, gdi->width, gdi->height, xfi->scanline_pad, 0);
+			if (xfi->use_xshm)
+			{
+				IFCALL(xfi->AsyncDrawingLock, xfi);
+				xf_shm_image_free(xfi, xfi->image, &xfi->image_shm_info);
+				xfi->image = xf_shm_image_new(xfi, &xfi->image_shm_info, xfi->depth, gdi->width, gdi->height);
+
+				if (xfi->image == NULL)
+					xfi->use_xshm = false;
+			}
+			else
+			{
+				xfi->image->data = NULL;
+				XDestroyImage(xfi->image);
+				xfi->image = NULL;
+			}
+
+			if (xfi->image == NULL)
+			{
+				xfi->image = XCreateImage(xfi->display, xfi->visual, xfi->depth, ZPixmap, 0,
+						(char*) gdi->primary_buffer, gdi->width, gdi->height, xfi->scanline_pad, 0);
+			}
+		}
+
+		IFCALL(xfi->PrimarySurfaceUnlock, xfi);
+
+		if (xfi->present)
+		{
+			/* pending damage refers to the old surface size */
+			((xfPresent*) xfi->present)->ndamage = 0;
+			xf_present_end_paint((xfPresent*) xfi->present, NULL, 0);
 		}
 	}
 }
@@ -604,6 +695,23 @@ static boolean xf_update_window_area_unlock(xfInfo* xfi)
 	return true;
 }
 
+/* MIT-SHM puts are asynchronous, wait for the server before reusing the segment */
+static boolean xf_async_drawing_lock(xfInfo* xfi)
+{
+	if (xfi->async_drawing)
+	{
+		XSync(xfi->display, False);
+		xfi->async_drawing = false;
+	}
+	return true;
+}
+
+static boolean xf_async_drawing_unlock(xfInfo* xfi)
+{
+	xfi->async_drawing = xfi->use_xshm;
+	return true;
+}
+
 void xf_register_callbacks(xfInfo* xfi)
 {
 	xfi->MonitorDetect = xf_detect_monitors;
@@ -615,8 +723,8 @@ void xf_register_callbacks(xfInfo* xfi)
 	xfi->PrimarySurfaceUnlock = xf_primary_surface_unlock;
 	xfi->UpdateWindowAreaLock = xf_update_window_area_lock;
 	xfi->UpdateWindowAreaUnlock = xf_update_window_area_unlock;
-	xfi->AsyncDrawingLock = NULL;
-	xfi->AsyncDrawingUnlock = NULL;
+	xfi->AsyncDrawingLock = xf_async_drawing_lock;
+	xfi->AsyncDrawingUnlock = xf_async_drawing_unlock;
 	xf_platform_register_system_callbacks(xfi);
 }
 
@@ -646,6 +754,8 @@ boolean xf_pre_connect(freerdp* instance)
 	xfi->context->settings = instance->settings;
 	xfi->instance = instance;
 
+	xfi->use_xshm = true;
+
 	xf_platform_init(xfi);
 	xf_register_callbacks(xfi);
 	
@@ -694,11 +804,11 @@ boolean xf_pre_connect(freerdp* instance)
 	settings->order_support[NEG_FAST_INDEX_INDEX] = true;
 	settings->order_support[NEG_FAST_GLYPH_INDEX] = true;
 
-	settings->order_support[NEG_POLYGON_SC_INDEX] = (settings->sw_gdi) ? false : true;
-	settings->order_support[NEG_POLYGON_CB_INDEX] = (settings->sw_gdi) ? false : true;
+	settings->order_support[NEG_POLYGON_SC_INDEX] = true;
+	settings->order_support[NEG_POLYGON_CB_INDEX] = true;
 
-	settings->order_support[NEG_ELLIPSE_SC_INDEX] = false;
-	settings->order_support[NEG_ELLIPSE_CB_INDEX] = false;
+	settings->order_support[NEG_ELLIPSE_SC_INDEX] = (settings->sw_gdi) ? true : false;
+	settings->order_support[NEG_ELLIPSE_CB_INDEX] = (settings->sw_gdi) ? true : false;
 	
 	freerdp_channels_pre_connect(xfi->_context->channels, instance);
 
@@ -853,8 +963,11 @@ boolean xf_post_connect(freerdp* instance)
 	XSetForeground(xfi->display, xfi->gc, BlackPixelOfScreen(xfi->screen));
 	XFillRectangle(xfi->display, xfi->primary, xfi->gc, 0, 0, xfi->width, xfi->height);
 
-	xfi->image = XCreateImage(xfi->display, xfi->visual, xfi->depth, ZPixmap, 0,
-			(char*) xfi->primary_buffer, xfi->width, xfi->height, xfi->scanline_pad, 0);
+	if (xf_shm_init(xfi) != true || xfi->image == NULL)
+	{
+		xfi->image = XCreateImage(xfi->display, xfi->visual, xfi->depth, ZPixmap, 0,
+				(char*) xfi->primary_buffer, xfi->width, xfi->height, xfi->scanline_pad, 0);
+	}
 
 	xfi->bmp_codec_none = (uint8*) xmalloc(64 * 64 * 4);
 
@@ -865,6 +978,9 @@ boolean xf_post_connect(freerdp* instance)
 		instance->update->BeginPaint = xf_sw_begin_paint;
 		instance->update->EndPaint = xf_sw_end_paint;
 		instance->update->DesktopResize = xf_sw_desktop_resize;
+
+		if (xfi->present_fps > 0)
+			xfi->present = xf_present_new(xfi, xfi->present_fps);
 	}
 	else
 	{
@@ -969,6 +1085,8 @@ void xf_print_client_args_help(void)
 		"  --kbd-list: list all keyboard layout ids used by -k\n"
 		"  --xv-port: Specify XVideo port for video redirection extension, default is 0\n"
 		"  --dbg-x11: Enable X11 debug mode\n"
+		"  --no-xshm: Disable MIT-SHM accelerated presentation\n"
+		"  --present-fps: Present software GDI updates from a separate thread at the given rate, up to 240\n"
 		"\n"
 	);
 	xf_platform_print_args();
@@ -1039,6 +1157,19 @@ int xf_process_client_args(rdpSettings* settings, const char* opt, const char* v
 		xfi->debug = true;
 		argc = 1;
 	}
+	else if (strcmp("--no-xshm", opt) == 0)
+	{
+		xfi->use_xshm = false;
+		argc = 1;
+	}
+	else if (strcmp("--present-fps", opt) == 0)
+	{
+		int fps = atoi(val);
+
+		/* 0 leaves presentation on the update thread */
+		xfi->present_fps = (fps > 0) ? MIN(fps, XF_PRESENT_MAX_FPS) : 0;
+		argc = 2;
+	}
 	else
 	{
 		/* Process platform specific commandline parameters */
@@ -1148,6 +1279,8 @@ void xf_window_free(xfInfo* xfi)
 		xfi->bitmap_mono = 0;
 	}
 
+	xf_shm_uninit(xfi);
+
 	if (xfi->image)
 	{
 		xfi->image->data = NULL;
@@ -1271,6 +1404,16 @@ int xfreerdp_run(freerdp* instance)
 			FD_SET(fds, &rfds_set);
 		}
 
+		for (i = 0; i < wcount; i++)
+		{
+			fds = (int)(long)(wfds[i]);
+
+			if (fds > max_fds)
+				max_fds = fds;
+
+			FD_SET(fds, &wfds_set);
+		}
+
 		if (max_fds == 0)
 			break;
 
@@ -1295,6 +1438,9 @@ int xfreerdp_run(freerdp* instance)
 			}
 		}
 
+		if (xfi->present)
+			xf_present_mark_arrival((xfPresent*) xfi->present);
+
 		if (freerdp_check_fds(instance) != true)
 		{
 			printf("Failed to check FreeRDP file descriptor\n");
@@ -1341,6 +1487,13 @@ int xfreerdp_run(freerdp* instance)
 	if (!ret)
 		ret = freerdp_error_info(instance);
 
+	/* stop presenting before the primary buffer goes away */
+	if (xfi->present)
+	{
+		xf_present_free((xfPresent*) xfi->present);
+		xfi->present = NULL;
+	}
+
 	freerdp_channels_close(channels, instance);
 	freerdp_channels_free(channels);
 	freerdp_disconnect(instance);
@@ -179,6 +179,15 @@ struct xf_info
 	boolean sw_gdi;
 	uint8* primary_buffer;
 
+	boolean use_xshm;
+	boolean async_drawing;
+	XImage* tiles_image;
+	XShmSegmentInfo image_shm_info;
+	XShmSegmentInfo tiles_shm_info;
+
+	void* present;
+	uint32 present_fps;
+
 	boolean frame_begin;
 	uint16 frame_x1;
 	uint16 frame_y1;
@@ -279,6 +288,8 @@ struct xf_info
 };
 
 void xf_toggle_fullscreen(xfInfo* xfi);
+void xf_sw_put_primary(xfInfo* xfi, rdpGdi* gdi, sint32 x, sint32 y, uint32 w, uint32 h);
+void xf_sw_put_image(xfInfo* xfi, rdpGdi* gdi, sint32 x, sint32 y, uint32 w, uint32 h);
 boolean xf_post_connect(freerdp* instance);
 
 enum XF_EXIT_CODE
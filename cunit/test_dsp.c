@@ -0,0 +1,632 @@
+/**
+ * FreeRDP: A Remote Desktop Protocol Client
+ * Audio DSP Unit Tests
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * The codecs are checked against straightforward per-sample versions of
+ * the reference algorithms, which the block-wise code must match bit for
+ * bit, and the resampler against a plain C version of its kernel and
+ * against itself fed in one piece.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <freerdp/types.h>
+#include <freerdp/utils/memory.h>
+#include <freerdp/utils/dsp.h>
+
+#include "test_dsp.h"
+
+static const sint16 ref_ima_step_index_table[] =
+{
+	-1, -1, -1, -1, 2, 4, 6, 8,
+	-1, -1, -1, -1, 2, 4, 6, 8
+};
+
+static const sint16 ref_ima_step_size_table[] =
+{
+	7, 8, 9, 10, 11, 12, 13, 14, 16, 17,
+	19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+	50, 55, 60, 66, 73, 80, 88, 97, 107, 118,
+	130, 143, 157, 173, 190, 209, 230, 253, 279, 307,
+	337, 371, 408, 449, 494, 544, 598, 658, 724, 796,
+	876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066,
+	2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358,
+	5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+	15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+};
+
+static const sint16 ref_ms_adaptation_table[] =
+{
+	230, 230, 230, 230, 307, 409, 512, 614,
+	768, 614, 512, 409, 307, 230, 230, 230
+};
+
+static const sint16 ref_ms_coeff1_table[] =
+{
+	256, 512, 0, 192, 240, 460, 392
+};
+
+static const sint16 ref_ms_coeff2_table[] =
+{
+	0, -256, 0, 64, 0, -208, -232
+};
+
+struct ref_channel
+{
+	sint32 sample;
+	sint32 step;
+	sint32 coeff1;
+	sint32 coeff2;
+	sint32 delta;
+	sint32 sample1;
+	sint32 sample2;
+};
+
+static sint16 ref_clamp(sint32 v)
+{
+	if (v > 32767)
+		return 32767;
+	if (v < -32768)
+		return -32768;
+	return (sint16) v;
+}
+
+static sint16 ref_read_sint16(const uint8* p)
+{
+	return (sint16) (p[0] | (p[1] << 8));
+}
+
+static void ref_write_sint16(uint8* p, sint32 v)
+{
+	p[0] = v & 0xff;
+	p[1] = (v >> 8) & 0xff;
+}
+
+/**
+ * A test signal, triangles of a different period on every channel. The
+ * level falls and rises again in steps of 300 frames so that the codecs
+ * go through most of their steps.
+ */
+static void dsp_fill_signal(sint16* dst, int frames, int channels)
+{
+	int i, j;
+	int period;
+	int phase;
+	int shift;
+	int level;
+
+	for (i = 0; i < frames; i++)
+	{
+		shift = (i / 300) % 14;
+		level = 12000 >> ((shift < 8) ? shift : 14 - shift);
+
+		for (j = 0; j < channels; j++)
+		{
+			period = 50 + j * 14;
+			phase = i % period;
+			phase = (phase < period / 2) ? phase : period - phase;
+			*dst++ = (sint16) ((phase * 4 * level) / period - level);
+		}
+	}
+}
+
+static void ref_resample_linear(const sint16* src, int channels,
+	sint16* dst, int rframes, uint64 phase, uint64 step)
+{
+	int i, j;
+	sint32 w;
+	const sint16* s;
+
+	for (i = 0; i < rframes; i++)
+	{
+		s = &src[(phase >> 32) * channels];
+		w = (sint32) ((phase >> 18) & 0x3FFF);
+
+		for (j = 0; j < channels; j++)
+			*dst++ = (sint16) ((s[j] * (16384 - w) + s[j + channels] * w) >> 14);
+
+		phase += step;
+	}
+}
+
+static sint16 ref_ima_decode_sample(struct ref_channel* channel, int nibble)
+{
+	sint32 ss;
+	sint32 diff;
+
+	ss = ref_ima_step_size_table[channel->step];
+	diff = ss >> 3;
+	if (nibble & 1)
+		diff += ss >> 2;
+	if (nibble & 2)
+		diff += ss >> 1;
+	if (nibble & 4)
+		diff += ss;
+	if (nibble & 8)
+		diff = -diff;
+
+	channel->sample = ref_clamp(channel->sample + diff);
+	channel->step += ref_ima_step_index_table[nibble];
+	channel->step = MAX(0, MIN(channel->step, 88));
+
+	return (sint16) channel->sample;
+}
+
+static uint8 ref_ima_encode_sample(struct ref_channel* channel, sint32 sample)
+{
+	sint32 d;
+	sint32 ss;
+	uint8 enc = 0;
+
+	ss = ref_ima_step_size_table[channel->step];
+	d = sample - channel->sample;
+
+	if (d < 0)
+	{
+		enc = 8;
+		d = -d;
+	}
+	if (d >= ss)
+	{
+		enc |= 4;
+		d -= ss;
+	}
+	ss >>= 1;
+	if (d >= ss)
+	{
+		enc |= 2;
+		d -= ss;
+	}
+	ss >>= 1;
+	if (d >= ss)
+		enc |= 1;
+
+	ref_ima_decode_sample(channel, enc);
+
+	return enc;
+}
+
+static int ref_ima_encode(const sint16* in, int blocks, int channels, int block_size, uint8* out)
+{
+	int i, j, k;
+	uint8* dst = out;
+	struct ref_channel state[2];
+	uint8 l0, l1, r0, r1;
+
+	memset(state, 0, sizeof(state));
+
+	for (i = 0; i < blocks; i++)
+	{
+		for (j = 0; j < channels; j++)
+		{
+			ref_write_sint16(dst, state[j].sample);
+			dst[2] = (uint8) state[j].step;
+			dst[3] = 0;
+			dst += 4;
+		}
+
+		for (k = 4 * channels; k < block_size; )
+		{
+			if (channels > 1)
+			{
+				for (j = 0; j < 4; j++)
+				{
+					l0 = ref_ima_encode_sample(&state[0], in[0]);
+					r0 = ref_ima_encode_sample(&state[1], in[1]);
+					l1 = ref_ima_encode_sample(&state[0], in[2]);
+					r1 = ref_ima_encode_sample(&state[1], in[3]);
+					dst[j] = l0 | (l1 << 4);
+					dst[j + 4] = r0 | (r1 << 4);
+					in += 4;
+				}
+				dst += 8;
+				k += 8;
+			}
+			else
+			{
+				l0 = ref_ima_encode_sample(&state[0], in[0]);
+				l1 = ref_ima_encode_sample(&state[0], in[1]);
+				*dst++ = l0 | (l1 << 4);
+				in += 2;
+				k++;
+			}
+		}
+	}
+
+	return dst - out;
+}
+
+static int ref_ima_decode(const uint8* src, int size, int channels, int block_size, sint16* out)
+{
+	int i, j;
+	sint16* dst = out;
+	const uint8* end;
+	struct ref_channel state[2];
+
+	for (; size >= block_size; size -= block_size)
+	{
+		end = src + block_size;
+
+		for (j = 0; j < channels; j++)
+		{
+			state[j].sample = ref_read_sint16(src);
+			state[j].step = MIN(src[2], 88);
+			src += 4;
+		}
+
+		while (src < end)
+		{
+			if (channels > 1)
+			{
+				for (i = 0; i < 4; i++)
+				{
+					*dst++ = ref_ima_decode_sample(&state[0], src[i] & 0x0f);
+					*dst++ = ref_ima_decode_sample(&state[1], src[i + 4] & 0x0f);
+					*dst++ = ref_ima_decode_sample(&state[0], src[i] >> 4);
+					*dst++ = ref_ima_decode_sample(&state[1], src[i + 4] >> 4);
+				}
+				src += 8;
+			}
+			else
+			{
+				*dst++ = ref_ima_decode_sample(&state[0], *src & 0x0f);
+				*dst++ = ref_ima_decode_sample(&state[0], *src >> 4);
+				src++;
+			}
+		}
+	}
+
+	return dst - out;
+}
+
+static sint16 ref_ms_decode_sample(struct ref_channel* channel, int nibble)
+{
+	sint32 sample;
+
+	sample = ((channel->sample1 * channel->coeff1) + (channel->sample2 * channel->coeff2)) / 256;
+	sample += ((nibble & 8) ? nibble - 16 : nibble) * channel->delta;
+	sample = ref_clamp(sample);
+
+	channel->sample2 = channel->sample1;
+	channel->sample1 = sample;
+	channel->delta = MAX(16, channel->delta * ref_ms_adaptation_table[nibble] / 256);
+
+	return (sint16) sample;
+}
+
+static uint8 ref_ms_encode_sample(struct ref_channel* channel, sint32 sample)
+{
+	sint32 predicted;
+	sint32 error;
+
+	predicted = ((channel->sample1 * channel->coeff1) + (channel->sample2 * channel->coeff2)) / 256;
+	error = (sample - predicted) / channel->delta;
+	if ((sample - predicted) % channel->delta > channel->delta / 2)
+		error++;
+	error = MAX(-8, MIN(error, 7));
+
+	ref_ms_decode_sample(channel, error & 0x0f);
+
+	return error & 0x0f;
+}
+
+static int ref_ms_encode(const sint16* in, int blocks, int channels, int block_size, uint8* out)
+{
+	int i, j, k;
+	uint8* dst = out;
+	struct ref_channel state[2];
+
+	memset(state, 0, sizeof(state));
+
+	for (j = 0; j < channels; j++)
+	{
+		state[j].coeff1 = ref_ms_coeff1_table[0];
+		state[j].coeff2 = ref_ms_coeff2_table[0];
+		state[j].delta = 16;
+	}
+
+	for (i = 0; i < blocks; i++)
+	{
+		/* predictors, deltas, then the first two frames */
+		for (j = 0; j < channels; j++)
+			*dst++ = 0;
+		for (j = 0; j < channels; j++)
+		{
+			ref_write_sint16(dst, state[j].delta);
+			dst += 2;
+		}
+		for (j = 0; j < channels; j++)
+		{
+			state[j].sample2 = in[j];
+			state[j].sample1 = in[channels + j];
+			ref_write_sint16(dst, state[j].sample1);
+			ref_write_sint16(dst + 2 * channels, state[j].sample2);
+			dst += 2;
+		}
+		dst += 2 * channels;
+		in += 2 * channels;
+
+		for (k = 7 * channels; k < block_size; k++)
+		{
+			*dst = ref_ms_encode_sample(&state[0], in[0]) << 4;
+			*dst++ |= ref_ms_encode_sample(&state[channels - 1], in[1]);
+			in += 2;
+		}
+	}
+
+	return dst - out;
+}
+
+static int ref_ms_decode(const uint8* src, int size, int channels, int block_size, sint16* out)
+{
+	int j;
+	sint16* dst = out;
+	const uint8* end;
+	struct ref_channel state[2];
+
+	for (; size >= block_size; size -= block_size)
+	{
+		end = src + block_size;
+
+		for (j = 0; j < channels; j++)
+		{
+			state[j].coeff1 = ref_ms_coeff1_table[src[j] > 6 ? 0 : src[j]];
+			state[j].coeff2 = ref_ms_coeff2_table[src[j] > 6 ? 0 : src[j]];
+			state[j].delta = ref_read_sint16(src + channels + 2 * j);
+			state[j].sample1 = ref_read_sint16(src + 3 * channels + 2 * j);
+			state[j].sample2 = ref_read_sint16(src + 5 * channels + 2 * j);
+		}
+		for (j = 0; j < channels; j++)
+			*dst++ = state[j].sample2;
+		for (j = 0; j < channels; j++)
+			*dst++ = state[j].sample1;
+		src += 7 * channels;
+
+		for (; src < end; src++)
+		{
+			*dst++ = ref_ms_decode_sample(&state[0], *src >> 4);
+			*dst++ = ref_ms_decode_sample(&state[channels - 1], *src & 0x0f);
+		}
+	}
+
+	return dst - out;
+}
+
+int init_dsp_suite(void)
+{
+	srand(1);
+	return 0;
+}
+
+int clean_dsp_suite(void)
+{
+	return 0;
+}
+
+int add_dsp_suite(void)
+{
+	add_test_suite(dsp);
+
+	add_test_function(dsp_resample_linear);
+	add_test_function(dsp_resample_chunked);
+	add_test_function(dsp_ima_adpcm);
+	add_test_function(dsp_ms_adpcm);
+
+	return 0;
+}
+
+/* the kernel in use, SIMD where available, against the C version */
+void test_dsp_resample_linear(void)
+{
+	int i, j;
+	int channels;
+	int rframes;
+	int sframes;
+	uint64 phase;
+	uint64 step;
+	sint16* src;
+	sint16 expected[1024 * 2];
+	sint16 actual[1024 * 2];
+	FREERDP_DSP_CONTEXT* context;
+
+	context = freerdp_dsp_context_new();
+
+	for (i = 0; i < 200; i++)
+	{
+		channels = 1 + i % 2;
+		rframes = 1 + rand() % 1024;
+		step = ((uint64) (rand() % 4 + 1) << 30) + ((uint64) rand() & 0x3FFFFFFF);
+		phase = ((uint64) rand() << 8) & 0xFFFFFFFF;
+
+		sframes = (int) ((phase + (rframes - 1) * step) >> 32) + 2;
+		src = (sint16*) xmalloc(sframes * channels * sizeof(sint16));
+
+		for (j = 0; j < sframes * channels; j++)
+			src[j] = (sint16) (rand() - RAND_MAX / 2);
+
+		ref_resample_linear(src, channels, expected, rframes, phase, step);
+		context->resample_linear(src, channels, actual, rframes, phase, step);
+
+		CU_ASSERT(memcmp(expected, actual, rframes * channels * sizeof(sint16)) == 0);
+
+		xfree(src);
+	}
+
+	freerdp_dsp_context_free(context);
+}
+
+/* the same signal fed in random pieces comes out as when fed in one */
+void test_dsp_resample_chunked(void)
+{
+	int i, j;
+	int n;
+	int frames;
+	int sframes = 4000;
+	int expected_size;
+	int actual_size;
+	uint8* src;
+	uint8* expected;
+	uint8* actual;
+	FREERDP_DSP_CONTEXT* whole;
+	FREERDP_DSP_CONTEXT* chunked;
+	static const int configs[][5] =
+	{
+		/* bytes per sample, schan, srate, rchan, rrate */
+		{ 2, 2, 44100, 2, 22050 },
+		{ 2, 1, 22050, 2, 44100 },
+		{ 2, 2, 48000, 1, 44100 },
+		{ 2, 2, 44100, 2, 44100 },
+		{ 1, 1, 8000, 1, 11025 }
+	};
+
+	for (i = 0; i < (int) (sizeof(configs) / sizeof(configs[0])); i++)
+	{
+		n = sframes * configs[i][1] * configs[i][0];
+		src = (uint8*) xmalloc(n);
+
+		for (j = 0; j < n; j++)
+			src[j] = rand();
+
+		whole = freerdp_dsp_context_new();
+		whole->resample(whole, src, configs[i][0], configs[i][1], configs[i][2], sframes,
+			configs[i][3], configs[i][4]);
+		expected_size = whole->resampled_size;
+		expected = whole->resampled_buffer;
+
+		CU_ASSERT(abs((int) whole->resampled_frames -
+			(int) ((uint64) sframes * configs[i][4] / configs[i][2])) <= 2);
+
+		chunked = freerdp_dsp_context_new();
+		actual = (uint8*) xmalloc(expected_size + 1024);
+		actual_size = 0;
+
+		for (j = 0; j < sframes; j += frames)
+		{
+			frames = 1 + rand() % 500;
+			frames = MIN(frames, sframes - j);
+
+			chunked->resample(chunked, &src[j * configs[i][1] * configs[i][0]], configs[i][0],
+				configs[i][1], configs[i][2], frames, configs[i][3], configs[i][4]);
+
+			if (actual_size + chunked->resampled_size <= expected_size)
+				memcpy(&actual[actual_size], chunked->resampled_buffer, chunked->resampled_size);
+			actual_size += chunked->resampled_size;
+		}
+
+		CU_ASSERT(actual_size == expected_size);
+		CU_ASSERT(actual_size == expected_size && memcmp(expected, actual, expected_size) == 0);
+
+		xfree(actual);
+		xfree(src);
+		freerdp_dsp_context_free(chunked);
+		freerdp_dsp_context_free(whole);
+	}
+}
+
+static void dsp_check_adpcm(int ms, int channels, int block_size)
+{
+	int i;
+	int blocks = 6;
+	int samples;
+	int size;
+	sint64 error;
+	sint64 level;
+	sint16* in;
+	uint8* encoded;
+	sint16* decoded;
+	FREERDP_DSP_CONTEXT* encoder;
+	FREERDP_DSP_CONTEXT* decoder;
+
+	/* samples per block, the MS ADPCM header carries the first two frames */
+	if (ms)
+		samples = (2 + (block_size - 7 * channels) * 2 / channels) * channels;
+	else
+		samples = (block_size - 4 * channels) * 2;
+
+	samples *= blocks;
+	in = (sint16*) xmalloc(samples * sizeof(sint16));
+	dsp_fill_signal(in, samples / channels, channels);
+
+	encoded = (uint8*) xmalloc(blocks * block_size);
+	decoded = (sint16*) xmalloc(samples * sizeof(sint16));
+
+	encoder = freerdp_dsp_context_new();
+	decoder = freerdp_dsp_context_new();
+
+	if (ms)
+	{
+		encoder->encode_ms_adpcm(encoder, (uint8*) in, samples * 2, channels, block_size);
+		size = ref_ms_encode(in, blocks, channels, block_size, encoded);
+	}
+	else
+	{
+		encoder->encode_ima_adpcm(encoder, (uint8*) in, samples * 2, channels, block_size);
+		size = ref_ima_encode(in, blocks, channels, block_size, encoded);
+	}
+
+	CU_ASSERT(size == blocks * block_size);
+	CU_ASSERT(encoder->adpcm_size == size);
+	CU_ASSERT(encoder->adpcm_size == size && memcmp(encoder->adpcm_buffer, encoded, size) == 0);
+
+	if (ms)
+	{
+		decoder->decode_ms_adpcm(decoder, encoded, size, channels, block_size);
+		CU_ASSERT(ref_ms_decode(encoded, size, channels, block_size, decoded) == samples);
+	}
+	else
+	{
+		decoder->decode_ima_adpcm(decoder, encoded, size, channels, block_size);
+		CU_ASSERT(ref_ima_decode(encoded, size, channels, block_size, decoded) == samples);
+	}
+
+	CU_ASSERT(decoder->adpcm_size == samples * 2);
+	CU_ASSERT(decoder->adpcm_size == samples * 2 &&
+		memcmp(decoder->adpcm_buffer, decoded, samples * 2) == 0);
+
+	/* the round trip stays close to the signal once the step has adapted */
+	error = 0;
+	level = 0;
+	for (i = samples / blocks; i < samples; i++)
+	{
+		error += abs(decoded[i] - in[i]);
+		level += abs(in[i]);
+	}
+	CU_ASSERT(error * 20 < level);
+
+	freerdp_dsp_context_free(decoder);
+	freerdp_dsp_context_free(encoder);
+	xfree(decoded);
+	xfree(encoded);
+	xfree(in);
+}
+
+void test_dsp_ima_adpcm(void)
+{
+	dsp_check_adpcm(0, 1, 256);
+	dsp_check_adpcm(0, 1, 1024);
+	dsp_check_adpcm(0, 2, 512);
+	dsp_check_adpcm(0, 2, 2048);
+}
+
+void test_dsp_ms_adpcm(void)
+{
+	dsp_check_adpcm(1, 1, 256);
+	dsp_check_adpcm(1, 1, 1024);
+	dsp_check_adpcm(1, 2, 512);
+	dsp_check_adpcm(1, 2, 2048);
+}
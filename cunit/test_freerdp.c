@@ -38,6 +38,7 @@
 #include "test_drdynvc.h"
 #include "test_rfx.h"
 #include "test_nsc.h"
+#include "test_dsp.h"
 #include "test_freerdp.h"
 #include "test_rail.h"
 #include "test_pcap.h"
@@ -128,6 +129,7 @@ const static test_suite suites[] =
 	{ "cliprdr", add_cliprdr_suite },
 	{ "color", add_color_suite },
 	{ "drdynvc", add_drdynvc_suite },
+	{ "dsp", add_dsp_suite },
 	{ "gcc", add_gcc_suite },
 	{ "gdi", add_gdi_suite },
 	{ "license", add_license_suite },
@@ -66,7 +66,10 @@ int add_gdi_suite(void)
 	add_test_function(gdi_SetROP2);
 	add_test_function(gdi_MoveToEx);
 	add_test_function(gdi_LineTo);
+	add_test_function(gdi_PolylineTo);
+	add_test_function(gdi_Polyline);
 	add_test_function(gdi_Ellipse);
+	add_test_function(gdi_Polygon);
 	add_test_function(gdi_PtInRect);
 	add_test_function(gdi_FillRect);
 	add_test_function(gdi_BitBlt_32bpp);
@@ -693,6 +696,26 @@ unsigned char line_to_case_11[256] =
 	"\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\x00"
 };
 
+unsigned char line_to_case_12[256] =
+{
+	"\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF"
+	"\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF"
+	"\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF"
+	"\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF"
+	"\xFF\xFF\xFF\x00\xFF\x00\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF"
+	"\xFF\xFF\xFF\x00\x00\xFF\x00\xFF\xFF\xFF\xFF\x00\xFF\xFF\xFF\xFF"
+	"\xFF\xFF\xFF\xFF\xFF\x00\x00\x00\x00\x00\x00\x00\xFF\xFF\xFF\xFF"
+	"\xFF\xFF\xFF\xFF\xFF\xFF\xFF\x00\xFF\x00\xFF\xFF\xFF\xFF\xFF\xFF"
+	"\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\x00\xFF\xFF\xFF\xFF\xFF\xFF\xFF"
+	"\xFF\xFF\xFF\xFF\xFF\xFF\xFF\x00\xFF\x00\x00\xFF\xFF\xFF\xFF\xFF"
+	"\xFF\xFF\xFF\xFF\xFF\xFF\x00\xFF\xFF\x00\xFF\x00\xFF\xFF\xFF\xFF"
+	"\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF"
+	"\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF"
+	"\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF"
+	"\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF"
+	"\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF"
+};
+
 unsigned char line_to_R2_BLACK[256] =
 {
 	"\x00\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF"
@@ -1055,15 +1078,35 @@ unsigned char polyline_to_case_2[256] =
 	"\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF"
 };
 
+unsigned char polyline_to_case_3[256] =
+{
+	"\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF"
+	"\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF"
+	"\xFF\xFF\xFF\xFF\xFF\xFF\xFF\x00\xFF\x00\xFF\xFF\xFF\xFF\xFF\xFF"
+	"\xFF\xFF\xFF\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\xFF\xFF"
+	"\xFF\xFF\xFF\x00\xFF\xFF\x00\xFF\xFF\xFF\x00\xFF\xFF\x00\xFF\xFF"
+	"\xFF\xFF\xFF\x00\xFF\x00\xFF\xFF\xFF\xFF\x00\xFF\xFF\x00\xFF\xFF"
+	"\xFF\xFF\xFF\x00\xFF\x00\xFF\xFF\xFF\xFF\xFF\x00\xFF\x00\xFF\xFF"
+	"\xFF\xFF\xFF\x00\x00\xFF\xFF\xFF\xFF\xFF\xFF\x00\xFF\x00\xFF\xFF"
+	"\xFF\xFF\xFF\x00\x00\xFF\xFF\xFF\xFF\xFF\xFF\xFF\x00\x00\xFF\xFF"
+	"\xFF\xFF\xFF\x00\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\x00\x00\xFF\xFF"
+	"\xFF\xFF\xFF\x00\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\x00\xFF\xFF"
+	"\xFF\xFF\x00\x00\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\x00\xFF\xFF"
+	"\xFF\xFF\x00\x00\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\x00\x00\xFF"
+	"\xFF\xFF\xFF\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\xFF"
+	"\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF"
+	"\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF"
+};
+
 /* Ellipse() Test Data */
 
 unsigned char ellipse_case_1[256] =
 {
 	"\xFF\xFF\xFF\xFF\xFF\x00\x00\x00\x00\x00\x00\xFF\xFF\xFF\xFF\xFF"
-	"\xFF\xFF\xFF\xFF\x00\x00\x00\x00\x00\x00\x00\x00\xFF\xFF\xFF\xFF"
-	"\xFF\xFF\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\xFF\xFF"
+	"\xFF\xFF\xFF\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\xFF\xFF\xFF"
 	"\xFF\xFF\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\xFF\xFF"
 	"\xFF\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\xFF"
+	"\xFF\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\xFF"
 	"\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00"
 	"\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00"
 	"\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00"
@@ -1071,30 +1114,30 @@ unsigned char ellipse_case_1[256] =
 	"\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00"
 	"\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00"
 	"\xFF\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\xFF"
+	"\xFF\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\xFF"
 	"\xFF\xFF\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\xFF\xFF"
-	"\xFF\xFF\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\xFF\xFF"
-	"\xFF\xFF\xFF\xFF\x00\x00\x00\x00\x00\x00\x00\x00\xFF\xFF\xFF\xFF"
+	"\xFF\xFF\xFF\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\xFF\xFF\xFF"
 	"\xFF\xFF\xFF\xFF\xFF\x00\x00\x00\x00\x00\x00\xFF\xFF\xFF\xFF\xFF"
 };
 
 unsigned char ellipse_case_2[256] =
 {
+	"\xFF\xFF\xFF\xFF\xFF\xFF\xFF\x00\x00\xFF\xFF\xFF\xFF\xFF\xFF\xFF"
 	"\xFF\xFF\xFF\xFF\xFF\xFF\x00\x00\x00\x00\xFF\xFF\xFF\xFF\xFF\xFF"
 	"\xFF\xFF\xFF\xFF\xFF\x00\x00\x00\x00\x00\x00\xFF\xFF\xFF\xFF\xFF"
+	"\xFF\xFF\xFF\xFF\xFF\x00\x00\x00\x00\x00\x00\xFF\xFF\xFF\xFF\xFF"
 	"\xFF\xFF\xFF\xFF\x00\x00\x00\x00\x00\x00\x00\x00\xFF\xFF\xFF\xFF"
 	"\xFF\xFF\xFF\xFF\x00\x00\x00\x00\x00\x00\x00\x00\xFF\xFF\xFF\xFF"
 	"\xFF\xFF\xFF\xFF\x00\x00\x00\x00\x00\x00\x00\x00\xFF\xFF\xFF\xFF"
 	"\xFF\xFF\xFF\xFF\x00\x00\x00\x00\x00\x00\x00\x00\xFF\xFF\xFF\xFF"
-	"\xFF\xFF\xFF\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\xFF\xFF\xFF"
-	"\xFF\xFF\xFF\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\xFF\xFF\xFF"
-	"\xFF\xFF\xFF\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\xFF\xFF\xFF"
-	"\xFF\xFF\xFF\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\xFF\xFF\xFF"
 	"\xFF\xFF\xFF\xFF\x00\x00\x00\x00\x00\x00\x00\x00\xFF\xFF\xFF\xFF"
 	"\xFF\xFF\xFF\xFF\x00\x00\x00\x00\x00\x00\x00\x00\xFF\xFF\xFF\xFF"
 	"\xFF\xFF\xFF\xFF\x00\x00\x00\x00\x00\x00\x00\x00\xFF\xFF\xFF\xFF"
 	"\xFF\xFF\xFF\xFF\x00\x00\x00\x00\x00\x00\x00\x00\xFF\xFF\xFF\xFF"
 	"\xFF\xFF\xFF\xFF\xFF\x00\x00\x00\x00\x00\x00\xFF\xFF\xFF\xFF\xFF"
+	"\xFF\xFF\xFF\xFF\xFF\x00\x00\x00\x00\x00\x00\xFF\xFF\xFF\xFF\xFF"
 	"\xFF\xFF\xFF\xFF\xFF\xFF\x00\x00\x00\x00\xFF\xFF\xFF\xFF\xFF\xFF"
+	"\xFF\xFF\xFF\xFF\xFF\xFF\xFF\x00\x00\xFF\xFF\xFF\xFF\xFF\xFF\xFF"
 };
 
 unsigned char ellipse_case_3[256] =
@@ -1102,7 +1145,7 @@ unsigned char ellipse_case_3[256] =
 	"\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF"
 	"\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF"
 	"\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF"
-	"\xFF\xFF\xFF\xFF\xFF\xFF\x00\x00\x00\x00\xFF\xFF\xFF\xFF\xFF\xFF"
+	"\xFF\xFF\xFF\xFF\xFF\x00\x00\x00\x00\x00\x00\xFF\xFF\xFF\xFF\xFF"
 	"\xFF\xFF\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\xFF\xFF"
 	"\xFF\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\xFF"
 	"\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00"
@@ -1111,7 +1154,47 @@ unsigned char ellipse_case_3[256] =
 	"\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00"
 	"\xFF\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\xFF"
 	"\xFF\xFF\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\xFF\xFF"
-	"\xFF\xFF\xFF\xFF\xFF\xFF\x00\x00\x00\x00\xFF\xFF\xFF\xFF\xFF\xFF"
+	"\xFF\xFF\xFF\xFF\xFF\x00\x00\x00\x00\x00\x00\xFF\xFF\xFF\xFF\xFF"
+	"\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF"
+	"\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF"
+	"\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF"
+};
+
+unsigned char ellipse_case_4[256] =
+{
+	"\xFF\xFF\xFF\xFF\xFF\x00\x00\x00\x00\x00\x00\xFF\xFF\xFF\xFF\xFF"
+	"\xFF\xFF\xFF\x00\x00\xFF\xFF\xFF\xFF\xFF\xFF\x00\x00\xFF\xFF\xFF"
+	"\xFF\xFF\x00\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\x00\xFF\xFF"
+	"\xFF\x00\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\x00\xFF"
+	"\xFF\x00\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\x00\xFF"
+	"\x00\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\x00"
+	"\x00\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\x00"
+	"\x00\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\x00"
+	"\x00\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\x00"
+	"\x00\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\x00"
+	"\x00\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\x00"
+	"\xFF\x00\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\x00\xFF"
+	"\xFF\x00\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\x00\xFF"
+	"\xFF\xFF\x00\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\x00\xFF\xFF"
+	"\xFF\xFF\xFF\x00\x00\xFF\xFF\xFF\xFF\xFF\xFF\x00\x00\xFF\xFF\xFF"
+	"\xFF\xFF\xFF\xFF\xFF\x00\x00\x00\x00\x00\x00\xFF\xFF\xFF\xFF\xFF"
+};
+
+unsigned char ellipse_case_5[256] =
+{
+	"\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF"
+	"\xFF\xFF\xFF\x00\x00\x00\x00\x00\x00\x00\x00\x00\xFF\xFF\xFF\xFF"
+	"\xFF\xFF\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\xFF\xFF\xFF\xFF"
+	"\xFF\xFF\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\xFF\xFF\xFF\xFF"
+	"\xFF\xFF\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\xFF\xFF\xFF\xFF"
+	"\xFF\xFF\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\xFF\xFF\xFF\xFF"
+	"\xFF\xFF\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\xFF\xFF\xFF\xFF"
+	"\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF"
+	"\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF"
+	"\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF"
+	"\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF"
+	"\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF"
+	"\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF"
 	"\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF"
 	"\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF"
 	"\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF"
@@ -1121,21 +1204,21 @@ unsigned char ellipse_case_3[256] =
 
 unsigned char polygon_case_1[256] =
 {
-	"\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\x00\xFF\xFF\xFF\xFF\xFF\xFF\xFF"
+	"\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF"
+	"\xFF\xFF\xFF\xFF\xFF\xFF\xFF\x00\x00\xFF\xFF\xFF\xFF\xFF\xFF\xFF"
 	"\xFF\xFF\xFF\xFF\xFF\xFF\xFF\x00\x00\xFF\xFF\xFF\xFF\xFF\xFF\xFF"
-	"\xFF\xFF\xFF\xFF\xFF\xFF\xFF\x00\x00\x00\xFF\xFF\xFF\xFF\xFF\xFF"
 	"\xFF\xFF\xFF\xFF\xFF\xFF\x00\x00\x00\x00\xFF\xFF\xFF\xFF\xFF\xFF"
-	"\xFF\xFF\xFF\xFF\xFF\xFF\x00\x00\x00\x00\x00\xFF\xFF\xFF\xFF\xFF"
+	"\xFF\xFF\xFF\xFF\xFF\xFF\x00\x00\x00\x00\xFF\xFF\xFF\xFF\xFF\xFF"
 	"\xFF\xFF\xFF\xFF\xFF\x00\x00\x00\x00\x00\x00\xFF\xFF\xFF\xFF\xFF"
-	"\xFF\xFF\xFF\xFF\xFF\x00\x00\x00\x00\x00\x00\x00\xFF\xFF\xFF\xFF"
+	"\xFF\xFF\xFF\xFF\xFF\x00\x00\x00\x00\x00\x00\xFF\xFF\xFF\xFF\xFF"
+	"\xFF\xFF\xFF\xFF\x00\x00\x00\x00\x00\x00\x00\x00\xFF\xFF\xFF\xFF"
 	"\xFF\xFF\xFF\xFF\x00\x00\x00\x00\x00\x00\x00\x00\xFF\xFF\xFF\xFF"
-	"\xFF\xFF\xFF\xFF\x00\x00\x00\x00\x00\x00\x00\x00\x00\xFF\xFF\xFF"
 	"\xFF\xFF\xFF\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\xFF\xFF\xFF"
-	"\xFF\xFF\xFF\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\xFF\xFF"
+	"\xFF\xFF\xFF\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\xFF\xFF\xFF"
+	"\xFF\xFF\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\xFF\xFF"
 	"\xFF\xFF\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\xFF\xFF"
-	"\xFF\xFF\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\xFF"
 	"\xFF\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\xFF"
-	"\xFF\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00"
+	"\xFF\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\xFF"
 	"\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00"
 };
 
@@ -1159,6 +1242,66 @@ unsigned char polygon_case_2[256] =
 	"\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF"
 };
 
+unsigned char polygon_case_3[256] =
+{
+	"\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF"
+	"\xFF\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\xFF\xFF\xFF\xFF\xFF"
+	"\xFF\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\xFF\xFF\xFF\xFF\xFF"
+	"\xFF\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\xFF\xFF\xFF\xFF\xFF"
+	"\xFF\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\xFF\xFF\xFF\xFF\xFF"
+	"\xFF\x00\x00\x00\x00\xFF\xFF\xFF\xFF\xFF\xFF\x00\x00\x00\x00\xFF"
+	"\xFF\x00\x00\x00\x00\xFF\xFF\xFF\xFF\xFF\xFF\x00\x00\x00\x00\xFF"
+	"\xFF\x00\x00\x00\x00\xFF\xFF\xFF\xFF\xFF\xFF\x00\x00\x00\x00\xFF"
+	"\xFF\x00\x00\x00\x00\xFF\xFF\xFF\xFF\xFF\xFF\x00\x00\x00\x00\xFF"
+	"\xFF\x00\x00\x00\x00\xFF\xFF\xFF\xFF\xFF\xFF\x00\x00\x00\x00\xFF"
+	"\xFF\x00\x00\x00\x00\xFF\xFF\xFF\xFF\xFF\xFF\x00\x00\x00\x00\xFF"
+	"\xFF\xFF\xFF\xFF\xFF\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\xFF"
+	"\xFF\xFF\xFF\xFF\xFF\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\xFF"
+	"\xFF\xFF\xFF\xFF\xFF\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\xFF"
+	"\xFF\xFF\xFF\xFF\xFF\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\xFF"
+	"\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF"
+};
+
+unsigned char polygon_case_4[256] =
+{
+	"\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF"
+	"\xFF\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\xFF\xFF\xFF\xFF\xFF"
+	"\xFF\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\xFF\xFF\xFF\xFF\xFF"
+	"\xFF\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\xFF\xFF\xFF\xFF\xFF"
+	"\xFF\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\xFF\xFF\xFF\xFF\xFF"
+	"\xFF\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\xFF"
+	"\xFF\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\xFF"
+	"\xFF\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\xFF"
+	"\xFF\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\xFF"
+	"\xFF\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\xFF"
+	"\xFF\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\xFF"
+	"\xFF\xFF\xFF\xFF\xFF\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\xFF"
+	"\xFF\xFF\xFF\xFF\xFF\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\xFF"
+	"\xFF\xFF\xFF\xFF\xFF\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\xFF"
+	"\xFF\xFF\xFF\xFF\xFF\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\xFF"
+	"\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF"
+};
+
+unsigned char polygon_case_5[256] =
+{
+	"\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF"
+	"\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF"
+	"\xFF\xFF\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\xFF\xFF"
+	"\xFF\xFF\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\xFF\xFF"
+	"\xFF\xFF\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\xFF\xFF"
+	"\xFF\xFF\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\xFF\xFF"
+	"\xFF\xFF\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\xFF\xFF"
+	"\xFF\xFF\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\xFF\xFF"
+	"\xFF\xFF\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\xFF\xFF"
+	"\xFF\xFF\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\xFF\xFF"
+	"\xFF\xFF\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\xFF\xFF"
+	"\xFF\xFF\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\xFF\xFF"
+	"\xFF\xFF\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\xFF\xFF"
+	"\xFF\xFF\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\xFF\xFF"
+	"\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF"
+	"\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF"
+};
+
 int CompareBitmaps(HGDI_BITMAP hBmp1, HGDI_BITMAP hBmp2)
 {
 	int x, y;
@@ -1494,6 +1637,7 @@ void test_gdi_LineTo(void)
 	HGDI_BITMAP hBmp_LineTo_9;
 	HGDI_BITMAP hBmp_LineTo_10;
 	HGDI_BITMAP hBmp_LineTo_11;
+	HGDI_BITMAP hBmp_LineTo_12;
 	HGDI_BITMAP hBmp_LineTo_R2_BLACK;
 	HGDI_BITMAP hBmp_LineTo_R2_NOTMERGEPEN;
 	HGDI_BITMAP hBmp_LineTo_R2_MASKNOTPEN;
@@ -1569,6 +1713,9 @@ void test_gdi_LineTo(void)
 	data = (uint8*) freerdp_image_convert((uint8*) line_to_case_11, NULL, 16, 16, 8, bitsPerPixel, clrconv);
 	hBmp_LineTo_11 = gdi_CreateBitmap(16, 16, bitsPerPixel, data);
 
+	data = (uint8*) freerdp_image_convert((uint8*) line_to_case_12, NULL, 16, 16, 8, bitsPerPixel, clrconv);
+	hBmp_LineTo_12 = gdi_CreateBitmap(16, 16, bitsPerPixel, data);
+
 	data = (uint8*) freerdp_image_convert((uint8*) line_to_R2_BLACK, NULL, 16, 16, 8, bitsPerPixel, clrconv);
 	hBmp_LineTo_R2_BLACK = gdi_CreateBitmap(16, 16, bitsPerPixel, data);
 
@@ -1817,17 +1964,163 @@ void test_gdi_LineTo(void)
 	gdi_SetROP2(hdc, GDI_R2_WHITE);
 	gdi_LineTo(hdc, 16, 16);
 	assertBitmapsEqual(hBmp, hBmp_LineTo_R2_WHITE, "Case 27");
+
+	/* Test Case 28: shallow, steep and diagonal lines clipped to (3,4) -> (12,11) */
+	gdi_BitBlt(hdc, 0, 0, 16, 16, hdc, 0, 0, GDI_WHITENESS);
+	gdi_SetClipRgn(hdc, 3, 4, 9, 7);
+	gdi_SetROP2(hdc, GDI_R2_BLACK);
+	gdi_MoveToEx(hdc, 0, 2, NULL);
+	gdi_LineTo(hdc, 16, 14);
+	gdi_MoveToEx(hdc, 2, 0, NULL);
+	gdi_LineTo(hdc, 14, 16);
+	gdi_MoveToEx(hdc, 15, 1, NULL);
+	gdi_LineTo(hdc, 1, 15);
+	gdi_MoveToEx(hdc, 0, 5, NULL);
+	gdi_LineTo(hdc, 16, 7);
+	assertBitmapsEqual(hBmp, hBmp_LineTo_12, "Case 28");
+}
+
+void test_gdi_PolylineTo(void)
+{
+	HGDI_DC hdc;
+	HGDI_PEN pen;
+	uint8* data;
+	HGDI_BITMAP hBmp;
+	HGDI_BITMAP hBmp_PolylineTo_1;
+	HGDI_BITMAP hBmp_PolylineTo_2;
+	GDI_POINT triangle[3] = { { 0, 15 }, { 15, 15 }, { 8, 0 } };
+	GDI_POINT rectangle[4] = { { 13, 3 }, { 13, 13 }, { 3, 13 }, { 3, 3 } };
+	rdpPalette* hPalette;
+	HCLRCONV clrconv;
+	int bitsPerPixel = 8;
+	int bytesPerPixel = 1;
+
+	hdc = gdi_GetDC();
+	hdc->bitsPerPixel = bitsPerPixel;
+	hdc->bytesPerPixel = bytesPerPixel;
+	gdi_SetNullClipRgn(hdc);
+
+	pen = gdi_CreatePen(1, 1, 0);
+	gdi_SelectObject(hdc, (HGDIOBJECT) pen);
+
+	hBmp = gdi_CreateCompatibleBitmap(hdc, 16, 16);
+	gdi_SelectObject(hdc, (HGDIOBJECT) hBmp);
+
+	hPalette = (rdpPalette*) gdi_GetSystemPalette();
+
+	clrconv = (HCLRCONV) malloc(sizeof(CLRCONV));
+	clrconv->alpha = 1;
+	clrconv->invert = 0;
+	clrconv->palette = hPalette;
+
+	data = (uint8*) freerdp_image_convert((uint8*) polyline_to_case_1, NULL, 16, 16, 8, bitsPerPixel, clrconv);
+	hBmp_PolylineTo_1 = gdi_CreateBitmap(16, 16, bitsPerPixel, data);
+
+	data = (uint8*) freerdp_image_convert((uint8*) polyline_to_case_2, NULL, 16, 16, 8, bitsPerPixel, clrconv);
+	hBmp_PolylineTo_2 = gdi_CreateBitmap(16, 16, bitsPerPixel, data);
+
+	/* Test Case 1: (8,0) -> (0,15) -> (15,15) -> (8,0) */
+	gdi_BitBlt(hdc, 0, 0, 16, 16, hdc, 0, 0, GDI_WHITENESS);
+	gdi_MoveToEx(hdc, 8, 0, NULL);
+	gdi_PolylineTo(hdc, triangle, 2);
+	CU_ASSERT(pen->posX == 15 && pen->posY == 15);
+	gdi_PolylineTo(hdc, &triangle[2], 1);
+	assertBitmapsEqual(hBmp, hBmp_PolylineTo_1, "Case 1");
+
+	/* Test Case 2: (3,3) -> (13,3) -> (13,13) -> (3,13) -> (3,3) */
+	gdi_BitBlt(hdc, 0, 0, 16, 16, hdc, 0, 0, GDI_WHITENESS);
+	gdi_MoveToEx(hdc, 3, 3, NULL);
+	gdi_PolylineTo(hdc, rectangle, 4);
+	assertBitmapsEqual(hBmp, hBmp_PolylineTo_2, "Case 2");
+
+	/* Test Case 3: Case 2 with R2_NOT, every joint is drawn once */
+	gdi_BitBlt(hdc, 0, 0, 16, 16, hdc, 0, 0, GDI_WHITENESS);
+	gdi_SetROP2(hdc, GDI_R2_NOT);
+	gdi_MoveToEx(hdc, 3, 3, NULL);
+	gdi_PolylineTo(hdc, rectangle, 4);
+	gdi_SetROP2(hdc, GDI_R2_BLACK);
+	assertBitmapsEqual(hBmp, hBmp_PolylineTo_2, "Case 3");
+}
+
+void test_gdi_Polyline(void)
+{
+	HGDI_DC hdc;
+	HGDI_PEN pen;
+	uint8* data;
+	HGDI_BITMAP hBmp;
+	HGDI_BITMAP hBmp_Polyline_1;
+	HGDI_BITMAP hBmp_Polyline_2;
+	HGDI_BITMAP hBmp_Polyline_3;
+	GDI_POINT polyline[9] =
+	{
+		{ 8, 0 }, { 0, 15 }, { 15, 15 }, { 8, 0 },
+		{ 3, 3 }, { 13, 3 }, { 13, 13 }, { 3, 13 }, { 3, 3 }
+	};
+	int counts[2] = { 4, 5 };
+	rdpPalette* hPalette;
+	HCLRCONV clrconv;
+	int bitsPerPixel = 8;
+	int bytesPerPixel = 1;
+
+	hdc = gdi_GetDC();
+	hdc->bitsPerPixel = bitsPerPixel;
+	hdc->bytesPerPixel = bytesPerPixel;
+	gdi_SetNullClipRgn(hdc);
+
+	pen = gdi_CreatePen(1, 1, 0);
+	gdi_SelectObject(hdc, (HGDIOBJECT) pen);
+
+	hBmp = gdi_CreateCompatibleBitmap(hdc, 16, 16);
+	gdi_SelectObject(hdc, (HGDIOBJECT) hBmp);
+
+	hPalette = (rdpPalette*) gdi_GetSystemPalette();
+
+	clrconv = (HCLRCONV) malloc(sizeof(CLRCONV));
+	clrconv->alpha = 1;
+	clrconv->invert = 0;
+	clrconv->palette = hPalette;
+
+	data = (uint8*) freerdp_image_convert((uint8*) polyline_to_case_1, NULL, 16, 16, 8, bitsPerPixel, clrconv);
+	hBmp_Polyline_1 = gdi_CreateBitmap(16, 16, bitsPerPixel, data);
+
+	data = (uint8*) freerdp_image_convert((uint8*) polyline_to_case_2, NULL, 16, 16, 8, bitsPerPixel, clrconv);
+	hBmp_Polyline_2 = gdi_CreateBitmap(16, 16, bitsPerPixel, data);
+
+	data = (uint8*) freerdp_image_convert((uint8*) polyline_to_case_3, NULL, 16, 16, 8, bitsPerPixel, clrconv);
+	hBmp_Polyline_3 = gdi_CreateBitmap(16, 16, bitsPerPixel, data);
+
+	/* Test Case 1: Polyline leaves the current position alone */
+	gdi_BitBlt(hdc, 0, 0, 16, 16, hdc, 0, 0, GDI_WHITENESS);
+	gdi_MoveToEx(hdc, 1, 2, NULL);
+	gdi_Polyline(hdc, &polyline[0], 4);
+	assertBitmapsEqual(hBmp, hBmp_Polyline_1, "Case 1");
+	CU_ASSERT(pen->posX == 1 && pen->posY == 2);
+
+	/* Test Case 2: the rectangle alone */
+	gdi_BitBlt(hdc, 0, 0, 16, 16, hdc, 0, 0, GDI_WHITENESS);
+	gdi_Polyline(hdc, &polyline[4], 5);
+	assertBitmapsEqual(hBmp, hBmp_Polyline_2, "Case 2");
+
+	/* Test Case 3: PolyPolyline, both series clipped to (2,2) -> (15,15) */
+	gdi_BitBlt(hdc, 0, 0, 16, 16, hdc, 0, 0, GDI_WHITENESS);
+	gdi_SetClipRgn(hdc, 2, 2, 13, 13);
+	gdi_PolyPolyline(hdc, polyline, counts, 2);
+	gdi_SetNullClipRgn(hdc);
+	assertBitmapsEqual(hBmp, hBmp_Polyline_3, "Case 3");
 }
 
 void test_gdi_Ellipse(void)
 {
 	HGDI_DC hdc;
 	HGDI_PEN pen;
+	HGDI_BRUSH brush;
 	uint8* data;
 	HGDI_BITMAP hBmp;
 	HGDI_BITMAP hBmp_Ellipse_1;
 	HGDI_BITMAP hBmp_Ellipse_2;
 	HGDI_BITMAP hBmp_Ellipse_3;
+	HGDI_BITMAP hBmp_Ellipse_4;
+	HGDI_BITMAP hBmp_Ellipse_5;
 	rdpPalette* hPalette;
 	HCLRCONV clrconv;
 	int bitsPerPixel = 8;
@@ -1841,6 +2134,9 @@ void test_gdi_Ellipse(void)
 	pen = gdi_CreatePen(1, 1, 0);
 	gdi_SelectObject(hdc, (HGDIOBJECT) pen);
 
+	brush = gdi_CreateSolidBrush(0);
+	gdi_SelectObject(hdc, (HGDIOBJECT) brush);
+
 	hBmp = gdi_CreateCompatibleBitmap(hdc, 16, 16);
 	gdi_SelectObject(hdc, (HGDIOBJECT) hBmp);
 
@@ -1860,10 +2156,142 @@ void test_gdi_Ellipse(void)
 	data = (uint8*) freerdp_image_convert((uint8*) ellipse_case_3, NULL, 16, 16, 8, bitsPerPixel, clrconv);
 	hBmp_Ellipse_3 = gdi_CreateBitmap(16, 16, bitsPerPixel, data);
 
+	data = (uint8*) freerdp_image_convert((uint8*) ellipse_case_4, NULL, 16, 16, 8, bitsPerPixel, clrconv);
+	hBmp_Ellipse_4 = gdi_CreateBitmap(16, 16, bitsPerPixel, data);
+
+	data = (uint8*) freerdp_image_convert((uint8*) ellipse_case_5, NULL, 16, 16, 8, bitsPerPixel, clrconv);
+	hBmp_Ellipse_5 = gdi_CreateBitmap(16, 16, bitsPerPixel, data);
+
+	gdi_SetROP2(hdc, GDI_R2_COPYPEN);
+
 	/* Test Case 1: (0,0) -> (16, 16) */
 	gdi_BitBlt(hdc, 0, 0, 16, 16, hdc, 0, 0, GDI_WHITENESS);
 	gdi_Ellipse(hdc, 0, 0, 16, 16);
-	//assertBitmapsEqual(hBmp, hBmp_Ellipse_1, "Case 1");
+	assertBitmapsEqual(hBmp, hBmp_Ellipse_1, "Case 1");
+
+	/* Test Case 2: (4,0) -> (12, 16) */
+	gdi_BitBlt(hdc, 0, 0, 16, 16, hdc, 0, 0, GDI_WHITENESS);
+	gdi_Ellipse(hdc, 4, 0, 12, 16);
+	assertBitmapsEqual(hBmp, hBmp_Ellipse_2, "Case 2");
+
+	/* Test Case 3: (16,13) -> (0, 3) */
+	gdi_BitBlt(hdc, 0, 0, 16, 16, hdc, 0, 0, GDI_WHITENESS);
+	gdi_Ellipse(hdc, 16, 13, 0, 3);
+	assertBitmapsEqual(hBmp, hBmp_Ellipse_3, "Case 3");
+
+	/* Test Case 4: (0,0) -> (16, 16), outline only */
+	gdi_BitBlt(hdc, 0, 0, 16, 16, hdc, 0, 0, GDI_WHITENESS);
+	brush->style = GDI_BS_NULL;
+	gdi_Ellipse(hdc, 0, 0, 16, 16);
+	brush->style = GDI_BS_SOLID;
+	assertBitmapsEqual(hBmp, hBmp_Ellipse_4, "Case 4");
+
+	/* Test Case 5: (0,0) -> (16, 16), clipped to (2,1) -> (12,7) */
+	gdi_BitBlt(hdc, 0, 0, 16, 16, hdc, 0, 0, GDI_WHITENESS);
+	gdi_SetClipRgn(hdc, 2, 1, 10, 6);
+	gdi_Ellipse(hdc, 0, 0, 16, 16);
+	gdi_SetNullClipRgn(hdc);
+	assertBitmapsEqual(hBmp, hBmp_Ellipse_5, "Case 5");
+}
+
+void test_gdi_Polygon(void)
+{
+	HGDI_DC hdc;
+	HGDI_PEN pen;
+	HGDI_BRUSH brush;
+	uint8* data;
+	HGDI_BITMAP hBmp;
+	HGDI_BITMAP hBmp_Polygon_1;
+	HGDI_BITMAP hBmp_Polygon_2;
+	HGDI_BITMAP hBmp_Polygon_3;
+	HGDI_BITMAP hBmp_Polygon_4;
+	HGDI_BITMAP hBmp_Polygon_5;
+	GDI_POINT triangle[3] = { { 8, 0 }, { 0, 16 }, { 16, 16 } };
+	GDI_POINT square[4] = { { 3, 3 }, { 14, 3 }, { 14, 14 }, { 3, 14 } };
+	GDI_POINT overlapping[8] =
+	{
+		{ 1, 1 }, { 11, 1 }, { 11, 11 }, { 1, 11 },
+		{ 5, 5 }, { 15, 5 }, { 15, 15 }, { 5, 15 }
+	};
+	GDI_POINT adjacent[8] =
+	{
+		{ 2, 2 }, { 8, 2 }, { 8, 14 }, { 2, 14 },
+		{ 8, 2 }, { 14, 2 }, { 14, 14 }, { 8, 14 }
+	};
+	int counts[2] = { 4, 4 };
+	rdpPalette* hPalette;
+	HCLRCONV clrconv;
+	int bitsPerPixel = 8;
+	int bytesPerPixel = 1;
+
+	hdc = gdi_GetDC();
+	hdc->bitsPerPixel = bitsPerPixel;
+	hdc->bytesPerPixel = bytesPerPixel;
+	gdi_SetNullClipRgn(hdc);
+
+	pen = gdi_CreatePen(1, 1, 0);
+	gdi_SelectObject(hdc, (HGDIOBJECT) pen);
+
+	brush = gdi_CreateSolidBrush(0);
+	gdi_SelectObject(hdc, (HGDIOBJECT) brush);
+
+	hBmp = gdi_CreateCompatibleBitmap(hdc, 16, 16);
+	gdi_SelectObject(hdc, (HGDIOBJECT) hBmp);
+
+	hPalette = (rdpPalette*) gdi_GetSystemPalette();
+
+	clrconv = (HCLRCONV) malloc(sizeof(CLRCONV));
+	clrconv->alpha = 1;
+	clrconv->invert = 0;
+	clrconv->palette = hPalette;
+
+	data = (uint8*) freerdp_image_convert((uint8*) polygon_case_1, NULL, 16, 16, 8, bitsPerPixel, clrconv);
+	hBmp_Polygon_1 = gdi_CreateBitmap(16, 16, bitsPerPixel, data);
+
+	data = (uint8*) freerdp_image_convert((uint8*) polygon_case_2, NULL, 16, 16, 8, bitsPerPixel, clrconv);
+	hBmp_Polygon_2 = gdi_CreateBitmap(16, 16, bitsPerPixel, data);
+
+	data = (uint8*) freerdp_image_convert((uint8*) polygon_case_3, NULL, 16, 16, 8, bitsPerPixel, clrconv);
+	hBmp_Polygon_3 = gdi_CreateBitmap(16, 16, bitsPerPixel, data);
+
+	data = (uint8*) freerdp_image_convert((uint8*) polygon_case_4, NULL, 16, 16, 8, bitsPerPixel, clrconv);
+	hBmp_Polygon_4 = gdi_CreateBitmap(16, 16, bitsPerPixel, data);
+
+	data = (uint8*) freerdp_image_convert((uint8*) polygon_case_5, NULL, 16, 16, 8, bitsPerPixel, clrconv);
+	hBmp_Polygon_5 = gdi_CreateBitmap(16, 16, bitsPerPixel, data);
+
+	gdi_SetROP2(hdc, GDI_R2_COPYPEN);
+
+	/* Test Case 1: triangle */
+	gdi_BitBlt(hdc, 0, 0, 16, 16, hdc, 0, 0, GDI_WHITENESS);
+	gdi_Polygon(hdc, triangle, 3);
+	assertBitmapsEqual(hBmp, hBmp_Polygon_1, "Case 1");
+
+	/* Test Case 2: square */
+	gdi_BitBlt(hdc, 0, 0, 16, 16, hdc, 0, 0, GDI_WHITENESS);
+	gdi_Polygon(hdc, square, 4);
+	assertBitmapsEqual(hBmp, hBmp_Polygon_2, "Case 2");
+
+	/* Test Case 3: overlapping squares, ALTERNATE */
+	gdi_BitBlt(hdc, 0, 0, 16, 16, hdc, 0, 0, GDI_WHITENESS);
+	gdi_SetPolyFillMode(hdc, GDI_ALTERNATE);
+	gdi_PolyPolygon(hdc, overlapping, counts, 2);
+	assertBitmapsEqual(hBmp, hBmp_Polygon_3, "Case 3");
+
+	/* Test Case 4: overlapping squares, WINDING */
+	gdi_BitBlt(hdc, 0, 0, 16, 16, hdc, 0, 0, GDI_WHITENESS);
+	gdi_SetPolyFillMode(hdc, GDI_WINDING);
+	gdi_PolyPolygon(hdc, overlapping, counts, 2);
+	gdi_SetPolyFillMode(hdc, GDI_ALTERNATE);
+	assertBitmapsEqual(hBmp, hBmp_Polygon_4, "Case 4");
+
+	/* Test Case 5: adjacent squares, R2_NOT, the shared edge is filled once */
+	gdi_BitBlt(hdc, 0, 0, 16, 16, hdc, 0, 0, GDI_WHITENESS);
+	gdi_SetROP2(hdc, GDI_R2_NOT);
+	gdi_Polygon(hdc, &adjacent[0], 4);
+	gdi_Polygon(hdc, &adjacent[4], 4);
+	gdi_SetROP2(hdc, GDI_R2_COPYPEN);
+	assertBitmapsEqual(hBmp, hBmp_Polygon_5, "Case 5");
 }
 
 void test_gdi_PtInRect(void)
@@ -37,7 +37,10 @@ void test_gdi_SetPixel(void);
 void test_gdi_SetROP2(void);
 void test_gdi_MoveToEx(void);
 void test_gdi_LineTo(void);
+void test_gdi_PolylineTo(void);
+void test_gdi_Polyline(void);
 void test_gdi_Ellipse(void);
+void test_gdi_Polygon(void);
 void test_gdi_PtInRect(void);
 void test_gdi_FillRect(void);
 void test_gdi_BitBlt_32bpp(void);
@@ -26,16 +26,19 @@
 #include "libfreerdp-core/update.h"
 
 ORDER_INFO* orderInfo;
+ARENA* orderArena;
 
 int init_orders_suite(void)
 {
 	orderInfo = (ORDER_INFO*) malloc(sizeof(ORDER_INFO));
+	orderArena = arena_new(4096);
 	return 0;
 }
 
 int clean_orders_suite(void)
 {
 	free(orderInfo);
+	arena_free(orderArena);
 	return 0;
 }
 
@@ -471,7 +474,7 @@ void test_read_fast_glyph_order(void)
 
 	memset(&fast_glyph, 0, sizeof(FAST_GLYPH_ORDER));
 
-	update_read_fast_glyph_order(s, orderInfo, &fast_glyph);
+	update_read_fast_glyph_order(s, orderInfo, &fast_glyph, orderArena);
 
 	CU_ASSERT(fast_glyph.backColor == 0);
 	CU_ASSERT(fast_glyph.foreColor == 0x0000FFFF);
@@ -637,7 +640,7 @@ void test_read_cache_brush_order(void)
 
 	memset(&cache_brush, 0, sizeof(CACHE_BRUSH_ORDER));
 
-	update_read_cache_brush_order(s, &cache_brush, 0);
+	update_read_cache_brush_order(s, &cache_brush, 0, orderArena);
 
 	CU_ASSERT(cache_brush.index == 0);
 	CU_ASSERT(cache_brush.bpp == 1);
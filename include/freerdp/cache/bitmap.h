@@ -45,7 +45,8 @@ struct rdp_bitmap_cache
 	pCacheBitmapV2 CacheBitmapV2; /* 3 */
 	pCacheBitmapV3 CacheBitmapV3; /* 4 */
 	pBitmapUpdate BitmapUpdate; /* 5 */
-	uint32 paddingA[16 - 6]; /* 6 */
+	pMemBltBatch MemBltBatch; /* 6 */
+	uint32 paddingA[16 - 7]; /* 7 */
 
 	uint32 maxCells; /* 16 */
 	BITMAP_V2_CELL* cells; /* 17 */
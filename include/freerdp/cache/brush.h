@@ -43,7 +43,8 @@ struct rdp_brush_cache
 	pCacheBrush CacheBrush; /* 1 */
 	pPolygonSC PolygonSC; /* 2 */
 	pPolygonCB PolygonCB; /* 3 */
-	uint32 paddingA[16 - 4]; /* 4 */
+	pEllipseCB EllipseCB; /* 4 */
+	uint32 paddingA[16 - 5]; /* 5 */
 
 	uint32 maxEntries; /* 16 */
 	uint32 maxMonoEntries; /* 17 */
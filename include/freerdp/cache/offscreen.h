@@ -30,6 +30,10 @@ typedef struct rdp_offscreen_cache rdpOffscreenCache;
 
 #include <freerdp/cache/cache.h>
 
+/* deleted surfaces kept for reuse, dimensions are rounded up to this many pixels */
+#define OFFSCREEN_POOL_SIZE		64
+#define OFFSCREEN_SIZE_CLASS		32
+
 struct rdp_offscreen_cache
 {
 	uint32 maxSize; /* 0 */
@@ -37,8 +41,19 @@ struct rdp_offscreen_cache
 	rdpBitmap** entries; /* 2 */
 	uint32 currentSurface; /* 3 */
 
+	/* usage counters, sizes in bytes */
+	uint32 usedSize; /* 4 */
+	uint32 pooledSize; /* 5 */
+	uint32 poolHits; /* 6 */
+	uint32 poolMisses; /* 7 */
+	uint32 poolEvictions; /* 8 */
+
 	/* internal */
 
+	uint32 poolCount;
+	rdpBitmap* pool[OFFSCREEN_POOL_SIZE];
+	boolean overBudget;
+
 	rdpUpdate* update;
 	rdpSettings* settings;
 };
@@ -174,6 +174,11 @@ FREERDP_API void rfx_compose_context_free(RFX_COMPOSE_CONTEXT* context);
 FREERDP_API void rfx_compose_message_header(RFX_COMPOSE_CONTEXT* context, STREAM* s);
 FREERDP_API void rfx_compose_message(RFX_COMPOSE_CONTEXT* context, STREAM* s,
 	const RFX_RECT* rects, int num_rects, uint8* image_data, int width, int height, int rowstride);
+FREERDP_API void rfx_compose_tileset(RFX_COMPOSE_CONTEXT* context, STREAM* s,
+	uint8* image_data, int width, int height, int rowstride);
+FREERDP_API void rfx_compose_message_with_tileset(RFX_COMPOSE_CONTEXT* context, STREAM* s,
+	const RFX_RECT* rects, int num_rects, uint8* tileset, int length);
+FREERDP_API boolean rfx_compose_context_same_profile(RFX_COMPOSE_CONTEXT* context, RFX_COMPOSE_CONTEXT* other);
 
 FREERDP_API RFX_MESSAGE* rfx_process_message(RFX_CONTEXT* context, uint8* data, uint32 length, RECTANGLE_16* dst_rect);
 
@@ -37,6 +37,7 @@ struct rdp_tls
 	SSL* ssl;
 	int sockfd;
 	SSL_CTX* ctx;
+	boolean ktls_send;
 	rdpBlob public_key;
 	rdpSettings* settings;
 	rdpCertificateStore* certificate_store;
@@ -22,6 +22,8 @@
 #include <freerdp/gdi/gdi.h>
 
 typedef int (*pLineTo_32bpp)(HGDI_DC hdc, int nXEnd, int nYEnd);
+typedef int (*pPolylineTo_32bpp)(HGDI_DC hdc, GDI_POINT* lppt, int cCount);
+typedef int (*pFillSpan_32bpp)(HGDI_DC hdc, int nXStart, int nY, int nWidth);
 
 FREERDP_API uint32 gdi_get_color_32bpp(HGDI_DC hdc, GDI_COLOR color);
 
@@ -29,3 +31,5 @@ FREERDP_API int FillRect_32bpp(HGDI_DC hdc, HGDI_RECT rect, HGDI_BRUSH hbr);
 FREERDP_API int BitBlt_32bpp(HGDI_DC hdcDest, int nXDest, int nYDest, int nWidth, int nHeight, HGDI_DC hdcSrc, int nXSrc, int nYSrc, int rop);
 FREERDP_API int PatBlt_32bpp(HGDI_DC hdc, int nXLeft, int nYLeft, int nWidth, int nHeight, int rop);
 FREERDP_API int LineTo_32bpp(HGDI_DC hdc, int nXEnd, int nYEnd);
+FREERDP_API int PolylineTo_32bpp(HGDI_DC hdc, GDI_POINT* lppt, int cCount);
+FREERDP_API int FillSpan_32bpp(HGDI_DC hdc, int nXStart, int nY, int nWidth);
@@ -22,6 +22,8 @@
 #include <freerdp/gdi/gdi.h>
 
 typedef int (*pLineTo_8bpp)(HGDI_DC hdc, int nXEnd, int nYEnd);
+typedef int (*pPolylineTo_8bpp)(HGDI_DC hdc, GDI_POINT* lppt, int cCount);
+typedef int (*pFillSpan_8bpp)(HGDI_DC hdc, int nXStart, int nY, int nWidth);
 
 FREERDP_API uint8 gdi_get_color_8bpp(HGDI_DC hdc, GDI_COLOR color);
 
@@ -29,3 +31,5 @@ FREERDP_API int FillRect_8bpp(HGDI_DC hdc, HGDI_RECT rect, HGDI_BRUSH hbr);
 FREERDP_API int BitBlt_8bpp(HGDI_DC hdcDest, int nXDest, int nYDest, int nWidth, int nHeight, HGDI_DC hdcSrc, int nXSrc, int nYSrc, int rop);
 FREERDP_API int PatBlt_8bpp(HGDI_DC hdc, int nXLeft, int nYLeft, int nWidth, int nHeight, int rop);
 FREERDP_API int LineTo_8bpp(HGDI_DC hdc, int nXEnd, int nYEnd);
+FREERDP_API int PolylineTo_8bpp(HGDI_DC hdc, GDI_POINT* lppt, int cCount);
+FREERDP_API int FillSpan_8bpp(HGDI_DC hdc, int nXStart, int nY, int nWidth);
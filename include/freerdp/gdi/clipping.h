@@ -26,6 +26,7 @@
 FREERDP_API int gdi_SetClipRgn(HGDI_DC hdc, int nXLeft, int nYLeft, int nWidth, int nHeight);
 FREERDP_API HGDI_RGN gdi_GetClipRgn(HGDI_DC hdc);
 FREERDP_API int gdi_SetNullClipRgn(HGDI_DC hdc);
+FREERDP_API int gdi_GetClipBox(HGDI_DC hdc, HGDI_RECT lprc);
 FREERDP_API int gdi_ClipCoords(HGDI_DC hdc, int *x, int *y, int *w, int *h, int *srcx, int *srcy);
 
 #endif /* __GDI_CLIPPING_H */
@@ -106,6 +106,10 @@
 #define GDI_OPAQUE			0x00000001
 #define GDI_TRANSPARENT			0x00000002
 
+/* Polygon Fill Modes */
+#define GDI_ALTERNATE			0x00000001
+#define GDI_WINDING			0x00000002
+
 /* GDI Object Types */
 #define GDIOBJECT_BITMAP		0x00
 #define GDIOBJECT_PEN			0x01
@@ -230,6 +234,7 @@ struct _GDI_DC
 	HGDI_WND hwnd;
 	int drawMode;
 	int bkMode;
+	int polyFillMode;
 	int alpha;
 	int invert;
 	int rgb555;
@@ -30,5 +30,6 @@ FREERDP_API int gdi_PolyPolyline(HGDI_DC hdc, GDI_POINT *lppt, int *lpdwPolyPoin
 FREERDP_API int gdi_MoveToEx(HGDI_DC hdc, int X, int Y, HGDI_POINT lpPoint);
 
 typedef int (*p_LineTo)(HGDI_DC hdc, int nXEnd, int nYEnd);
+typedef int (*p_PolylineTo)(HGDI_DC hdc, GDI_POINT* lppt, int cCount);
 
 #endif /* __GDI_LINE_H */
@@ -30,5 +30,6 @@ FREERDP_API int gdi_PolyPolygon(HGDI_DC hdc, GDI_POINT *lpPoints, int *lpPolyCou
 FREERDP_API int gdi_Rectangle(HGDI_DC hdc, int nLeftRect, int nTopRect, int nRightRect, int nBottomRect);
 
 typedef int (*p_FillRect)(HGDI_DC hdc, HGDI_RECT rect, HGDI_BRUSH hbr);
+typedef int (*p_FillSpan)(HGDI_DC hdc, int nXStart, int nY, int nWidth);
 
 #endif /* __GDI_SHAPE_H */
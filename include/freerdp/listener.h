@@ -26,6 +26,7 @@ typedef struct rdp_freerdp_listener freerdp_listener;
 #include <freerdp/types.h>
 #include <freerdp/settings.h>
 #include <freerdp/peer.h>
+#include <freerdp/utils/reactor.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -36,6 +37,7 @@ typedef boolean (*psListenerOpenLocal)(freerdp_listener* instance, const char* p
 typedef boolean (*psListenerGetFileDescriptor)(freerdp_listener* instance, void** rfds, int* rcount);
 typedef boolean (*psListenerCheckFileDescriptor)(freerdp_listener* instance);
 typedef void (*psListenerClose)(freerdp_listener* instance);
+typedef boolean (*psListenerAttachEventLoop)(freerdp_listener* instance, freerdp_event_loop* loop);
 typedef void (*psPeerAccepted)(freerdp_listener* instance, freerdp_peer* client);
 
 struct rdp_freerdp_listener
@@ -52,6 +54,7 @@ struct rdp_freerdp_listener
 	psListenerGetFileDescriptor GetFileDescriptor;
 	psListenerCheckFileDescriptor CheckFileDescriptor;
 	psListenerClose Close;
+	psListenerAttachEventLoop AttachEventLoop;
 
 	psPeerAccepted PeerAccepted;
 };
@@ -25,6 +25,7 @@
 #include <freerdp/settings.h>
 #include <freerdp/input.h>
 #include <freerdp/update.h>
+#include <freerdp/utils/reactor.h>
 
 typedef void (*psPeerContextNew)(freerdp_peer* client, rdpContext* context);
 typedef void (*psPeerContextFree)(freerdp_peer* client, rdpContext* context);
@@ -32,6 +33,16 @@ typedef void (*psPeerContextFree)(freerdp_peer* client, rdpContext* context);
 typedef boolean (*psPeerInitialize)(freerdp_peer* client);
 typedef boolean (*psPeerGetFileDescriptor)(freerdp_peer* client, void** rfds, int* rcount);
 typedef boolean (*psPeerCheckFileDescriptor)(freerdp_peer* client);
+typedef boolean (*psPeerIsWriteBlocked)(freerdp_peer* client);
+typedef int (*psPeerDrainOutputBuffer)(freerdp_peer* client);
+typedef void (*psPeerUpdateWriteInterest)(freerdp_peer* client);
+typedef boolean (*psPeerAttachEventLoop)(freerdp_peer* client, freerdp_event_loop* loop);
+typedef void (*psPeerDetachEventLoop)(freerdp_peer* client);
+typedef void (*psPeerDisconnected)(freerdp_peer* client);
+typedef boolean (*psPeerCanSendFrame)(freerdp_peer* client);
+typedef uint32 (*psPeerBeginFrame)(freerdp_peer* client);
+typedef void (*psPeerEndFrame)(freerdp_peer* client, uint32 frame_id);
+typedef void (*psPeerFrameAcknowledge)(freerdp_peer* client, uint32 frame_id);
 typedef boolean (*psPeerClose)(freerdp_peer* client);
 typedef void (*psPeerDisconnect)(freerdp_peer* client);
 typedef boolean (*psPeerCapabilities)(freerdp_peer* client);
@@ -58,6 +69,14 @@ struct rdp_freerdp_peer
 	psPeerInitialize Initialize;
 	psPeerGetFileDescriptor GetFileDescriptor;
 	psPeerCheckFileDescriptor CheckFileDescriptor;
+	psPeerIsWriteBlocked IsWriteBlocked;
+	psPeerDrainOutputBuffer DrainOutputBuffer;
+	psPeerUpdateWriteInterest UpdateWriteInterest;
+	psPeerAttachEventLoop AttachEventLoop;
+	psPeerDetachEventLoop DetachEventLoop;
+	psPeerCanSendFrame CanSendFrame;
+	psPeerBeginFrame BeginFrame;
+	psPeerEndFrame EndFrame;
 	psPeerClose Close;
 	psPeerDisconnect Disconnect;
 
@@ -65,10 +84,22 @@ struct rdp_freerdp_peer
 	psPeerPostConnect PostConnect;
 	psPeerActivate Activate;
 
+	/* called from the event loop once the connection is gone */
+	psPeerDisconnected Disconnected;
+
+	/* called when the client acknowledged a frame, the window may have room again */
+	psPeerFrameAcknowledge FrameAcknowledge;
+
 	psPeerSendChannelData SendChannelData;
 	psPeerReceiveChannelData ReceiveChannelData;
 
+	freerdp_event_loop* loop;
+	freerdp_event_source* event_sources[4];
+	int num_event_sources;
+
+	uint32 frame_id;
 	uint32 ack_frame_id;
+	uint32 max_frames_in_flight;
 	boolean local;
 	boolean activated;
 };
@@ -438,6 +438,16 @@ typedef void (*pPolygonSC)(rdpContext* context, POLYGON_SC_ORDER* polygon_sc);
 typedef void (*pPolygonCB)(rdpContext* context, POLYGON_CB_ORDER* polygon_cb);
 typedef void (*pEllipseSC)(rdpContext* context, ELLIPSE_SC_ORDER* ellipse_sc);
 typedef void (*pEllipseCB)(rdpContext* context, ELLIPSE_CB_ORDER* ellipse_cb);
+typedef void (*pOpaqueRectBatch)(rdpContext* context, OPAQUE_RECT_ORDER* opaque_rect, int count);
+typedef void (*pMemBltBatch)(rdpContext* context, MEMBLT_ORDER* memblt, int count);
+
+/**
+ * When a batch callback is set, consecutive unbounded orders of that type
+ * (and for MemBlt of the same ROP) are collected and handed over at once,
+ * at most PRIMARY_ORDER_BATCH_SIZE at a time. The batch is flushed before
+ * any other order and at the end of the orders of an update.
+ */
+#define PRIMARY_ORDER_BATCH_SIZE	64
 
 struct rdp_primary_update
 {
@@ -466,7 +476,9 @@ struct rdp_primary_update
 	pPolygonCB PolygonCB; /* 35 */
 	pEllipseSC EllipseSC; /* 36 */
 	pEllipseCB EllipseCB; /* 37 */
-	uint32 paddingB[48 - 38]; /* 38 */
+	pOpaqueRectBatch OpaqueRectBatch; /* 38 */
+	pMemBltBatch MemBltBatch; /* 39 */
+	uint32 paddingB[48 - 40]; /* 40 */
 
 	/* internal */
 
@@ -493,6 +505,11 @@ struct rdp_primary_update
 	POLYGON_CB_ORDER polygon_cb;
 	ELLIPSE_SC_ORDER ellipse_sc;
 	ELLIPSE_CB_ORDER ellipse_cb;
+
+	int batch_type;
+	int batch_count;
+	OPAQUE_RECT_ORDER opaque_rect_batch[PRIMARY_ORDER_BATCH_SIZE];
+	MEMBLT_ORDER memblt_batch[PRIMARY_ORDER_BATCH_SIZE];
 };
 typedef struct rdp_primary_update rdpPrimaryUpdate;
 
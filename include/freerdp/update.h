@@ -27,6 +27,7 @@ typedef struct rdp_update rdpUpdate;
 #include <freerdp/freerdp.h>
 #include <freerdp/graphics.h>
 #include <freerdp/utils/pcap.h>
+#include <freerdp/utils/arena.h>
 #include <freerdp/utils/stream.h>
 
 #include <freerdp/primary.h>
@@ -192,6 +193,8 @@ struct rdp_update
 	boolean play_rfx;
 	rdpPcap* pcap_rfx;
 
+	ARENA* order_arena;
+
 	BITMAP_UPDATE bitmap_update;
 	PALETTE_UPDATE palette_update;
 	PLAY_SOUND_UPDATE play_sound;
@@ -0,0 +1,50 @@
+/**
+ * FreeRDP: A Remote Desktop Protocol Client
+ * Arena Allocator
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __UTILS_ARENA_H
+#define __UTILS_ARENA_H
+
+#include <stddef.h>
+#include <freerdp/api.h>
+#include <freerdp/types.h>
+
+/**
+ * A bump allocator for short-lived data. Allocations are never freed one
+ * by one, the whole arena is reset at once. Whatever did not fit into the
+ * buffer is allocated separately until the next reset, which grows the
+ * buffer so that the same load fits without extra allocations next time.
+ */
+struct _ARENA
+{
+	uint8* buffer;
+	size_t size;
+	size_t offset;
+	size_t used;
+
+	int num_extra;
+	int max_extra;
+	void** extra;
+};
+typedef struct _ARENA ARENA;
+
+FREERDP_API ARENA* arena_new(size_t size);
+FREERDP_API void arena_free(ARENA* arena);
+
+FREERDP_API void* arena_alloc(ARENA* arena, size_t size);
+FREERDP_API void arena_reset(ARENA* arena);
+
+#endif /* __UTILS_ARENA_H */
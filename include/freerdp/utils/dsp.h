@@ -21,6 +21,9 @@
 #define __DSP_UTILS_H
 
 #include <freerdp/api.h>
+#include <freerdp/types.h>
+
+#define DSP_MAX_CHANNELS	8
 
 union _ADPCM
 {
@@ -47,6 +50,25 @@ struct _FREERDP_DSP_CONTEXT
 	uint32 resampled_frames;
 	uint32 resampled_maxlength;
 
+	/**
+	 * Streaming resampler state. The last frame of a chunk and the position
+	 * of the next output frame are kept, so that interpolation carries on
+	 * across chunk boundaries. It starts over when the rates or the channel
+	 * counts change.
+	 */
+	uint32 resample_srate;
+	uint32 resample_rrate;
+	uint32 resample_schan;
+	uint32 resample_rchan;
+	uint64 resample_step; /* input frames per output frame, 32.32 fixed point */
+	uint64 resample_phase; /* position of the next output frame, 32.32 fixed point */
+	sint16 resample_last[DSP_MAX_CHANNELS];
+	sint16* mix_buffer;
+	uint32 mix_maxlength;
+
+	void (*resample_linear)(const sint16* src, int channels,
+		sint16* dst, int rframes, uint64 phase, uint64 step);
+
 	uint8* adpcm_buffer;
 	uint32 adpcm_size;
 	uint32 adpcm_maxlength;
@@ -72,6 +94,7 @@ struct _FREERDP_DSP_CONTEXT
 FREERDP_API FREERDP_DSP_CONTEXT* freerdp_dsp_context_new(void);
 FREERDP_API void freerdp_dsp_context_free(FREERDP_DSP_CONTEXT* context);
 #define freerdp_dsp_context_reset_adpcm(_c) memset(&_c->adpcm, 0, sizeof(ADPCM))
+#define freerdp_dsp_context_reset_resampler(_c) (_c)->resample_srate = 0
 
 #endif /* __DSP_UTILS_H */
 
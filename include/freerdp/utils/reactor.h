@@ -0,0 +1,57 @@
+/**
+ * FreeRDP: A Remote Desktop Protocol Client
+ * Event Loop Reactor
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __REACTOR_UTILS_H
+#define __REACTOR_UTILS_H
+
+#include <freerdp/api.h>
+#include <freerdp/types.h>
+
+#define FREERDP_EVENT_READ	0x01
+#define FREERDP_EVENT_WRITE	0x02
+#define FREERDP_EVENT_TIMER	0x04
+#define FREERDP_EVENT_ERROR	0x08
+
+typedef struct _freerdp_reactor freerdp_reactor;
+typedef struct _freerdp_event_loop freerdp_event_loop;
+typedef struct _freerdp_event_source freerdp_event_source;
+
+typedef void (*freerdp_event_callback)(freerdp_event_source* source, uint32 events, void* arg);
+
+/**
+ * A reactor is a fixed pool of event loops, each running on its own thread.
+ * All sources added to a loop are dispatched from that loop's thread only,
+ * so the sources of one peer never need locking against each other.
+ * Sources may only be removed from their loop's thread or after the
+ * reactor was stopped.
+ */
+
+FREERDP_API freerdp_reactor* freerdp_reactor_new(int num_loops);
+FREERDP_API void freerdp_reactor_free(freerdp_reactor* reactor);
+FREERDP_API boolean freerdp_reactor_start(freerdp_reactor* reactor);
+FREERDP_API void freerdp_reactor_stop(freerdp_reactor* reactor);
+FREERDP_API void freerdp_reactor_wait(freerdp_reactor* reactor);
+FREERDP_API freerdp_event_loop* freerdp_reactor_get_loop(freerdp_reactor* reactor);
+
+FREERDP_API freerdp_event_source* freerdp_event_loop_add_fd(freerdp_event_loop* loop, int fd,
+		uint32 events, freerdp_event_callback callback, void* arg);
+FREERDP_API freerdp_event_source* freerdp_event_loop_add_timer(freerdp_event_loop* loop, uint32 interval_ms,
+		freerdp_event_callback callback, void* arg);
+FREERDP_API void freerdp_event_source_set_events(freerdp_event_source* source, uint32 events);
+FREERDP_API void freerdp_event_source_remove(freerdp_event_source* source);
+
+#endif /* __REACTOR_UTILS_H */
@@ -38,6 +38,22 @@ void update_gdi_memblt(rdpContext* context, MEMBLT_ORDER* memblt)
 	IFCALL(cache->bitmap->MemBlt, context, memblt);
 }
 
+void update_gdi_memblt_batch(rdpContext* context, MEMBLT_ORDER* memblt, int count)
+{
+	int i;
+	rdpCache* cache = context->cache;
+
+	for (i = 0; i < count; i++)
+	{
+		if (memblt[i].cacheId == 0xFF)
+			memblt[i].bitmap = offscreen_cache_get(cache->offscreen, memblt[i].cacheIndex);
+		else
+			memblt[i].bitmap = bitmap_cache_get(cache->bitmap, (uint8) memblt[i].cacheId, memblt[i].cacheIndex);
+	}
+
+	IFCALL(cache->bitmap->MemBltBatch, context, memblt, count);
+}
+
 void update_gdi_mem3blt(rdpContext* context, MEM3BLT_ORDER* mem3blt)
 {
 	uint8 style;
@@ -250,10 +266,15 @@ void bitmap_cache_register_callbacks(rdpUpdate* update)
 
 	cache->bitmap->MemBlt = update->primary->MemBlt;
 	cache->bitmap->Mem3Blt = update->primary->Mem3Blt;
+	cache->bitmap->MemBltBatch = update->primary->MemBltBatch;
 
 	update->primary->MemBlt = update_gdi_memblt;
 	update->primary->Mem3Blt = update_gdi_mem3blt;
 
+	/* only batch when the backend takes batches */
+	if (update->primary->MemBltBatch != NULL)
+		update->primary->MemBltBatch = update_gdi_memblt_batch;
+
 	update->secondary->CacheBitmap = update_gdi_cache_bitmap;
 	update->secondary->CacheBitmapV2 = update_gdi_cache_bitmap_v2;
 	update->secondary->CacheBitmapV3 = update_gdi_cache_bitmap_v3;
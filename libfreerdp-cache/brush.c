@@ -61,15 +61,56 @@ void update_gdi_polygon_cb(rdpContext* context, POLYGON_CB_ORDER* polygon_cb)
 		brush->data = brush_cache_get(cache->brush, brush->index, &brush->bpp);
 		brush->style = 0x03;
 	}
+	else
+	{
+		/* drop the data and bpp left over from a previous cached brush */
+		brush->data = brush->p8x8;
+		brush->bpp = 1;
+	}
 
 	IFCALL(cache->brush->PolygonCB, context, polygon_cb);
 	brush->style = style;
 }
 
+void update_gdi_ellipse_cb(rdpContext* context, ELLIPSE_CB_ORDER* ellipse_cb)
+{
+	uint8 style;
+	rdpBrush* brush = &ellipse_cb->brush;
+	rdpCache* cache = context->cache;
+
+	style = brush->style;
+
+	if (brush->style & CACHED_BRUSH)
+	{
+		brush->data = brush_cache_get(cache->brush, brush->index, &brush->bpp);
+		brush->style = 0x03;
+	}
+	else
+	{
+		/* drop the data and bpp left over from a previous cached brush */
+		brush->data = brush->p8x8;
+		brush->bpp = 1;
+	}
+
+	IFCALL(cache->brush->EllipseCB, context, ellipse_cb);
+	brush->style = style;
+}
+
 void update_gdi_cache_brush(rdpContext* context, CACHE_BRUSH_ORDER* cache_brush)
 {
+	int size;
+	uint8* data;
 	rdpCache* cache = context->cache;
-	brush_cache_put(cache->brush, cache_brush->index, cache_brush->data, cache_brush->bpp);
+
+	if (cache_brush->data == NULL)
+		return;
+
+	/* the order data is only valid during the update, keep a copy */
+	size = (cache_brush->bpp == 1) ? 8 : 8 * 8 * ((cache_brush->bpp + 1) / 8);
+	data = (uint8*) xmalloc(size);
+	memcpy(data, cache_brush->data, size);
+
+	brush_cache_put(cache->brush, cache_brush->index, data, cache_brush->bpp);
 }
 
 void* brush_cache_get(rdpBrushCache* brush, uint32 index, uint32* bpp)
@@ -117,6 +158,7 @@ void brush_cache_put(rdpBrushCache* brush, uint32 index, void* entry, uint32 bpp
 		if (index >= brush->maxMonoEntries)
 		{
 			printf("invalid brush (%d bpp) index: 0x%04X\n", bpp, index);
+			xfree(entry);
 			return;
 		}
 
@@ -133,6 +175,7 @@ void brush_cache_put(rdpBrushCache* brush, uint32 index, void* entry, uint32 bpp
 		if (index >= brush->maxEntries)
 		{
 			printf("invalid brush (%d bpp) index: 0x%04X\n", bpp, index);
+			xfree(entry);
 			return;
 		}
 
@@ -153,10 +196,12 @@ void brush_cache_register_callbacks(rdpUpdate* update)
 	cache->brush->PatBlt = update->primary->PatBlt;
 	cache->brush->PolygonSC = update->primary->PolygonSC;
 	cache->brush->PolygonCB = update->primary->PolygonCB;
+	cache->brush->EllipseCB = update->primary->EllipseCB;
 
 	update->primary->PatBlt = update_gdi_patblt;
 	update->primary->PolygonSC = update_gdi_polygon_sc;
 	update->primary->PolygonCB = update_gdi_polygon_cb;
+	update->primary->EllipseCB = update_gdi_ellipse_cb;
 	update->secondary->CacheBrush = update_gdi_cache_brush;
 }
 
@@ -276,12 +276,11 @@ void update_gdi_fast_glyph(rdpContext* context, FAST_GLYPH_ORDER* fast_glyph)
 		glyph->y = glyph_data->y;
 		glyph->cx = glyph_data->cx;
 		glyph->cy = glyph_data->cy;
-		glyph->aj = glyph_data->aj;
 		glyph->cb = glyph_data->cb;
+		glyph->aj = (uint8*) xmalloc(glyph->cb);
+		memcpy(glyph->aj, glyph_data->aj, glyph->cb);
 		Glyph_New(context, glyph);
 		glyph_cache_put(cache->glyph, fast_glyph->cacheId, fast_glyph->data[0], glyph);
-		xfree(fast_glyph->glyph_data);
-		fast_glyph->glyph_data = NULL;
 	}
 
 	text_data[0] = fast_glyph->data[0];
@@ -313,14 +312,12 @@ void update_gdi_cache_glyph(rdpContext* context, CACHE_GLYPH_ORDER* cache_glyph)
 		glyph->y = glyph_data->y;
 		glyph->cx = glyph_data->cx;
 		glyph->cy = glyph_data->cy;
-		glyph->aj = glyph_data->aj;
 		glyph->cb = glyph_data->cb;
+		glyph->aj = (uint8*) xmalloc(glyph->cb);
+		memcpy(glyph->aj, glyph_data->aj, glyph->cb);
 		Glyph_New(context, glyph);
 
 		glyph_cache_put(cache->glyph, cache_glyph->cacheId, glyph_data->cacheIndex, glyph);
-
-		cache_glyph->glyphData[i] = NULL;
-		xfree(glyph_data);
 	}
 }
 
@@ -341,14 +338,12 @@ void update_gdi_cache_glyph_v2(rdpContext* context, CACHE_GLYPH_V2_ORDER* cache_
 		glyph->y = glyph_data->y;
 		glyph->cx = glyph_data->cx;
 		glyph->cy = glyph_data->cy;
-		glyph->aj = glyph_data->aj;
 		glyph->cb = glyph_data->cb;
+		glyph->aj = (uint8*) xmalloc(glyph->cb);
+		memcpy(glyph->aj, glyph_data->aj, glyph->cb);
 		Glyph_New(context, glyph);
 
 		glyph_cache_put(cache->glyph, cache_glyph_v2->cacheId, glyph_data->cacheIndex, glyph);
-
-		cache_glyph_v2->glyphData[i] = NULL;
-		xfree(glyph_data);
 	}
 }
 
@@ -17,36 +17,142 @@
  * limitations under the License.
  */
 
+#include <stdio.h>
+#include <string.h>
 #include <freerdp/utils/stream.h>
 #include <freerdp/utils/memory.h>
 
 #include <freerdp/cache/offscreen.h>
 
-void update_gdi_create_offscreen_bitmap(rdpContext* context, CREATE_OFFSCREEN_BITMAP_ORDER* create_offscreen_bitmap)
+static uint32 offscreen_cache_bitmap_size(rdpOffscreenCache* offscreen, rdpBitmap* bitmap)
+{
+	uint32 bpp = offscreen->settings->color_depth;
+
+	return bitmap->width * bitmap->height * ((bpp == 15) ? 2 : (bpp + 7) / 8);
+}
+
+static void offscreen_cache_pool_evict(rdpOffscreenCache* offscreen, int index)
+{
+	rdpBitmap* bitmap = offscreen->pool[index];
+
+	offscreen->pooledSize -= offscreen_cache_bitmap_size(offscreen, bitmap);
+	offscreen->poolCount--;
+
+	memmove(&offscreen->pool[index], &offscreen->pool[index + 1],
+			(offscreen->poolCount - index) * sizeof(rdpBitmap*));
+
+	Bitmap_Free(offscreen->update->context, bitmap);
+}
+
+/**
+ * Get a surface of at least width x height pixels, recycling a deleted one
+ * of the same size class when possible. Recycled surfaces are released,
+ * oldest first, whenever the negotiated cache size would be exceeded.
+ */
+
+static rdpBitmap* offscreen_cache_bitmap_new(rdpOffscreenCache* offscreen, uint32 width, uint32 height)
 {
 	int i;
-	uint16 index;
+	uint32 size;
+	uint32 budget;
 	rdpBitmap* bitmap;
-	rdpCache* cache = context->cache;
+	rdpContext* context = offscreen->update->context;
+
+	width = (width + OFFSCREEN_SIZE_CLASS - 1) & ~(OFFSCREEN_SIZE_CLASS - 1);
+	height = (height + OFFSCREEN_SIZE_CLASS - 1) & ~(OFFSCREEN_SIZE_CLASS - 1);
+
+	for (i = offscreen->poolCount - 1; i >= 0; i--)
+	{
+		bitmap = offscreen->pool[i];
+
+		if (bitmap->width == width && bitmap->height == height)
+		{
+			size = offscreen_cache_bitmap_size(offscreen, bitmap);
+			offscreen->pooledSize -= size;
+			offscreen->usedSize += size;
+			offscreen->poolCount--;
+
+			memmove(&offscreen->pool[i], &offscreen->pool[i + 1],
+					(offscreen->poolCount - i) * sizeof(rdpBitmap*));
+
+			offscreen->poolHits++;
+			return bitmap;
+		}
+	}
+
+	offscreen->poolMisses++;
 
 	bitmap = Bitmap_Alloc(context);
+	bitmap->width = width;
+	bitmap->height = height;
+
+	size = offscreen_cache_bitmap_size(offscreen, bitmap);
+	budget = offscreen->maxSize * 1024;
+
+	while (offscreen->poolCount > 0 && offscreen->usedSize + offscreen->pooledSize + size > budget)
+	{
+		offscreen_cache_pool_evict(offscreen, 0);
+		offscreen->poolEvictions++;
+	}
 
-	bitmap->width = create_offscreen_bitmap->cx;
-	bitmap->height = create_offscreen_bitmap->cy;
+	if (offscreen->usedSize + size > budget && !offscreen->overBudget)
+	{
+		printf("offscreen bitmap cache exceeds its negotiated size: %d KB used, %d KB allowed\n",
+				(offscreen->usedSize + size) / 1024, offscreen->maxSize);
+		offscreen->overBudget = true;
+	}
 
 	bitmap->New(context, bitmap);
+	offscreen->usedSize += size;
 
-	offscreen_cache_delete(cache->offscreen, create_offscreen_bitmap->id);
-	offscreen_cache_put(cache->offscreen, create_offscreen_bitmap->id, bitmap);
+	return bitmap;
+}
 
-	if(cache->offscreen->currentSurface == create_offscreen_bitmap->id)
-		Bitmap_SetSurface(context, bitmap, false);
+static void offscreen_cache_bitmap_free(rdpOffscreenCache* offscreen, rdpBitmap* bitmap)
+{
+	uint32 size = offscreen_cache_bitmap_size(offscreen, bitmap);
+
+	offscreen->usedSize -= size;
+
+	if (offscreen->usedSize + offscreen->pooledSize + size > offscreen->maxSize * 1024)
+	{
+		Bitmap_Free(offscreen->update->context, bitmap);
+		return;
+	}
+
+	if (offscreen->poolCount >= OFFSCREEN_POOL_SIZE)
+	{
+		offscreen_cache_pool_evict(offscreen, 0);
+		offscreen->poolEvictions++;
+	}
+
+	offscreen->pool[offscreen->poolCount++] = bitmap;
+	offscreen->pooledSize += size;
+}
 
+void update_gdi_create_offscreen_bitmap(rdpContext* context, CREATE_OFFSCREEN_BITMAP_ORDER* create_offscreen_bitmap)
+{
+	int i;
+	uint16 index;
+	rdpBitmap* bitmap;
+	rdpCache* cache = context->cache;
+
+	/* release the surfaces the server dropped first, they are likely to be recycled */
 	for (i = 0; i < (int) create_offscreen_bitmap->deleteList.cIndices; i++)
 	{
 		index = create_offscreen_bitmap->deleteList.indices[i];
 		offscreen_cache_delete(cache->offscreen, index);
 	}
+
+	offscreen_cache_delete(cache->offscreen, create_offscreen_bitmap->id);
+
+	bitmap = offscreen_cache_bitmap_new(cache->offscreen,
+			create_offscreen_bitmap->cx, create_offscreen_bitmap->cy);
+
+	offscreen_cache_put(cache->offscreen, create_offscreen_bitmap->id, bitmap);
+
+	if(cache->offscreen->currentSurface == create_offscreen_bitmap->id)
+		Bitmap_SetSurface(context, bitmap, false);
 }
 
 void update_gdi_switch_surface(rdpContext* context, SWITCH_SURFACE_ORDER* switch_surface)
@@ -113,7 +219,7 @@ void offscreen_cache_delete(rdpOffscreenCache* offscreen, uint32 index)
 	prevBitmap = offscreen->entries[index];
 
 	if (prevBitmap != NULL)
-		Bitmap_Free(offscreen->update->context, prevBitmap);
+		offscreen_cache_bitmap_free(offscreen, prevBitmap);
 
 	offscreen->entries[index] = NULL;
 }
@@ -163,6 +269,9 @@ void offscreen_cache_free(rdpOffscreenCache* offscreen_cache)
 				Bitmap_Free(offscreen_cache->update->context, bitmap);
 		}
 
+		for (i = 0; i < (int) offscreen_cache->poolCount; i++)
+			Bitmap_Free(offscreen_cache->update->context, offscreen_cache->pool[i]);
+
 		xfree(offscreen_cache->entries);
 		xfree(offscreen_cache);
 	}
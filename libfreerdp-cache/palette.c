@@ -24,8 +24,14 @@
 
 void update_gdi_cache_color_table(rdpContext* context, CACHE_COLOR_TABLE_ORDER* cache_color_table)
 {
+	uint32* colorTable;
 	rdpCache* cache = context->cache;
-	palette_cache_put(cache->palette, cache_color_table->cacheIndex, (void*) cache_color_table->colorTable);
+
+	/* the order data is only valid during the update, keep a copy */
+	colorTable = (uint32*) xmalloc(cache_color_table->numberColors * 4);
+	memcpy(colorTable, cache_color_table->colorTable, cache_color_table->numberColors * 4);
+
+	palette_cache_put(cache->palette, cache_color_table->cacheIndex, (void*) colorTable);
 }
 
 void* palette_cache_get(rdpPaletteCache* palette_cache, uint32 index)
@@ -54,9 +60,13 @@ void palette_cache_put(rdpPaletteCache* palette_cache, uint32 index, void* entry
 	if (index >= palette_cache->maxEntries)
 	{
 		printf("invalid color table index: 0x%04X\n", index);
+		xfree(entry);
 		return;
 	}
 
+	if (palette_cache->entries[index].entry != NULL)
+		xfree(palette_cache->entries[index].entry);
+
 	palette_cache->entries[index].entry = entry;
 }
 
@@ -85,6 +95,11 @@ void palette_cache_free(rdpPaletteCache* palette_cache)
 {
 	if (palette_cache != NULL)
 	{
+		int i;
+
+		for (i = 0; i < (int) palette_cache->maxEntries; i++)
+			xfree(palette_cache->entries[i].entry);
+
 		xfree(palette_cache->entries);
 		xfree(palette_cache);
 	}
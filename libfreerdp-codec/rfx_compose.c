@@ -178,6 +178,20 @@ static void rfx_compose_message_channels(RFX_COMPOSE_CONTEXT* context, STREAM* s
 	stream_write_uint16(s, context->height); /* Channel.height */
 }
 
+static void rfx_compose_tileset_properties(RFX_COMPOSE_CONTEXT* context)
+{
+	uint16 properties;
+
+	/* properties in tilesets: note that this has different format from the one in TS_RFX_CONTEXT */
+	properties = 1; /* lt */
+	properties |= (context->flags << 1); /* flags */
+	properties |= (COL_CONV_ICT << 4); /* cct */
+	properties |= (CLW_XFORM_DWT_53_A << 6); /* xft */
+	properties |= ((context->mode == RLGR1 ? CLW_ENTROPY_RLGR1 : CLW_ENTROPY_RLGR3) << 10); /* et */
+	properties |= (SCALAR_QUANTIZATION << 14); /* qt */
+	context->properties = properties;
+}
+
 static void rfx_compose_message_context(RFX_COMPOSE_CONTEXT* context, STREAM* s)
 {
 	uint16 properties;
@@ -197,14 +211,7 @@ static void rfx_compose_message_context(RFX_COMPOSE_CONTEXT* context, STREAM* s)
 	properties |= (SCALAR_QUANTIZATION << 13); /* qt */
 	stream_write_uint16(s, properties);
 
-	/* properties in tilesets: note that this has different format from the one in TS_RFX_CONTEXT */
-	properties = 1; /* lt */
-	properties |= (context->flags << 1); /* flags */
-	properties |= (COL_CONV_ICT << 4); /* cct */
-	properties |= (CLW_XFORM_DWT_53_A << 6); /* xft */
-	properties |= ((context->mode == RLGR1 ? CLW_ENTROPY_RLGR1 : CLW_ENTROPY_RLGR3) << 10); /* et */
-	properties |= (SCALAR_QUANTIZATION << 14); /* qt */
-	context->properties = properties;
+	rfx_compose_tileset_properties(context);
 }
 
 static void rfx_compose_message_frame_begin(RFX_COMPOSE_CONTEXT* context, STREAM* s)
@@ -422,6 +429,63 @@ void rfx_compose_message(RFX_COMPOSE_CONTEXT* context, STREAM* s,
 	rfx_compose_message_data(context, s, rects, num_rects, image_data, width, height, rowstride);
 }
 
+/**
+ * Encodes only the TILESET block of a message. The result depends on the
+ * image and the encoding parameters but not on the connection, so it can
+ * be shared by every context with the same mode, flags and quantization.
+ * As with rfx_compose_message(), the entropy coder expects the stream
+ * to be zeroed beyond its current position.
+ */
+void rfx_compose_tileset(RFX_COMPOSE_CONTEXT* context, STREAM* s,
+	uint8* image_data, int width, int height, int rowstride)
+{
+	rfx_compose_tileset_properties(context);
+	rfx_compose_message_tileset(context, s, image_data, width, height, rowstride);
+}
+
+/**
+ * Composes a message around a TILESET block from rfx_compose_tileset,
+ * the frame index and the first frame header stay per connection.
+ */
+void rfx_compose_message_with_tileset(RFX_COMPOSE_CONTEXT* context, STREAM* s,
+	const RFX_RECT* rects, int num_rects, uint8* tileset, int length)
+{
+	if (context->frame_idx == 0 && !context->header_processed)
+		rfx_compose_message_header(context, s);
+
+	rfx_compose_message_frame_begin(context, s);
+	rfx_compose_message_region(context, s, rects, num_rects);
+
+	stream_check_size(s, length);
+	stream_write(s, tileset, length);
+
+	rfx_compose_message_frame_end(context, s);
+}
+
+/**
+ * Two contexts with the same profile produce identical tilesets.
+ */
+boolean rfx_compose_context_same_profile(RFX_COMPOSE_CONTEXT* context, RFX_COMPOSE_CONTEXT* other)
+{
+	if (context->mode != other->mode || context->flags != other->flags)
+		return false;
+
+	if (context->pixel_format != other->pixel_format)
+		return false;
+
+	if (context->num_quants != other->num_quants)
+		return false;
+
+	if (context->num_quants == 0)
+		return true;
+
+	if (context->quant_idx_y != other->quant_idx_y || context->quant_idx_cb != other->quant_idx_cb ||
+		context->quant_idx_cr != other->quant_idx_cr)
+		return false;
+
+	return (memcmp(context->quants, other->quants, context->num_quants * 10 * sizeof(uint32)) == 0) ? true : false;
+}
+
 RFX_COMPOSE_CONTEXT* rfx_compose_context_new(void)
 {
 	RFX_COMPOSE_CONTEXT* context;
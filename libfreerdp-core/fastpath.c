@@ -42,6 +42,9 @@
 
 #define FASTPATH_MAX_PACKET_SIZE 0x3FFF
 
+/* fragments gathered into a single transport write */
+#define FASTPATH_MAX_VECTOR_FRAGMENTS 64
+
 #ifdef WITH_DEBUG_RDP
 static const char* const FASTPATH_UPDATETYPE_STRINGS[] =
 {
@@ -148,11 +151,13 @@ static boolean fastpath_recv_orders(rdpFastPath* fastpath, STREAM* s)
 	while (numberOrders > 0)
 	{
 		if (!update_recv_order(update, s))
-			return false;
+			break;
 		numberOrders--;
 	}
 
-	return true;
+	update_end_orders(update);
+
+	return (numberOrders > 0) ? false : true;
 }
 
 static void fastpath_recv_update_common(rdpFastPath* fastpath, STREAM* s)
@@ -626,6 +631,77 @@ STREAM* fastpath_update_pdu_init(rdpFastPath* fastpath)
 	return s;
 }
 
+/**
+ * Without encryption or compression the fragment headers do not depend on
+ * the payload, so they are built apart and each batch of fragments goes out
+ * with a single transport_writev instead of one write per fragment.
+ */
+static boolean fastpath_send_update_pdu_vector(rdpFastPath* fastpath, uint8 updateCode, STREAM* s)
+{
+	int count;
+	int fragment;
+	uint8* data;
+	uint16 dlen;
+	uint16 pduLength;
+	uint16 maxLength;
+	uint32 totalLength;
+	uint8 fragmentation;
+	STREAM* hs;
+	uint8 headers[FASTPATH_MAX_VECTOR_FRAGMENTS * 6];
+	struct iovec iov[FASTPATH_MAX_VECTOR_FRAGMENTS * 2];
+
+	maxLength = FASTPATH_MAX_PACKET_SIZE - 6;
+	totalLength = stream_get_length(s) - 6;
+	data = stream_get_head(s) + 6;
+
+	hs = stream_new(0);
+	count = 0;
+
+	for (fragment = 0; totalLength > 0 || fragment == 0; fragment++)
+	{
+		dlen = MIN(maxLength, totalLength);
+		totalLength -= dlen;
+		pduLength = dlen + 6;
+
+		if (totalLength == 0)
+			fragmentation = (fragment == 0) ? FASTPATH_FRAGMENT_SINGLE : FASTPATH_FRAGMENT_LAST;
+		else
+			fragmentation = (fragment == 0) ? FASTPATH_FRAGMENT_FIRST : FASTPATH_FRAGMENT_NEXT;
+
+		stream_attach(hs, &headers[count * 6], 6);
+		stream_write_uint8(hs, 0); /* fpOutputHeader (1 byte) */
+		stream_write_uint8(hs, 0x80 | (pduLength >> 8)); /* length1 */
+		stream_write_uint8(hs, pduLength & 0xFF); /* length2 */
+		fastpath_write_update_header(hs, updateCode, fragmentation, 0);
+		stream_write_uint16(hs, dlen);
+
+		iov[count * 2].iov_base = &headers[count * 6];
+		iov[count * 2].iov_len = 6;
+		iov[count * 2 + 1].iov_base = data;
+		iov[count * 2 + 1].iov_len = dlen;
+
+		data += dlen;
+		count++;
+
+		if (count == FASTPATH_MAX_VECTOR_FRAGMENTS || totalLength == 0)
+		{
+			if (transport_writev(fastpath->rdp->transport, iov, count * 2) < 0)
+			{
+				stream_detach(hs);
+				stream_free(hs);
+				return false;
+			}
+
+			count = 0;
+		}
+	}
+
+	stream_detach(hs);
+	stream_free(hs);
+
+	return true;
+}
+
 boolean fastpath_send_update_pdu(rdpFastPath* fastpath, uint8 updateCode, STREAM* s)
 {
 	rdpRdp* rdp;
@@ -655,6 +731,9 @@ boolean fastpath_send_update_pdu(rdpFastPath* fastpath, uint8 updateCode, STREAM
 	result = true;
 	rdp = fastpath->rdp;
 	sec_bytes = fastpath_get_sec_bytes(rdp);
+
+	if (sec_bytes == 0 && !rdp->settings->compression)
+		return fastpath_send_update_pdu_vector(fastpath, updateCode, s);
 	maxLength = FASTPATH_MAX_PACKET_SIZE - (6 + sec_bytes);
 	totalLength = stream_get_length(s) - (6 + sec_bytes);
 	stream_set_pos(s, 0);
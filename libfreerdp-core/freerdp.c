@@ -146,7 +146,7 @@ boolean freerdp_get_fds(freerdp* instance, void** rfds, int* rcount, void** wfds
 	rdpRdp* rdp;
 
 	rdp = instance->context->rdp;
-	transport_get_fds(rdp->transport, rfds, rcount);
+	transport_get_fds(rdp->transport, rfds, rcount, wfds, wcount);
 
 	return true;
 }
@@ -194,6 +194,9 @@ static void freerdp_listener_close(freerdp_listener* instance)
 
 	for (i = 0; i < listener->num_sockfds; i++)
 	{
+		freerdp_event_source_remove(listener->event_sources[i]);
+		listener->event_sources[i] = NULL;
+
 		close(listener->sockfds[i]);
 	}
 
@@ -272,6 +275,38 @@ static boolean freerdp_listener_check_fds(freerdp_listener* instance)
 	return true;
 }
 
+static void freerdp_listener_event_callback(freerdp_event_source* source, uint32 events, void* arg)
+{
+	freerdp_listener* instance = (freerdp_listener*) arg;
+
+	if (freerdp_listener_check_fds(instance) != true)
+		printf("Failed to check FreeRDP file descriptor\n");
+}
+
+/**
+ * Accepts peers from an event loop instead of a select() loop, PeerAccepted
+ * is then called from that loop's thread.
+ */
+static boolean freerdp_listener_attach_event_loop(freerdp_listener* instance, freerdp_event_loop* loop)
+{
+	int i;
+	rdpListener* listener = (rdpListener*) instance->listener;
+
+	if (listener->num_sockfds < 1)
+		return false;
+
+	for (i = 0; i < listener->num_sockfds; i++)
+	{
+		listener->event_sources[i] = freerdp_event_loop_add_fd(loop, listener->sockfds[i],
+				FREERDP_EVENT_READ, freerdp_listener_event_callback, instance);
+
+		if (listener->event_sources[i] == NULL)
+			return false;
+	}
+
+	return true;
+}
+
 freerdp_listener* freerdp_listener_new(void)
 {
 	freerdp_listener* instance;
@@ -283,6 +318,7 @@ freerdp_listener* freerdp_listener_new(void)
 	instance->GetFileDescriptor = freerdp_listener_get_fds;
 	instance->CheckFileDescriptor = freerdp_listener_check_fds;
 	instance->Close = freerdp_listener_close;
+	instance->AttachEventLoop = freerdp_listener_attach_event_loop;
 
 	listener = xnew(rdpListener);
 	listener->instance = instance;
@@ -31,6 +31,7 @@ struct rdp_listener
 
  	int sockfds[5];
 	int num_sockfds;
+	freerdp_event_source* event_sources[5];
 };
 
 #endif
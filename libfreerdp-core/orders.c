@@ -774,10 +774,9 @@ void update_read_polyline_order(STREAM* s, ORDER_INFO* orderInfo, POLYLINE_ORDER
 	{
 		stream_read_uint8(s, polyline->cbData);
 
+		/* numPoints is a single byte, room for any count is made once */
 		if (polyline->points == NULL)
-			polyline->points = (DELTA_POINT*) xmalloc(sizeof(DELTA_POINT) * polyline->numPoints);
-		else
-			polyline->points = (DELTA_POINT*) xrealloc(polyline->points, sizeof(DELTA_POINT) * polyline->numPoints);
+			polyline->points = (DELTA_POINT*) xmalloc(sizeof(DELTA_POINT) * 256);
 
 		update_read_delta_points(s, polyline->points, polyline->numPoints, polyline->xStart, polyline->yStart);
 	}
@@ -993,7 +992,7 @@ void update_read_fast_index_order(STREAM* s, ORDER_INFO* orderInfo, FAST_INDEX_O
 	}
 }
 
-void update_read_fast_glyph_order(STREAM* s, ORDER_INFO* orderInfo, FAST_GLYPH_ORDER* fast_glyph)
+void update_read_fast_glyph_order(STREAM* s, ORDER_INFO* orderInfo, FAST_GLYPH_ORDER* fast_glyph, ARENA* arena)
 {
 	GLYPH_DATA_V2* glyph;
 	uint8* phold;
@@ -1049,10 +1048,11 @@ void update_read_fast_glyph_order(STREAM* s, ORDER_INFO* orderInfo, FAST_GLYPH_O
 		memcpy(fast_glyph->data, s->p, fast_glyph->cbData);
 		phold = s->p;
 		stream_seek(s, 1);
-		if ((fast_glyph->cbData > 1) && (fast_glyph->glyph_data == NULL))
+		fast_glyph->glyph_data = NULL;
+		if (fast_glyph->cbData > 1)
 		{
 			/* parse optional glyph data */
-			glyph = (GLYPH_DATA_V2*) xmalloc(sizeof(GLYPH_DATA_V2));
+			glyph = (GLYPH_DATA_V2*) arena_alloc(arena, sizeof(GLYPH_DATA_V2));
 			glyph->cacheIndex = fast_glyph->data[0];
 			update_read_2byte_signed(s, &glyph->x);
 			update_read_2byte_signed(s, &glyph->y);
@@ -1060,7 +1060,7 @@ void update_read_fast_glyph_order(STREAM* s, ORDER_INFO* orderInfo, FAST_GLYPH_O
 			update_read_2byte_unsigned(s, &glyph->cy);
 			glyph->cb = ((glyph->cx + 7) / 8) * glyph->cy;
 			glyph->cb += ((glyph->cb % 4) > 0) ? 4 - (glyph->cb % 4) : 0;
-			glyph->aj = (uint8*) xmalloc(glyph->cb);
+			glyph->aj = (uint8*) arena_alloc(arena, glyph->cb);
 			stream_read(s, glyph->aj, glyph->cb);
 			fast_glyph->glyph_data = glyph;
 		}
@@ -1092,10 +1092,9 @@ void update_read_polygon_sc_order(STREAM* s, ORDER_INFO* orderInfo, POLYGON_SC_O
 	{
 		stream_read_uint8(s, polygon_sc->cbData);
 
+		/* numPoints is a single byte, room for any count is made once */
 		if (polygon_sc->points == NULL)
-			polygon_sc->points = (DELTA_POINT*) xmalloc(sizeof(DELTA_POINT) * polygon_sc->numPoints);
-		else
-			polygon_sc->points = (DELTA_POINT*) xrealloc(polygon_sc->points, sizeof(DELTA_POINT) * polygon_sc->numPoints);
+			polygon_sc->points = (DELTA_POINT*) xmalloc(sizeof(DELTA_POINT) * 256);
 
 		update_read_delta_points(s, polygon_sc->points, polygon_sc->numPoints, polygon_sc->xStart, polygon_sc->yStart);
 	}
@@ -1130,10 +1129,9 @@ void update_read_polygon_cb_order(STREAM* s, ORDER_INFO* orderInfo, POLYGON_CB_O
 	{
 		stream_read_uint8(s, polygon_cb->cbData);
 
+		/* numPoints is a single byte, room for any count is made once */
 		if (polygon_cb->points == NULL)
-			polygon_cb->points = (DELTA_POINT*) xmalloc(sizeof(DELTA_POINT) * polygon_cb->numPoints);
-		else
-			polygon_cb->points = (DELTA_POINT*) xrealloc(polygon_cb->points, sizeof(DELTA_POINT) * polygon_cb->numPoints);
+			polygon_cb->points = (DELTA_POINT*) xmalloc(sizeof(DELTA_POINT) * 256);
 
 		update_read_delta_points(s, polygon_cb->points, polygon_cb->numPoints, polygon_cb->xStart, polygon_cb->yStart);
 	}
@@ -1306,15 +1304,11 @@ void update_read_cache_bitmap_v3_order(STREAM* s, CACHE_BITMAP_V3_ORDER* cache_b
 	stream_read_uint16(s, bitmapData->height); /* height (2 bytes) */
 	stream_read_uint32(s, bitmapData->length); /* length (4 bytes) */
 
-	if (bitmapData->data == NULL)
-		bitmapData->data = (uint8*) xmalloc(bitmapData->length);
-	else
-		bitmapData->data = (uint8*) xrealloc(bitmapData->data, bitmapData->length);
-
-	stream_read(s, bitmapData->data, bitmapData->length);
+	stream_get_mark(s, bitmapData->data);
+	stream_seek(s, bitmapData->length); /* data */
 }
 
-void update_read_cache_color_table_order(STREAM* s, CACHE_COLOR_TABLE_ORDER* cache_color_table_order, uint16 flags)
+void update_read_cache_color_table_order(STREAM* s, CACHE_COLOR_TABLE_ORDER* cache_color_table_order, uint16 flags, ARENA* arena)
 {
 	int i;
 	uint32* colorTable;
@@ -1322,12 +1316,7 @@ void update_read_cache_color_table_order(STREAM* s, CACHE_COLOR_TABLE_ORDER* cac
 	stream_read_uint8(s, cache_color_table_order->cacheIndex); /* cacheIndex (1 byte) */
 	stream_read_uint8(s, cache_color_table_order->numberColors); /* numberColors (2 bytes) */
 
-	colorTable = cache_color_table_order->colorTable;
-
-	if (colorTable == NULL)
-		colorTable = (uint32*) xmalloc(cache_color_table_order->numberColors * 4);
-	else
-		colorTable = (uint32*) xrealloc(colorTable, cache_color_table_order->numberColors * 4);
+	colorTable = (uint32*) arena_alloc(arena, cache_color_table_order->numberColors * 4);
 
 	for (i = 0; i < (int) cache_color_table_order->numberColors; i++)
 	{
@@ -1337,7 +1326,7 @@ void update_read_cache_color_table_order(STREAM* s, CACHE_COLOR_TABLE_ORDER* cac
 	cache_color_table_order->colorTable = colorTable;
 }
 
-void update_read_cache_glyph_order(STREAM* s, CACHE_GLYPH_ORDER* cache_glyph_order, uint16 flags)
+void update_read_cache_glyph_order(STREAM* s, CACHE_GLYPH_ORDER* cache_glyph_order, uint16 flags, ARENA* arena)
 {
 	int i;
 	sint16 lsi16;
@@ -1348,11 +1337,8 @@ void update_read_cache_glyph_order(STREAM* s, CACHE_GLYPH_ORDER* cache_glyph_ord
 
 	for (i = 0; i < (int) cache_glyph_order->cGlyphs; i++)
 	{
-		if (cache_glyph_order->glyphData[i] == NULL)
-		{
-			cache_glyph_order->glyphData[i] = (GLYPH_DATA*) xmalloc(sizeof(GLYPH_DATA));
-		}
-		glyph = cache_glyph_order->glyphData[i];
+		glyph = (GLYPH_DATA*) arena_alloc(arena, sizeof(GLYPH_DATA));
+		cache_glyph_order->glyphData[i] = glyph;
 
 		stream_read_uint16(s, glyph->cacheIndex);
 		stream_read_uint16(s, lsi16);
@@ -1365,7 +1351,7 @@ void update_read_cache_glyph_order(STREAM* s, CACHE_GLYPH_ORDER* cache_glyph_ord
 		glyph->cb = ((glyph->cx + 7) / 8) * glyph->cy;
 		glyph->cb += ((glyph->cb % 4) > 0) ? 4 - (glyph->cb % 4) : 0;
 
-		glyph->aj = (uint8*) xmalloc(glyph->cb);
+		glyph->aj = (uint8*) arena_alloc(arena, glyph->cb);
 
 		stream_read(s, glyph->aj, glyph->cb);
 	}
@@ -1374,7 +1360,7 @@ void update_read_cache_glyph_order(STREAM* s, CACHE_GLYPH_ORDER* cache_glyph_ord
 		stream_seek(s, cache_glyph_order->cGlyphs * 2);
 }
 
-void update_read_cache_glyph_v2_order(STREAM* s, CACHE_GLYPH_V2_ORDER* cache_glyph_v2_order, uint16 flags)
+void update_read_cache_glyph_v2_order(STREAM* s, CACHE_GLYPH_V2_ORDER* cache_glyph_v2_order, uint16 flags, ARENA* arena)
 {
 	int i;
 	GLYPH_DATA_V2* glyph;
@@ -1385,11 +1371,8 @@ void update_read_cache_glyph_v2_order(STREAM* s, CACHE_GLYPH_V2_ORDER* cache_gly
 
 	for (i = 0; i < (int) cache_glyph_v2_order->cGlyphs; i++)
 	{
-		if (cache_glyph_v2_order->glyphData[i] == NULL)
-		{
-			cache_glyph_v2_order->glyphData[i] = (GLYPH_DATA_V2*) xmalloc(sizeof(GLYPH_DATA_V2));
-		}
-		glyph = cache_glyph_v2_order->glyphData[i];
+		glyph = (GLYPH_DATA_V2*) arena_alloc(arena, sizeof(GLYPH_DATA_V2));
+		cache_glyph_v2_order->glyphData[i] = glyph;
 
 		stream_read_uint8(s, glyph->cacheIndex);
 		update_read_2byte_signed(s, &glyph->x);
@@ -1400,7 +1383,7 @@ void update_read_cache_glyph_v2_order(STREAM* s, CACHE_GLYPH_V2_ORDER* cache_gly
 		glyph->cb = ((glyph->cx + 7) / 8) * glyph->cy;
 		glyph->cb += ((glyph->cb % 4) > 0) ? 4 - (glyph->cb % 4) : 0;
 
-		glyph->aj = (uint8*) xmalloc(glyph->cb);
+		glyph->aj = (uint8*) arena_alloc(arena, glyph->cb);
 
 		stream_read(s, glyph->aj, glyph->cb);
 	}
@@ -1437,7 +1420,7 @@ void update_decompress_brush(STREAM* s, uint8* output, uint8 bpp)
 	}
 }
 
-void update_read_cache_brush_order(STREAM* s, CACHE_BRUSH_ORDER* cache_brush_order, uint16 flags)
+void update_read_cache_brush_order(STREAM* s, CACHE_BRUSH_ORDER* cache_brush_order, uint16 flags, ARENA* arena)
 {
 	int i;
 	int size;
@@ -1454,11 +1437,13 @@ void update_read_cache_brush_order(STREAM* s, CACHE_BRUSH_ORDER* cache_brush_ord
 	stream_read_uint8(s, cache_brush_order->style); /* style (1 byte) */
 	stream_read_uint8(s, cache_brush_order->length); /* iBytes (1 byte) */
 
+	cache_brush_order->data = NULL;
+
 	if ((cache_brush_order->cx == 8) && (cache_brush_order->cy == 8))
 	{
-		size = (cache_brush_order->bpp == 1) ? 8 : 8 * 8 * cache_brush_order->bpp;
+		size = (cache_brush_order->bpp == 1) ? 8 : 8 * 8 * ((cache_brush_order->bpp + 1) / 8);
 
-		cache_brush_order->data = (uint8*) xmalloc(size);
+		cache_brush_order->data = (uint8*) arena_alloc(arena, size);
 
 		if (cache_brush_order->bpp == 1)
 		{
@@ -1698,6 +1683,38 @@ void update_read_bounds(STREAM* s, rdpBounds* bounds)
 		update_read_coord(s, &bounds->bottom, true);
 }
 
+static void update_flush_primary_batch(rdpUpdate* update)
+{
+	rdpContext* context = update->context;
+	rdpPrimaryUpdate* primary = update->primary;
+
+	if (primary->batch_count < 1)
+		return;
+
+	if (primary->batch_type == ORDER_TYPE_OPAQUE_RECT)
+		IFCALL(primary->OpaqueRectBatch, context, primary->opaque_rect_batch, primary->batch_count);
+	else if (primary->batch_type == ORDER_TYPE_MEMBLT)
+		IFCALL(primary->MemBltBatch, context, primary->memblt_batch, primary->batch_count);
+
+	primary->batch_count = 0;
+}
+
+static void update_batch_primary_order(rdpUpdate* update, int orderType)
+{
+	rdpPrimaryUpdate* primary = update->primary;
+
+	if (orderType == ORDER_TYPE_OPAQUE_RECT)
+		primary->opaque_rect_batch[primary->batch_count] = primary->opaque_rect;
+	else
+		primary->memblt_batch[primary->batch_count] = primary->memblt;
+
+	primary->batch_type = orderType;
+	primary->batch_count++;
+
+	if (primary->batch_count >= PRIMARY_ORDER_BATCH_SIZE)
+		update_flush_primary_batch(update);
+}
+
 boolean update_recv_primary_order(rdpUpdate* update, STREAM* s, uint8 flags)
 {
 	ORDER_INFO* orderInfo;
@@ -1718,6 +1735,10 @@ boolean update_recv_primary_order(rdpUpdate* update, STREAM* s, uint8 flags)
 	update_read_field_flags(s, &(orderInfo->fieldFlags), flags,
 			PRIMARY_DRAWING_ORDER_FIELD_BYTES[orderInfo->orderType]);
 
+	/* bounded orders are never batched, the bounds only apply to themselves */
+	if ((flags & ORDER_BOUNDS) || (orderInfo->orderType != primary->batch_type))
+		update_flush_primary_batch(update);
+
 	if (flags & ORDER_BOUNDS)
 	{
 		if (!(flags & ORDER_ZERO_BOUNDS_DELTAS))
@@ -1751,7 +1772,11 @@ boolean update_recv_primary_order(rdpUpdate* update, STREAM* s, uint8 flags)
 
 		case ORDER_TYPE_OPAQUE_RECT:
 			update_read_opaque_rect_order(s, orderInfo, &(primary->opaque_rect));
-			IFCALL(primary->OpaqueRect, context, &primary->opaque_rect);
+
+			if ((primary->OpaqueRectBatch != NULL) && !(flags & ORDER_BOUNDS))
+				update_batch_primary_order(update, ORDER_TYPE_OPAQUE_RECT);
+			else
+				IFCALL(primary->OpaqueRect, context, &primary->opaque_rect);
 			break;
 
 		case ORDER_TYPE_DRAW_NINE_GRID:
@@ -1796,7 +1821,18 @@ boolean update_recv_primary_order(rdpUpdate* update, STREAM* s, uint8 flags)
 
 		case ORDER_TYPE_MEMBLT:
 			update_read_memblt_order(s, orderInfo, &(primary->memblt));
-			IFCALL(primary->MemBlt, context, &primary->memblt);
+
+			if ((primary->MemBltBatch != NULL) && !(flags & ORDER_BOUNDS))
+			{
+				if ((primary->batch_count > 0) && (primary->memblt_batch[0].bRop != primary->memblt.bRop))
+					update_flush_primary_batch(update);
+
+				update_batch_primary_order(update, ORDER_TYPE_MEMBLT);
+			}
+			else
+			{
+				IFCALL(primary->MemBlt, context, &primary->memblt);
+			}
 			break;
 
 		case ORDER_TYPE_MEM3BLT:
@@ -1820,7 +1856,7 @@ boolean update_recv_primary_order(rdpUpdate* update, STREAM* s, uint8 flags)
 			break;
 
 		case ORDER_TYPE_FAST_GLYPH:
-			update_read_fast_glyph_order(s, orderInfo, &(primary->fast_glyph));
+			update_read_fast_glyph_order(s, orderInfo, &(primary->fast_glyph), update->order_arena);
 			IFCALL(primary->FastGlyph, context, &primary->fast_glyph);
 			break;
 
@@ -1906,25 +1942,25 @@ void update_recv_secondary_order(rdpUpdate* update, STREAM* s, uint8 flags)
 			break;
 
 		case ORDER_TYPE_CACHE_COLOR_TABLE:
-			update_read_cache_color_table_order(s, &(secondary->cache_color_table_order), extraFlags);
+			update_read_cache_color_table_order(s, &(secondary->cache_color_table_order), extraFlags, update->order_arena);
 			IFCALL(secondary->CacheColorTable, context, &(secondary->cache_color_table_order));
 			break;
 
 		case ORDER_TYPE_CACHE_GLYPH:
 			if (secondary->glyph_v2)
 			{
-				update_read_cache_glyph_v2_order(s, &(secondary->cache_glyph_v2_order), extraFlags);
+				update_read_cache_glyph_v2_order(s, &(secondary->cache_glyph_v2_order), extraFlags, update->order_arena);
 				IFCALL(secondary->CacheGlyphV2, context, &(secondary->cache_glyph_v2_order));
 			}
 			else
 			{
-				update_read_cache_glyph_order(s, &(secondary->cache_glyph_order), extraFlags);
+				update_read_cache_glyph_order(s, &(secondary->cache_glyph_order), extraFlags, update->order_arena);
 				IFCALL(secondary->CacheGlyph, context, &(secondary->cache_glyph_order));
 			}
 			break;
 
 		case ORDER_TYPE_CACHE_BRUSH:
-			update_read_cache_brush_order(s, &(secondary->cache_brush_order), extraFlags);
+			update_read_cache_brush_order(s, &(secondary->cache_brush_order), extraFlags, update->order_arena);
 			IFCALL(secondary->CacheBrush, context, &(secondary->cache_brush_order));
 			break;
 
@@ -2030,6 +2066,10 @@ boolean update_recv_order(rdpUpdate* update, STREAM* s)
 
 	stream_read_uint8(s, controlFlags); /* controlFlags (1 byte) */
 
+	/* cache and surface changes must not overtake batched drawing */
+	if (!(controlFlags & ORDER_STANDARD) || (controlFlags & ORDER_SECONDARY))
+		update_flush_primary_batch(update);
+
 	if (!(controlFlags & ORDER_STANDARD))
 		update_recv_altsec_order(update, s, controlFlags);
 	else if (controlFlags & ORDER_SECONDARY)
@@ -2042,3 +2082,15 @@ boolean update_recv_order(rdpUpdate* update, STREAM* s)
 
 	return true;
 }
+
+/**
+ * Called once all orders of an update were received, drawing
+ * still batched is handed over and order data is released.
+ */
+
+void update_end_orders(rdpUpdate* update)
+{
+	update_flush_primary_batch(update);
+
+	arena_reset(update->order_arena);
+}
@@ -43,6 +43,177 @@ static boolean freerdp_peer_get_fds(freerdp_peer* client, void** rfds, int* rcou
 	rfds[*rcount] = (void*)(long)(client->context->rdp->transport->tcp->sockfd);
 	(*rcount)++;
 
+	/* set when a batched read stopped with data left in the TLS read-ahead */
+	wait_obj_get_fds(client->context->rdp->transport->recv_event, rfds, rcount);
+
+	return true;
+}
+
+static boolean freerdp_peer_is_write_blocked(freerdp_peer* client)
+{
+	return transport_is_write_blocked(client->context->rdp->transport);
+}
+
+static int freerdp_peer_drain_output_buffer(freerdp_peer* client)
+{
+	return transport_drain_output_buffer(client->context->rdp->transport);
+}
+
+/**
+ * Frames are bracketed by frame markers when the client acknowledges them.
+ * The in-flight window is the smaller of max_frames_in_flight and the
+ * maximum the client advertised in its frame acknowledge capability set.
+ */
+static boolean freerdp_peer_can_send_frame(freerdp_peer* client)
+{
+	uint32 window;
+
+	window = client->settings->frame_acknowledge;
+
+	/* the client does not acknowledge frames */
+	if (window == 0)
+		return true;
+
+	if (client->max_frames_in_flight > 0 && client->max_frames_in_flight < window)
+		window = client->max_frames_in_flight;
+
+	return (client->frame_id - client->ack_frame_id < window) ? true : false;
+}
+
+static uint32 freerdp_peer_begin_frame(freerdp_peer* client)
+{
+	rdpUpdate* update = client->update;
+	SURFACE_FRAME_MARKER* marker = &update->surface_frame_marker;
+
+	client->frame_id++;
+
+	if (client->settings->frame_acknowledge > 0)
+	{
+		marker->frameAction = SURFACECMD_FRAMEACTION_BEGIN;
+		marker->frameId = client->frame_id;
+		update->SurfaceFrameMarker(update->context, marker);
+	}
+
+	return client->frame_id;
+}
+
+static void freerdp_peer_end_frame(freerdp_peer* client, uint32 frame_id)
+{
+	rdpUpdate* update = client->update;
+	SURFACE_FRAME_MARKER* marker = &update->surface_frame_marker;
+
+	if (client->settings->frame_acknowledge > 0)
+	{
+		marker->frameAction = SURFACECMD_FRAMEACTION_END;
+		marker->frameId = frame_id;
+		update->SurfaceFrameMarker(update->context, marker);
+	}
+}
+
+static void freerdp_peer_recv_frame_acknowledge(freerdp_peer* client, uint32 frame_id)
+{
+	/* 0xFFFFFFFF acknowledges everything that is in flight */
+	if (frame_id == 0xFFFFFFFF)
+		frame_id = client->frame_id;
+
+	/* ignore acknowledgements older than the last one or for frames never sent */
+	if (client->frame_id - frame_id > client->frame_id - client->ack_frame_id)
+		return;
+
+	client->ack_frame_id = frame_id;
+
+	IFCALL(client->FrameAcknowledge, client, frame_id);
+}
+
+static void freerdp_peer_detach_event_loop(freerdp_peer* client)
+{
+	int i;
+
+	for (i = 0; i < client->num_event_sources; i++)
+		freerdp_event_source_remove(client->event_sources[i]);
+
+	client->num_event_sources = 0;
+	client->loop = NULL;
+}
+
+/**
+ * The socket is the first source, it is polled for writing only while
+ * output is queued. Sending from any other source of the loop has to call
+ * this afterwards, or queued output waits for the next input from the client.
+ */
+static void freerdp_peer_update_write_interest(freerdp_peer* client)
+{
+	uint32 interest;
+
+	if (client->loop == NULL || client->num_event_sources < 1)
+		return;
+
+	interest = FREERDP_EVENT_READ;
+
+	if (client->IsWriteBlocked(client))
+		interest |= FREERDP_EVENT_WRITE;
+
+	freerdp_event_source_set_events(client->event_sources[0], interest);
+}
+
+static void freerdp_peer_event_callback(freerdp_event_source* source, uint32 events, void* arg)
+{
+	freerdp_peer* client = (freerdp_peer*) arg;
+
+	if (events & FREERDP_EVENT_WRITE)
+	{
+		if (client->DrainOutputBuffer(client) < 0)
+			events |= FREERDP_EVENT_ERROR;
+	}
+
+	if (events & FREERDP_EVENT_READ)
+	{
+		if (client->CheckFileDescriptor(client) != true)
+			events |= FREERDP_EVENT_ERROR;
+	}
+
+	if (events & FREERDP_EVENT_ERROR)
+	{
+		freerdp_peer_detach_event_loop(client);
+		IFCALL(client->Disconnected, client);
+		return;
+	}
+
+	freerdp_peer_update_write_interest(client);
+}
+
+/**
+ * Registers the peer socket and transport events with an event loop,
+ * the loop then calls CheckFileDescriptor and drains queued output.
+ */
+static boolean freerdp_peer_attach_event_loop(freerdp_peer* client, freerdp_event_loop* loop)
+{
+	int i;
+	int rcount = 0;
+	int wcount = 0;
+	void* rfds[4];
+	void* wfds[4];
+	freerdp_event_source* source;
+
+	transport_get_fds(client->context->rdp->transport, rfds, &rcount, wfds, &wcount);
+
+	client->loop = loop;
+	client->num_event_sources = 0;
+
+	for (i = 0; i < rcount; i++)
+	{
+		source = freerdp_event_loop_add_fd(loop, (int)(long) rfds[i],
+				FREERDP_EVENT_READ, freerdp_peer_event_callback, client);
+
+		if (source == NULL)
+		{
+			freerdp_peer_detach_event_loop(client);
+			return false;
+		}
+
+		client->event_sources[client->num_event_sources++] = source;
+	}
+
 	return true;
 }
 
@@ -65,6 +236,7 @@ static boolean peer_recv_data_pdu(freerdp_peer* client, STREAM* s)
 {
 	uint8 type;
 	uint16 length;
+	uint32 frame_id;
 	uint32 share_id;
 	uint8 compressed_type;
 	uint16 compressed_len;
@@ -125,7 +297,8 @@ static boolean peer_recv_data_pdu(freerdp_peer* client, STREAM* s)
 			return false;
 
 		case DATA_PDU_TYPE_FRAME_ACKNOWLEDGE:
-			stream_read_uint32(s, client->ack_frame_id);
+			stream_read_uint32(s, frame_id);
+			freerdp_peer_recv_frame_acknowledge(client, frame_id);
 			break;
 
 		case DATA_PDU_TYPE_REFRESH_RECT:
@@ -381,6 +554,14 @@ freerdp_peer* freerdp_peer_new(int sockfd)
 		client->Initialize = freerdp_peer_initialize;
 		client->GetFileDescriptor = freerdp_peer_get_fds;
 		client->CheckFileDescriptor = freerdp_peer_check_fds;
+		client->IsWriteBlocked = freerdp_peer_is_write_blocked;
+		client->DrainOutputBuffer = freerdp_peer_drain_output_buffer;
+		client->UpdateWriteInterest = freerdp_peer_update_write_interest;
+		client->AttachEventLoop = freerdp_peer_attach_event_loop;
+		client->DetachEventLoop = freerdp_peer_detach_event_loop;
+		client->CanSendFrame = freerdp_peer_can_send_frame;
+		client->BeginFrame = freerdp_peer_begin_frame;
+		client->EndFrame = freerdp_peer_end_frame;
 		client->Close = freerdp_peer_close;
 		client->Disconnect = freerdp_peer_disconnect;
 		client->SendChannelData = freerdp_peer_send_channel_data;
@@ -164,6 +164,44 @@ int tcp_write(rdpTcp* tcp, uint8* data, int length)
 	return freerdp_tcp_write(tcp->sockfd, data, length);
 }
 
+/**
+ * Gather write, returns 0 when the socket would block like tcp_write.
+ */
+int tcp_writev(rdpTcp* tcp, struct iovec* iov, int iovcnt)
+{
+#ifndef _WIN32
+	int status;
+	struct msghdr msg;
+
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = iov;
+	msg.msg_iovlen = iovcnt;
+
+	status = sendmsg(tcp->sockfd, &msg, MSG_NOSIGNAL);
+
+	if (status < 0)
+	{
+		if (errno == EAGAIN || errno == EWOULDBLOCK)
+			status = 0;
+		else
+			perror("sendmsg");
+	}
+
+	return status;
+#else
+	int i;
+
+	/* no sendmsg, write the first non-empty buffer */
+	for (i = 0; i < iovcnt; i++)
+	{
+		if (iov[i].iov_len > 0)
+			return freerdp_tcp_write(tcp->sockfd, (uint8*) iov[i].iov_base, iov[i].iov_len);
+	}
+
+	return 0;
+#endif
+}
+
 boolean tcp_disconnect(rdpTcp* tcp)
 {
 	freerdp_tcp_disconnect(tcp->sockfd);
@@ -31,6 +31,16 @@
 #define MSG_NOSIGNAL 0
 #endif
 
+#ifndef _WIN32
+#include <sys/uio.h>
+#else
+struct iovec
+{
+	void* iov_base;
+	size_t iov_len;
+};
+#endif
+
 typedef struct rdp_tcp rdpTcp;
 
 struct rdp_tcp
@@ -48,6 +58,7 @@ boolean tcp_connect(rdpTcp* tcp, const char* hostname, uint16 port);
 boolean tcp_disconnect(rdpTcp* tcp);
 int tcp_read(rdpTcp* tcp, uint8* data, int length);
 int tcp_write(rdpTcp* tcp, uint8* data, int length);
+int tcp_writev(rdpTcp* tcp, struct iovec* iov, int iovcnt);
 boolean tcp_set_blocking_mode(rdpTcp* tcp, boolean blocking);
 boolean tcp_set_keep_alive_mode(rdpTcp* tcp);
 
@@ -33,6 +33,7 @@
 
 #ifndef _WIN32
 #include <netdb.h>
+#include <sys/select.h>
 #include <sys/socket.h>
 #endif
 
@@ -296,21 +297,314 @@ int transport_read(rdpTransport* transport, STREAM* s)
 	return status;
 }
 
+/**
+ * Reads everything the layer has to offer, up to TRANSPORT_READ_BATCH.
+ * TLS reads return at most one record and OpenSSL reads ahead, so records
+ * may be buffered while the socket is no longer readable: TLS is read until
+ * it wants more input, TCP until a read comes back short.
+ */
 static int transport_read_nonblocking(rdpTransport* transport)
 {
 	int status;
+	int requested;
+	int total = 0;
 
-	stream_check_size(transport->recv_buffer, 4096);
-	status = transport_read(transport, transport->recv_buffer);
+	while (total < TRANSPORT_READ_BATCH)
+	{
+		stream_check_size(transport->recv_buffer, TRANSPORT_READ_SIZE);
+		requested = stream_get_left(transport->recv_buffer);
+		status = transport_read(transport, transport->recv_buffer);
 
-	if (status <= 0)
-		return status;
+		/* a disconnect is reported by the next read, after dispatching what we have */
+		if (status < 0)
+			return (total > 0) ? total : status;
+
+		if (status == 0)
+			break;
+
+		stream_seek(transport->recv_buffer, status);
+		total += status;
+
+		if (transport->blocking || transport->layer == TRANSPORT_LAYER_TSG)
+			break;
+
+		if (transport->layer == TRANSPORT_LAYER_TCP && status < requested)
+			break;
+	}
+
+	/* stopped at the limit, the rest may sit in the TLS buffers where select does not see it */
+	if (total >= TRANSPORT_READ_BATCH)
+		wait_obj_set(transport->recv_event);
 
-	stream_seek(transport->recv_buffer, status);
+	return total;
+}
+
+static int transport_write_layer(rdpTransport* transport, uint8* data, int length)
+{
+	int status = -1;
+
+	if (transport->layer == TRANSPORT_LAYER_TLS)
+		status = tls_write(transport->tls, data, length);
+	else if (transport->layer == TRANSPORT_LAYER_TCP)
+		status = tcp_write(transport->tcp, data, length);
+	else if (transport->layer == TRANSPORT_LAYER_TSG)
+		status = tsg_write(transport->tsg, data, length);
+
+	if (status < 0)
+	{
+		/* A write error indicates that the peer has dropped the connection */
+		transport->layer = TRANSPORT_LAYER_CLOSED;
+	}
 
 	return status;
 }
 
+static int transport_get_pending_bytes(rdpTransport* transport)
+{
+	return stream_get_pos(transport->send_queue) - transport->send_queue_head;
+}
+
+/**
+ * Writes as much of the output queue as the socket accepts without blocking.
+ * Returns the number of bytes still queued, or -1 on error.
+ */
+int transport_drain_output_buffer(rdpTransport* transport)
+{
+	int status;
+	int pending;
+	STREAM* queue = transport->send_queue;
+
+	pending = transport_get_pending_bytes(transport);
+
+	while (pending > 0)
+	{
+		status = transport_write_layer(transport, &queue->data[transport->send_queue_head], pending);
+
+		if (status < 0)
+			return -1;
+
+		if (status == 0)
+			break;
+
+		transport->send_queue_head += status;
+		pending -= status;
+	}
+
+	if (pending == 0)
+	{
+		stream_set_pos(queue, 0);
+		transport->send_queue_head = 0;
+	}
+	else if (transport->send_queue_head > queue->size / 2)
+	{
+		/* the TLS layer is set up to accept a moved write buffer on retry */
+		memmove(queue->data, &queue->data[transport->send_queue_head], pending);
+		stream_set_pos(queue, pending);
+		transport->send_queue_head = 0;
+	}
+
+	return pending;
+}
+
+boolean transport_is_write_blocked(rdpTransport* transport)
+{
+	return (transport_get_pending_bytes(transport) > 0) ? true : false;
+}
+
+/**
+ * Called when the output queue went over its limit: wait for the socket to
+ * become writable, reading incoming data meanwhile so that both sides can't
+ * end up blocked on a full send buffer.
+ */
+static int transport_wait_output_buffer(rdpTransport* transport)
+{
+	int pending;
+	int sockfd;
+	fd_set rfds_set;
+	fd_set wfds_set;
+	struct timeval timeout;
+
+	sockfd = transport->tcp->sockfd;
+
+	while ((pending = transport_drain_output_buffer(transport)) > TRANSPORT_SEND_QUEUE_LIMIT)
+	{
+		FD_ZERO(&rfds_set);
+		FD_ZERO(&wfds_set);
+		FD_SET(sockfd, &rfds_set);
+		FD_SET(sockfd, &wfds_set);
+
+		timeout.tv_sec = 0;
+		timeout.tv_usec = 100000;
+
+		if (select(sockfd + 1, &rfds_set, &wfds_set, NULL, &timeout) < 0)
+		{
+			if (errno != EINTR)
+				return -1;
+
+			continue;
+		}
+
+		if (FD_ISSET(sockfd, &rfds_set))
+		{
+			/* in case we do have buffered some data, we set the event so next loop will get it */
+			if (transport_read_nonblocking(transport) > 0)
+				wait_obj_set(transport->recv_event);
+		}
+	}
+
+	return pending;
+}
+
+static int transport_write_queued(rdpTransport* transport, uint8* data, int length)
+{
+	int status;
+	int sent = 0;
+
+	/* bytes already queued go first, only append behind them */
+	if (transport_get_pending_bytes(transport) == 0)
+	{
+		while (sent < length)
+		{
+			status = transport_write_layer(transport, &data[sent], length - sent);
+
+			if (status < 0)
+				return -1;
+
+			if (status == 0)
+				break;
+
+			sent += status;
+		}
+	}
+
+	if (sent < length)
+	{
+		stream_check_size(transport->send_queue, length - sent);
+		stream_write(transport->send_queue, &data[sent], length - sent);
+
+		if (transport_get_pending_bytes(transport) > TRANSPORT_SEND_QUEUE_LIMIT)
+		{
+			if (transport_wait_output_buffer(transport) < 0)
+				return -1;
+		}
+	}
+
+	return length;
+}
+
+static void transport_iov_advance(struct iovec** piov, int* piovcnt, int count)
+{
+	struct iovec* iov = *piov;
+	int iovcnt = *piovcnt;
+
+	while (iovcnt > 0 && count >= (int) iov->iov_len)
+	{
+		count -= iov->iov_len;
+		iov++;
+		iovcnt--;
+	}
+
+	if (iovcnt > 0)
+	{
+		iov->iov_base = (uint8*) iov->iov_base + count;
+		iov->iov_len -= count;
+	}
+
+	*piov = iov;
+	*piovcnt = iovcnt;
+}
+
+static int transport_writev_tcp(rdpTransport* transport, struct iovec* iov, int iovcnt, int length)
+{
+	int i;
+	int status;
+	int sent = 0;
+
+	if (transport->blocking || transport_get_pending_bytes(transport) == 0)
+	{
+		while (sent < length)
+		{
+			status = tcp_writev(transport->tcp, iov, iovcnt);
+
+			if (status < 0)
+			{
+				transport->layer = TRANSPORT_LAYER_CLOSED;
+				return -1;
+			}
+
+			if (status == 0)
+			{
+				if (!transport->blocking)
+					break;
+
+				freerdp_usleep(transport->usleep_interval);
+				continue;
+			}
+
+			sent += status;
+			transport_iov_advance(&iov, &iovcnt, status);
+		}
+	}
+
+	if (sent < length)
+	{
+		stream_check_size(transport->send_queue, length - sent);
+
+		for (i = 0; i < iovcnt; i++)
+			stream_write(transport->send_queue, iov[i].iov_base, iov[i].iov_len);
+
+		if (transport_get_pending_bytes(transport) > TRANSPORT_SEND_QUEUE_LIMIT)
+		{
+			if (transport_wait_output_buffer(transport) < 0)
+				return -1;
+		}
+	}
+
+	return length;
+}
+
+/**
+ * Writes a PDU given as a list of buffers, typically headers kept apart from
+ * the payload they describe. TCP and kernel TLS send them with a single gather
+ * write, the other layers get one coalesced buffer so that TLS produces full
+ * records.
+ * The iovec array is consumed.
+ */
+int transport_writev(rdpTransport* transport, struct iovec* iov, int iovcnt)
+{
+	int i;
+	int length = 0;
+	STREAM* s = transport->gather_stream;
+
+	for (i = 0; i < iovcnt; i++)
+		length += iov[i].iov_len;
+
+#ifdef WITH_DEBUG_TRANSPORT
+	if (length > 0)
+	{
+		printf("Local > Remote\n");
+
+		for (i = 0; i < iovcnt; i++)
+			freerdp_hexdump(iov[i].iov_base, iov[i].iov_len);
+	}
+#endif
+
+	if (transport->layer == TRANSPORT_LAYER_TCP)
+		return transport_writev_tcp(transport, iov, iovcnt, length);
+
+	/* the kernel builds the records, skip the copy into one buffer for SSL_write */
+	if (transport->layer == TRANSPORT_LAYER_TLS && transport->tls->ktls_send)
+		return transport_writev_tcp(transport, iov, iovcnt, length);
+
+	stream_set_pos(s, 0);
+	stream_check_size(s, length);
+
+	for (i = 0; i < iovcnt; i++)
+		stream_write(s, iov[i].iov_base, iov[i].iov_len);
+
+	return transport_write(transport, s);
+}
+
 int transport_write(rdpTransport* transport, STREAM* s)
 {
 	int status = -1;
@@ -327,14 +621,20 @@ int transport_write(rdpTransport* transport, STREAM* s)
 	}
 #endif
 
+	/* in non-blocking mode, whatever the socket does not take now is queued */
+	if (!transport->blocking && transport->layer != TRANSPORT_LAYER_TSG)
+	{
+		status = transport_write_queued(transport, stream_get_tail(s), length);
+
+		if (status > 0)
+			stream_seek(s, length);
+
+		return status;
+	}
+
 	while (length > 0)
 	{
-		if (transport->layer == TRANSPORT_LAYER_TLS)
-			status = tls_write(transport->tls, stream_get_tail(s), length);
-		else if (transport->layer == TRANSPORT_LAYER_TCP)
-			status = tcp_write(transport->tcp, stream_get_tail(s), length);
-		else if (transport->layer == TRANSPORT_LAYER_TSG)
-			status = tsg_write(transport->tsg, stream_get_tail(s), length);
+		status = transport_write_layer(transport, stream_get_tail(s), length);
 
 		if (status < 0)
 			break; /* error occurred */
@@ -357,64 +657,168 @@ int transport_write(rdpTransport* transport, STREAM* s)
 		stream_seek(s, status);
 	}
 
-	if (status < 0)
-	{
-		/* A write error indicates that the peer has dropped the connection */
-		transport->layer = TRANSPORT_LAYER_CLOSED;
-	}
-
 	return status;
 }
 
-void transport_get_fds(rdpTransport* transport, void** rfds, int* rcount)
+void transport_get_fds(rdpTransport* transport, void** rfds, int* rcount, void** wfds, int* wcount)
 {
 	rfds[*rcount] = (void*)(long)(transport->tcp->sockfd);
 	(*rcount)++;
 	wait_obj_get_fds(transport->recv_event, rfds, rcount);
+
+	/* only poll for writability while output is queued */
+	if (transport_is_write_blocked(transport))
+	{
+		wfds[*wcount] = (void*)(long)(transport->tcp->sockfd);
+		(*wcount)++;
+	}
+}
+
+/**
+ * Receive streams are recycled instead of being allocated for every PDU,
+ * a sealed stream gets its original capacity back when returned to the pool.
+ */
+static STREAM* transport_recv_buffer_get(rdpTransport* transport)
+{
+	STREAM* s;
+
+	if (transport->recv_pool_count > 0)
+	{
+		s = transport->recv_pool[--transport->recv_pool_count];
+		transport->recv_stats.reuses++;
+	}
+	else
+	{
+		s = stream_new(BUFFER_SIZE);
+		transport->recv_stats.allocations++;
+		transport->recv_stats.window_allocations++;
+	}
+
+	stream_set_pos(s, 0);
+
+	return s;
+}
+
+static void transport_recv_buffer_put(rdpTransport* transport, STREAM* s, int capacity)
+{
+	if (transport->recv_pool_count >= TRANSPORT_RECV_POOL_SIZE)
+	{
+		stream_free(s);
+		return;
+	}
+
+	s->size = capacity;
+	transport->recv_pool[transport->recv_pool_count++] = s;
+}
+
+static void transport_recv_stats_update(rdpTransport* transport)
+{
+	time_t now;
+	rdpTransportRecvStats* stats = &transport->recv_stats;
+
+	now = time(NULL);
+
+	if (now == stats->window_start)
+		return;
+
+	/* an idle gap of several seconds only reports the last one */
+	if (now == stats->window_start + 1)
+	{
+		stats->allocations_per_second = stats->window_allocations;
+		stats->bytes_copied_per_second = stats->window_bytes_copied;
+	}
+	else
+	{
+		stats->allocations_per_second = 0;
+		stats->bytes_copied_per_second = 0;
+	}
+
+	stats->window_start = now;
+	stats->window_allocations = 0;
+	stats->window_bytes_copied = 0;
+}
+
+void transport_get_recv_stats(rdpTransport* transport, rdpTransportRecvStats* stats)
+{
+	transport_recv_stats_update(transport);
+	memcpy(stats, &transport->recv_stats, sizeof(rdpTransportRecvStats));
+}
+
+/**
+ * Moves the bytes of a partially received PDU to the front of the receive
+ * buffer once the complete PDUs of a batch were dispatched.
+ */
+static void transport_recv_buffer_compact(rdpTransport* transport, int head)
+{
+	int pos;
+	STREAM* s = transport->recv_buffer;
+
+	if (head < 1)
+		return;
+
+	pos = stream_get_pos(s);
+	memmove(s->data, s->data + head, pos - head);
+	stream_set_pos(s, pos - head);
+
+	transport->recv_stats.bytes_copied += pos - head;
+	transport->recv_stats.window_bytes_copied += pos - head;
 }
 
 int transport_check_fds(rdpTransport** ptransport)
 {
 	int pos;
+	int head;
+	int avail;
 	int status;
+	int capacity;
 	uint16 length;
 	STREAM* received;
 	rdpTransport* transport = *ptransport;
 
+	transport_recv_stats_update(transport);
+
 	wait_obj_clear(transport->recv_event);
 
+	if (transport_drain_output_buffer(transport) < 0)
+		return -1;
+
 	status = transport_read_nonblocking(transport);
 
 	if (status < 0)
 		return status;
 
-	while ((pos = stream_get_pos(transport->recv_buffer)) > 0)
+	/* start of the first PDU not yet dispatched */
+	head = 0;
+
+	while ((pos = stream_get_pos(transport->recv_buffer)) > head)
 	{
-		stream_set_pos(transport->recv_buffer, 0);
+		avail = pos - head;
+		stream_set_pos(transport->recv_buffer, head);
+
 		if (tpkt_verify_header(transport->recv_buffer)) /* TPKT */
 		{
 			/* Ensure the TPKT header is available. */
-			if (pos <= 4)
+			if (avail <= 4)
 			{
 				stream_set_pos(transport->recv_buffer, pos);
-				return 0;
+				break;
 			}
 			length = tpkt_read_header(transport->recv_buffer);
 		}
 		else /* Fast Path */
 		{
 			/* Ensure the Fast Path header is available. */
-			if (pos <= 2)
+			if (avail <= 2)
 			{
 				stream_set_pos(transport->recv_buffer, pos);
-				return 0;
+				break;
 			}
 			/* Fastpath header can be two or three bytes long. */
 			length = fastpath_header_length(transport->recv_buffer);
-			if (pos < length)
+			if (avail < length)
 			{
 				stream_set_pos(transport->recv_buffer, pos);
-				return 0;
+				break;
 			}
 			length = fastpath_read_header(NULL, transport->recv_buffer);
 		}
@@ -422,28 +826,37 @@ int transport_check_fds(rdpTransport** ptransport)
 		if (length == 0)
 		{
 			printf("transport_check_fds: protocol error, not a TPKT or Fast Path header.\n");
-			freerdp_hexdump(stream_get_head(transport->recv_buffer), pos);
+			freerdp_hexdump(stream_get_head(transport->recv_buffer) + head, avail);
 			return -1;
 		}
 
-		if (pos < length)
-		{
-			stream_set_pos(transport->recv_buffer, pos);
-			return 0; /* Packet is not yet completely received. */
-		}
+		stream_set_pos(transport->recv_buffer, pos);
 
-		/*
-		 * A complete packet has been received. In case there are trailing data
-		 * for the next packet, we copy it to the new receive buffer.
-		 */
-		received = transport->recv_buffer;
-		transport->recv_buffer = stream_new(BUFFER_SIZE);
+		if (avail < length)
+			break; /* Packet is not yet completely received. */
 
-		if (pos > length)
+		if (head == 0 && avail == length)
+		{
+			/* the buffer holds exactly this PDU, hand it over as is */
+			received = transport->recv_buffer;
+			capacity = received->size;
+			transport->recv_buffer = transport_recv_buffer_get(transport);
+		}
+		else
 		{
-			stream_set_pos(received, length);
-			stream_check_size(transport->recv_buffer, pos - length);
-			stream_copy(transport->recv_buffer, received, pos - length);
+			/**
+			 * A batch holds several PDUs. Copying each one out leaves the rest
+			 * in place, moving the trailing data instead would copy the batch
+			 * over and over again.
+			 */
+			received = transport_recv_buffer_get(transport);
+			stream_check_size(received, length);
+			capacity = received->size;
+			stream_write(received, stream_get_head(transport->recv_buffer) + head, length);
+			head += length;
+
+			transport->recv_stats.bytes_copied += length;
+			transport->recv_stats.window_bytes_copied += length;
 		}
 
 		stream_set_pos(received, length);
@@ -453,31 +866,47 @@ int transport_check_fds(rdpTransport** ptransport)
 		if (transport->recv_callback(transport, received, transport->recv_extra) == false)
 			status = -1;
 
-		stream_free(received);
+		/* transport might now have been freed by rdp_client_redirect and a new rdp->transport created */
+		if (*ptransport == transport)
+		{
+			transport_recv_buffer_put(transport, received, capacity);
+		}
+		else
+		{
+			stream_free(received);
+			transport = *ptransport;
+			head = 0;
+		}
 
 		if (status < 0)
+		{
+			transport_recv_buffer_compact(transport, head);
 			return status;
-
-		/* transport might now have been freed by rdp_client_redirect and a new rdp->transport created */
-		transport = *ptransport;
+		}
 
 		if (transport->process_single_pdu)
 		{
 			/* one at a time but set event if data buffered
 			 * so the main loop will call freerdp_check_fds asap */
-			if (stream_get_pos(transport->recv_buffer) > 0)
+			if (stream_get_pos(transport->recv_buffer) > head)
 				wait_obj_set(transport->recv_event);
 			break;
 		}
-
 	}
 
+	transport_recv_buffer_compact(transport, head);
+
 	return 0;
 }
 
 boolean transport_set_blocking_mode(rdpTransport* transport, boolean blocking)
 {
 	transport->blocking = blocking;
+
+	/* blocking reads may have left data in the TLS buffers, check before waiting on the socket */
+	if (!blocking)
+		wait_obj_set(transport->recv_event);
+
 	return tcp_set_blocking_mode(transport->tcp, blocking);
 }
 
@@ -505,6 +934,12 @@ rdpTransport* transport_new(rdpSettings* settings)
 		transport->recv_stream = stream_new(BUFFER_SIZE);
 		transport->send_stream = stream_new(BUFFER_SIZE);
 
+		/* output queue for non-blocking writes */
+		transport->send_queue = stream_new(BUFFER_SIZE);
+
+		/* coalescing buffer for transport_writev on layers without gather writes */
+		transport->gather_stream = stream_new(BUFFER_SIZE);
+
 		transport->blocking = true;
 
 		transport->layer = TRANSPORT_LAYER_TCP;
@@ -518,8 +953,14 @@ void transport_free(rdpTransport* transport)
 	if (transport != NULL)
 	{
 		stream_free(transport->recv_buffer);
+
+		while (transport->recv_pool_count > 0)
+			stream_free(transport->recv_pool[--transport->recv_pool_count]);
+
 		stream_free(transport->recv_stream);
 		stream_free(transport->send_stream);
+		stream_free(transport->send_queue);
+		stream_free(transport->gather_stream);
 		wait_obj_free(transport->recv_event);
 
 		if (transport->tls)
@@ -44,10 +44,40 @@ typedef struct rdp_transport rdpTransport;
 
 typedef boolean (*TransportRecv) (rdpTransport* transport, STREAM* stream, void* extra);
 
+#define TRANSPORT_RECV_POOL_SIZE	4
+
+/* queued output above which transport_write waits for the socket */
+#define TRANSPORT_SEND_QUEUE_LIMIT	(8 * 1024 * 1024)
+
+/* a non-blocking read asks for one full TLS record at a time */
+#define TRANSPORT_READ_SIZE		16384
+
+/* upper bound of what a single transport_check_fds reads before dispatching */
+#define TRANSPORT_READ_BATCH		(128 * 1024)
+
+struct rdp_transport_recv_stats
+{
+	uint32 allocations; /* receive streams allocated */
+	uint32 reuses; /* receive streams taken from the pool */
+	uint64 bytes_copied; /* bytes copied out of the receive batch */
+
+	/* rates over the last complete second */
+	uint32 allocations_per_second;
+	uint32 bytes_copied_per_second;
+
+	time_t window_start;
+	uint32 window_allocations;
+	uint32 window_bytes_copied;
+};
+typedef struct rdp_transport_recv_stats rdpTransportRecvStats;
+
 struct rdp_transport
 {
 	STREAM* recv_stream;
 	STREAM* send_stream;
+	STREAM* send_queue;
+	int send_queue_head;
+	STREAM* gather_stream;
 	TRANSPORT_LAYER layer;
 	struct rdp_tcp* tcp;
 	struct rdp_tls* tls;
@@ -61,6 +91,9 @@ struct rdp_transport
 	uint32 usleep_interval;
 	void* recv_extra;
 	STREAM* recv_buffer;
+	STREAM* recv_pool[TRANSPORT_RECV_POOL_SIZE];
+	int recv_pool_count;
+	rdpTransportRecvStats recv_stats;
 	TransportRecv recv_callback;
 	struct wait_obj* recv_event;
 	boolean blocking;
@@ -81,8 +114,12 @@ boolean transport_accept_tls(rdpTransport* transport);
 boolean transport_accept_nla(rdpTransport* transport);
 int transport_read(rdpTransport* transport, STREAM* s);
 int transport_write(rdpTransport* transport, STREAM* s);
-void transport_get_fds(rdpTransport* transport, void** rfds, int* rcount);
+int transport_writev(rdpTransport* transport, struct iovec* iov, int iovcnt);
+int transport_drain_output_buffer(rdpTransport* transport);
+boolean transport_is_write_blocked(rdpTransport* transport);
+void transport_get_fds(rdpTransport* transport, void** rfds, int* rcount, void** wfds, int* wcount);
 int transport_check_fds(rdpTransport** ptransport);
+void transport_get_recv_stats(rdpTransport* transport, rdpTransportRecvStats* stats);
 boolean transport_set_blocking_mode(rdpTransport* transport, boolean blocking);
 rdpTransport* transport_new(rdpSettings* settings);
 void transport_free(rdpTransport* transport);
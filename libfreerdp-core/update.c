@@ -43,11 +43,13 @@ boolean update_recv_orders(rdpUpdate* update, STREAM* s)
 	while (numberOrders > 0)
 	{
 		if (!update_recv_order(update, s))
-			return false;
+			break;
 		numberOrders--;
 	}
 
-	return true;
+	update_end_orders(update);
+
+	return (numberOrders > 0) ? false : true;
 }
 
 void update_read_bitmap_data(STREAM* s, BITMAP_DATA* bitmap_data)
@@ -327,6 +329,7 @@ void update_reset_state(rdpUpdate* update)
 	memset(&primary->polygon_cb, 0, sizeof(POLYGON_CB_ORDER));
 	memset(&primary->ellipse_sc, 0, sizeof(ELLIPSE_SC_ORDER));
 	memset(&primary->ellipse_cb, 0, sizeof(ELLIPSE_CB_ORDER));
+	primary->batch_count = 0;
 
 	primary->order_info.orderType = ORDER_TYPE_PATBLT;
 	altsec->switch_surface.bitmapId = SCREEN_BITMAP_SURFACE;
@@ -600,6 +603,8 @@ rdpUpdate* update_new(rdpRdp* rdp)
 		update->altsec = xnew(rdpAltSecUpdate);
 		update->window = xnew(rdpWindowUpdate);
 
+		update->order_arena = arena_new(16384);
+
 		deleteList = &(update->altsec->create_offscreen_bitmap.deleteList);
 		deleteList->sIndices = 64;
 		deleteList->indices = xmalloc(deleteList->sIndices * 2);
@@ -623,10 +628,12 @@ void update_free(rdpUpdate* update)
 		xfree(update->pointer);
 		xfree(update->primary->polyline.points);
 		xfree(update->primary->polygon_sc.points);
+		xfree(update->primary->polygon_cb.points);
 		xfree(update->primary);
 		xfree(update->secondary);
 		xfree(update->altsec);
 		xfree(update->window);
+		arena_free(update->order_arena);
 		xfree(update);
 	}
 }
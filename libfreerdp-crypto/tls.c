@@ -53,6 +53,17 @@ static void tls_free_certificate(CryptoCert cert)
 	xfree(cert);
 }
 
+/**
+ * With the kernel encrypting records, plain socket writes are sent as
+ * application data, which allows gather writes without coalescing.
+ */
+static void tls_check_ktls(rdpTls* tls)
+{
+#ifdef SSL_OP_ENABLE_KTLS
+	tls->ktls_send = BIO_get_ktls_send(SSL_get_wbio(tls->ssl)) ? true : false;
+#endif
+}
+
 boolean tls_connect(rdpTls* tls)
 {
 	CryptoCert cert;
@@ -96,8 +107,32 @@ boolean tls_connect(rdpTls* tls)
 	 */
 	options |= SSL_OP_DONT_INSERT_EMPTY_FRAGMENTS;
 
+	/**
+	 * SSL_OP_ENABLE_KTLS:
+	 *
+	 * Let the kernel encrypt records when OpenSSL and the kernel support
+	 * the negotiated cipher, OpenSSL silently falls back otherwise.
+	 */
+#ifdef SSL_OP_ENABLE_KTLS
+	options |= SSL_OP_ENABLE_KTLS;
+#endif
+
 	SSL_CTX_set_options(tls->ctx, options);
 
+	/**
+	 * A non-blocking transport queues what SSL_write could not send and
+	 * retries later from its output queue, possibly at another address.
+	 */
+	SSL_CTX_set_mode(tls->ctx, SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
+
+	/**
+	 * Read ahead lets OpenSSL fetch several records per system call instead
+	 * of a record header and a record body. Decrypted data may then be left
+	 * in the SSL buffers without the socket being readable, the transport
+	 * reads until SSL_read wants more input.
+	 */
+	SSL_CTX_set_read_ahead(tls->ctx, 1);
+
 	tls->ssl = SSL_new(tls->ctx);
 
 	if (tls->ssl == NULL)
@@ -122,6 +157,8 @@ boolean tls_connect(rdpTls* tls)
 		}
 	}
 
+	tls_check_ktls(tls);
+
 	cert = tls_get_certificate(tls, true);
 
 	if (cert == NULL)
@@ -201,8 +238,32 @@ boolean tls_accept(rdpTls* tls, const char* cert_file, const char* privatekey_fi
 	 */
 	options |= SSL_OP_DONT_INSERT_EMPTY_FRAGMENTS;
 
+	/**
+	 * SSL_OP_ENABLE_KTLS:
+	 *
+	 * Let the kernel encrypt records when OpenSSL and the kernel support
+	 * the negotiated cipher, OpenSSL silently falls back otherwise.
+	 */
+#ifdef SSL_OP_ENABLE_KTLS
+	options |= SSL_OP_ENABLE_KTLS;
+#endif
+
 	SSL_CTX_set_options(tls->ctx, options);
 
+	/**
+	 * A non-blocking transport queues what SSL_write could not send and
+	 * retries later from its output queue, possibly at another address.
+	 */
+	SSL_CTX_set_mode(tls->ctx, SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
+
+	/**
+	 * Read ahead lets OpenSSL fetch several records per system call instead
+	 * of a record header and a record body. Decrypted data may then be left
+	 * in the SSL buffers without the socket being readable, the transport
+	 * reads until SSL_read wants more input.
+	 */
+	SSL_CTX_set_read_ahead(tls->ctx, 1);
+
 	if (SSL_CTX_use_RSAPrivateKey_file(tls->ctx, privatekey_file, SSL_FILETYPE_PEM) <= 0)
 	{
 		printf("SSL_CTX_use_RSAPrivateKey_file failed\n");
@@ -271,7 +332,9 @@ boolean tls_accept(rdpTls* tls, const char* cert_file, const char* privatekey_fi
 		}
 	}
 
-	printf("TLS connection accepted\n");
+	tls_check_ktls(tls);
+
+	printf("TLS connection accepted%s\n", tls->ktls_send ? " (kernel TLS)" : "");
 
 	return true;
 }
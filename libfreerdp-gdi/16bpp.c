@@ -978,104 +978,267 @@ static INLINE void SetPixel_WHITE_16bpp(uint16 *pixel, uint16 *pen)
 #define GDI_GET_PEN_COLOR	gdi_GetPenColor_16bpp
 
 #define LINE_TO			LineTo_BLACK_16bpp
+#define LINE_SEGMENT		LineSegment_BLACK_16bpp
+#define POLYLINE_TO		PolylineTo_BLACK_16bpp
 #define SET_PIXEL_ROP2		SetPixel_BLACK_16bpp
 #include "include/line.c"
 #undef LINE_TO
+#undef LINE_SEGMENT
+#undef POLYLINE_TO
 #undef SET_PIXEL_ROP2
 
 #define LINE_TO			LineTo_NOTMERGEPEN_16bpp
+#define LINE_SEGMENT		LineSegment_NOTMERGEPEN_16bpp
+#define POLYLINE_TO		PolylineTo_NOTMERGEPEN_16bpp
 #define SET_PIXEL_ROP2		SetPixel_NOTMERGEPEN_16bpp
 #include "include/line.c"
 #undef LINE_TO
+#undef LINE_SEGMENT
+#undef POLYLINE_TO
 #undef SET_PIXEL_ROP2
 
 #define LINE_TO			LineTo_MASKNOTPEN_16bpp
+#define LINE_SEGMENT		LineSegment_MASKNOTPEN_16bpp
+#define POLYLINE_TO		PolylineTo_MASKNOTPEN_16bpp
 #define SET_PIXEL_ROP2		SetPixel_MASKNOTPEN_16bpp
 #include "include/line.c"
 #undef LINE_TO
+#undef LINE_SEGMENT
+#undef POLYLINE_TO
 #undef SET_PIXEL_ROP2
 
 #define LINE_TO			LineTo_NOTCOPYPEN_16bpp
+#define LINE_SEGMENT		LineSegment_NOTCOPYPEN_16bpp
+#define POLYLINE_TO		PolylineTo_NOTCOPYPEN_16bpp
 #define SET_PIXEL_ROP2		SetPixel_NOTCOPYPEN_16bpp
 #include "include/line.c"
 #undef LINE_TO
+#undef LINE_SEGMENT
+#undef POLYLINE_TO
 #undef SET_PIXEL_ROP2
 
 #define LINE_TO			LineTo_MASKPENNOT_16bpp
+#define LINE_SEGMENT		LineSegment_MASKPENNOT_16bpp
+#define POLYLINE_TO		PolylineTo_MASKPENNOT_16bpp
 #define SET_PIXEL_ROP2		SetPixel_MASKPENNOT_16bpp
 #include "include/line.c"
 #undef LINE_TO
+#undef LINE_SEGMENT
+#undef POLYLINE_TO
 #undef SET_PIXEL_ROP2
 
 #define LINE_TO			LineTo_NOT_16bpp
+#define LINE_SEGMENT		LineSegment_NOT_16bpp
+#define POLYLINE_TO		PolylineTo_NOT_16bpp
 #define SET_PIXEL_ROP2		SetPixel_NOT_16bpp
 #include "include/line.c"
 #undef LINE_TO
+#undef LINE_SEGMENT
+#undef POLYLINE_TO
 #undef SET_PIXEL_ROP2
 
 #define LINE_TO			LineTo_XORPEN_16bpp
+#define LINE_SEGMENT		LineSegment_XORPEN_16bpp
+#define POLYLINE_TO		PolylineTo_XORPEN_16bpp
 #define SET_PIXEL_ROP2		SetPixel_XORPEN_16bpp
 #include "include/line.c"
 #undef LINE_TO
+#undef LINE_SEGMENT
+#undef POLYLINE_TO
 #undef SET_PIXEL_ROP2
 
 #define LINE_TO			LineTo_NOTMASKPEN_16bpp
+#define LINE_SEGMENT		LineSegment_NOTMASKPEN_16bpp
+#define POLYLINE_TO		PolylineTo_NOTMASKPEN_16bpp
 #define SET_PIXEL_ROP2		SetPixel_NOTMASKPEN_16bpp
 #include "include/line.c"
 #undef LINE_TO
+#undef LINE_SEGMENT
+#undef POLYLINE_TO
 #undef SET_PIXEL_ROP2
 
 #define LINE_TO			LineTo_MASKPEN_16bpp
+#define LINE_SEGMENT		LineSegment_MASKPEN_16bpp
+#define POLYLINE_TO		PolylineTo_MASKPEN_16bpp
 #define SET_PIXEL_ROP2		SetPixel_MASKPEN_16bpp
 #include "include/line.c"
 #undef LINE_TO
+#undef LINE_SEGMENT
+#undef POLYLINE_TO
 #undef SET_PIXEL_ROP2
 
 #define LINE_TO			LineTo_NOTXORPEN_16bpp
+#define LINE_SEGMENT		LineSegment_NOTXORPEN_16bpp
+#define POLYLINE_TO		PolylineTo_NOTXORPEN_16bpp
 #define SET_PIXEL_ROP2		SetPixel_NOTXORPEN_16bpp
 #include "include/line.c"
 #undef LINE_TO
+#undef LINE_SEGMENT
+#undef POLYLINE_TO
 #undef SET_PIXEL_ROP2
 
 #define LINE_TO			LineTo_NOP_16bpp
+#define LINE_SEGMENT		LineSegment_NOP_16bpp
+#define POLYLINE_TO		PolylineTo_NOP_16bpp
 #define SET_PIXEL_ROP2		SetPixel_NOP_16bpp
 #include "include/line.c"
 #undef LINE_TO
+#undef LINE_SEGMENT
+#undef POLYLINE_TO
 #undef SET_PIXEL_ROP2
 
 #define LINE_TO			LineTo_MERGENOTPEN_16bpp
+#define LINE_SEGMENT		LineSegment_MERGENOTPEN_16bpp
+#define POLYLINE_TO		PolylineTo_MERGENOTPEN_16bpp
 #define SET_PIXEL_ROP2		SetPixel_MERGENOTPEN_16bpp
 #include "include/line.c"
 #undef LINE_TO
+#undef LINE_SEGMENT
+#undef POLYLINE_TO
 #undef SET_PIXEL_ROP2
 
 #define LINE_TO			LineTo_COPYPEN_16bpp
+#define LINE_SEGMENT		LineSegment_COPYPEN_16bpp
+#define POLYLINE_TO		PolylineTo_COPYPEN_16bpp
 #define SET_PIXEL_ROP2		SetPixel_COPYPEN_16bpp
 #include "include/line.c"
 #undef LINE_TO
+#undef LINE_SEGMENT
+#undef POLYLINE_TO
 #undef SET_PIXEL_ROP2
 
 #define LINE_TO			LineTo_MERGEPENNOT_16bpp
+#define LINE_SEGMENT		LineSegment_MERGEPENNOT_16bpp
+#define POLYLINE_TO		PolylineTo_MERGEPENNOT_16bpp
 #define SET_PIXEL_ROP2		SetPixel_MERGEPENNOT_16bpp
 #include "include/line.c"
 #undef LINE_TO
+#undef LINE_SEGMENT
+#undef POLYLINE_TO
 #undef SET_PIXEL_ROP2
 
 #define LINE_TO			LineTo_MERGEPEN_16bpp
+#define LINE_SEGMENT		LineSegment_MERGEPEN_16bpp
+#define POLYLINE_TO		PolylineTo_MERGEPEN_16bpp
 #define SET_PIXEL_ROP2		SetPixel_MERGEPEN_16bpp
 #include "include/line.c"
 #undef LINE_TO
+#undef LINE_SEGMENT
+#undef POLYLINE_TO
 #undef SET_PIXEL_ROP2
 
 #define LINE_TO			LineTo_WHITE_16bpp
+#define LINE_SEGMENT		LineSegment_WHITE_16bpp
+#define POLYLINE_TO		PolylineTo_WHITE_16bpp
 #define SET_PIXEL_ROP2		SetPixel_WHITE_16bpp
 #include "include/line.c"
 #undef LINE_TO
+#undef LINE_SEGMENT
+#undef POLYLINE_TO
+#undef SET_PIXEL_ROP2
+
+#define GDI_GET_COLOR		gdi_get_color_16bpp
+
+#define FILL_SPAN		FillSpan_BLACK_16bpp
+#define SET_PIXEL_ROP2		SetPixel_BLACK_16bpp
+#include "include/span.c"
+#undef FILL_SPAN
+#undef SET_PIXEL_ROP2
+
+#define FILL_SPAN		FillSpan_NOTMERGEPEN_16bpp
+#define SET_PIXEL_ROP2		SetPixel_NOTMERGEPEN_16bpp
+#include "include/span.c"
+#undef FILL_SPAN
+#undef SET_PIXEL_ROP2
+
+#define FILL_SPAN		FillSpan_MASKNOTPEN_16bpp
+#define SET_PIXEL_ROP2		SetPixel_MASKNOTPEN_16bpp
+#include "include/span.c"
+#undef FILL_SPAN
+#undef SET_PIXEL_ROP2
+
+#define FILL_SPAN		FillSpan_NOTCOPYPEN_16bpp
+#define SET_PIXEL_ROP2		SetPixel_NOTCOPYPEN_16bpp
+#include "include/span.c"
+#undef FILL_SPAN
+#undef SET_PIXEL_ROP2
+
+#define FILL_SPAN		FillSpan_MASKPENNOT_16bpp
+#define SET_PIXEL_ROP2		SetPixel_MASKPENNOT_16bpp
+#include "include/span.c"
+#undef FILL_SPAN
+#undef SET_PIXEL_ROP2
+
+#define FILL_SPAN		FillSpan_NOT_16bpp
+#define SET_PIXEL_ROP2		SetPixel_NOT_16bpp
+#include "include/span.c"
+#undef FILL_SPAN
+#undef SET_PIXEL_ROP2
+
+#define FILL_SPAN		FillSpan_XORPEN_16bpp
+#define SET_PIXEL_ROP2		SetPixel_XORPEN_16bpp
+#include "include/span.c"
+#undef FILL_SPAN
+#undef SET_PIXEL_ROP2
+
+#define FILL_SPAN		FillSpan_NOTMASKPEN_16bpp
+#define SET_PIXEL_ROP2		SetPixel_NOTMASKPEN_16bpp
+#include "include/span.c"
+#undef FILL_SPAN
+#undef SET_PIXEL_ROP2
+
+#define FILL_SPAN		FillSpan_MASKPEN_16bpp
+#define SET_PIXEL_ROP2		SetPixel_MASKPEN_16bpp
+#include "include/span.c"
+#undef FILL_SPAN
+#undef SET_PIXEL_ROP2
+
+#define FILL_SPAN		FillSpan_NOTXORPEN_16bpp
+#define SET_PIXEL_ROP2		SetPixel_NOTXORPEN_16bpp
+#include "include/span.c"
+#undef FILL_SPAN
+#undef SET_PIXEL_ROP2
+
+#define FILL_SPAN		FillSpan_NOP_16bpp
+#define SET_PIXEL_ROP2		SetPixel_NOP_16bpp
+#include "include/span.c"
+#undef FILL_SPAN
+#undef SET_PIXEL_ROP2
+
+#define FILL_SPAN		FillSpan_MERGENOTPEN_16bpp
+#define SET_PIXEL_ROP2		SetPixel_MERGENOTPEN_16bpp
+#include "include/span.c"
+#undef FILL_SPAN
+#undef SET_PIXEL_ROP2
+
+#define FILL_SPAN		FillSpan_COPYPEN_16bpp
+#define SET_PIXEL_ROP2		SetPixel_COPYPEN_16bpp
+#include "include/span.c"
+#undef FILL_SPAN
+#undef SET_PIXEL_ROP2
+
+#define FILL_SPAN		FillSpan_MERGEPENNOT_16bpp
+#define SET_PIXEL_ROP2		SetPixel_MERGEPENNOT_16bpp
+#include "include/span.c"
+#undef FILL_SPAN
+#undef SET_PIXEL_ROP2
+
+#define FILL_SPAN		FillSpan_MERGEPEN_16bpp
+#define SET_PIXEL_ROP2		SetPixel_MERGEPEN_16bpp
+#include "include/span.c"
+#undef FILL_SPAN
+#undef SET_PIXEL_ROP2
+
+#define FILL_SPAN		FillSpan_WHITE_16bpp
+#define SET_PIXEL_ROP2		SetPixel_WHITE_16bpp
+#include "include/span.c"
+#undef FILL_SPAN
 #undef SET_PIXEL_ROP2
 
 #undef PIXEL_TYPE
 #undef GDI_GET_POINTER
 #undef GDI_GET_PEN_COLOR
+#undef GDI_GET_COLOR
 
 pLineTo_16bpp LineTo_ROP2_16bpp[32] =
 {
@@ -1109,3 +1272,93 @@ int LineTo_16bpp(HGDI_DC hdc, int nXEnd, int nYEnd)
 	else
 		return 0;
 }
+
+pPolylineTo_16bpp PolylineTo_ROP2_16bpp[32] =
+{
+	PolylineTo_BLACK_16bpp,
+	PolylineTo_NOTMERGEPEN_16bpp,
+	PolylineTo_MASKNOTPEN_16bpp,
+	PolylineTo_NOTCOPYPEN_16bpp,
+	PolylineTo_MASKPENNOT_16bpp,
+	PolylineTo_NOT_16bpp,
+	PolylineTo_XORPEN_16bpp,
+	PolylineTo_NOTMASKPEN_16bpp,
+	PolylineTo_MASKPEN_16bpp,
+	PolylineTo_NOTXORPEN_16bpp,
+	PolylineTo_NOP_16bpp,
+	PolylineTo_MERGENOTPEN_16bpp,
+	PolylineTo_COPYPEN_16bpp,
+	PolylineTo_MERGEPENNOT_16bpp,
+	PolylineTo_MERGEPEN_16bpp,
+	PolylineTo_WHITE_16bpp
+};
+
+int PolylineTo_16bpp(HGDI_DC hdc, GDI_POINT* lppt, int cCount)
+{
+	pPolylineTo_16bpp _PolylineTo;
+	int rop2 = gdi_GetROP2(hdc) - 1;
+
+	_PolylineTo = PolylineTo_ROP2_16bpp[rop2];
+
+	if (_PolylineTo != NULL)
+		return _PolylineTo(hdc, lppt, cCount);
+	else
+		return 0;
+}
+
+pFillSpan_16bpp FillSpan_ROP2_16bpp[32] =
+{
+	FillSpan_BLACK_16bpp,
+	FillSpan_NOTMERGEPEN_16bpp,
+	FillSpan_MASKNOTPEN_16bpp,
+	FillSpan_NOTCOPYPEN_16bpp,
+	FillSpan_MASKPENNOT_16bpp,
+	FillSpan_NOT_16bpp,
+	FillSpan_XORPEN_16bpp,
+	FillSpan_NOTMASKPEN_16bpp,
+	FillSpan_MASKPEN_16bpp,
+	FillSpan_NOTXORPEN_16bpp,
+	FillSpan_NOP_16bpp,
+	FillSpan_MERGENOTPEN_16bpp,
+	FillSpan_COPYPEN_16bpp,
+	FillSpan_MERGEPENNOT_16bpp,
+	FillSpan_MERGEPEN_16bpp,
+	FillSpan_WHITE_16bpp
+};
+
+/**
+ * Fill one horizontal span with the current brush.\n
+ * Solid copies are the common case and get a plain row store,
+ * the compiler turns it into wide stores.
+ */
+
+int FillSpan_16bpp(HGDI_DC hdc, int nXStart, int nY, int nWidth)
+{
+	int x;
+	uint16* dstp;
+	uint16 color16;
+	pFillSpan_16bpp _FillSpan;
+	int rop2 = gdi_GetROP2(hdc) - 1;
+
+	if ((rop2 == GDI_R2_COPYPEN - 1) && (hdc->brush->style == GDI_BS_SOLID))
+	{
+		dstp = (uint16*) gdi_get_bitmap_pointer(hdc, nXStart, nY);
+
+		if (dstp == 0)
+			return 0;
+
+		color16 = gdi_get_color_16bpp(hdc, hdc->brush->color);
+
+		for (x = 0; x < nWidth; x++)
+			dstp[x] = color16;
+
+		return 1;
+	}
+
+	_FillSpan = FillSpan_ROP2_16bpp[rop2];
+
+	if (_FillSpan != NULL)
+		return _FillSpan(hdc, nXStart, nY, nWidth);
+	else
+		return 0;
+}
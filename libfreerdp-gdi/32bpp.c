@@ -1020,104 +1020,267 @@ static INLINE void SetPixel_WHITE_32bpp(uint32* pixel, uint32* pen)
 #define GDI_GET_PEN_COLOR	gdi_GetPenColor_32bpp
 
 #define LINE_TO			LineTo_BLACK_32bpp
+#define LINE_SEGMENT		LineSegment_BLACK_32bpp
+#define POLYLINE_TO		PolylineTo_BLACK_32bpp
 #define SET_PIXEL_ROP2		SetPixel_BLACK_32bpp
 #include "include/line.c"
 #undef LINE_TO
+#undef LINE_SEGMENT
+#undef POLYLINE_TO
 #undef SET_PIXEL_ROP2
 
 #define LINE_TO			LineTo_NOTMERGEPEN_32bpp
+#define LINE_SEGMENT		LineSegment_NOTMERGEPEN_32bpp
+#define POLYLINE_TO		PolylineTo_NOTMERGEPEN_32bpp
 #define SET_PIXEL_ROP2		SetPixel_NOTMERGEPEN_32bpp
 #include "include/line.c"
 #undef LINE_TO
+#undef LINE_SEGMENT
+#undef POLYLINE_TO
 #undef SET_PIXEL_ROP2
 
 #define LINE_TO			LineTo_MASKNOTPEN_32bpp
+#define LINE_SEGMENT		LineSegment_MASKNOTPEN_32bpp
+#define POLYLINE_TO		PolylineTo_MASKNOTPEN_32bpp
 #define SET_PIXEL_ROP2		SetPixel_MASKNOTPEN_32bpp
 #include "include/line.c"
 #undef LINE_TO
+#undef LINE_SEGMENT
+#undef POLYLINE_TO
 #undef SET_PIXEL_ROP2
 
 #define LINE_TO			LineTo_NOTCOPYPEN_32bpp
+#define LINE_SEGMENT		LineSegment_NOTCOPYPEN_32bpp
+#define POLYLINE_TO		PolylineTo_NOTCOPYPEN_32bpp
 #define SET_PIXEL_ROP2		SetPixel_NOTCOPYPEN_32bpp
 #include "include/line.c"
 #undef LINE_TO
+#undef LINE_SEGMENT
+#undef POLYLINE_TO
 #undef SET_PIXEL_ROP2
 
 #define LINE_TO			LineTo_MASKPENNOT_32bpp
+#define LINE_SEGMENT		LineSegment_MASKPENNOT_32bpp
+#define POLYLINE_TO		PolylineTo_MASKPENNOT_32bpp
 #define SET_PIXEL_ROP2		SetPixel_MASKPENNOT_32bpp
 #include "include/line.c"
 #undef LINE_TO
+#undef LINE_SEGMENT
+#undef POLYLINE_TO
 #undef SET_PIXEL_ROP2
 
 #define LINE_TO			LineTo_NOT_32bpp
+#define LINE_SEGMENT		LineSegment_NOT_32bpp
+#define POLYLINE_TO		PolylineTo_NOT_32bpp
 #define SET_PIXEL_ROP2		SetPixel_NOT_32bpp
 #include "include/line.c"
 #undef LINE_TO
+#undef LINE_SEGMENT
+#undef POLYLINE_TO
 #undef SET_PIXEL_ROP2
 
 #define LINE_TO			LineTo_XORPEN_32bpp
+#define LINE_SEGMENT		LineSegment_XORPEN_32bpp
+#define POLYLINE_TO		PolylineTo_XORPEN_32bpp
 #define SET_PIXEL_ROP2		SetPixel_XORPEN_32bpp
 #include "include/line.c"
 #undef LINE_TO
+#undef LINE_SEGMENT
+#undef POLYLINE_TO
 #undef SET_PIXEL_ROP2
 
 #define LINE_TO			LineTo_NOTMASKPEN_32bpp
+#define LINE_SEGMENT		LineSegment_NOTMASKPEN_32bpp
+#define POLYLINE_TO		PolylineTo_NOTMASKPEN_32bpp
 #define SET_PIXEL_ROP2		SetPixel_NOTMASKPEN_32bpp
 #include "include/line.c"
 #undef LINE_TO
+#undef LINE_SEGMENT
+#undef POLYLINE_TO
 #undef SET_PIXEL_ROP2
 
 #define LINE_TO			LineTo_MASKPEN_32bpp
+#define LINE_SEGMENT		LineSegment_MASKPEN_32bpp
+#define POLYLINE_TO		PolylineTo_MASKPEN_32bpp
 #define SET_PIXEL_ROP2		SetPixel_MASKPEN_32bpp
 #include "include/line.c"
 #undef LINE_TO
+#undef LINE_SEGMENT
+#undef POLYLINE_TO
 #undef SET_PIXEL_ROP2
 
 #define LINE_TO			LineTo_NOTXORPEN_32bpp
+#define LINE_SEGMENT		LineSegment_NOTXORPEN_32bpp
+#define POLYLINE_TO		PolylineTo_NOTXORPEN_32bpp
 #define SET_PIXEL_ROP2		SetPixel_NOTXORPEN_32bpp
 #include "include/line.c"
 #undef LINE_TO
+#undef LINE_SEGMENT
+#undef POLYLINE_TO
 #undef SET_PIXEL_ROP2
 
 #define LINE_TO			LineTo_NOP_32bpp
+#define LINE_SEGMENT		LineSegment_NOP_32bpp
+#define POLYLINE_TO		PolylineTo_NOP_32bpp
 #define SET_PIXEL_ROP2		SetPixel_NOP_32bpp
 #include "include/line.c"
 #undef LINE_TO
+#undef LINE_SEGMENT
+#undef POLYLINE_TO
 #undef SET_PIXEL_ROP2
 
 #define LINE_TO			LineTo_MERGENOTPEN_32bpp
+#define LINE_SEGMENT		LineSegment_MERGENOTPEN_32bpp
+#define POLYLINE_TO		PolylineTo_MERGENOTPEN_32bpp
 #define SET_PIXEL_ROP2		SetPixel_MERGENOTPEN_32bpp
 #include "include/line.c"
 #undef LINE_TO
+#undef LINE_SEGMENT
+#undef POLYLINE_TO
 #undef SET_PIXEL_ROP2
 
 #define LINE_TO			LineTo_COPYPEN_32bpp
+#define LINE_SEGMENT		LineSegment_COPYPEN_32bpp
+#define POLYLINE_TO		PolylineTo_COPYPEN_32bpp
 #define SET_PIXEL_ROP2		SetPixel_COPYPEN_32bpp
 #include "include/line.c"
 #undef LINE_TO
+#undef LINE_SEGMENT
+#undef POLYLINE_TO
 #undef SET_PIXEL_ROP2
 
 #define LINE_TO			LineTo_MERGEPENNOT_32bpp
+#define LINE_SEGMENT		LineSegment_MERGEPENNOT_32bpp
+#define POLYLINE_TO		PolylineTo_MERGEPENNOT_32bpp
 #define SET_PIXEL_ROP2		SetPixel_MERGEPENNOT_32bpp
 #include "include/line.c"
 #undef LINE_TO
+#undef LINE_SEGMENT
+#undef POLYLINE_TO
 #undef SET_PIXEL_ROP2
 
 #define LINE_TO			LineTo_MERGEPEN_32bpp
+#define LINE_SEGMENT		LineSegment_MERGEPEN_32bpp
+#define POLYLINE_TO		PolylineTo_MERGEPEN_32bpp
 #define SET_PIXEL_ROP2		SetPixel_MERGEPEN_32bpp
 #include "include/line.c"
 #undef LINE_TO
+#undef LINE_SEGMENT
+#undef POLYLINE_TO
 #undef SET_PIXEL_ROP2
 
 #define LINE_TO			LineTo_WHITE_32bpp
+#define LINE_SEGMENT		LineSegment_WHITE_32bpp
+#define POLYLINE_TO		PolylineTo_WHITE_32bpp
 #define SET_PIXEL_ROP2		SetPixel_WHITE_32bpp
 #include "include/line.c"
 #undef LINE_TO
+#undef LINE_SEGMENT
+#undef POLYLINE_TO
+#undef SET_PIXEL_ROP2
+
+#define GDI_GET_COLOR		gdi_get_color_32bpp
+
+#define FILL_SPAN		FillSpan_BLACK_32bpp
+#define SET_PIXEL_ROP2		SetPixel_BLACK_32bpp
+#include "include/span.c"
+#undef FILL_SPAN
+#undef SET_PIXEL_ROP2
+
+#define FILL_SPAN		FillSpan_NOTMERGEPEN_32bpp
+#define SET_PIXEL_ROP2		SetPixel_NOTMERGEPEN_32bpp
+#include "include/span.c"
+#undef FILL_SPAN
+#undef SET_PIXEL_ROP2
+
+#define FILL_SPAN		FillSpan_MASKNOTPEN_32bpp
+#define SET_PIXEL_ROP2		SetPixel_MASKNOTPEN_32bpp
+#include "include/span.c"
+#undef FILL_SPAN
+#undef SET_PIXEL_ROP2
+
+#define FILL_SPAN		FillSpan_NOTCOPYPEN_32bpp
+#define SET_PIXEL_ROP2		SetPixel_NOTCOPYPEN_32bpp
+#include "include/span.c"
+#undef FILL_SPAN
+#undef SET_PIXEL_ROP2
+
+#define FILL_SPAN		FillSpan_MASKPENNOT_32bpp
+#define SET_PIXEL_ROP2		SetPixel_MASKPENNOT_32bpp
+#include "include/span.c"
+#undef FILL_SPAN
+#undef SET_PIXEL_ROP2
+
+#define FILL_SPAN		FillSpan_NOT_32bpp
+#define SET_PIXEL_ROP2		SetPixel_NOT_32bpp
+#include "include/span.c"
+#undef FILL_SPAN
+#undef SET_PIXEL_ROP2
+
+#define FILL_SPAN		FillSpan_XORPEN_32bpp
+#define SET_PIXEL_ROP2		SetPixel_XORPEN_32bpp
+#include "include/span.c"
+#undef FILL_SPAN
+#undef SET_PIXEL_ROP2
+
+#define FILL_SPAN		FillSpan_NOTMASKPEN_32bpp
+#define SET_PIXEL_ROP2		SetPixel_NOTMASKPEN_32bpp
+#include "include/span.c"
+#undef FILL_SPAN
+#undef SET_PIXEL_ROP2
+
+#define FILL_SPAN		FillSpan_MASKPEN_32bpp
+#define SET_PIXEL_ROP2		SetPixel_MASKPEN_32bpp
+#include "include/span.c"
+#undef FILL_SPAN
+#undef SET_PIXEL_ROP2
+
+#define FILL_SPAN		FillSpan_NOTXORPEN_32bpp
+#define SET_PIXEL_ROP2		SetPixel_NOTXORPEN_32bpp
+#include "include/span.c"
+#undef FILL_SPAN
+#undef SET_PIXEL_ROP2
+
+#define FILL_SPAN		FillSpan_NOP_32bpp
+#define SET_PIXEL_ROP2		SetPixel_NOP_32bpp
+#include "include/span.c"
+#undef FILL_SPAN
+#undef SET_PIXEL_ROP2
+
+#define FILL_SPAN		FillSpan_MERGENOTPEN_32bpp
+#define SET_PIXEL_ROP2		SetPixel_MERGENOTPEN_32bpp
+#include "include/span.c"
+#undef FILL_SPAN
+#undef SET_PIXEL_ROP2
+
+#define FILL_SPAN		FillSpan_COPYPEN_32bpp
+#define SET_PIXEL_ROP2		SetPixel_COPYPEN_32bpp
+#include "include/span.c"
+#undef FILL_SPAN
+#undef SET_PIXEL_ROP2
+
+#define FILL_SPAN		FillSpan_MERGEPENNOT_32bpp
+#define SET_PIXEL_ROP2		SetPixel_MERGEPENNOT_32bpp
+#include "include/span.c"
+#undef FILL_SPAN
+#undef SET_PIXEL_ROP2
+
+#define FILL_SPAN		FillSpan_MERGEPEN_32bpp
+#define SET_PIXEL_ROP2		SetPixel_MERGEPEN_32bpp
+#include "include/span.c"
+#undef FILL_SPAN
+#undef SET_PIXEL_ROP2
+
+#define FILL_SPAN		FillSpan_WHITE_32bpp
+#define SET_PIXEL_ROP2		SetPixel_WHITE_32bpp
+#include "include/span.c"
+#undef FILL_SPAN
 #undef SET_PIXEL_ROP2
 
 #undef PIXEL_TYPE
 #undef GDI_GET_POINTER
 #undef GDI_GET_PEN_COLOR
+#undef GDI_GET_COLOR
 
 pLineTo_32bpp LineTo_ROP2_32bpp[32] =
 {
@@ -1151,3 +1314,93 @@ int LineTo_32bpp(HGDI_DC hdc, int nXEnd, int nYEnd)
 	else
 		return 0;
 }
+
+pPolylineTo_32bpp PolylineTo_ROP2_32bpp[32] =
+{
+	PolylineTo_BLACK_32bpp,
+	PolylineTo_NOTMERGEPEN_32bpp,
+	PolylineTo_MASKNOTPEN_32bpp,
+	PolylineTo_NOTCOPYPEN_32bpp,
+	PolylineTo_MASKPENNOT_32bpp,
+	PolylineTo_NOT_32bpp,
+	PolylineTo_XORPEN_32bpp,
+	PolylineTo_NOTMASKPEN_32bpp,
+	PolylineTo_MASKPEN_32bpp,
+	PolylineTo_NOTXORPEN_32bpp,
+	PolylineTo_NOP_32bpp,
+	PolylineTo_MERGENOTPEN_32bpp,
+	PolylineTo_COPYPEN_32bpp,
+	PolylineTo_MERGEPENNOT_32bpp,
+	PolylineTo_MERGEPEN_32bpp,
+	PolylineTo_WHITE_32bpp
+};
+
+int PolylineTo_32bpp(HGDI_DC hdc, GDI_POINT* lppt, int cCount)
+{
+	pPolylineTo_32bpp _PolylineTo;
+	int rop2 = gdi_GetROP2(hdc) - 1;
+
+	_PolylineTo = PolylineTo_ROP2_32bpp[rop2];
+
+	if (_PolylineTo != NULL)
+		return _PolylineTo(hdc, lppt, cCount);
+	else
+		return 0;
+}
+
+pFillSpan_32bpp FillSpan_ROP2_32bpp[32] =
+{
+	FillSpan_BLACK_32bpp,
+	FillSpan_NOTMERGEPEN_32bpp,
+	FillSpan_MASKNOTPEN_32bpp,
+	FillSpan_NOTCOPYPEN_32bpp,
+	FillSpan_MASKPENNOT_32bpp,
+	FillSpan_NOT_32bpp,
+	FillSpan_XORPEN_32bpp,
+	FillSpan_NOTMASKPEN_32bpp,
+	FillSpan_MASKPEN_32bpp,
+	FillSpan_NOTXORPEN_32bpp,
+	FillSpan_NOP_32bpp,
+	FillSpan_MERGENOTPEN_32bpp,
+	FillSpan_COPYPEN_32bpp,
+	FillSpan_MERGEPENNOT_32bpp,
+	FillSpan_MERGEPEN_32bpp,
+	FillSpan_WHITE_32bpp
+};
+
+/**
+ * Fill one horizontal span with the current brush.\n
+ * Solid copies are the common case and get a plain row store,
+ * the compiler turns it into wide stores.
+ */
+
+int FillSpan_32bpp(HGDI_DC hdc, int nXStart, int nY, int nWidth)
+{
+	int x;
+	uint32* dstp;
+	uint32 color32;
+	pFillSpan_32bpp _FillSpan;
+	int rop2 = gdi_GetROP2(hdc) - 1;
+
+	if ((rop2 == GDI_R2_COPYPEN - 1) && (hdc->brush->style == GDI_BS_SOLID))
+	{
+		dstp = (uint32*) gdi_get_bitmap_pointer(hdc, nXStart, nY);
+
+		if (dstp == 0)
+			return 0;
+
+		color32 = gdi_get_color_32bpp(hdc, hdc->brush->color);
+
+		for (x = 0; x < nWidth; x++)
+			dstp[x] = color32;
+
+		return 1;
+	}
+
+	_FillSpan = FillSpan_ROP2_32bpp[rop2];
+
+	if (_FillSpan != NULL)
+		return _FillSpan(hdc, nXStart, nY, nWidth);
+	else
+		return 0;
+}
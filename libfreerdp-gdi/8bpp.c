@@ -893,104 +893,267 @@ static INLINE void SetPixel_WHITE_8bpp(uint8* pixel, uint8* pen)
 #define GDI_GET_PEN_COLOR	gdi_GetPenColor_8bpp
 
 #define LINE_TO			LineTo_BLACK_8bpp
+#define LINE_SEGMENT		LineSegment_BLACK_8bpp
+#define POLYLINE_TO		PolylineTo_BLACK_8bpp
 #define SET_PIXEL_ROP2		SetPixel_BLACK_8bpp
 #include "include/line.c"
 #undef LINE_TO
+#undef LINE_SEGMENT
+#undef POLYLINE_TO
 #undef SET_PIXEL_ROP2
 
 #define LINE_TO			LineTo_NOTMERGEPEN_8bpp
+#define LINE_SEGMENT		LineSegment_NOTMERGEPEN_8bpp
+#define POLYLINE_TO		PolylineTo_NOTMERGEPEN_8bpp
 #define SET_PIXEL_ROP2		SetPixel_NOTMERGEPEN_8bpp
 #include "include/line.c"
 #undef LINE_TO
+#undef LINE_SEGMENT
+#undef POLYLINE_TO
 #undef SET_PIXEL_ROP2
 
 #define LINE_TO			LineTo_MASKNOTPEN_8bpp
+#define LINE_SEGMENT		LineSegment_MASKNOTPEN_8bpp
+#define POLYLINE_TO		PolylineTo_MASKNOTPEN_8bpp
 #define SET_PIXEL_ROP2		SetPixel_MASKNOTPEN_8bpp
 #include "include/line.c"
 #undef LINE_TO
+#undef LINE_SEGMENT
+#undef POLYLINE_TO
 #undef SET_PIXEL_ROP2
 
 #define LINE_TO			LineTo_NOTCOPYPEN_8bpp
+#define LINE_SEGMENT		LineSegment_NOTCOPYPEN_8bpp
+#define POLYLINE_TO		PolylineTo_NOTCOPYPEN_8bpp
 #define SET_PIXEL_ROP2		SetPixel_NOTCOPYPEN_8bpp
 #include "include/line.c"
 #undef LINE_TO
+#undef LINE_SEGMENT
+#undef POLYLINE_TO
 #undef SET_PIXEL_ROP2
 
 #define LINE_TO			LineTo_MASKPENNOT_8bpp
+#define LINE_SEGMENT		LineSegment_MASKPENNOT_8bpp
+#define POLYLINE_TO		PolylineTo_MASKPENNOT_8bpp
 #define SET_PIXEL_ROP2		SetPixel_MASKPENNOT_8bpp
 #include "include/line.c"
 #undef LINE_TO
+#undef LINE_SEGMENT
+#undef POLYLINE_TO
 #undef SET_PIXEL_ROP2
 
 #define LINE_TO			LineTo_NOT_8bpp
+#define LINE_SEGMENT		LineSegment_NOT_8bpp
+#define POLYLINE_TO		PolylineTo_NOT_8bpp
 #define SET_PIXEL_ROP2		SetPixel_NOT_8bpp
 #include "include/line.c"
 #undef LINE_TO
+#undef LINE_SEGMENT
+#undef POLYLINE_TO
 #undef SET_PIXEL_ROP2
 
 #define LINE_TO			LineTo_XORPEN_8bpp
+#define LINE_SEGMENT		LineSegment_XORPEN_8bpp
+#define POLYLINE_TO		PolylineTo_XORPEN_8bpp
 #define SET_PIXEL_ROP2		SetPixel_XORPEN_8bpp
 #include "include/line.c"
 #undef LINE_TO
+#undef LINE_SEGMENT
+#undef POLYLINE_TO
 #undef SET_PIXEL_ROP2
 
 #define LINE_TO			LineTo_NOTMASKPEN_8bpp
+#define LINE_SEGMENT		LineSegment_NOTMASKPEN_8bpp
+#define POLYLINE_TO		PolylineTo_NOTMASKPEN_8bpp
 #define SET_PIXEL_ROP2		SetPixel_NOTMASKPEN_8bpp
 #include "include/line.c"
 #undef LINE_TO
+#undef LINE_SEGMENT
+#undef POLYLINE_TO
 #undef SET_PIXEL_ROP2
 
 #define LINE_TO			LineTo_MASKPEN_8bpp
+#define LINE_SEGMENT		LineSegment_MASKPEN_8bpp
+#define POLYLINE_TO		PolylineTo_MASKPEN_8bpp
 #define SET_PIXEL_ROP2		SetPixel_MASKPEN_8bpp
 #include "include/line.c"
 #undef LINE_TO
+#undef LINE_SEGMENT
+#undef POLYLINE_TO
 #undef SET_PIXEL_ROP2
 
 #define LINE_TO			LineTo_NOTXORPEN_8bpp
+#define LINE_SEGMENT		LineSegment_NOTXORPEN_8bpp
+#define POLYLINE_TO		PolylineTo_NOTXORPEN_8bpp
 #define SET_PIXEL_ROP2		SetPixel_NOTXORPEN_8bpp
 #include "include/line.c"
 #undef LINE_TO
+#undef LINE_SEGMENT
+#undef POLYLINE_TO
 #undef SET_PIXEL_ROP2
 
 #define LINE_TO			LineTo_NOP_8bpp
+#define LINE_SEGMENT		LineSegment_NOP_8bpp
+#define POLYLINE_TO		PolylineTo_NOP_8bpp
 #define SET_PIXEL_ROP2		SetPixel_NOP_8bpp
 #include "include/line.c"
 #undef LINE_TO
+#undef LINE_SEGMENT
+#undef POLYLINE_TO
 #undef SET_PIXEL_ROP2
 
 #define LINE_TO			LineTo_MERGENOTPEN_8bpp
+#define LINE_SEGMENT		LineSegment_MERGENOTPEN_8bpp
+#define POLYLINE_TO		PolylineTo_MERGENOTPEN_8bpp
 #define SET_PIXEL_ROP2		SetPixel_MERGENOTPEN_8bpp
 #include "include/line.c"
 #undef LINE_TO
+#undef LINE_SEGMENT
+#undef POLYLINE_TO
 #undef SET_PIXEL_ROP2
 
 #define LINE_TO			LineTo_COPYPEN_8bpp
+#define LINE_SEGMENT		LineSegment_COPYPEN_8bpp
+#define POLYLINE_TO		PolylineTo_COPYPEN_8bpp
 #define SET_PIXEL_ROP2		SetPixel_COPYPEN_8bpp
 #include "include/line.c"
 #undef LINE_TO
+#undef LINE_SEGMENT
+#undef POLYLINE_TO
 #undef SET_PIXEL_ROP2
 
 #define LINE_TO			LineTo_MERGEPENNOT_8bpp
+#define LINE_SEGMENT		LineSegment_MERGEPENNOT_8bpp
+#define POLYLINE_TO		PolylineTo_MERGEPENNOT_8bpp
 #define SET_PIXEL_ROP2		SetPixel_MERGEPENNOT_8bpp
 #include "include/line.c"
 #undef LINE_TO
+#undef LINE_SEGMENT
+#undef POLYLINE_TO
 #undef SET_PIXEL_ROP2
 
 #define LINE_TO			LineTo_MERGEPEN_8bpp
+#define LINE_SEGMENT		LineSegment_MERGEPEN_8bpp
+#define POLYLINE_TO		PolylineTo_MERGEPEN_8bpp
 #define SET_PIXEL_ROP2		SetPixel_MERGEPEN_8bpp
 #include "include/line.c"
 #undef LINE_TO
+#undef LINE_SEGMENT
+#undef POLYLINE_TO
 #undef SET_PIXEL_ROP2
 
 #define LINE_TO			LineTo_WHITE_8bpp
+#define LINE_SEGMENT		LineSegment_WHITE_8bpp
+#define POLYLINE_TO		PolylineTo_WHITE_8bpp
 #define SET_PIXEL_ROP2		SetPixel_WHITE_8bpp
 #include "include/line.c"
 #undef LINE_TO
+#undef LINE_SEGMENT
+#undef POLYLINE_TO
+#undef SET_PIXEL_ROP2
+
+#define GDI_GET_COLOR		gdi_get_color_8bpp
+
+#define FILL_SPAN		FillSpan_BLACK_8bpp
+#define SET_PIXEL_ROP2		SetPixel_BLACK_8bpp
+#include "include/span.c"
+#undef FILL_SPAN
+#undef SET_PIXEL_ROP2
+
+#define FILL_SPAN		FillSpan_NOTMERGEPEN_8bpp
+#define SET_PIXEL_ROP2		SetPixel_NOTMERGEPEN_8bpp
+#include "include/span.c"
+#undef FILL_SPAN
+#undef SET_PIXEL_ROP2
+
+#define FILL_SPAN		FillSpan_MASKNOTPEN_8bpp
+#define SET_PIXEL_ROP2		SetPixel_MASKNOTPEN_8bpp
+#include "include/span.c"
+#undef FILL_SPAN
+#undef SET_PIXEL_ROP2
+
+#define FILL_SPAN		FillSpan_NOTCOPYPEN_8bpp
+#define SET_PIXEL_ROP2		SetPixel_NOTCOPYPEN_8bpp
+#include "include/span.c"
+#undef FILL_SPAN
+#undef SET_PIXEL_ROP2
+
+#define FILL_SPAN		FillSpan_MASKPENNOT_8bpp
+#define SET_PIXEL_ROP2		SetPixel_MASKPENNOT_8bpp
+#include "include/span.c"
+#undef FILL_SPAN
+#undef SET_PIXEL_ROP2
+
+#define FILL_SPAN		FillSpan_NOT_8bpp
+#define SET_PIXEL_ROP2		SetPixel_NOT_8bpp
+#include "include/span.c"
+#undef FILL_SPAN
+#undef SET_PIXEL_ROP2
+
+#define FILL_SPAN		FillSpan_XORPEN_8bpp
+#define SET_PIXEL_ROP2		SetPixel_XORPEN_8bpp
+#include "include/span.c"
+#undef FILL_SPAN
+#undef SET_PIXEL_ROP2
+
+#define FILL_SPAN		FillSpan_NOTMASKPEN_8bpp
+#define SET_PIXEL_ROP2		SetPixel_NOTMASKPEN_8bpp
+#include "include/span.c"
+#undef FILL_SPAN
+#undef SET_PIXEL_ROP2
+
+#define FILL_SPAN		FillSpan_MASKPEN_8bpp
+#define SET_PIXEL_ROP2		SetPixel_MASKPEN_8bpp
+#include "include/span.c"
+#undef FILL_SPAN
+#undef SET_PIXEL_ROP2
+
+#define FILL_SPAN		FillSpan_NOTXORPEN_8bpp
+#define SET_PIXEL_ROP2		SetPixel_NOTXORPEN_8bpp
+#include "include/span.c"
+#undef FILL_SPAN
+#undef SET_PIXEL_ROP2
+
+#define FILL_SPAN		FillSpan_NOP_8bpp
+#define SET_PIXEL_ROP2		SetPixel_NOP_8bpp
+#include "include/span.c"
+#undef FILL_SPAN
+#undef SET_PIXEL_ROP2
+
+#define FILL_SPAN		FillSpan_MERGENOTPEN_8bpp
+#define SET_PIXEL_ROP2		SetPixel_MERGENOTPEN_8bpp
+#include "include/span.c"
+#undef FILL_SPAN
+#undef SET_PIXEL_ROP2
+
+#define FILL_SPAN		FillSpan_COPYPEN_8bpp
+#define SET_PIXEL_ROP2		SetPixel_COPYPEN_8bpp
+#include "include/span.c"
+#undef FILL_SPAN
+#undef SET_PIXEL_ROP2
+
+#define FILL_SPAN		FillSpan_MERGEPENNOT_8bpp
+#define SET_PIXEL_ROP2		SetPixel_MERGEPENNOT_8bpp
+#include "include/span.c"
+#undef FILL_SPAN
+#undef SET_PIXEL_ROP2
+
+#define FILL_SPAN		FillSpan_MERGEPEN_8bpp
+#define SET_PIXEL_ROP2		SetPixel_MERGEPEN_8bpp
+#include "include/span.c"
+#undef FILL_SPAN
+#undef SET_PIXEL_ROP2
+
+#define FILL_SPAN		FillSpan_WHITE_8bpp
+#define SET_PIXEL_ROP2		SetPixel_WHITE_8bpp
+#include "include/span.c"
+#undef FILL_SPAN
 #undef SET_PIXEL_ROP2
 
 #undef PIXEL_TYPE
 #undef GDI_GET_POINTER
 #undef GDI_GET_PEN_COLOR
+#undef GDI_GET_COLOR
 
 pLineTo_8bpp LineTo_ROP2_8bpp[32] =
 {
@@ -1024,3 +1187,88 @@ int LineTo_8bpp(HGDI_DC hdc, int nXEnd, int nYEnd)
 	else
 		return 0;
 }
+
+pPolylineTo_8bpp PolylineTo_ROP2_8bpp[32] =
+{
+	PolylineTo_BLACK_8bpp,
+	PolylineTo_NOTMERGEPEN_8bpp,
+	PolylineTo_MASKNOTPEN_8bpp,
+	PolylineTo_NOTCOPYPEN_8bpp,
+	PolylineTo_MASKPENNOT_8bpp,
+	PolylineTo_NOT_8bpp,
+	PolylineTo_XORPEN_8bpp,
+	PolylineTo_NOTMASKPEN_8bpp,
+	PolylineTo_MASKPEN_8bpp,
+	PolylineTo_NOTXORPEN_8bpp,
+	PolylineTo_NOP_8bpp,
+	PolylineTo_MERGENOTPEN_8bpp,
+	PolylineTo_COPYPEN_8bpp,
+	PolylineTo_MERGEPENNOT_8bpp,
+	PolylineTo_MERGEPEN_8bpp,
+	PolylineTo_WHITE_8bpp
+};
+
+int PolylineTo_8bpp(HGDI_DC hdc, GDI_POINT* lppt, int cCount)
+{
+	pPolylineTo_8bpp _PolylineTo;
+	int rop2 = gdi_GetROP2(hdc) - 1;
+
+	_PolylineTo = PolylineTo_ROP2_8bpp[rop2];
+
+	if (_PolylineTo != NULL)
+		return _PolylineTo(hdc, lppt, cCount);
+	else
+		return 0;
+}
+
+pFillSpan_8bpp FillSpan_ROP2_8bpp[32] =
+{
+	FillSpan_BLACK_8bpp,
+	FillSpan_NOTMERGEPEN_8bpp,
+	FillSpan_MASKNOTPEN_8bpp,
+	FillSpan_NOTCOPYPEN_8bpp,
+	FillSpan_MASKPENNOT_8bpp,
+	FillSpan_NOT_8bpp,
+	FillSpan_XORPEN_8bpp,
+	FillSpan_NOTMASKPEN_8bpp,
+	FillSpan_MASKPEN_8bpp,
+	FillSpan_NOTXORPEN_8bpp,
+	FillSpan_NOP_8bpp,
+	FillSpan_MERGENOTPEN_8bpp,
+	FillSpan_COPYPEN_8bpp,
+	FillSpan_MERGEPENNOT_8bpp,
+	FillSpan_MERGEPEN_8bpp,
+	FillSpan_WHITE_8bpp
+};
+
+/**
+ * Fill one horizontal span with the current brush.\n
+ * Solid copies are the common case and get a plain row store,
+ * the compiler turns it into wide stores.
+ */
+
+int FillSpan_8bpp(HGDI_DC hdc, int nXStart, int nY, int nWidth)
+{
+	uint8* dstp;
+	pFillSpan_8bpp _FillSpan;
+	int rop2 = gdi_GetROP2(hdc) - 1;
+
+	if ((rop2 == GDI_R2_COPYPEN - 1) && (hdc->brush->style == GDI_BS_SOLID))
+	{
+		dstp = (uint8*) gdi_get_bitmap_pointer(hdc, nXStart, nY);
+
+		if (dstp == 0)
+			return 0;
+
+		memset(dstp, gdi_get_color_8bpp(hdc, hdc->brush->color), nWidth);
+
+		return 1;
+	}
+
+	_FillSpan = FillSpan_ROP2_8bpp[rop2];
+
+	if (_FillSpan != NULL)
+		return _FillSpan(hdc, nXStart, nY, nWidth);
+	else
+		return 0;
+}
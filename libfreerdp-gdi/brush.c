@@ -74,6 +74,25 @@ HGDI_BRUSH gdi_CreatePatternBrush(HGDI_BITMAP hbmp)
 	return hBrush;
 }
 
+/**
+ * Create a new hatched brush.\n
+ * The hatch is given as an 8bpp mask where non-zero pixels are drawn with
+ * the brush color and the others with the background color of the DC.
+ * @param hbmp hatch mask bitmap
+ * @param crColor hatch color
+ * @return new brush
+ */
+
+HGDI_BRUSH gdi_CreateHatchBrush(HGDI_BITMAP hbmp, GDI_COLOR crColor)
+{
+	HGDI_BRUSH hBrush = (HGDI_BRUSH) xmalloc(sizeof(GDI_BRUSH));
+	hBrush->objectType = GDIOBJECT_BRUSH;
+	hBrush->style = GDI_BS_HATCHED;
+	hBrush->pattern = hbmp;
+	hBrush->color = crColor;
+	return hBrush;
+}
+
 /**
  * Perform a pattern blit operation on the given pixel buffer.\n
  * @msdn{dd162778}
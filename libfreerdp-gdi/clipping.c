@@ -57,6 +57,32 @@ int gdi_SetNullClipRgn(HGDI_DC hdc)
 	return 0;
 }
 
+/**
+ * Get the tightest rectangle shapes can be drawn to, the selected
+ * bitmap reduced to the clipping region. Edges are inclusive.\n
+ * @msdn{dd144865}
+ * @param hdc device context
+ * @param lprc clipping box
+ * @return 1 if the clipping box is not empty, 0 otherwise
+ */
+
+int gdi_GetClipBox(HGDI_DC hdc, HGDI_RECT lprc)
+{
+	HGDI_BITMAP hBmp = (HGDI_BITMAP) hdc->selectedObject;
+
+	gdi_CRgnToRect(0, 0, hBmp->width, hBmp->height, lprc);
+
+	if (!hdc->clip->null)
+	{
+		lprc->left = MAX(lprc->left, hdc->clip->x);
+		lprc->top = MAX(lprc->top, hdc->clip->y);
+		lprc->right = MIN(lprc->right, hdc->clip->x + hdc->clip->w - 1);
+		lprc->bottom = MIN(lprc->bottom, hdc->clip->y + hdc->clip->h - 1);
+	}
+
+	return (lprc->left <= lprc->right) && (lprc->top <= lprc->bottom);
+}
+
 /**
  * Clip coordinates according to clipping region
  * @param hdc device context
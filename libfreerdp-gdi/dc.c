@@ -43,6 +43,7 @@ HGDI_DC gdi_GetDC()
 	hDC->bytesPerPixel = 4;
 	hDC->bitsPerPixel = 32;
 	hDC->drawMode = GDI_R2_BLACK;
+	hDC->polyFillMode = GDI_ALTERNATE;
 	hDC->clip = gdi_CreateRectRgn(0, 0, 0, 0);
 	hDC->clip->null = 1;
 	hDC->hwnd = NULL;
@@ -60,6 +61,7 @@ HGDI_DC gdi_CreateDC(HCLRCONV clrconv, int bpp)
 	HGDI_DC hDC = (HGDI_DC) xmalloc(sizeof(GDI_DC));
 
 	hDC->drawMode = GDI_R2_BLACK;
+	hDC->polyFillMode = GDI_ALTERNATE;
 	hDC->clip = gdi_CreateRectRgn(0, 0, 0, 0);
 	hDC->clip->null = 1;
 	hDC->hwnd = NULL;
@@ -95,6 +97,7 @@ HGDI_DC gdi_CreateCompatibleDC(HGDI_DC hdc)
 	hDC->bytesPerPixel = hdc->bytesPerPixel;
 	hDC->bitsPerPixel = hdc->bitsPerPixel;
 	hDC->drawMode = hdc->drawMode;
+	hDC->polyFillMode = hdc->polyFillMode;
 	hDC->clip = gdi_CreateRectRgn(0, 0, 0, 0);
 	hDC->clip->null = 1;
 	hDC->hwnd = NULL;
@@ -180,7 +183,7 @@ int gdi_DeleteObject(HGDIOBJECT hgdiobject)
 	{
 		HGDI_BRUSH hBrush = (HGDI_BRUSH) hgdiobject;
 
-		if(hBrush->style == GDI_BS_PATTERN)
+		if (hBrush->style == GDI_BS_PATTERN || hBrush->style == GDI_BS_HATCHED)
 		{
 			if (hBrush->pattern != NULL)
 				gdi_DeleteObject((HGDIOBJECT) hBrush->pattern);
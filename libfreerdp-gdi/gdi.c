@@ -583,34 +583,46 @@ void gdi_line_to(rdpContext* context, LINE_TO_ORDER* line_to)
 	gdi_DeleteObject((HGDIOBJECT) hPen);
 }
 
-void gdi_polyline(rdpContext* context, POLYLINE_ORDER* polyline)
+/* delta-encoded points to absolute coordinates, including the start point */
+static GDI_POINT* gdi_get_delta_points(sint32 xStart, sint32 yStart, DELTA_POINT* deltas, int numPoints)
 {
 	int i;
+	GDI_POINT* points;
+
+	points = (GDI_POINT*) xmalloc(sizeof(GDI_POINT) * (numPoints + 1));
+
+	points[0].x = xStart;
+	points[0].y = yStart;
+
+	for (i = 0; i < numPoints; i++)
+	{
+		points[i + 1].x = points[i].x + deltas[i].x;
+		points[i + 1].y = points[i].y + deltas[i].y;
+	}
+
+	return points;
+}
+
+void gdi_polyline(rdpContext* context, POLYLINE_ORDER* polyline)
+{
 	uint32 color;
 	HGDI_PEN hPen;
-	DELTA_POINT* points;
+	GDI_POINT* points;
 	rdpGdi* gdi = context->gdi;
-	sint32 x;
-	sint32 y;
 
 	color = freerdp_color_convert_rgb(polyline->penColor, gdi->srcBpp, 32, gdi->clrconv);
 	hPen = gdi_CreatePen(GDI_PS_SOLID, 1, (GDI_COLOR) color);
 	gdi_SelectObject(gdi->drawing->hdc, (HGDIOBJECT) hPen);
 	gdi_SetROP2(gdi->drawing->hdc, polyline->bRop2);
 
-	x = polyline->xStart;
-	y = polyline->yStart;
-	gdi_MoveToEx(gdi->drawing->hdc, x, y, NULL);
+	/* the whole polyline is drawn in one pass */
+	points = gdi_get_delta_points(polyline->xStart, polyline->yStart,
+			polyline->points, polyline->numPoints);
 
-	points = polyline->points;
-	for (i = 0; i < (int) polyline->numPoints; i++)
-	{
-		x += points[i].x;
-		y += points[i].y;
-		gdi_LineTo(gdi->drawing->hdc, x, y);
-		gdi_MoveToEx(gdi->drawing->hdc, x, y, NULL);
-	}
+	gdi_MoveToEx(gdi->drawing->hdc, points[0].x, points[0].y, NULL);
+	gdi_PolylineTo(gdi->drawing->hdc, &points[1], polyline->numPoints);
 
+	xfree(points);
 	gdi_DeleteObject((HGDIOBJECT) hPen);
 }
 
@@ -659,24 +671,214 @@ void gdi_mem3blt(rdpContext* context, MEM3BLT_ORDER* mem3blt)
 	}
 }
 
+/* 8x8 hatch patterns indexed by GDI_HS_*, set bits are drawn in the foreground color */
+static const uint8 gdi_hatch_patterns[6][8] =
+{
+	{ 0x00, 0x00, 0x00, 0xFF, 0x00, 0x00, 0x00, 0x00 }, /* GDI_HS_HORIZONTAL */
+	{ 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08 }, /* GDI_HS_VERTICAL */
+	{ 0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01 }, /* GDI_HS_FDIAGONAL */
+	{ 0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80 }, /* GDI_HS_BDIAGONAL */
+	{ 0x08, 0x08, 0x08, 0xFF, 0x08, 0x08, 0x08, 0x08 }, /* GDI_HS_CROSS */
+	{ 0x81, 0x42, 0x24, 0x18, 0x18, 0x24, 0x42, 0x81 }  /* GDI_HS_DIAGCROSS */
+};
+
+static HGDI_BITMAP gdi_create_hatch_mask(const uint8* bits, boolean foregroundSet)
+{
+	int x, y;
+	uint8* mask;
+
+	mask = (uint8*) xmalloc(8 * 8);
+
+	for (y = 0; y < 8; y++)
+	{
+		for (x = 0; x < 8; x++)
+		{
+			if (((bits[y] >> (7 - x)) & 0x01) == (foregroundSet ? 1 : 0))
+				mask[y * 8 + x] = 0xFF;
+			else
+				mask[y * 8 + x] = 0x00;
+		}
+	}
+
+	return gdi_CreateBitmap(8, 8, 8, mask);
+}
+
+/**
+ * Create a brush for the shape orders, mono patterns and hatches become
+ * hatched brushes so the background can follow the order back mode.
+ */
+
+static HGDI_BRUSH gdi_create_order_brush(rdpGdi* gdi, rdpBrush* brush, uint32 foreColor)
+{
+	uint8* data;
+	HGDI_BITMAP hBmp;
+
+	if (brush->style == GDI_BS_SOLID)
+		return gdi_CreateSolidBrush(foreColor);
+
+	if (brush->style == GDI_BS_HATCHED && brush->hatch <= GDI_HS_DIAGCROSS)
+		return gdi_CreateHatchBrush(gdi_create_hatch_mask(gdi_hatch_patterns[brush->hatch], true), foreColor);
+
+	if (brush->style == GDI_BS_PATTERN)
+	{
+		/* a failed brush cache lookup */
+		if (brush->data == NULL)
+			return NULL;
+
+		/* only cached brushes carry colour data, inline patterns are the 8 bytes of p8x8 */
+		if (brush->data == brush->p8x8 || brush->bpp <= 1)
+			return gdi_CreateHatchBrush(gdi_create_hatch_mask(brush->data, false), foreColor);
+
+		data = freerdp_image_convert(brush->data, NULL, 8, 8, gdi->srcBpp, gdi->dstBpp, gdi->clrconv);
+		hBmp = gdi_CreateBitmap(8, 8, gdi->drawing->hdc->bitsPerPixel, data);
+
+		return gdi_CreatePatternBrush(hBmp);
+	}
+
+	printf("unimplemented brush style:%d\n", brush->style);
+	return NULL;
+}
+
 void gdi_polygon_sc(rdpContext* context, POLYGON_SC_ORDER* polygon_sc)
 {
-	printf("PolygonSC\n");
+	uint32 color;
+	GDI_POINT* points;
+	HGDI_BRUSH originalBrush;
+	rdpGdi* gdi = context->gdi;
+	HGDI_DC hdc = gdi->drawing->hdc;
+
+	color = freerdp_color_convert_rgb(polygon_sc->brushColor, gdi->srcBpp, 32, gdi->clrconv);
+	points = gdi_get_delta_points(polygon_sc->xStart, polygon_sc->yStart,
+			polygon_sc->points, polygon_sc->numPoints);
+
+	originalBrush = hdc->brush;
+	hdc->brush = gdi_CreateSolidBrush(color);
+	gdi_SetROP2(hdc, polygon_sc->bRop2);
+	gdi_SetPolyFillMode(hdc, polygon_sc->fillMode);
+
+	gdi_Polygon(hdc, points, polygon_sc->numPoints + 1);
+
+	gdi_DeleteObject((HGDIOBJECT) hdc->brush);
+	hdc->brush = originalBrush;
+	xfree(points);
 }
 
 void gdi_polygon_cb(rdpContext* context, POLYGON_CB_ORDER* polygon_cb)
 {
-	printf("PolygonCB\n");
+	int bkMode;
+	GDI_COLOR bkColor;
+	uint32 foreColor;
+	uint32 backColor;
+	GDI_POINT* points;
+	HGDI_BRUSH hBrush;
+	HGDI_BRUSH originalBrush;
+	rdpGdi* gdi = context->gdi;
+	HGDI_DC hdc = gdi->drawing->hdc;
+
+	foreColor = freerdp_color_convert_rgb(polygon_cb->foreColor, gdi->srcBpp, 32, gdi->clrconv);
+	backColor = freerdp_color_convert_rgb(polygon_cb->backColor, gdi->srcBpp, 32, gdi->clrconv);
+
+	hBrush = gdi_create_order_brush(gdi, &polygon_cb->brush, foreColor);
+
+	if (hBrush == NULL)
+		return;
+
+	points = gdi_get_delta_points(polygon_cb->xStart, polygon_cb->yStart,
+			polygon_cb->points, polygon_cb->numPoints);
+
+	bkMode = gdi_GetBkMode(hdc);
+	bkColor = gdi_SetBkColor(hdc, backColor);
+	gdi_SetBkMode(hdc, (polygon_cb->backMode == BACKMODE_TRANSPARENT) ? GDI_TRANSPARENT : GDI_OPAQUE);
+
+	originalBrush = hdc->brush;
+	hdc->brush = hBrush;
+	gdi_SetROP2(hdc, polygon_cb->bRop2);
+	gdi_SetPolyFillMode(hdc, polygon_cb->fillMode);
+
+	gdi_Polygon(hdc, points, polygon_cb->numPoints + 1);
+
+	gdi_DeleteObject((HGDIOBJECT) hdc->brush);
+	hdc->brush = originalBrush;
+	gdi_SetBkColor(hdc, bkColor);
+	gdi_SetBkMode(hdc, bkMode);
+	xfree(points);
 }
 
+/**
+ * Ellipse orders carry an inclusive bounding rectangle, a zero fill mode
+ * only draws the outline.
+ */
+
 void gdi_ellipse_sc(rdpContext* context, ELLIPSE_SC_ORDER* ellipse_sc)
 {
-	printf("EllipseSC\n");
+	uint32 color;
+	HGDI_PEN hPen;
+	HGDI_BRUSH originalBrush;
+	rdpGdi* gdi = context->gdi;
+	HGDI_DC hdc = gdi->drawing->hdc;
+
+	color = freerdp_color_convert_rgb(ellipse_sc->color, gdi->srcBpp, 32, gdi->clrconv);
+
+	hPen = gdi_CreatePen((ellipse_sc->fillMode) ? GDI_PS_NULL : GDI_PS_SOLID, 1, (GDI_COLOR) color);
+	gdi_SelectObject(hdc, (HGDIOBJECT) hPen);
+	gdi_SetROP2(hdc, ellipse_sc->bRop2);
+
+	originalBrush = hdc->brush;
+	hdc->brush = (ellipse_sc->fillMode) ? gdi_CreateSolidBrush(color) : NULL;
+
+	gdi_Ellipse(hdc, ellipse_sc->leftRect, ellipse_sc->topRect,
+			ellipse_sc->rightRect + 1, ellipse_sc->bottomRect + 1);
+
+	if (hdc->brush != NULL)
+		gdi_DeleteObject((HGDIOBJECT) hdc->brush);
+
+	hdc->brush = originalBrush;
+	gdi_DeleteObject((HGDIOBJECT) hPen);
 }
 
 void gdi_ellipse_cb(rdpContext* context, ELLIPSE_CB_ORDER* ellipse_cb)
 {
-	printf("EllipseCB\n");
+	int bkMode;
+	uint32 foreColor;
+	uint32 backColor;
+	GDI_COLOR bkColor;
+	HGDI_PEN hPen;
+	HGDI_BRUSH hBrush = NULL;
+	HGDI_BRUSH originalBrush;
+	rdpGdi* gdi = context->gdi;
+	HGDI_DC hdc = gdi->drawing->hdc;
+
+	foreColor = freerdp_color_convert_rgb(ellipse_cb->foreColor, gdi->srcBpp, 32, gdi->clrconv);
+	backColor = freerdp_color_convert_rgb(ellipse_cb->backColor, gdi->srcBpp, 32, gdi->clrconv);
+
+	if (ellipse_cb->fillMode)
+	{
+		hBrush = gdi_create_order_brush(gdi, &ellipse_cb->brush, foreColor);
+
+		if (hBrush == NULL)
+			return;
+	}
+
+	hPen = gdi_CreatePen((ellipse_cb->fillMode) ? GDI_PS_NULL : GDI_PS_SOLID, 1, (GDI_COLOR) foreColor);
+	gdi_SelectObject(hdc, (HGDIOBJECT) hPen);
+	gdi_SetROP2(hdc, ellipse_cb->bRop2);
+	bkMode = gdi_GetBkMode(hdc);
+	bkColor = gdi_SetBkColor(hdc, backColor);
+	gdi_SetBkMode(hdc, GDI_OPAQUE);
+
+	originalBrush = hdc->brush;
+	hdc->brush = hBrush;
+
+	gdi_Ellipse(hdc, ellipse_cb->leftRect, ellipse_cb->topRect,
+			ellipse_cb->rightRect + 1, ellipse_cb->bottomRect + 1);
+
+	if (hBrush != NULL)
+		gdi_DeleteObject((HGDIOBJECT) hBrush);
+
+	hdc->brush = originalBrush;
+	gdi_SetBkColor(hdc, bkColor);
+	gdi_SetBkMode(hdc, bkMode);
+	gdi_DeleteObject((HGDIOBJECT) hPen);
 }
 
 int tilenum = 0;
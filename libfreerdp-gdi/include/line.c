@@ -19,24 +19,24 @@
 
 /* do not include this file directly! */
 
-int LINE_TO(HGDI_DC hdc, int nXEnd, int nYEnd)
+/**
+ * Draw a segment from (x1, y1) up to, but not including, (x2, y2).
+ * Pixels are written in runs along the major axis, so clipping is
+ * done per run and horizontal or vertical lines are a single run.
+ */
+
+static void LINE_SEGMENT(HGDI_BITMAP bmp, HGDI_RECT bounds, PIXEL_TYPE pen, int x1, int y1, int x2, int y2)
 {
+	int n;
 	int x, y;
-	int x1, y1;
-	int x2, y2;
+	int px, py;
+	int rx, ry;
 	int e, e2;
 	int dx, dy;
 	int sx, sy;
-	int bx1, by1;
-	int bx2, by2;
-	PIXEL_TYPE pen;
+	int start, end;
+	boolean xmajor;
 	PIXEL_TYPE* pixel;
-	HGDI_BITMAP bmp;
-
-	x1 = hdc->pen->posX;
-	y1 = hdc->pen->posY;
-	x2 = nXEnd;
-	y2 = nYEnd;
 
 	dx = (x1 > x2) ? x1 - x2 : x2 - x1;
 	dy = (y1 > y2) ? y1 - y2 : y2 - y1;
@@ -44,44 +44,17 @@ int LINE_TO(HGDI_DC hdc, int nXEnd, int nYEnd)
 	sx = (x1 < x2) ? 1 : -1;
 	sy = (y1 < y2) ? 1 : -1;
 
+	xmajor = (dx >= dy) ? true : false;
+
 	e = dx - dy;
 
-	x = x1;
-	y = y1;
+	x = rx = x1;
+	y = ry = y1;
 
-	bmp = (HGDI_BITMAP) hdc->selectedObject;
-
-	if (hdc->clip->null)
-	{
-		bx1 = (x1 < x2) ? x1 : x2;
-		by1 = (y1 < y2) ? y1 : y2;
-		bx2 = (x1 > x2) ? x1 : x2;
-		by2 = (y1 > y2) ? y1 : y2;
-	}
-	else
+	while (!(x == x2 && y == y2))
 	{
-		bx1 = hdc->clip->x;
-		by1 = hdc->clip->y;
-		bx2 = bx1 + hdc->clip->w - 1;
-		by2 = by1 + hdc->clip->h - 1;
-	}
-
-	pen = GDI_GET_PEN_COLOR(hdc->pen);
-
-	while (1)
-	{
-		if (!(x == x2 && y == y2))
-		{
-			if ((x >= bx1 && x <= bx2) && (y >= by1 && y <= by2))
-			{
-				pixel = GDI_GET_POINTER(bmp, x, y);
-				SET_PIXEL_ROP2(pixel, &pen);
-			}
-		}
-		else
-		{
-			break;
-		}
+		px = x;
+		py = y;
 
 		e2 = 2 * e;
 
@@ -96,13 +69,137 @@ int LINE_TO(HGDI_DC hdc, int nXEnd, int nYEnd)
 			e += dx;
 			y += sy;
 		}
+
+		/* extend the run until the minor coordinate changes */
+		if (!(x == x2 && y == y2) && ((xmajor) ? (y == py) : (x == px)))
+			continue;
+
+		if (xmajor)
+		{
+			if (py >= bounds->top && py <= bounds->bottom)
+			{
+				start = MAX(MIN(rx, px), bounds->left);
+				end = MIN(MAX(rx, px), bounds->right);
+
+				if (start <= end)
+				{
+					pixel = GDI_GET_POINTER(bmp, start, py);
+
+					for (n = start; n <= end; n++)
+						SET_PIXEL_ROP2(pixel++, &pen);
+				}
+			}
+		}
+		else
+		{
+			if (px >= bounds->left && px <= bounds->right)
+			{
+				start = MAX(MIN(ry, py), bounds->top);
+				end = MIN(MAX(ry, py), bounds->bottom);
+
+				if (start <= end)
+				{
+					pixel = GDI_GET_POINTER(bmp, px, start);
+
+					for (n = start; n <= end; n++)
+					{
+						SET_PIXEL_ROP2(pixel, &pen);
+						pixel += bmp->width;
+					}
+				}
+			}
+		}
+
+		rx = x;
+		ry = y;
+	}
+}
+
+int LINE_TO(HGDI_DC hdc, int nXEnd, int nYEnd)
+{
+	int x1, y1;
+	int x2, y2;
+	PIXEL_TYPE pen;
+	GDI_RECT bounds;
+	HGDI_BITMAP bmp;
+
+	if (!gdi_GetClipBox(hdc, &bounds))
+		return 1;
+
+	bmp = (HGDI_BITMAP) hdc->selectedObject;
+	pen = GDI_GET_PEN_COLOR(hdc->pen);
+
+	LINE_SEGMENT(bmp, &bounds, pen, hdc->pen->posX, hdc->pen->posY, nXEnd, nYEnd);
+
+	x1 = MAX(MIN(hdc->pen->posX, nXEnd), bounds.left);
+	y1 = MAX(MIN(hdc->pen->posY, nYEnd), bounds.top);
+	x2 = MIN(MAX(hdc->pen->posX, nXEnd), bounds.right);
+	y2 = MIN(MAX(hdc->pen->posY, nYEnd), bounds.bottom);
+
+	if (x1 <= x2 && y1 <= y2)
+		gdi_InvalidateRegion(hdc, x1, y1, x2 - x1 + 1, y2 - y1 + 1);
+
+	return 1;
+}
+
+/**
+ * Draw connected segments from the current position, the clipping box,
+ * pen color and invalidated region are computed once for the whole run.
+ */
+
+int POLYLINE_TO(HGDI_DC hdc, GDI_POINT* lppt, int cCount)
+{
+	int i;
+	int x, y;
+	int x1, y1;
+	int x2, y2;
+	PIXEL_TYPE pen;
+	GDI_RECT bounds;
+	HGDI_BITMAP bmp;
+
+	if (cCount < 1)
+		return 1;
+
+	x = x1 = x2 = hdc->pen->posX;
+	y = y1 = y2 = hdc->pen->posY;
+
+	hdc->pen->posX = lppt[cCount - 1].x;
+	hdc->pen->posY = lppt[cCount - 1].y;
+
+	if (!gdi_GetClipBox(hdc, &bounds))
+		return 1;
+
+	bmp = (HGDI_BITMAP) hdc->selectedObject;
+	pen = GDI_GET_PEN_COLOR(hdc->pen);
+
+	for (i = 0; i < cCount; i++)
+	{
+		LINE_SEGMENT(bmp, &bounds, pen, x, y, lppt[i].x, lppt[i].y);
+
+		x = lppt[i].x;
+		y = lppt[i].y;
+
+		x1 = MIN(x1, x);
+		y1 = MIN(y1, y);
+		x2 = MAX(x2, x);
+		y2 = MAX(y2, y);
 	}
 
+	x1 = MAX(x1, bounds.left);
+	y1 = MAX(y1, bounds.top);
+	x2 = MIN(x2, bounds.right);
+	y2 = MIN(y2, bounds.bottom);
+
+	if (x1 <= x2 && y1 <= y2)
+		gdi_InvalidateRegion(hdc, x1, y1, x2 - x1 + 1, y2 - y1 + 1);
+
 	return 1;
 }
 
 /*
 #undef LINE_TO
+#undef LINE_SEGMENT
+#undef POLYLINE_TO
 #undef PIXEL_TYPE
 #undef SET_PIXEL_ROP2
 #undef GDI_GET_POINTER
@@ -0,0 +1,89 @@
+/**
+ * FreeRDP: A Remote Desktop Protocol Client
+ * GDI FillSpan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* do not include this file directly! */
+
+int FILL_SPAN(HGDI_DC hdc, int nXStart, int nY, int nWidth)
+{
+	int x;
+	int nXEnd;
+	uint8* maskp;
+	PIXEL_TYPE fore;
+	PIXEL_TYPE back;
+	PIXEL_TYPE* dstp;
+	PIXEL_TYPE* patp;
+	HGDI_BITMAP pattern;
+	HGDI_BRUSH brush = hdc->brush;
+
+	dstp = (PIXEL_TYPE*) gdi_get_bitmap_pointer(hdc, nXStart, nY);
+
+	if (dstp == 0)
+		return 0;
+
+	nXEnd = nXStart + nWidth;
+
+	switch (brush->style)
+	{
+		case GDI_BS_SOLID:
+			fore = GDI_GET_COLOR(hdc, brush->color);
+
+			for (x = nXStart; x < nXEnd; x++)
+				SET_PIXEL_ROP2(dstp++, &fore);
+
+			break;
+
+		case GDI_BS_PATTERN:
+			pattern = brush->pattern;
+			patp = (PIXEL_TYPE*) &pattern->data[(nY % pattern->height) * pattern->scanline];
+
+			for (x = nXStart; x < nXEnd; x++)
+				SET_PIXEL_ROP2(dstp++, &patp[x % pattern->width]);
+
+			break;
+
+		case GDI_BS_HATCHED:
+			/* the pattern is an 8bpp mask, the background follows bkMode */
+			pattern = brush->pattern;
+			maskp = &pattern->data[(nY % pattern->height) * pattern->scanline];
+			fore = GDI_GET_COLOR(hdc, brush->color);
+			back = GDI_GET_COLOR(hdc, hdc->bkColor);
+
+			for (x = nXStart; x < nXEnd; x++)
+			{
+				if (maskp[x % pattern->width])
+					SET_PIXEL_ROP2(dstp, &fore);
+				else if (hdc->bkMode == GDI_OPAQUE)
+					SET_PIXEL_ROP2(dstp, &back);
+
+				dstp++;
+			}
+
+			break;
+
+		default:
+			break;
+	}
+
+	return 1;
+}
+
+/*
+#undef FILL_SPAN
+#undef PIXEL_TYPE
+#undef SET_PIXEL_ROP2
+#undef GDI_GET_COLOR
+*/
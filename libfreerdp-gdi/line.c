@@ -39,6 +39,15 @@ p_LineTo LineTo_[5] =
 	LineTo_32bpp
 };
 
+p_PolylineTo PolylineTo_[5] =
+{
+	NULL,
+	PolylineTo_8bpp,
+	PolylineTo_16bpp,
+	NULL,
+	PolylineTo_32bpp
+};
+
 /**
  * Draw a line from the current position to the given position.\n
  * @msdn{dd145029}
@@ -67,15 +76,12 @@ int gdi_LineTo(HGDI_DC hdc, int nXEnd, int nYEnd)
  */
 int gdi_PolylineTo(HGDI_DC hdc, GDI_POINT *lppt, int cCount)
 {
-	int i;
-
-	for (i = 0; i < cCount; i++)
-	{
-		gdi_LineTo(hdc, lppt[i].x, lppt[i].y);
-		gdi_MoveToEx(hdc, lppt[i].x, lppt[i].y, NULL);
-	}
+	p_PolylineTo _PolylineTo = PolylineTo_[IBPP(hdc->bitsPerPixel)];
 
-	return 1;
+	if (_PolylineTo != NULL)
+		return _PolylineTo(hdc, lppt, cCount);
+	else
+		return 0;
 }
 
 /**
@@ -89,17 +95,10 @@ int gdi_Polyline(HGDI_DC hdc, GDI_POINT *lppt, int cPoints)
 {
 	if (cPoints > 0)
 	{
-		int i;
 		GDI_POINT pt;
 
 		gdi_MoveToEx(hdc, lppt[0].x, lppt[0].y, &pt);
-
-		for (i = 0; i < cPoints; i++)
-		{
-			gdi_LineTo(hdc, lppt[i].x, lppt[i].y);
-			gdi_MoveToEx(hdc, lppt[i].x, lppt[i].y, NULL);
-		}
-
+		gdi_PolylineTo(hdc, &lppt[1], cPoints - 1);
 		gdi_MoveToEx(hdc, pt.x, pt.y, NULL);
 	}
 
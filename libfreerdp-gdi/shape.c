@@ -22,11 +22,14 @@
 #include <stdlib.h>
 #include <freerdp/freerdp.h>
 #include <freerdp/gdi/gdi.h>
+#include <freerdp/utils/memory.h>
 
 #include <freerdp/gdi/8bpp.h>
 #include <freerdp/gdi/16bpp.h>
 #include <freerdp/gdi/32bpp.h>
 #include <freerdp/gdi/bitmap.h>
+#include <freerdp/gdi/region.h>
+#include <freerdp/gdi/clipping.h>
 
 #include <freerdp/gdi/shape.h>
 
@@ -39,118 +42,168 @@ p_FillRect FillRect_[5] =
 	FillRect_32bpp
 };
 
-static void Ellipse_Bresenham(HGDI_DC hdc, int x1, int y1, int x2, int y2)
+p_FillSpan FillSpan_[5] =
 {
-	int i;
-	long e, e2;
-	long dx, dy;
-	int a, b, c;
-
-	HGDI_BITMAP bmp;
-	uint8 pixel8;
-	uint16 pixel16;
-	uint32 pixel32;
-	int bpp = hdc->bitsPerPixel;
-
-	a = (x1 < x2) ? x2 - x1 : x1 - x2;
-	b = (y1 < y2) ? y2 - y1 : y1 - y2;
-	c = b & 1;
-
-	dx = 4 * (1 - a) * b * b;
-	dy = 4 * (c + 1) * a * a;
-	e = dx + dy + c * a * a;
-
-	if (x1 > x2)
-	{
-		x1 = x2;
-		x2 += a;
-	}
+	NULL,
+	FillSpan_8bpp,
+	FillSpan_16bpp,
+	NULL,
+	FillSpan_32bpp
+};
+
+struct _GDI_EDGE
+{
+	int yTop; /* first scanline crossed */
+	int yBottom; /* last scanline crossed + 1 */
+	int winding;
+	sint64 x; /* 16.16, at the center of the current scanline */
+	sint64 dx;
+};
+typedef struct _GDI_EDGE GDI_EDGE;
 
-	if (y1 > y2)
-		y1 = y2;
+/* first pixel whose center lies at or right of a 16.16 coordinate */
+#define FIXED_TO_PIXEL(_x)	((int) (((_x) + 0x7FFF) >> 16))
 
-	y1 += (b + 1) / 2;
-	y2 = y1 - c;
+static INLINE void gdi_fill_span(HGDI_DC hdc, p_FillSpan _FillSpan, GDI_RECT* bounds, int x1, int x2, int y)
+{
+	x1 = MAX(x1, bounds->left);
+	x2 = MIN(x2, bounds->right + 1);
+
+	if (x1 < x2)
+		_FillSpan(hdc, x1, y, x2 - x1);
+}
 
-	a *= 8 * a;
-	c = 8 * b * b;
+static uint32 gdi_isqrt(uint64 n)
+{
+	uint64 root = 0;
+	uint64 bit = ((uint64) 1) << 62;
 
-	pixel8 = 0;
-	pixel16 = 0;
-	pixel32 = 0;
-	bmp = (HGDI_BITMAP) hdc->selectedObject;
+	while (bit > n)
+		bit >>= 2;
 
-	do
+	while (bit != 0)
 	{
-		if (bpp == 32)
+		if (n >= root + bit)
 		{
-			gdi_SetPixel_32bpp(bmp, x2, y1, pixel32);
-			gdi_SetPixel_32bpp(bmp, x1, y1, pixel32);
-			gdi_SetPixel_32bpp(bmp, x1, y2, pixel32);
-			gdi_SetPixel_32bpp(bmp, x2, y2, pixel32);
+			n -= root + bit;
+			root = (root >> 1) + bit;
 		}
-		else if (bpp == 16)
+		else
 		{
-			gdi_SetPixel_16bpp(bmp, x2, y1, pixel16);
-			gdi_SetPixel_16bpp(bmp, x1, y1, pixel16);
-			gdi_SetPixel_16bpp(bmp, x1, y2, pixel16);
-			gdi_SetPixel_16bpp(bmp, x2, y2, pixel16);
+			root >>= 1;
 		}
-		else if (bpp == 8)
+
+		bit >>= 2;
+	}
+
+	return (uint32) root;
+}
+
+/**
+ * Compute the span of scanline y covered by the ellipse inscribed in [left, right) x [top, bottom).
+ * Coordinates are doubled so pixel centers stay integral.
+ * @return false if the scanline does not cross the ellipse
+ */
+
+static boolean gdi_ellipse_span(int left, int top, int right, int bottom, int y, int* x1, int* x2)
+{
+	sint64 w, h, dy;
+	uint32 d;
+
+	w = right - left;
+	h = bottom - top;
+	dy = 2 * y + 1 - (top + bottom);
+
+	if (w < 1 || h < 1 || dy <= -h || dy >= h)
+		return false;
+
+	d = gdi_isqrt(((uint64) (w * w) * (uint64) (h * h - dy * dy)) / (uint64) (h * h));
+
+	*x1 = (left + right - (int) d) >> 1;
+	*x2 = ((left + right + (int) d - 1) >> 1) + 1;
+
+	/* keep the tips of narrow ellipses */
+	if (*x2 <= *x1)
+		*x2 = *x1 + 1;
+
+	return true;
+}
+
+static void gdi_fill_ellipse(HGDI_DC hdc, int left, int top, int right, int bottom)
+{
+	int y;
+	int x1, x2;
+	int fx1, fx2;
+	int lx, rx;
+	boolean fill;
+	boolean outline;
+	GDI_RECT bounds;
+	GDI_BRUSH penBrush;
+	HGDI_BRUSH brush = hdc->brush;
+	p_FillSpan _FillSpan = FillSpan_[IBPP(hdc->bitsPerPixel)];
+
+	if (_FillSpan == NULL || !gdi_GetClipBox(hdc, &bounds))
+		return;
+
+	fill = (brush != NULL) && (brush->style != GDI_BS_NULL);
+	outline = (hdc->pen != NULL) && (hdc->pen->style != GDI_PS_NULL);
+
+	penBrush.objectType = GDIOBJECT_BRUSH;
+	penBrush.style = GDI_BS_SOLID;
+	penBrush.pattern = NULL;
+	penBrush.color = (outline) ? hdc->pen->color : 0;
+
+	for (y = MAX(top, bounds.top); y < MIN(bottom, bounds.bottom + 1); y++)
+	{
+		if (!gdi_ellipse_span(left, top, right, bottom, y, &x1, &x2))
+			continue;
+
+		lx = x1;
+		rx = x2;
+
+		if (outline)
 		{
-			for (i = x1; i < x2; i++)
+			/* the outline must reach the scanline one step further from the center */
+			if (gdi_ellipse_span(left, top, right, bottom, (2 * y + 1 < top + bottom) ? y - 1 : y + 1, &fx1, &fx2))
 			{
-				gdi_SetPixel_8bpp(bmp, i, y1, pixel8);
-				gdi_SetPixel_8bpp(bmp, i, y2, pixel8);
+				lx = MAX(x1 + 1, fx1);
+				rx = MIN(x2 - 1, fx2);
 			}
-
-			for (i = y1; i < y2; i++)
+			else
 			{
-				gdi_SetPixel_8bpp(bmp, x1, i, pixel8);
-				gdi_SetPixel_8bpp(bmp, x2, i, pixel8);
+				/* top or bottom scanline, entirely outline */
+				lx = rx = x2;
 			}
-		}
 
-		e2 = 2 * e;
+			hdc->brush = &penBrush;
 
-		if (e2 >= dx)
-		{
-			x1++;
-			x2--;
-			e += dx += c;
-		}
+			if (lx >= rx)
+			{
+				gdi_fill_span(hdc, _FillSpan, &bounds, x1, x2, y);
+			}
+			else
+			{
+				gdi_fill_span(hdc, _FillSpan, &bounds, x1, lx, y);
+				gdi_fill_span(hdc, _FillSpan, &bounds, rx, x2, y);
+			}
 
-		if (e2 <= dy)
-		{
-			y1++;
-			y2--;
-			e += dy += a;
+			hdc->brush = brush;
 		}
-	}
-	while (x1 <= x2);
 
-	while (y1 - y2 < b)
-	{
-		if (bpp == 32)
-		{
-			gdi_SetPixel_32bpp(bmp, x1 - 1, ++y1, pixel32);
-			gdi_SetPixel_32bpp(bmp, x1 - 1, --y2, pixel32);
-		}
-		else if (bpp == 16)
-		{
-			gdi_SetPixel_16bpp(bmp, x1 - 1, ++y1, pixel16);
-			gdi_SetPixel_16bpp(bmp, x1 - 1, --y2, pixel16);
-		}
-		else if (bpp == 8)
-		{
-			gdi_SetPixel_8bpp(bmp, x1 - 1, ++y1, pixel8);
-			gdi_SetPixel_8bpp(bmp, x1 - 1, --y2, pixel8);
-		}
+		if (fill && lx < rx)
+			gdi_fill_span(hdc, _FillSpan, &bounds, lx, rx, y);
 	}
+
+	x1 = MAX(left, bounds.left);
+	x2 = MIN(right, bounds.right + 1);
+	y = MAX(top, bounds.top);
+
+	if (x1 < x2 && y < MIN(bottom, bounds.bottom + 1))
+		gdi_InvalidateRegion(hdc, x1, y, x2 - x1, MIN(bottom, bounds.bottom + 1) - y);
 }
 
 /**
- * Draw an ellipse
+ * Draw an ellipse, the outline uses the current pen and the interior the current brush.
  * @param hdc device context
  * @param nLeftRect x1
  * @param nTopRect y1
@@ -160,7 +213,8 @@ static void Ellipse_Bresenham(HGDI_DC hdc, int x1, int y1, int x2, int y2)
  */
 int gdi_Ellipse(HGDI_DC hdc, int nLeftRect, int nTopRect, int nRightRect, int nBottomRect)
 {
-	Ellipse_Bresenham(hdc, nLeftRect, nTopRect, nRightRect, nBottomRect);
+	gdi_fill_ellipse(hdc, MIN(nLeftRect, nRightRect), MIN(nTopRect, nBottomRect),
+			MAX(nLeftRect, nRightRect), MAX(nTopRect, nBottomRect));
 	return 1;
 }
 
@@ -183,8 +237,184 @@ int gdi_FillRect(HGDI_DC hdc, HGDI_RECT rect, HGDI_BRUSH hbr)
 		return 0;
 }
 
+static int gdi_compare_edges(const void* a, const void* b)
+{
+	return ((GDI_EDGE*) a)->yTop - ((GDI_EDGE*) b)->yTop;
+}
+
 /**
- *
+ * Active edge table scanline fill of a set of closed polygons.
+ * Edges are sampled at pixel centers, so shared edges of adjacent
+ * polygons are drawn exactly once.
+ */
+
+static int gdi_fill_polygons(HGDI_DC hdc, GDI_POINT* lpPoints, int* lpPolyCounts, int nCount)
+{
+	int i, j, k;
+	int y, yEnd;
+	int winding;
+	int nEdges;
+	int nActive;
+	int nextEdge;
+	int x1 = 0;
+	int minX, minY;
+	int maxX, maxY;
+	GDI_RECT bounds;
+	GDI_EDGE* edge;
+	GDI_EDGE* edges;
+	GDI_EDGE** active;
+	GDI_POINT* polygon;
+	GDI_POINT *p1, *p2;
+	p_FillSpan _FillSpan = FillSpan_[IBPP(hdc->bitsPerPixel)];
+
+	if (_FillSpan == NULL || hdc->brush == NULL || hdc->brush->style == GDI_BS_NULL)
+		return 0;
+
+	if (!gdi_GetClipBox(hdc, &bounds))
+		return 1;
+
+	nEdges = 0;
+
+	for (i = 0; i < nCount; i++)
+		nEdges += lpPolyCounts[i];
+
+	if (nEdges < 1)
+		return 1;
+
+	edges = (GDI_EDGE*) xmalloc(sizeof(GDI_EDGE) * nEdges);
+	active = (GDI_EDGE**) xmalloc(sizeof(GDI_EDGE*) * nEdges);
+
+	nEdges = 0;
+	polygon = lpPoints;
+	minX = maxX = lpPoints[0].x;
+	minY = maxY = lpPoints[0].y;
+
+	for (i = 0; i < nCount; i++)
+	{
+		for (j = 0; j < lpPolyCounts[i]; j++)
+		{
+			p1 = &polygon[j];
+			p2 = &polygon[(j + 1) % lpPolyCounts[i]];
+
+			minX = MIN(minX, p1->x);
+			minY = MIN(minY, p1->y);
+			maxX = MAX(maxX, p1->x);
+			maxY = MAX(maxY, p1->y);
+
+			/* horizontal edges never cross a scanline center */
+			if (p1->y == p2->y)
+				continue;
+
+			edge = &edges[nEdges++];
+			edge->winding = (p1->y < p2->y) ? 1 : -1;
+
+			if (p1->y > p2->y)
+			{
+				p1 = p2;
+				p2 = &polygon[j];
+			}
+
+			edge->yTop = p1->y;
+			edge->yBottom = p2->y;
+			edge->dx = (((sint64) (p2->x - p1->x)) << 16) / (p2->y - p1->y);
+			edge->x = (((sint64) p1->x) << 16) + (edge->dx / 2);
+		}
+
+		polygon += lpPolyCounts[i];
+	}
+
+	qsort(edges, nEdges, sizeof(GDI_EDGE), gdi_compare_edges);
+
+	nActive = 0;
+	nextEdge = 0;
+	y = MAX(minY, bounds.top);
+	yEnd = MIN(maxY, bounds.bottom + 1);
+
+	while (y < yEnd && (nActive > 0 || nextEdge < nEdges))
+	{
+		if (nActive == 0 && edges[nextEdge].yTop > y)
+			y = edges[nextEdge].yTop;
+
+		if (y >= yEnd)
+			break;
+
+		/* add the edges starting above this scanline */
+		while (nextEdge < nEdges && edges[nextEdge].yTop <= y)
+		{
+			edge = &edges[nextEdge++];
+
+			if (edge->yBottom <= y)
+				continue;
+
+			edge->x += edge->dx * (y - edge->yTop);
+			active[nActive++] = edge;
+		}
+
+		/* drop finished edges, then keep the active list sorted by x */
+		for (i = 0, k = 0; i < nActive; i++)
+		{
+			if (active[i]->yBottom > y)
+				active[k++] = active[i];
+		}
+
+		nActive = k;
+
+		for (i = 1; i < nActive; i++)
+		{
+			edge = active[i];
+
+			for (j = i; j > 0 && active[j - 1]->x > edge->x; j--)
+				active[j] = active[j - 1];
+
+			active[j] = edge;
+		}
+
+		winding = 0;
+
+		for (i = 0; i < nActive; i++)
+		{
+			edge = active[i];
+
+			if (hdc->polyFillMode == GDI_WINDING)
+			{
+				if (winding == 0)
+					x1 = FIXED_TO_PIXEL(edge->x);
+
+				winding += edge->winding;
+
+				if (winding == 0)
+					gdi_fill_span(hdc, _FillSpan, &bounds, x1, FIXED_TO_PIXEL(edge->x), y);
+			}
+			else
+			{
+				if ((i & 1) == 0)
+					x1 = FIXED_TO_PIXEL(edge->x);
+				else
+					gdi_fill_span(hdc, _FillSpan, &bounds, x1, FIXED_TO_PIXEL(edge->x), y);
+			}
+
+			edge->x += edge->dx;
+		}
+
+		y++;
+	}
+
+	xfree(edges);
+	xfree(active);
+
+	minX = MAX(minX, bounds.left);
+	minY = MAX(minY, bounds.top);
+	maxX = MIN(maxX, bounds.right + 1);
+	maxY = MIN(maxY, bounds.bottom + 1);
+
+	if (minX < maxX && minY < maxY)
+		gdi_InvalidateRegion(hdc, minX, minY, maxX - minX, maxY - minY);
+
+	return 1;
+}
+
+/**
+ * Fill a closed polygon with the current brush and polygon fill mode.
  * @param hdc device context
  * @param lpPoints array of points
  * @param nCount number of points
@@ -192,11 +422,11 @@ int gdi_FillRect(HGDI_DC hdc, HGDI_RECT rect, HGDI_BRUSH hbr)
  */
 int gdi_Polygon(HGDI_DC hdc, GDI_POINT *lpPoints, int nCount)
 {
-	return 1;
+	return gdi_fill_polygons(hdc, lpPoints, &nCount, 1);
 }
 
 /**
- * Draw a series of closed polygons
+ * Fill a series of closed polygons with the current brush and polygon fill mode
  * @param hdc device context
  * @param lpPoints array of series of points
  * @param lpPolyCounts array of number of points in each series
@@ -205,7 +435,7 @@ int gdi_Polygon(HGDI_DC hdc, GDI_POINT *lpPoints, int nCount)
  */
 int gdi_PolyPolygon(HGDI_DC hdc, GDI_POINT *lpPoints, int *lpPolyCounts, int nCount)
 {
-	return 1;
+	return gdi_fill_polygons(hdc, lpPoints, lpPolyCounts, nCount);
 }
 
 /**
@@ -0,0 +1,97 @@
+/**
+ * FreeRDP: A Remote Desktop Protocol Client
+ * Arena Allocator
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <freerdp/utils/memory.h>
+
+#include <freerdp/utils/arena.h>
+
+#define ARENA_ALIGN(_size)	(((_size) + 15) & ~((size_t) 15))
+
+ARENA* arena_new(size_t size)
+{
+	ARENA* arena;
+
+	arena = xnew(ARENA);
+	arena->size = ARENA_ALIGN(size);
+	arena->buffer = (uint8*) xmalloc(arena->size);
+
+	return arena;
+}
+
+void arena_free(ARENA* arena)
+{
+	if (arena == NULL)
+		return;
+
+	arena_reset(arena);
+
+	xfree(arena->extra);
+	xfree(arena->buffer);
+	xfree(arena);
+}
+
+/**
+ * Allocate uninitialized memory, aligned for any type.
+ * The memory stays valid until the next arena_reset().
+ */
+
+void* arena_alloc(ARENA* arena, size_t size)
+{
+	void* ptr;
+
+	size = ARENA_ALIGN(size);
+	arena->used += size;
+
+	if (arena->offset + size <= arena->size)
+	{
+		ptr = &arena->buffer[arena->offset];
+		arena->offset += size;
+		return ptr;
+	}
+
+	if (arena->num_extra >= arena->max_extra)
+	{
+		arena->max_extra = (arena->max_extra > 0) ? arena->max_extra * 2 : 8;
+		arena->extra = (void**) xrealloc(arena->extra, sizeof(void*) * arena->max_extra);
+	}
+
+	ptr = xmalloc(size);
+	arena->extra[arena->num_extra++] = ptr;
+
+	return ptr;
+}
+
+void arena_reset(ARENA* arena)
+{
+	int i;
+
+	if (arena->num_extra > 0)
+	{
+		for (i = 0; i < arena->num_extra; i++)
+			xfree(arena->extra[i]);
+
+		arena->num_extra = 0;
+
+		/* the buffer is empty now, grow it to what this round needed */
+		xfree(arena->buffer);
+		arena->size = arena->used;
+		arena->buffer = (uint8*) xmalloc(arena->size);
+	}
+
+	arena->offset = 0;
+	arena->used = 0;
+}
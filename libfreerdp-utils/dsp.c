@@ -17,6 +17,7 @@
  * limitations under the License.
  */
 
+#include "config.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -24,49 +25,167 @@
 #include <freerdp/utils/memory.h>
 #include <freerdp/utils/dsp.h>
 
+#ifdef WITH_SSE2
+#include "dsp_sse2.h"
+#endif
+
+#ifndef DSP_INIT_SIMD
+#define DSP_INIT_SIMD(_context) do { } while (0)
+#endif
+
+/**
+ * Linear interpolation between the two input frames around each output
+ * frame, with a 14-bit weight so that the products fit the 16-bit
+ * multiply-add of the SIMD versions, which must give the same result.
+ */
+static void freerdp_dsp_resample_linear(const sint16* src, int channels,
+	sint16* dst, int rframes, uint64 phase, uint64 step)
+{
+	int i, j;
+	sint32 w;
+	const sint16* s;
+
+	for (i = 0; i < rframes; i++)
+	{
+		s = &src[(phase >> 32) * channels];
+		w = (sint32) ((phase >> 18) & 0x3FFF);
+
+		for (j = 0; j < channels; j++)
+			*dst++ = (sint16) ((s[j] * (16384 - w) + s[j + channels] * w) >> 14);
+
+		phase += step;
+	}
+}
+
+/**
+ * Converts the input to 16-bit samples with the output channel count,
+ * behind the last frame of the previous chunk. Mono is spread to all
+ * channels, downmixing to mono averages all channels, other channel
+ * count changes map the channels in order.
+ */
+static sint16* freerdp_dsp_mix(FREERDP_DSP_CONTEXT* context,
+	const uint8* src, int bytes_per_sample, uint32 schan, int sframes, uint32 rchan)
+{
+	int i;
+	uint32 j;
+	sint32 sum;
+	sint16* dst;
+	sint16 frame[DSP_MAX_CHANNELS];
+	uint32 size;
+
+	size = (sframes + 1) * rchan * sizeof(sint16);
+
+	if (size > context->mix_maxlength)
+	{
+		context->mix_maxlength = size + 1024;
+		context->mix_buffer = (sint16*) xrealloc(context->mix_buffer, context->mix_maxlength);
+	}
+
+	dst = context->mix_buffer;
+	memcpy(dst, context->resample_last, rchan * sizeof(sint16));
+	dst += rchan;
+
+	for (i = 0; i < sframes; i++)
+	{
+		for (j = 0; j < schan; j++)
+		{
+			if (bytes_per_sample == 1)
+				frame[j] = (sint16) (((sint8) *src++) << 8);
+			else
+			{
+				frame[j] = (sint16) (src[0] | (src[1] << 8));
+				src += 2;
+			}
+		}
+
+		if (rchan == schan)
+		{
+			for (j = 0; j < rchan; j++)
+				*dst++ = frame[j];
+		}
+		else if (rchan == 1)
+		{
+			for (sum = 0, j = 0; j < schan; j++)
+				sum += frame[j];
+			*dst++ = (sint16) (sum / (sint32) schan);
+		}
+		else
+		{
+			for (j = 0; j < rchan; j++)
+				*dst++ = frame[j % schan];
+		}
+	}
+
+	return context->mix_buffer;
+}
+
 static void freerdp_dsp_resample(FREERDP_DSP_CONTEXT* context,
 	const uint8* src, int bytes_per_sample,
 	uint32 schan, uint32 srate, int sframes,
 	uint32 rchan, uint32 rrate)
 {
-	uint8* dst;
-	uint8* p;
+	int i;
+	uint8* dst8;
+	sint16* dst;
+	sint16* mixed;
+	uint64 end;
 	int rframes;
 	int rsize;
-	int i, j;
-	int n1, n2;
-	int sbytes, rbytes;
 
-	sbytes = bytes_per_sample * schan;
-	rbytes = bytes_per_sample * rchan;
-	rframes = sframes * rrate / srate;
-	rsize = rbytes * rframes;
+	if (schan < 1 || rchan < 1 || srate < 1 || rrate < 1 || sframes < 1 ||
+		schan > DSP_MAX_CHANNELS || rchan > DSP_MAX_CHANNELS)
+	{
+		context->resampled_frames = 0;
+		context->resampled_size = 0;
+		return;
+	}
+
+	if (context->resample_srate != srate || context->resample_rrate != rrate ||
+		context->resample_schan != schan || context->resample_rchan != rchan)
+	{
+		context->resample_srate = srate;
+		context->resample_rrate = rrate;
+		context->resample_schan = schan;
+		context->resample_rchan = rchan;
+		context->resample_step = ((uint64) srate << 32) / rrate;
+
+		/* the first output frame is the first input frame */
+		context->resample_phase = (uint64) 1 << 32;
+	}
+
+	mixed = freerdp_dsp_mix(context, src, bytes_per_sample, schan, sframes, rchan);
+
+	/* input frame i is at i + 1 in the mixed buffer, interpolation needs the frame after */
+	end = (uint64) sframes << 32;
+	if (context->resample_phase < end)
+		rframes = (int) ((end - context->resample_phase + context->resample_step - 1) / context->resample_step);
+	else
+		rframes = 0;
+
+	rsize = rframes * rchan * sizeof(sint16);
 
 	if (rsize > (int) context->resampled_maxlength)
 	{
 		context->resampled_maxlength = rsize + 1024;
 		context->resampled_buffer = (uint8*) xrealloc(context->resampled_buffer, context->resampled_maxlength);
 	}
-	dst = context->resampled_buffer;
+	dst = (sint16*) context->resampled_buffer;
 
-	p = dst;
-	for (i = 0; i < rframes; i++)
+	context->resample_linear(mixed, rchan, dst, rframes, context->resample_phase, context->resample_step);
+
+	context->resample_phase += rframes * context->resample_step;
+	context->resample_phase -= end;
+	memcpy(context->resample_last, &mixed[sframes * rchan], rchan * sizeof(sint16));
+
+	if (bytes_per_sample == 1)
 	{
-		n1 = i * srate / rrate;
-		if (n1 >= sframes)
-			n1 = sframes - 1;
-		n2 = (n1 * rrate == i * srate || n1 == sframes - 1 ? n1 : n1 + 1);
-		for (j = 0; j < rbytes; j++)
-		{
-			/* Nearest Interpolation, probably the easiest, but works */
-			*p++ = (i * srate - n1 * rrate > n2 * rrate - i * srate ?
-				src[n2 * sbytes + (j % sbytes)] :
-				src[n1 * sbytes + (j % sbytes)]);
-		}
+		dst8 = context->resampled_buffer;
+		for (i = 0; i < rframes * (int) rchan; i++)
+			dst8[i] = (uint8) (dst[i] >> 8);
 	}
 
 	context->resampled_frames = rframes;
-	context->resampled_size = rsize;
+	context->resampled_size = rframes * rchan * bytes_per_sample;
 }
 
 /**
@@ -95,49 +214,216 @@ static const sint16 ima_step_size_table[] =
 	15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767 
 };
 
-static uint16 dsp_decode_ima_adpcm_sample(ADPCM* adpcm,
-	int channel, uint8 sample)
+/**
+ * The difference added to the last sample for every step index and nibble,
+ * so that decoding does not branch on the bits of the nibble. A row is
+ * (ss >> 3) plus (ss >> 2), (ss >> 1) and ss for nibble bits 0 to 2, bit 3
+ * negates, where ss is the entry of ima_step_size_table.
+ */
+static const sint32 ima_diff_table[89 * 16] =
+{
+	0, 1, 3, 4, 7, 8, 10, 11, 0, -1, -3, -4, -7, -8, -10, -11,
+	1, 3, 5, 7, 9, 11, 13, 15, -1, -3, -5, -7, -9, -11, -13, -15,
+	1, 3, 5, 7, 10, 12, 14, 16, -1, -3, -5, -7, -10, -12, -14, -16,
+	1, 3, 6, 8, 11, 13, 16, 18, -1, -3, -6, -8, -11, -13, -16, -18,
+	1, 3, 6, 8, 12, 14, 17, 19, -1, -3, -6, -8, -12, -14, -17, -19,
+	1, 4, 7, 10, 13, 16, 19, 22, -1, -4, -7, -10, -13, -16, -19, -22,
+	1, 4, 7, 10, 14, 17, 20, 23, -1, -4, -7, -10, -14, -17, -20, -23,
+	1, 4, 8, 11, 15, 18, 22, 25, -1, -4, -8, -11, -15, -18, -22, -25,
+	2, 6, 10, 14, 18, 22, 26, 30, -2, -6, -10, -14, -18, -22, -26, -30,
+	2, 6, 10, 14, 19, 23, 27, 31, -2, -6, -10, -14, -19, -23, -27, -31,
+	2, 6, 11, 15, 21, 25, 30, 34, -2, -6, -11, -15, -21, -25, -30, -34,
+	2, 7, 12, 17, 23, 28, 33, 38, -2, -7, -12, -17, -23, -28, -33, -38,
+	2, 7, 13, 18, 25, 30, 36, 41, -2, -7, -13, -18, -25, -30, -36, -41,
+	3, 9, 15, 21, 28, 34, 40, 46, -3, -9, -15, -21, -28, -34, -40, -46,
+	3, 10, 17, 24, 31, 38, 45, 52, -3, -10, -17, -24, -31, -38, -45, -52,
+	3, 10, 18, 25, 34, 41, 49, 56, -3, -10, -18, -25, -34, -41, -49, -56,
+	4, 12, 21, 29, 38, 46, 55, 63, -4, -12, -21, -29, -38, -46, -55, -63,
+	4, 13, 22, 31, 41, 50, 59, 68, -4, -13, -22, -31, -41, -50, -59, -68,
+	5, 15, 25, 35, 46, 56, 66, 76, -5, -15, -25, -35, -46, -56, -66, -76,
+	5, 16, 27, 38, 50, 61, 72, 83, -5, -16, -27, -38, -50, -61, -72, -83,
+	6, 18, 31, 43, 56, 68, 81, 93, -6, -18, -31, -43, -56, -68, -81, -93,
+	6, 19, 33, 46, 61, 74, 88, 101, -6, -19, -33, -46, -61, -74, -88, -101,
+	7, 22, 37, 52, 67, 82, 97, 112, -7, -22, -37, -52, -67, -82, -97, -112,
+	8, 24, 41, 57, 74, 90, 107, 123, -8, -24, -41, -57, -74, -90, -107, -123,
+	9, 27, 45, 63, 82, 100, 118, 136, -9, -27, -45, -63, -82, -100, -118, -136,
+	10, 30, 50, 70, 90, 110, 130, 150, -10, -30, -50, -70, -90, -110, -130, -150,
+	11, 33, 55, 77, 99, 121, 143, 165, -11, -33, -55, -77, -99, -121, -143, -165,
+	12, 36, 60, 84, 109, 133, 157, 181, -12, -36, -60, -84, -109, -133, -157, -181,
+	13, 39, 66, 92, 120, 146, 173, 199, -13, -39, -66, -92, -120, -146, -173, -199,
+	14, 43, 73, 102, 132, 161, 191, 220, -14, -43, -73, -102, -132, -161, -191, -220,
+	16, 48, 81, 113, 146, 178, 211, 243, -16, -48, -81, -113, -146, -178, -211, -243,
+	17, 52, 88, 123, 160, 195, 231, 266, -17, -52, -88, -123, -160, -195, -231, -266,
+	19, 58, 97, 136, 176, 215, 254, 293, -19, -58, -97, -136, -176, -215, -254, -293,
+	21, 64, 107, 150, 194, 237, 280, 323, -21, -64, -107, -150, -194, -237, -280, -323,
+	23, 70, 118, 165, 213, 260, 308, 355, -23, -70, -118, -165, -213, -260, -308, -355,
+	26, 78, 130, 182, 235, 287, 339, 391, -26, -78, -130, -182, -235, -287, -339, -391,
+	28, 85, 143, 200, 258, 315, 373, 430, -28, -85, -143, -200, -258, -315, -373, -430,
+	31, 94, 157, 220, 284, 347, 410, 473, -31, -94, -157, -220, -284, -347, -410, -473,
+	34, 103, 173, 242, 313, 382, 452, 521, -34, -103, -173, -242, -313, -382, -452, -521,
+	38, 114, 191, 267, 345, 421, 498, 574, -38, -114, -191, -267, -345, -421, -498, -574,
+	42, 126, 210, 294, 379, 463, 547, 631, -42, -126, -210, -294, -379, -463, -547, -631,
+	46, 138, 231, 323, 417, 509, 602, 694, -46, -138, -231, -323, -417, -509, -602, -694,
+	51, 153, 255, 357, 459, 561, 663, 765, -51, -153, -255, -357, -459, -561, -663, -765,
+	56, 168, 280, 392, 505, 617, 729, 841, -56, -168, -280, -392, -505, -617, -729, -841,
+	61, 184, 308, 431, 555, 678, 802, 925, -61, -184, -308, -431, -555, -678, -802, -925,
+	68, 204, 340, 476, 612, 748, 884, 1020, -68, -204, -340, -476, -612, -748, -884, -1020,
+	74, 223, 373, 522, 672, 821, 971, 1120, -74, -223, -373, -522, -672, -821, -971, -1120,
+	82, 246, 411, 575, 740, 904, 1069, 1233, -82, -246, -411, -575, -740, -904, -1069, -1233,
+	90, 271, 452, 633, 814, 995, 1176, 1357, -90, -271, -452, -633, -814, -995, -1176, -1357,
+	99, 298, 497, 696, 895, 1094, 1293, 1492, -99, -298, -497, -696, -895, -1094, -1293, -1492,
+	109, 328, 547, 766, 985, 1204, 1423, 1642, -109, -328, -547, -766, -985, -1204, -1423, -1642,
+	120, 360, 601, 841, 1083, 1323, 1564, 1804, -120, -360, -601, -841, -1083, -1323, -1564, -1804,
+	132, 397, 662, 927, 1192, 1457, 1722, 1987, -132, -397, -662, -927, -1192, -1457, -1722, -1987,
+	145, 436, 728, 1019, 1311, 1602, 1894, 2185, -145, -436, -728, -1019, -1311, -1602, -1894, -2185,
+	160, 480, 801, 1121, 1442, 1762, 2083, 2403, -160, -480, -801, -1121, -1442, -1762, -2083, -2403,
+	176, 528, 881, 1233, 1587, 1939, 2292, 2644, -176, -528, -881, -1233, -1587, -1939, -2292, -2644,
+	194, 582, 970, 1358, 1746, 2134, 2522, 2910, -194, -582, -970, -1358, -1746, -2134, -2522, -2910,
+	213, 639, 1066, 1492, 1920, 2346, 2773, 3199, -213, -639, -1066, -1492, -1920, -2346, -2773, -3199,
+	234, 703, 1173, 1642, 2112, 2581, 3051, 3520, -234, -703, -1173, -1642, -2112, -2581, -3051, -3520,
+	258, 774, 1291, 1807, 2324, 2840, 3357, 3873, -258, -774, -1291, -1807, -2324, -2840, -3357, -3873,
+	284, 852, 1420, 1988, 2556, 3124, 3692, 4260, -284, -852, -1420, -1988, -2556, -3124, -3692, -4260,
+	312, 936, 1561, 2185, 2811, 3435, 4060, 4684, -312, -936, -1561, -2185, -2811, -3435, -4060, -4684,
+	343, 1030, 1717, 2404, 3092, 3779, 4466, 5153, -343, -1030, -1717, -2404, -3092, -3779, -4466, -5153,
+	378, 1134, 1890, 2646, 3402, 4158, 4914, 5670, -378, -1134, -1890, -2646, -3402, -4158, -4914, -5670,
+	415, 1246, 2078, 2909, 3742, 4573, 5405, 6236, -415, -1246, -2078, -2909, -3742, -4573, -5405, -6236,
+	457, 1372, 2287, 3202, 4117, 5032, 5947, 6862, -457, -1372, -2287, -3202, -4117, -5032, -5947, -6862,
+	503, 1509, 2516, 3522, 4529, 5535, 6542, 7548, -503, -1509, -2516, -3522, -4529, -5535, -6542, -7548,
+	553, 1660, 2767, 3874, 4981, 6088, 7195, 8302, -553, -1660, -2767, -3874, -4981, -6088, -7195, -8302,
+	608, 1825, 3043, 4260, 5479, 6696, 7914, 9131, -608, -1825, -3043, -4260, -5479, -6696, -7914, -9131,
+	669, 2008, 3348, 4687, 6027, 7366, 8706, 10045, -669, -2008, -3348, -4687, -6027, -7366, -8706, -10045,
+	736, 2209, 3683, 5156, 6630, 8103, 9577, 11050, -736, -2209, -3683, -5156, -6630, -8103, -9577, -11050,
+	810, 2431, 4052, 5673, 7294, 8915, 10536, 12157, -810, -2431, -4052, -5673, -7294, -8915, -10536, -12157,
+	891, 2674, 4457, 6240, 8023, 9806, 11589, 13372, -891, -2674, -4457, -6240, -8023, -9806, -11589, -13372,
+	980, 2941, 4902, 6863, 8825, 10786, 12747, 14708, -980, -2941, -4902, -6863, -8825, -10786, -12747, -14708,
+	1078, 3235, 5393, 7550, 9708, 11865, 14023, 16180, -1078, -3235, -5393, -7550, -9708, -11865, -14023, -16180,
+	1186, 3559, 5932, 8305, 10679, 13052, 15425, 17798, -1186, -3559, -5932, -8305, -10679, -13052, -15425, -17798,
+	1305, 3915, 6526, 9136, 11747, 14357, 16968, 19578, -1305, -3915, -6526, -9136, -11747, -14357, -16968, -19578,
+	1435, 4306, 7178, 10049, 12922, 15793, 18665, 21536, -1435, -4306, -7178, -10049, -12922, -15793, -18665, -21536,
+	1579, 4737, 7896, 11054, 14214, 17372, 20531, 23689, -1579, -4737, -7896, -11054, -14214, -17372, -20531, -23689,
+	1737, 5211, 8686, 12160, 15636, 19110, 22585, 26059, -1737, -5211, -8686, -12160, -15636, -19110, -22585, -26059,
+	1911, 5733, 9555, 13377, 17200, 21022, 24844, 28666, -1911, -5733, -9555, -13377, -17200, -21022, -24844, -28666,
+	2102, 6306, 10511, 14715, 18920, 23124, 27329, 31533, -2102, -6306, -10511, -14715, -18920, -23124, -27329, -31533,
+	2312, 6937, 11562, 16187, 20812, 25437, 30062, 34687, -2312, -6937, -11562, -16187, -20812, -25437, -30062, -34687,
+	2543, 7630, 12718, 17805, 22893, 27980, 33068, 38155, -2543, -7630, -12718, -17805, -22893, -27980, -33068, -38155,
+	2798, 8394, 13990, 19586, 25183, 30779, 36375, 41971, -2798, -8394, -13990, -19586, -25183, -30779, -36375, -41971,
+	3077, 9232, 15388, 21543, 27700, 33855, 40011, 46166, -3077, -9232, -15388, -21543, -27700, -33855, -40011, -46166,
+	3385, 10156, 16928, 23699, 30471, 37242, 44014, 50785, -3385, -10156, -16928, -23699, -30471, -37242, -44014, -50785,
+	3724, 11172, 18621, 26069, 33518, 40966, 48415, 55863, -3724, -11172, -18621, -26069, -33518, -40966, -48415, -55863,
+	4095, 12286, 20478, 28669, 36862, 45053, 53245, 61436, -4095, -12286, -20478, -28669, -36862, -45053, -53245, -61436
+};
+
+/**
+ * The state of one channel is kept in locals while a block is processed.
+ * The channels of a block do not depend on each other, so stereo blocks
+ * run both chains in the same loop and the CPU can overlap them.
+ */
+struct _IMA_ADPCM_CHANNEL
 {
-	sint32 ss;
-	sint32 d;
+	sint32 sample;
+	sint32 step;
+};
+typedef struct _IMA_ADPCM_CHANNEL IMA_ADPCM_CHANNEL;
+
+static void dsp_load_ima_adpcm_channel(ADPCM* adpcm, int channel, IMA_ADPCM_CHANNEL* state)
+{
+	state->sample = adpcm->ima.last_sample[channel];
+	state->step = adpcm->ima.last_step[channel];
 
-	ss = ima_step_size_table[adpcm->ima.last_step[channel]];
-	d = (ss >> 3);
-	if (sample & 1)
-		d += (ss >> 2);
-	if (sample & 2)
-		d += (ss >> 1);
-	if (sample & 4)
-		d += ss;
-	if (sample & 8)
-		d = -d;
-	d += adpcm->ima.last_sample[channel];
+	if (state->step < 0)
+		state->step = 0;
+	else if (state->step > 88)
+		state->step = 88;
+}
+
+static void dsp_store_ima_adpcm_channel(ADPCM* adpcm, int channel, IMA_ADPCM_CHANNEL* state)
+{
+	adpcm->ima.last_sample[channel] = (sint16) state->sample;
+	adpcm->ima.last_step[channel] = (sint16) state->step;
+}
 
+static INLINE sint16 dsp_decode_ima_adpcm_sample(IMA_ADPCM_CHANNEL* channel, int nibble)
+{
+	sint32 d;
+	sint32 step;
+
+	d = channel->sample + ima_diff_table[(channel->step << 4) | nibble];
 	if (d < -32768)
 		d = -32768;
 	else if (d > 32767)
 		d = 32767;
+	channel->sample = d;
 
-	adpcm->ima.last_sample[channel] = (sint16) d;
+	step = channel->step + ima_step_index_table[nibble];
+	if (step < 0)
+		step = 0;
+	else if (step > 88)
+		step = 88;
+	channel->step = step;
 
-	adpcm->ima.last_step[channel] += ima_step_index_table[sample];
-	if (adpcm->ima.last_step[channel] < 0)
-		adpcm->ima.last_step[channel] = 0;
-	else if (adpcm->ima.last_step[channel] > 88)
-		adpcm->ima.last_step[channel] = 88;
+	return (sint16) d;
+}
 
-	return (uint16) d;
+/**
+ * Decodes the data following a block header. Stereo data comes in groups
+ * of 8 bytes, 4 bytes of the left channel followed by 4 of the right.
+ */
+static sint16* dsp_decode_ima_adpcm_data(ADPCM* adpcm,
+	const uint8* src, int size, int channels, sint16* dst)
+{
+	int i;
+	IMA_ADPCM_CHANNEL left;
+	IMA_ADPCM_CHANNEL right;
+
+	dsp_load_ima_adpcm_channel(adpcm, 0, &left);
+
+	if (channels > 1)
+	{
+		dsp_load_ima_adpcm_channel(adpcm, 1, &right);
+
+		for (; size >= 8; size -= 8)
+		{
+			for (i = 0; i < 4; i++)
+			{
+				dst[0] = dsp_decode_ima_adpcm_sample(&left, src[i] & 0x0f);
+				dst[1] = dsp_decode_ima_adpcm_sample(&right, src[i + 4] & 0x0f);
+				dst[2] = dsp_decode_ima_adpcm_sample(&left, src[i] >> 4);
+				dst[3] = dsp_decode_ima_adpcm_sample(&right, src[i + 4] >> 4);
+				dst += 4;
+			}
+			src += 8;
+		}
+
+		dsp_store_ima_adpcm_channel(adpcm, 1, &right);
+	}
+	else
+	{
+		for (i = 0; i < size; i++)
+		{
+			dst[0] = dsp_decode_ima_adpcm_sample(&left, src[i] & 0x0f);
+			dst[1] = dsp_decode_ima_adpcm_sample(&left, src[i] >> 4);
+			dst += 2;
+		}
+	}
+
+	dsp_store_ima_adpcm_channel(adpcm, 0, &left);
+
+	return dst;
+}
+
+static void dsp_read_ima_adpcm_header(ADPCM* adpcm, const uint8* src, int channel)
+{
+	adpcm->ima.last_sample[channel] = (sint16) (((uint16) src[0]) | (((uint16) src[1]) << 8));
+	adpcm->ima.last_step[channel] = (src[2] > 88 ? 88 : src[2]);
 }
 
 static void freerdp_dsp_decode_ima_adpcm(FREERDP_DSP_CONTEXT* context,
 	const uint8* src, int size, int channels, int block_size)
 {
-	uint8* dst;
-	uint8 sample;
-	uint16 decoded;
+	sint16* dst;
 	uint32 out_size;
-	int channel;
-	int i;
+	int header_size;
+	int length;
 
 	out_size = size * 4;
 	if (out_size > context->adpcm_maxlength)
@@ -145,209 +431,180 @@ static void freerdp_dsp_decode_ima_adpcm(FREERDP_DSP_CONTEXT* context,
 		context->adpcm_maxlength = out_size + 1024;
 		context->adpcm_buffer = xrealloc(context->adpcm_buffer, context->adpcm_maxlength);
 	}
-	dst = context->adpcm_buffer;
-	while (size > 0)
+	dst = (sint16*) context->adpcm_buffer;
+
+	header_size = (channels > 1 ? 8 : 4);
+	if (block_size <= header_size)
 	{
-		if (size % block_size == 0)
-		{
-			context->adpcm.ima.last_sample[0] = (sint16) (((uint16)(*src)) | (((uint16)(*(src + 1))) << 8));
-			context->adpcm.ima.last_step[0] = (sint16) (*(src + 2));
-			src += 4;
-			size -= 4;
-			out_size -= 16;
-			if (channels > 1)
-			{
-				context->adpcm.ima.last_sample[1] = (sint16) (((uint16)(*src)) | (((uint16)(*(src + 1))) << 8));
-				context->adpcm.ima.last_step[1] = (sint16) (*(src + 2));
-				src += 4;
-				size -= 4;
-				out_size -= 16;
-			}
-		}
+		context->adpcm_size = 0;
+		return;
+	}
 
+	/* data in front of the first whole block continues the previous block */
+	length = size % block_size;
+	dst = dsp_decode_ima_adpcm_data(&context->adpcm, src, length, channels, dst);
+	src += length;
+	size -= length;
+
+	for (; size > 0; size -= block_size)
+	{
+		dsp_read_ima_adpcm_header(&context->adpcm, src, 0);
 		if (channels > 1)
-		{
-			for (i = 0; i < 8; i++)
-			{
-				channel = (i < 4 ? 0 : 1);
-				sample = ((*src) & 0x0f);
-				decoded = dsp_decode_ima_adpcm_sample(&context->adpcm, channel, sample);
-				dst[((i & 3) << 3) + (channel << 1)] = (decoded & 0xff);
-				dst[((i & 3) << 3) + (channel << 1) + 1] = (decoded >> 8);
-				sample = ((*src) >> 4);
-				decoded = dsp_decode_ima_adpcm_sample(&context->adpcm, channel, sample);
-				dst[((i & 3) << 3) + (channel << 1) + 4] = (decoded & 0xff);
-				dst[((i & 3) << 3) + (channel << 1) + 5] = (decoded >> 8);
-				src++;
-			}
-			dst += 32;
-			size -= 8;
-		}
-		else
-		{
-			sample = ((*src) & 0x0f);
-			decoded = dsp_decode_ima_adpcm_sample(&context->adpcm, 0, sample);
-			*dst++ = (decoded & 0xff);
-			*dst++ = (decoded >> 8);
-			sample = ((*src) >> 4);
-			decoded = dsp_decode_ima_adpcm_sample(&context->adpcm, 0, sample);
-			*dst++ = (decoded & 0xff);
-			*dst++ = (decoded >> 8);
-			src++;
-			size--;
-		}
+			dsp_read_ima_adpcm_header(&context->adpcm, src + 4, 1);
+
+		dst = dsp_decode_ima_adpcm_data(&context->adpcm, src + header_size,
+			block_size - header_size, channels, dst);
+		src += block_size;
 	}
 
-	context->adpcm_size = dst - context->adpcm_buffer;
+	context->adpcm_size = (uint8*) dst - context->adpcm_buffer;
 }
 
-/**
- * 0     1     2     3
- * 2 0   6 4   10 8  14 12   <left>
- *
- * 4     5     6     7
- * 3 1   7 5   11 9  15 13   <right>
- */
-static const struct
-{
-	uint8 byte_num;
-	uint8 byte_shift;
-} ima_stereo_encode_map[] =
-{
-	{ 0, 0 },
-	{ 4, 0 },
-	{ 0, 4 },
-	{ 4, 4 },
-	{ 1, 0 },
-	{ 5, 0 },
-	{ 1, 4 },
-	{ 5, 4 },
-	{ 2, 0 },
-	{ 6, 0 },
-	{ 2, 4 },
-	{ 6, 4 },
-	{ 3, 0 },
-	{ 7, 0 },
-	{ 3, 4 },
-	{ 7, 4 }
-};
-
-static uint8 dsp_encode_ima_adpcm_sample(ADPCM* adpcm,
-	int channel, sint16 sample)
+static INLINE uint8 dsp_encode_ima_adpcm_sample(IMA_ADPCM_CHANNEL* channel, sint32 sample)
 {
 	sint32 e;
 	sint32 d;
 	sint32 ss;
+	sint32 bit;
+	sint32 sign;
 	uint8 enc;
 	sint32 diff;
+	sint32 step;
 
-	ss = ima_step_size_table[adpcm->ima.last_step[channel]];
-	d = e = sample - adpcm->ima.last_sample[channel];
+	/* the quantization is done with masks, its branches would be random */
+	ss = ima_step_size_table[channel->step];
+	d = sample - channel->sample;
+	sign = -(d < 0);
+	e = (d ^ sign) - sign;
 	diff = ss >> 3;
-	enc = 0;
-	if (e < 0)
-	{
-		enc = 8;
-		e = -e;
-	}
-	if (e >= ss)
-	{
-		enc |= 4;
-		e -= ss;
-	}
+	enc = sign & 8;
+
+	bit = -(e >= ss);
+	enc |= bit & 4;
+	e -= bit & ss;
 	ss >>= 1;
-	if (e >= ss)
-	{
-		enc |= 2;
-		e -= ss;
-	}
+	bit = -(e >= ss);
+	enc |= bit & 2;
+	e -= bit & ss;
 	ss >>= 1;
-	if (e >= ss)
-	{
-		enc |= 1;
-		e -= ss;
-	}
+	bit = -(e >= ss);
+	enc |= bit & 1;
+	e -= bit & ss;
 
-	if (d < 0)
-		diff = d + e - diff;
-	else
-		diff = d - e + diff;
+	/* d - e + diff for positive differences, d + e - diff for negative ones */
+	diff = d + (((diff - e) ^ sign) - sign);
 
-	diff += adpcm->ima.last_sample[channel];
+	diff += channel->sample;
 	if (diff < -32768)
 		diff = -32768;
 	else if (diff > 32767)
 		diff = 32767;
-	adpcm->ima.last_sample[channel] = (sint16) diff;
+	channel->sample = diff;
 
-	adpcm->ima.last_step[channel] += ima_step_index_table[enc];
-	if (adpcm->ima.last_step[channel] < 0)
-		adpcm->ima.last_step[channel] = 0;
-	else if (adpcm->ima.last_step[channel] > 88)
-		adpcm->ima.last_step[channel] = 88;
+	step = channel->step + ima_step_index_table[enc];
+	if (step < 0)
+		step = 0;
+	else if (step > 88)
+		step = 88;
+	channel->step = step;
 
 	return enc;
 }
 
+/**
+ * The last group of a packet may be short, the missing samples are
+ * encoded as silence.
+ */
+#define DSP_INPUT_SAMPLE(_src, _count, _index) ((_index) < (_count) ? (_src)[_index] : 0)
+
 static void freerdp_dsp_encode_ima_adpcm(FREERDP_DSP_CONTEXT* context,
 	const uint8* src, int size, int channels, int block_size)
 {
+	int i;
 	uint8* dst;
-	sint16 sample;
-	uint8 encoded;
+	int count;
+	int offset;
+	int header_size;
+	const sint16* in;
 	uint32 out_size;
-	int i;
+	IMA_ADPCM_CHANNEL left;
+	IMA_ADPCM_CHANNEL right;
+	uint8 l0, l1, r0, r1;
+
+	header_size = (channels > 1 ? 8 : 4);
+	if (block_size <= header_size)
+	{
+		context->adpcm_size = 0;
+		return;
+	}
 
-	out_size = size / 2;
+	in = (const sint16*) src;
+	count = size / 2;
+
+	out_size = count / 2 + 8 + (count / 2 / (block_size - header_size) + 2) * header_size;
 	if (out_size > context->adpcm_maxlength)
 	{
 		context->adpcm_maxlength = out_size + 1024;
 		context->adpcm_buffer = xrealloc(context->adpcm_buffer, context->adpcm_maxlength);
 	}
 	dst = context->adpcm_buffer;
-	while (size > 0)
+
+	dsp_load_ima_adpcm_channel(&context->adpcm, 0, &left);
+	dsp_load_ima_adpcm_channel(&context->adpcm, 1, &right);
+
+	/* stereo groups take 8 frames into 8 bytes, mono groups 2 samples into 1 byte */
+	offset = 0;
+	while (count > 0)
 	{
-		if ((dst - context->adpcm_buffer) % block_size == 0)
+		if (offset == 0)
 		{
-			*dst++ = context->adpcm.ima.last_sample[0] & 0xff;
-			*dst++ = (context->adpcm.ima.last_sample[0] >> 8) & 0xff;
-			*dst++ = (uint8) context->adpcm.ima.last_step[0];
+			*dst++ = left.sample & 0xff;
+			*dst++ = (left.sample >> 8) & 0xff;
+			*dst++ = (uint8) left.step;
 			*dst++ = 0;
 			if (channels > 1)
 			{
-				*dst++ = context->adpcm.ima.last_sample[1] & 0xff;
-				*dst++ = (context->adpcm.ima.last_sample[1] >> 8) & 0xff;
-				*dst++ = (uint8) context->adpcm.ima.last_step[1];
+				*dst++ = right.sample & 0xff;
+				*dst++ = (right.sample >> 8) & 0xff;
+				*dst++ = (uint8) right.step;
 				*dst++ = 0;
 			}
+			offset = header_size;
 		}
 
 		if (channels > 1)
 		{
-			memset(dst, 0, 8);
-			for (i = 0; i < 16; i++)
+			for (i = 0; i < 4; i++)
 			{
-				sample = (sint16) (((uint16)(*src)) | (((uint16)(*(src + 1))) << 8));
-				src += 2;
-				encoded = dsp_encode_ima_adpcm_sample(&context->adpcm, i % 2, sample);
-				dst[ima_stereo_encode_map[i].byte_num] |= encoded << ima_stereo_encode_map[i].byte_shift;
+				l0 = dsp_encode_ima_adpcm_sample(&left, DSP_INPUT_SAMPLE(in, count, 0));
+				r0 = dsp_encode_ima_adpcm_sample(&right, DSP_INPUT_SAMPLE(in, count, 1));
+				l1 = dsp_encode_ima_adpcm_sample(&left, DSP_INPUT_SAMPLE(in, count, 2));
+				r1 = dsp_encode_ima_adpcm_sample(&right, DSP_INPUT_SAMPLE(in, count, 3));
+				dst[i] = l0 | (l1 << 4);
+				dst[i + 4] = r0 | (r1 << 4);
+				in += 4;
+				count -= 4;
 			}
 			dst += 8;
-			size -= 32;
+			offset += 8;
 		}
 		else
 		{
-			sample = (sint16) (((uint16)(*src)) | (((uint16)(*(src + 1))) << 8));
-			src += 2;
-			encoded = dsp_encode_ima_adpcm_sample(&context->adpcm, 0, sample);
-			sample = (sint16) (((uint16)(*src)) | (((uint16)(*(src + 1))) << 8));
-			src += 2;
-			encoded |= dsp_encode_ima_adpcm_sample(&context->adpcm, 0, sample) << 4;
-			*dst++ = encoded;
-			size -= 4;
+			l0 = dsp_encode_ima_adpcm_sample(&left, DSP_INPUT_SAMPLE(in, count, 0));
+			l1 = dsp_encode_ima_adpcm_sample(&left, DSP_INPUT_SAMPLE(in, count, 1));
+			*dst++ = l0 | (l1 << 4);
+			in += 2;
+			count -= 2;
+			offset++;
 		}
+
+		if (offset >= block_size)
+			offset -= block_size;
 	}
-	
+
+	dsp_store_ima_adpcm_channel(&context->adpcm, 0, &left);
+	dsp_store_ima_adpcm_channel(&context->adpcm, 1, &right);
+
 	context->adpcm_size = dst - context->adpcm_buffer;
 }
 
@@ -373,33 +630,112 @@ static const sint16 ms_adpcm_coeff2_table[] =
 	0, -256, 0, 64, 0, -208, -232
 };
 
-static sint16 freerdp_dsp_decode_ms_adpcm_sample(ADPCM* adpcm, uint8 sample, int channel)
+/**
+ * The predictor coefficients do not change within a block, they are
+ * looked up once with the block header.
+ */
+struct _MS_ADPCM_CHANNEL
+{
+	sint32 coeff1;
+	sint32 coeff2;
+	sint32 delta;
+	sint32 sample1;
+	sint32 sample2;
+};
+typedef struct _MS_ADPCM_CHANNEL MS_ADPCM_CHANNEL;
+
+static void dsp_load_ms_adpcm_channel(ADPCM* adpcm, int channel, MS_ADPCM_CHANNEL* state)
+{
+	/* a broken header must not index past the coefficient tables */
+	if (adpcm->ms.predictor[channel] > 6)
+		adpcm->ms.predictor[channel] = 0;
+
+	state->coeff1 = ms_adpcm_coeff1_table[adpcm->ms.predictor[channel]];
+	state->coeff2 = ms_adpcm_coeff2_table[adpcm->ms.predictor[channel]];
+	state->delta = adpcm->ms.delta[channel];
+	state->sample1 = adpcm->ms.sample1[channel];
+	state->sample2 = adpcm->ms.sample2[channel];
+}
+
+static void dsp_store_ms_adpcm_channel(ADPCM* adpcm, int channel, MS_ADPCM_CHANNEL* state)
 {
-	sint8 nibble;
+	adpcm->ms.delta[channel] = state->delta;
+	adpcm->ms.sample1[channel] = state->sample1;
+	adpcm->ms.sample2[channel] = state->sample2;
+}
+
+static INLINE sint16 dsp_decode_ms_adpcm_sample(MS_ADPCM_CHANNEL* channel, int sample)
+{
+	sint32 nibble;
 	sint32 presample;
 
-	nibble = (sample & 0x08 ? (sint8)sample - 16 : sample);
-	presample = ((adpcm->ms.sample1[channel] * ms_adpcm_coeff1_table[adpcm->ms.predictor[channel]]) +
-		(adpcm->ms.sample2[channel] * ms_adpcm_coeff2_table[adpcm->ms.predictor[channel]])) / 256;
-	presample += nibble * adpcm->ms.delta[channel];
+	nibble = (sample & 0x08 ? sample - 16 : sample);
+	presample = ((channel->sample1 * channel->coeff1) + (channel->sample2 * channel->coeff2)) / 256;
+	presample += nibble * channel->delta;
 	if (presample > 32767)
 		presample = 32767;
 	else if (presample < -32768)
 		presample = -32768;
-	adpcm->ms.sample2[channel] = adpcm->ms.sample1[channel];
-	adpcm->ms.sample1[channel] = presample;
-	adpcm->ms.delta[channel] = adpcm->ms.delta[channel] * ms_adpcm_adaptation_table[sample] / 256;
-	if (adpcm->ms.delta[channel] < 16)
-		adpcm->ms.delta[channel] = 16;
+	channel->sample2 = channel->sample1;
+	channel->sample1 = presample;
+	channel->delta = channel->delta * ms_adpcm_adaptation_table[sample] / 256;
+	if (channel->delta < 16)
+		channel->delta = 16;
 	return (sint16) presample;
 }
 
+/**
+ * Decodes the data following a block header. Each byte holds the high
+ * nibble of the first channel and the low nibble of the second one, or
+ * two samples of the same channel in mono.
+ */
+static sint16* dsp_decode_ms_adpcm_data(ADPCM* adpcm,
+	const uint8* src, int size, int channels, sint16* dst)
+{
+	int i;
+	MS_ADPCM_CHANNEL left;
+	MS_ADPCM_CHANNEL right;
+
+	dsp_load_ms_adpcm_channel(adpcm, 0, &left);
+
+	if (channels > 1)
+	{
+		dsp_load_ms_adpcm_channel(adpcm, 1, &right);
+
+		for (i = 0; i < size; i++)
+		{
+			dst[0] = dsp_decode_ms_adpcm_sample(&left, src[i] >> 4);
+			dst[1] = dsp_decode_ms_adpcm_sample(&right, src[i] & 0x0f);
+			dst += 2;
+		}
+
+		dsp_store_ms_adpcm_channel(adpcm, 1, &right);
+	}
+	else
+	{
+		for (i = 0; i < size; i++)
+		{
+			dst[0] = dsp_decode_ms_adpcm_sample(&left, src[i] >> 4);
+			dst[1] = dsp_decode_ms_adpcm_sample(&left, src[i] & 0x0f);
+			dst += 2;
+		}
+	}
+
+	dsp_store_ms_adpcm_channel(adpcm, 0, &left);
+
+	return dst;
+}
+
+#define DSP_READ_SINT16(_p) ((sint16) (((uint16) (_p)[0]) | (((uint16) (_p)[1]) << 8)))
+#define DSP_WRITE_SINT16(_p, _v) do { (_p)[0] = (uint8) ((_v) & 0xff); (_p)[1] = (uint8) (((_v) >> 8) & 0xff); } while (0)
+
 static void freerdp_dsp_decode_ms_adpcm(FREERDP_DSP_CONTEXT* context,
 	const uint8* src, int size, int channels, int block_size)
 {
-	uint8* dst;
-	uint8 sample;
+	sint16* dst;
 	uint32 out_size;
+	int header_size;
+	int length;
 
 	out_size = size * 4;
 	if (out_size > context->adpcm_maxlength)
@@ -407,121 +743,110 @@ static void freerdp_dsp_decode_ms_adpcm(FREERDP_DSP_CONTEXT* context,
 		context->adpcm_maxlength = out_size + 1024;
 		context->adpcm_buffer = xrealloc(context->adpcm_buffer, context->adpcm_maxlength);
 	}
-	dst = context->adpcm_buffer;
-	while (size > 0)
+	dst = (sint16*) context->adpcm_buffer;
+
+	header_size = (channels > 1 ? 14 : 7);
+	if (block_size <= header_size)
 	{
-		if (size % block_size == 0)
-		{
-			if (channels > 1)
-			{
-				context->adpcm.ms.predictor[0] = *src++;
-				context->adpcm.ms.predictor[1] = *src++;
-				context->adpcm.ms.delta[0] = *((sint16*)src);
-				src += 2;
-				context->adpcm.ms.delta[1] = *((sint16*)src);
-				src += 2;
-				context->adpcm.ms.sample1[0] = *((sint16*)src);
-				src += 2;
-				context->adpcm.ms.sample1[1] = *((sint16*)src);
-				src += 2;
-				context->adpcm.ms.sample2[0] = *((sint16*)src);
-				src += 2;
-				context->adpcm.ms.sample2[1] = *((sint16*)src);
-				src += 2;
-				size -= 14;
-
-				*((sint16*)dst) = context->adpcm.ms.sample2[0];
-				dst += 2;
-				*((sint16*)dst) = context->adpcm.ms.sample2[1];
-				dst += 2;
-				*((sint16*)dst) = context->adpcm.ms.sample1[0];
-				dst += 2;
-				*((sint16*)dst) = context->adpcm.ms.sample1[1];
-				dst += 2;
-			}
-			else
-			{
-				context->adpcm.ms.predictor[0] = *src++;
-				context->adpcm.ms.delta[0] = *((sint16*)src);
-				src += 2;
-				context->adpcm.ms.sample1[0] = *((sint16*)src);
-				src += 2;
-				context->adpcm.ms.sample2[0] = *((sint16*)src);
-				src += 2;
-				size -= 7;
+		context->adpcm_size = 0;
+		return;
+	}
 
-				*((sint16*)dst) = context->adpcm.ms.sample2[0];
-				dst += 2;
-				*((sint16*)dst) = context->adpcm.ms.sample1[0];
-				dst += 2;
-			}
-		}
+	/* data in front of the first whole block continues the previous block */
+	length = size % block_size;
+	dst = dsp_decode_ms_adpcm_data(&context->adpcm, src, length, channels, dst);
+	src += length;
+	size -= length;
 
+	for (; size > 0; size -= block_size)
+	{
 		if (channels > 1)
 		{
-			sample = *src++;
-			size--;
-			*((sint16*)dst) = freerdp_dsp_decode_ms_adpcm_sample(&context->adpcm, sample >> 4, 0);
-			dst += 2;
-			*((sint16*)dst) = freerdp_dsp_decode_ms_adpcm_sample(&context->adpcm, sample & 0x0F, 1);
-			dst += 2;
-
-			sample = *src++;
-			size--;
-			*((sint16*)dst) = freerdp_dsp_decode_ms_adpcm_sample(&context->adpcm, sample >> 4, 0);
-			dst += 2;
-			*((sint16*)dst) = freerdp_dsp_decode_ms_adpcm_sample(&context->adpcm, sample & 0x0F, 1);
-			dst += 2;
+			context->adpcm.ms.predictor[0] = src[0];
+			context->adpcm.ms.predictor[1] = src[1];
+			context->adpcm.ms.delta[0] = DSP_READ_SINT16(src + 2);
+			context->adpcm.ms.delta[1] = DSP_READ_SINT16(src + 4);
+			context->adpcm.ms.sample1[0] = DSP_READ_SINT16(src + 6);
+			context->adpcm.ms.sample1[1] = DSP_READ_SINT16(src + 8);
+			context->adpcm.ms.sample2[0] = DSP_READ_SINT16(src + 10);
+			context->adpcm.ms.sample2[1] = DSP_READ_SINT16(src + 12);
+
+			dst[0] = context->adpcm.ms.sample2[0];
+			dst[1] = context->adpcm.ms.sample2[1];
+			dst[2] = context->adpcm.ms.sample1[0];
+			dst[3] = context->adpcm.ms.sample1[1];
+			dst += 4;
 		}
 		else
 		{
-			sample = *src++;
-			size--;
-			*((sint16*)dst) = freerdp_dsp_decode_ms_adpcm_sample(&context->adpcm, sample >> 4, 0);
-			dst += 2;
-			*((sint16*)dst) = freerdp_dsp_decode_ms_adpcm_sample(&context->adpcm, sample & 0x0F, 0);
+			context->adpcm.ms.predictor[0] = src[0];
+			context->adpcm.ms.delta[0] = DSP_READ_SINT16(src + 1);
+			context->adpcm.ms.sample1[0] = DSP_READ_SINT16(src + 3);
+			context->adpcm.ms.sample2[0] = DSP_READ_SINT16(src + 5);
+
+			dst[0] = context->adpcm.ms.sample2[0];
+			dst[1] = context->adpcm.ms.sample1[0];
 			dst += 2;
 		}
+
+		dst = dsp_decode_ms_adpcm_data(&context->adpcm, src + header_size,
+			block_size - header_size, channels, dst);
+		src += block_size;
 	}
 
-	context->adpcm_size = dst - context->adpcm_buffer;
+	context->adpcm_size = (uint8*) dst - context->adpcm_buffer;
 }
 
-static uint8 freerdp_dsp_encode_ms_adpcm_sample(ADPCM* adpcm, sint32 sample, int channel)
+static INLINE uint8 dsp_encode_ms_adpcm_sample(MS_ADPCM_CHANNEL* channel, sint32 sample)
 {
 	sint32 presample;
 	sint32 errordelta;
 
-	presample = ((adpcm->ms.sample1[channel] * ms_adpcm_coeff1_table[adpcm->ms.predictor[channel]]) +
-		(adpcm->ms.sample2[channel] * ms_adpcm_coeff2_table[adpcm->ms.predictor[channel]])) / 256;
-	errordelta = (sample - presample) / adpcm->ms.delta[channel];
-	if ((sample - presample) % adpcm->ms.delta[channel] > adpcm->ms.delta[channel] / 2)
+	presample = ((channel->sample1 * channel->coeff1) + (channel->sample2 * channel->coeff2)) / 256;
+	errordelta = (sample - presample) / channel->delta;
+	if ((sample - presample) % channel->delta > channel->delta / 2)
 		errordelta++;
 	if (errordelta > 7)
 		errordelta = 7;
 	else if (errordelta < -8)
 		errordelta = -8;
-	presample += adpcm->ms.delta[channel] * errordelta;
+	presample += channel->delta * errordelta;
 	if (presample > 32767)
 		presample = 32767;
 	else if (presample < -32768)
 		presample = -32768;
-	adpcm->ms.sample2[channel] = adpcm->ms.sample1[channel];
-	adpcm->ms.sample1[channel] = presample;
-	adpcm->ms.delta[channel] = adpcm->ms.delta[channel] * ms_adpcm_adaptation_table[(((uint8)errordelta) & 0x0F)] / 256;
-	if (adpcm->ms.delta[channel] < 16)
-		adpcm->ms.delta[channel] = 16;
-	return ((uint8)errordelta) & 0x0F;
+	channel->sample2 = channel->sample1;
+	channel->sample1 = presample;
+	channel->delta = channel->delta * ms_adpcm_adaptation_table[(((uint8) errordelta) & 0x0F)] / 256;
+	if (channel->delta < 16)
+		channel->delta = 16;
+	return ((uint8) errordelta) & 0x0F;
 }
 
 static void freerdp_dsp_encode_ms_adpcm(FREERDP_DSP_CONTEXT* context,
 	const uint8* src, int size, int channels, int block_size)
 {
 	uint8* dst;
-	sint32 sample;
+	int count;
+	int offset;
+	int header_size;
+	const sint16* in;
 	uint32 out_size;
+	MS_ADPCM_CHANNEL left;
+	MS_ADPCM_CHANNEL right;
+
+	header_size = (channels > 1 ? 14 : 7);
+	if (block_size <= header_size)
+	{
+		context->adpcm_size = 0;
+		return;
+	}
 
-	out_size = size / 2;
+	in = (const sint16*) src;
+	count = size / 2;
+
+	/* a header takes 2 frames, every other byte 2 samples */
+	out_size = (count + 1) / 2 + (count / 2 / (block_size - header_size) + 2) * header_size;
 	if (out_size > context->adpcm_maxlength)
 	{
 		context->adpcm_maxlength = out_size + 1024;
@@ -534,55 +859,72 @@ static void freerdp_dsp_encode_ms_adpcm(FREERDP_DSP_CONTEXT* context,
 	if (context->adpcm.ms.delta[1] < 16)
 		context->adpcm.ms.delta[1] = 16;
 
-	while (size > 0)
+	dsp_load_ms_adpcm_channel(&context->adpcm, 0, &left);
+	dsp_load_ms_adpcm_channel(&context->adpcm, 1, &right);
+
+	offset = 0;
+	while (count > 0)
 	{
-		if ((dst - context->adpcm_buffer) % block_size == 0)
+		if (offset == 0)
 		{
 			if (channels > 1)
 			{
 				*dst++ = context->adpcm.ms.predictor[0];
 				*dst++ = context->adpcm.ms.predictor[1];
-				*dst++ = (uint8) (context->adpcm.ms.delta[0] & 0xff);
-				*dst++ = (uint8) ((context->adpcm.ms.delta[0] >> 8) & 0xff);
-				*dst++ = (uint8) (context->adpcm.ms.delta[1] & 0xff);
-				*dst++ = (uint8) ((context->adpcm.ms.delta[1] >> 8) & 0xff);
-				context->adpcm.ms.sample1[0] = *((sint16*) (src + 4));
-				context->adpcm.ms.sample1[1] = *((sint16*) (src + 6));
-				context->adpcm.ms.sample2[0] = *((sint16*) (src + 0));
-				context->adpcm.ms.sample2[1] = *((sint16*) (src + 2));
-				*((sint16*) (dst + 0)) = (sint16) context->adpcm.ms.sample1[0];
-				*((sint16*) (dst + 2)) = (sint16) context->adpcm.ms.sample1[1];
-				*((sint16*) (dst + 4)) = (sint16) context->adpcm.ms.sample2[0];
-				*((sint16*) (dst + 6)) = (sint16) context->adpcm.ms.sample2[1];
+				*dst++ = (uint8) (left.delta & 0xff);
+				*dst++ = (uint8) ((left.delta >> 8) & 0xff);
+				*dst++ = (uint8) (right.delta & 0xff);
+				*dst++ = (uint8) ((right.delta >> 8) & 0xff);
+				left.sample1 = DSP_INPUT_SAMPLE(in, count, 2);
+				right.sample1 = DSP_INPUT_SAMPLE(in, count, 3);
+				left.sample2 = DSP_INPUT_SAMPLE(in, count, 0);
+				right.sample2 = DSP_INPUT_SAMPLE(in, count, 1);
+				DSP_WRITE_SINT16(dst + 0, left.sample1);
+				DSP_WRITE_SINT16(dst + 2, right.sample1);
+				DSP_WRITE_SINT16(dst + 4, left.sample2);
+				DSP_WRITE_SINT16(dst + 6, right.sample2);
 				dst += 8;
-				src += 8;
-				size -= 8;
+				in += 4;
+				count -= 4;
 			}
 			else
 			{
 				*dst++ = context->adpcm.ms.predictor[0];
-				*dst++ = (uint8) (context->adpcm.ms.delta[0] & 0xff);
-				*dst++ = (uint8) ((context->adpcm.ms.delta[0] >> 8) & 0xff);
-				context->adpcm.ms.sample1[0] = *((sint16*) (src + 2));
-				context->adpcm.ms.sample2[0] = *((sint16*) (src + 0));
-				*((sint16*) (dst + 0)) = (sint16) context->adpcm.ms.sample1[0];
-				*((sint16*) (dst + 2)) = (sint16) context->adpcm.ms.sample2[0];
+				*dst++ = (uint8) (left.delta & 0xff);
+				*dst++ = (uint8) ((left.delta >> 8) & 0xff);
+				left.sample1 = DSP_INPUT_SAMPLE(in, count, 1);
+				left.sample2 = DSP_INPUT_SAMPLE(in, count, 0);
+				DSP_WRITE_SINT16(dst + 0, left.sample1);
+				DSP_WRITE_SINT16(dst + 2, left.sample2);
 				dst += 4;
-				src += 4;
-				size -= 4;
+				in += 2;
+				count -= 2;
 			}
+
+			offset = header_size;
 		}
 
-		sample = *((sint16*) src);
-		src += 2;
-		*dst = freerdp_dsp_encode_ms_adpcm_sample(&context->adpcm, sample, 0) << 4;
-		sample = *((sint16*) src);
-		src += 2;
-		*dst += freerdp_dsp_encode_ms_adpcm_sample(&context->adpcm, sample, channels > 1 ? 1 : 0);
+		if (channels > 1)
+		{
+			*dst = dsp_encode_ms_adpcm_sample(&left, DSP_INPUT_SAMPLE(in, count, 0)) << 4;
+			*dst += dsp_encode_ms_adpcm_sample(&right, DSP_INPUT_SAMPLE(in, count, 1));
+		}
+		else
+		{
+			*dst = dsp_encode_ms_adpcm_sample(&left, DSP_INPUT_SAMPLE(in, count, 0)) << 4;
+			*dst += dsp_encode_ms_adpcm_sample(&left, DSP_INPUT_SAMPLE(in, count, 1));
+		}
 		dst++;
-		size -= 4;
+		in += 2;
+		count -= 2;
+
+		if (++offset >= block_size)
+			offset -= block_size;
 	}
-	
+
+	dsp_store_ms_adpcm_channel(&context->adpcm, 0, &left);
+	dsp_store_ms_adpcm_channel(&context->adpcm, 1, &right);
+
 	context->adpcm_size = dst - context->adpcm_buffer;
 }
 
@@ -593,11 +935,14 @@ FREERDP_DSP_CONTEXT* freerdp_dsp_context_new(void)
 	context = xnew(FREERDP_DSP_CONTEXT);
 
 	context->resample = freerdp_dsp_resample;
+	context->resample_linear = freerdp_dsp_resample_linear;
 	context->decode_ima_adpcm = freerdp_dsp_decode_ima_adpcm;
 	context->encode_ima_adpcm = freerdp_dsp_encode_ima_adpcm;
 	context->decode_ms_adpcm = freerdp_dsp_decode_ms_adpcm;
 	context->encode_ms_adpcm = freerdp_dsp_encode_ms_adpcm;
 
+	DSP_INIT_SIMD(context);
+
 	return context;
 }
 
@@ -609,6 +954,7 @@ void freerdp_dsp_context_free(FREERDP_DSP_CONTEXT* context)
 			xfree(context->resampled_buffer);
 		if (context->adpcm_buffer)
 			xfree(context->adpcm_buffer);
+		xfree(context->mix_buffer);
 		xfree(context);
 	}
 }
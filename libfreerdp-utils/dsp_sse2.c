@@ -0,0 +1,134 @@
+/**
+ * FreeRDP: A Remote Desktop Protocol client.
+ * Digital Sound Processing - SSE2 Optimizations
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <xmmintrin.h>
+#include <emmintrin.h>
+#include <freerdp/types.h>
+
+#include "dsp_sse2.h"
+
+/* two adjacent samples as one 32-bit lane */
+static INLINE sint32 dsp_load_pair(const sint16* p)
+{
+	sint32 v;
+
+	memcpy(&v, p, sizeof(v));
+
+	return v;
+}
+
+/* the 16-bit weights of both frames as one 32-bit lane */
+#define DSP_WEIGHTS(_phase) \
+	((sint32) (16384 - (((_phase) >> 18) & 0x3FFF)) | (sint32) ((((_phase) >> 18) & 0x3FFF) << 16))
+
+static void dsp_resample_linear_tail(const sint16* src, int channels,
+	sint16* dst, int rframes, uint64 phase, uint64 step)
+{
+	int i, j;
+	sint32 w;
+	const sint16* s;
+
+	for (i = 0; i < rframes; i++)
+	{
+		s = &src[(phase >> 32) * channels];
+		w = (sint32) ((phase >> 18) & 0x3FFF);
+
+		for (j = 0; j < channels; j++)
+			*dst++ = (sint16) ((s[j] * (16384 - w) + s[j + channels] * w) >> 14);
+
+		phase += step;
+	}
+}
+
+static void dsp_resample_linear_mono_sse2(const sint16* src,
+	sint16* dst, int rframes, uint64 phase, uint64 step)
+{
+	int i, k;
+	sint32 pairs[8];
+	sint32 weights[8];
+	__m128i lo, hi;
+
+	for (i = 0; i + 8 <= rframes; i += 8)
+	{
+		for (k = 0; k < 8; k++)
+		{
+			pairs[k] = dsp_load_pair(&src[phase >> 32]);
+			weights[k] = DSP_WEIGHTS(phase);
+			phase += step;
+		}
+
+		lo = _mm_madd_epi16(_mm_loadu_si128((__m128i*) &pairs[0]), _mm_loadu_si128((__m128i*) &weights[0]));
+		hi = _mm_madd_epi16(_mm_loadu_si128((__m128i*) &pairs[4]), _mm_loadu_si128((__m128i*) &weights[4]));
+		lo = _mm_srai_epi32(lo, 14);
+		hi = _mm_srai_epi32(hi, 14);
+		_mm_storeu_si128((__m128i*) &dst[i], _mm_packs_epi32(lo, hi));
+	}
+
+	dsp_resample_linear_tail(src, 1, &dst[i], rframes - i, phase, step);
+}
+
+static void dsp_resample_linear_stereo_sse2(const sint16* src,
+	sint16* dst, int rframes, uint64 phase, uint64 step)
+{
+	int i, k;
+	const sint16* s;
+	sint32 a[4], b[4];
+	sint32 weights[8];
+	__m128i va, vb, lo, hi;
+
+	for (i = 0; i + 4 <= rframes; i += 4)
+	{
+		for (k = 0; k < 4; k++)
+		{
+			s = &src[(phase >> 32) * 2];
+			a[k] = dsp_load_pair(&s[0]);
+			b[k] = dsp_load_pair(&s[2]);
+			weights[2 * k] = weights[2 * k + 1] = DSP_WEIGHTS(phase);
+			phase += step;
+		}
+
+		/* interleave the left and right samples of both frames */
+		va = _mm_loadu_si128((__m128i*) a);
+		vb = _mm_loadu_si128((__m128i*) b);
+		lo = _mm_madd_epi16(_mm_unpacklo_epi16(va, vb), _mm_loadu_si128((__m128i*) &weights[0]));
+		hi = _mm_madd_epi16(_mm_unpackhi_epi16(va, vb), _mm_loadu_si128((__m128i*) &weights[4]));
+		lo = _mm_srai_epi32(lo, 14);
+		hi = _mm_srai_epi32(hi, 14);
+		_mm_storeu_si128((__m128i*) &dst[i * 2], _mm_packs_epi32(lo, hi));
+	}
+
+	dsp_resample_linear_tail(src, 2, &dst[i * 2], rframes - i, phase, step);
+}
+
+static void dsp_resample_linear_sse2(const sint16* src, int channels,
+	sint16* dst, int rframes, uint64 phase, uint64 step)
+{
+	if (channels == 1)
+		dsp_resample_linear_mono_sse2(src, dst, rframes, phase, step);
+	else if (channels == 2)
+		dsp_resample_linear_stereo_sse2(src, dst, rframes, phase, step);
+	else
+		dsp_resample_linear_tail(src, channels, dst, rframes, phase, step);
+}
+
+void freerdp_dsp_init_sse2(FREERDP_DSP_CONTEXT* context)
+{
+	context->resample_linear = dsp_resample_linear_sse2;
+}
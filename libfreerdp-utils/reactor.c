@@ -0,0 +1,490 @@
+/**
+ * FreeRDP: A Remote Desktop Protocol Client
+ * Event Loop Reactor
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <freerdp/utils/memory.h>
+#include <freerdp/utils/mutex.h>
+#include <freerdp/utils/reactor.h>
+
+#ifdef __linux__
+
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+
+#define REACTOR_MAX_EVENTS	64
+
+struct _freerdp_event_source
+{
+	freerdp_event_loop* loop;
+	int fd;
+	boolean timer;
+	boolean removed;
+	freerdp_event_callback callback;
+	void* arg;
+	freerdp_event_source* next;
+};
+
+struct _freerdp_event_loop
+{
+	freerdp_reactor* reactor;
+	int epfd;
+	int wakefd;
+	pthread_t thread;
+	boolean running;
+	int num_sources;
+	freerdp_event_source* removed;
+};
+
+struct _freerdp_reactor
+{
+	freerdp_mutex mutex;
+	boolean stopped;
+	int num_loops;
+	freerdp_event_loop* loops;
+};
+
+static uint32 freerdp_event_to_epoll(uint32 events)
+{
+	uint32 epoll_events = 0;
+
+	if (events & (FREERDP_EVENT_READ | FREERDP_EVENT_TIMER))
+		epoll_events |= EPOLLIN;
+
+	if (events & FREERDP_EVENT_WRITE)
+		epoll_events |= EPOLLOUT;
+
+	return epoll_events;
+}
+
+static void freerdp_event_loop_collect(freerdp_event_loop* loop)
+{
+	freerdp_event_source* source;
+	freerdp_event_source* next;
+	freerdp_reactor* reactor = loop->reactor;
+
+	freerdp_mutex_lock(reactor->mutex);
+	source = loop->removed;
+	loop->removed = NULL;
+	freerdp_mutex_unlock(reactor->mutex);
+
+	while (source != NULL)
+	{
+		next = source->next;
+
+		if (source->timer)
+			close(source->fd);
+
+		xfree(source);
+		source = next;
+	}
+}
+
+static void freerdp_event_loop_dispatch(freerdp_event_source* source, uint32 epoll_events)
+{
+	uint64 expirations;
+	uint32 events = 0;
+
+	if (source->timer)
+	{
+		/* clear the expiration count, the callback runs once however late we are */
+		if (read(source->fd, &expirations, sizeof(expirations)) != sizeof(expirations))
+			return;
+
+		events |= FREERDP_EVENT_TIMER;
+	}
+	else
+	{
+		if (epoll_events & EPOLLIN)
+			events |= FREERDP_EVENT_READ;
+
+		if (epoll_events & EPOLLOUT)
+			events |= FREERDP_EVENT_WRITE;
+
+		/* hangups are reported as readable too, a read will then fail */
+		if (epoll_events & (EPOLLERR | EPOLLHUP))
+			events |= FREERDP_EVENT_ERROR | FREERDP_EVENT_READ;
+	}
+
+	source->callback(source, events, source->arg);
+}
+
+static void* freerdp_event_loop_thread(void* arg)
+{
+	int i;
+	int status;
+	uint64 value;
+	freerdp_event_source* source;
+	struct epoll_event events[REACTOR_MAX_EVENTS];
+	freerdp_event_loop* loop = (freerdp_event_loop*) arg;
+
+	while (loop->reactor->stopped != true)
+	{
+		status = epoll_wait(loop->epfd, events, REACTOR_MAX_EVENTS, -1);
+
+		if (status < 0)
+		{
+			if (errno == EINTR)
+				continue;
+
+			perror("epoll_wait");
+			break;
+		}
+
+		for (i = 0; i < status; i++)
+		{
+			source = (freerdp_event_source*) events[i].data.ptr;
+
+			/* woken up by freerdp_reactor_stop */
+			if (source == NULL)
+			{
+				if (read(loop->wakefd, &value, sizeof(value)) < 0)
+					perror("read");
+
+				continue;
+			}
+
+			/* removed by an earlier callback of the same batch */
+			if (source->removed)
+				continue;
+
+			freerdp_event_loop_dispatch(source, events[i].events);
+		}
+
+		freerdp_event_loop_collect(loop);
+	}
+
+	return NULL;
+}
+
+static freerdp_event_source* freerdp_event_loop_add(freerdp_event_loop* loop, int fd, boolean timer,
+		uint32 events, freerdp_event_callback callback, void* arg)
+{
+	struct epoll_event event;
+	freerdp_event_source* source;
+
+	source = xnew(freerdp_event_source);
+	source->loop = loop;
+	source->fd = fd;
+	source->timer = timer;
+	source->callback = callback;
+	source->arg = arg;
+
+	memset(&event, 0, sizeof(event));
+	event.events = freerdp_event_to_epoll(events);
+	event.data.ptr = source;
+
+	if (epoll_ctl(loop->epfd, EPOLL_CTL_ADD, fd, &event) < 0)
+	{
+		perror("epoll_ctl");
+		xfree(source);
+		return NULL;
+	}
+
+	freerdp_mutex_lock(loop->reactor->mutex);
+	loop->num_sources++;
+	freerdp_mutex_unlock(loop->reactor->mutex);
+
+	return source;
+}
+
+freerdp_event_source* freerdp_event_loop_add_fd(freerdp_event_loop* loop, int fd,
+		uint32 events, freerdp_event_callback callback, void* arg)
+{
+	return freerdp_event_loop_add(loop, fd, false, events, callback, arg);
+}
+
+freerdp_event_source* freerdp_event_loop_add_timer(freerdp_event_loop* loop, uint32 interval_ms,
+		freerdp_event_callback callback, void* arg)
+{
+	int fd;
+	struct itimerspec spec;
+	freerdp_event_source* source;
+
+	fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+
+	if (fd < 0)
+	{
+		perror("timerfd_create");
+		return NULL;
+	}
+
+	if (interval_ms < 1)
+		interval_ms = 1;
+
+	spec.it_interval.tv_sec = interval_ms / 1000;
+	spec.it_interval.tv_nsec = (interval_ms % 1000) * 1000000;
+	spec.it_value = spec.it_interval;
+
+	if (timerfd_settime(fd, 0, &spec, NULL) < 0)
+	{
+		perror("timerfd_settime");
+		close(fd);
+		return NULL;
+	}
+
+	source = freerdp_event_loop_add(loop, fd, true, FREERDP_EVENT_TIMER, callback, arg);
+
+	if (source == NULL)
+		close(fd);
+
+	return source;
+}
+
+void freerdp_event_source_set_events(freerdp_event_source* source, uint32 events)
+{
+	struct epoll_event event;
+
+	if (source == NULL || source->timer)
+		return;
+
+	memset(&event, 0, sizeof(event));
+	event.events = freerdp_event_to_epoll(events);
+	event.data.ptr = source;
+
+	epoll_ctl(source->loop->epfd, EPOLL_CTL_MOD, source->fd, &event);
+}
+
+void freerdp_event_source_remove(freerdp_event_source* source)
+{
+	freerdp_event_loop* loop;
+
+	if (source == NULL || source->removed)
+		return;
+
+	loop = source->loop;
+	epoll_ctl(loop->epfd, EPOLL_CTL_DEL, source->fd, NULL);
+
+	/* freed by the loop once the current batch of events is dispatched */
+	freerdp_mutex_lock(loop->reactor->mutex);
+	source->removed = true;
+	source->next = loop->removed;
+	loop->removed = source;
+	loop->num_sources--;
+	freerdp_mutex_unlock(loop->reactor->mutex);
+}
+
+/**
+ * Returns the loop serving the fewest sources, callers add all the sources
+ * of one connection to the same loop.
+ */
+freerdp_event_loop* freerdp_reactor_get_loop(freerdp_reactor* reactor)
+{
+	int i;
+	freerdp_event_loop* loop;
+
+	freerdp_mutex_lock(reactor->mutex);
+
+	loop = &reactor->loops[0];
+
+	for (i = 1; i < reactor->num_loops; i++)
+	{
+		if (reactor->loops[i].num_sources < loop->num_sources)
+			loop = &reactor->loops[i];
+	}
+
+	freerdp_mutex_unlock(reactor->mutex);
+
+	return loop;
+}
+
+boolean freerdp_reactor_start(freerdp_reactor* reactor)
+{
+	int i;
+	freerdp_event_loop* loop;
+
+	reactor->stopped = false;
+
+	for (i = 0; i < reactor->num_loops; i++)
+	{
+		loop = &reactor->loops[i];
+
+		if (pthread_create(&loop->thread, 0, freerdp_event_loop_thread, loop) != 0)
+		{
+			printf("freerdp_reactor_start: failed to create event loop thread\n");
+			freerdp_reactor_stop(reactor);
+			freerdp_reactor_wait(reactor);
+			return false;
+		}
+
+		loop->running = true;
+	}
+
+	return true;
+}
+
+void freerdp_reactor_stop(freerdp_reactor* reactor)
+{
+	int i;
+	uint64 value = 1;
+
+	reactor->stopped = true;
+
+	for (i = 0; i < reactor->num_loops; i++)
+	{
+		if (reactor->loops[i].wakefd < 0)
+			continue;
+
+		if (write(reactor->loops[i].wakefd, &value, sizeof(value)) < 0)
+			perror("write");
+	}
+}
+
+void freerdp_reactor_wait(freerdp_reactor* reactor)
+{
+	int i;
+	freerdp_event_loop* loop;
+
+	for (i = 0; i < reactor->num_loops; i++)
+	{
+		loop = &reactor->loops[i];
+
+		if (loop->running)
+		{
+			pthread_join(loop->thread, NULL);
+			loop->running = false;
+		}
+	}
+}
+
+freerdp_reactor* freerdp_reactor_new(int num_loops)
+{
+	int i;
+	struct epoll_event event;
+	freerdp_event_loop* loop;
+	freerdp_reactor* reactor;
+
+	if (num_loops < 1)
+		num_loops = (int) sysconf(_SC_NPROCESSORS_ONLN);
+
+	if (num_loops < 1)
+		num_loops = 1;
+
+	reactor = xnew(freerdp_reactor);
+	reactor->mutex = freerdp_mutex_new();
+	reactor->num_loops = num_loops;
+	reactor->loops = (freerdp_event_loop*) xzalloc(sizeof(freerdp_event_loop) * num_loops);
+
+	for (i = 0; i < num_loops; i++)
+	{
+		loop = &reactor->loops[i];
+		loop->reactor = reactor;
+		loop->wakefd = -1;
+		loop->epfd = epoll_create(REACTOR_MAX_EVENTS);
+		loop->wakefd = eventfd(0, EFD_NONBLOCK);
+
+		if (loop->epfd < 0 || loop->wakefd < 0)
+		{
+			perror("freerdp_reactor_new");
+			reactor->num_loops = i + 1;
+			freerdp_reactor_free(reactor);
+			return NULL;
+		}
+
+		memset(&event, 0, sizeof(event));
+		event.events = EPOLLIN;
+		event.data.ptr = NULL;
+		epoll_ctl(loop->epfd, EPOLL_CTL_ADD, loop->wakefd, &event);
+	}
+
+	return reactor;
+}
+
+void freerdp_reactor_free(freerdp_reactor* reactor)
+{
+	int i;
+	freerdp_event_loop* loop;
+
+	if (reactor == NULL)
+		return;
+
+	freerdp_reactor_stop(reactor);
+	freerdp_reactor_wait(reactor);
+
+	for (i = 0; i < reactor->num_loops; i++)
+	{
+		loop = &reactor->loops[i];
+		freerdp_event_loop_collect(loop);
+
+		if (loop->epfd >= 0)
+			close(loop->epfd);
+
+		if (loop->wakefd >= 0)
+			close(loop->wakefd);
+	}
+
+	freerdp_mutex_free(reactor->mutex);
+	xfree(reactor->loops);
+	xfree(reactor);
+}
+
+#else /* __linux__ */
+
+freerdp_reactor* freerdp_reactor_new(int num_loops)
+{
+	return NULL;
+}
+
+void freerdp_reactor_free(freerdp_reactor* reactor)
+{
+}
+
+boolean freerdp_reactor_start(freerdp_reactor* reactor)
+{
+	return false;
+}
+
+void freerdp_reactor_stop(freerdp_reactor* reactor)
+{
+}
+
+void freerdp_reactor_wait(freerdp_reactor* reactor)
+{
+}
+
+freerdp_event_loop* freerdp_reactor_get_loop(freerdp_reactor* reactor)
+{
+	return NULL;
+}
+
+freerdp_event_source* freerdp_event_loop_add_fd(freerdp_event_loop* loop, int fd,
+		uint32 events, freerdp_event_callback callback, void* arg)
+{
+	return NULL;
+}
+
+freerdp_event_source* freerdp_event_loop_add_timer(freerdp_event_loop* loop, uint32 interval_ms,
+		freerdp_event_callback callback, void* arg)
+{
+	return NULL;
+}
+
+void freerdp_event_source_set_events(freerdp_event_source* source, uint32 events)
+{
+}
+
+void freerdp_event_source_remove(freerdp_event_source* source)
+{
+}
+
+#endif /* __linux__ */
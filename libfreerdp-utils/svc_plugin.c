@@ -24,10 +24,10 @@
 #include <string.h>
 #include <freerdp/constants.h>
 #include <freerdp/utils/memory.h>
+#include <freerdp/utils/list.h>
 #include <freerdp/utils/mutex.h>
 #include <freerdp/utils/debug.h>
 #include <freerdp/utils/stream.h>
-#include <freerdp/utils/list.h>
 #include <freerdp/utils/thread.h>
 #include <freerdp/utils/event.h>
 #include <freerdp/utils/svc_plugin.h>
@@ -45,6 +45,15 @@ static rdpSvcPluginList* g_svc_plugin_list = NULL;
 /* For locking the global resources */
 static freerdp_mutex g_mutex = NULL;
 
+#ifdef _WIN32
+#define SVC_MEMORY_BARRIER() MemoryBarrier()
+#else
+#define SVC_MEMORY_BARRIER() __sync_synchronize()
+#endif
+
+/* power of two */
+#define SVC_DATA_IN_RING_SIZE	256
+
 /* Queue for receiving packets */
 struct _svc_data_in_item
 {
@@ -53,6 +62,28 @@ struct _svc_data_in_item
 };
 typedef struct _svc_data_in_item svc_data_in_item;
 
+/**
+ * A single producer, single consumer queue. The items live in the ring
+ * itself, so nothing is allocated per message and neither side takes a
+ * lock. The producer only wakes up the plugin thread when it finds the
+ * ring drained, a busy consumer picks up new items without being signaled.
+ *
+ * The producer never waits: the plugin thread may itself be blocked on the
+ * producer thread (event_sem), so a full ring spills into a locked list.
+ */
+struct _svc_data_in_ring
+{
+	svc_data_in_item items[SVC_DATA_IN_RING_SIZE];
+	volatile uint32 head; /* next item to consume */
+	volatile uint32 tail; /* next free slot */
+
+	/* items that did not fit, newer than everything in the ring */
+	LIST* overflow;
+	volatile uint32 spilled;
+	freerdp_mutex overflow_mutex;
+};
+typedef struct _svc_data_in_ring svc_data_in_ring;
+
 static void svc_data_in_item_free(svc_data_in_item* item)
 {
 	if (item->data_in)
@@ -65,7 +96,6 @@ static void svc_data_in_item_free(svc_data_in_item* item)
 		freerdp_event_free(item->event_in);
 		item->event_in = NULL;
 	}
-	xfree(item);
 }
 
 struct rdp_svc_plugin_private
@@ -74,7 +104,13 @@ struct rdp_svc_plugin_private
 	uint32 open_handle;
 	STREAM* data_in;
 
-	LIST* data_in_list;
+	/* channel data is only ever received on one thread */
+	svc_data_in_ring data_in_ring;
+
+	/* events may be pushed from any thread, the producers take event_mutex */
+	svc_data_in_ring event_in_ring;
+	freerdp_mutex event_mutex;
+
 	freerdp_thread* thread;
 };
 
@@ -139,12 +175,121 @@ static void svc_plugin_remove(rdpSvcPlugin* plugin)
 	freerdp_mutex_unlock(g_mutex);
 }
 
+static void svc_data_in_ring_init(svc_data_in_ring* ring)
+{
+	ring->overflow = list_new();
+	ring->overflow_mutex = freerdp_mutex_new();
+}
+
+static void svc_data_in_ring_uninit(svc_data_in_ring* ring)
+{
+	list_free(ring->overflow);
+	freerdp_mutex_free(ring->overflow_mutex);
+}
+
+/**
+ * Returns true when the consumer may have found the ring empty and has to
+ * be signaled. Once a full ring has spilled, the following items go to the
+ * overflow list as well until the consumer has drained it, to keep the order.
+ */
+static boolean svc_data_in_ring_push(svc_data_in_ring* ring, STREAM* data_in, RDP_EVENT* event_in)
+{
+	uint32 tail = ring->tail;
+	svc_data_in_item* item;
+
+	if (ring->spilled > 0 || tail - ring->head >= SVC_DATA_IN_RING_SIZE)
+	{
+		freerdp_mutex_lock(ring->overflow_mutex);
+
+		if (ring->spilled > 0 || tail - ring->head >= SVC_DATA_IN_RING_SIZE)
+		{
+			item = xnew(svc_data_in_item);
+			item->data_in = data_in;
+			item->event_in = event_in;
+			list_enqueue(ring->overflow, item);
+			ring->spilled++;
+
+			freerdp_mutex_unlock(ring->overflow_mutex);
+			return true;
+		}
+
+		freerdp_mutex_unlock(ring->overflow_mutex);
+	}
+
+	item = &ring->items[tail & (SVC_DATA_IN_RING_SIZE - 1)];
+	item->data_in = data_in;
+	item->event_in = event_in;
+
+	/* publish the item, then look whether the consumer has caught up */
+	SVC_MEMORY_BARRIER();
+	ring->tail = tail + 1;
+	SVC_MEMORY_BARRIER();
+
+	return (ring->head == tail) ? true : false;
+}
+
+static boolean svc_data_in_ring_pop(svc_data_in_ring* ring, svc_data_in_item* item)
+{
+	uint32 head = ring->head;
+	svc_data_in_item* spilled = NULL;
+
+	if (head == ring->tail)
+	{
+		if (ring->spilled == 0)
+			return false;
+
+		freerdp_mutex_lock(ring->overflow_mutex);
+		spilled = (svc_data_in_item*) list_dequeue(ring->overflow);
+
+		if (spilled != NULL)
+			ring->spilled--;
+
+		freerdp_mutex_unlock(ring->overflow_mutex);
+
+		if (spilled == NULL)
+			return false;
+
+		*item = *spilled;
+		xfree(spilled);
+		return true;
+	}
+
+	SVC_MEMORY_BARRIER();
+	*item = ring->items[head & (SVC_DATA_IN_RING_SIZE - 1)];
+	SVC_MEMORY_BARRIER();
+	ring->head = head + 1;
+	SVC_MEMORY_BARRIER();
+
+	return true;
+}
+
+/**
+ * The chunks point into the transport receive buffer, which is reused as
+ * soon as we return, so each chunk is copied exactly once, straight into
+ * a buffer of the announced total length. The buffer is not zeroed, a
+ * message whose chunks do not add up to that length is dropped.
+ */
+static STREAM* svc_plugin_stream_new(uint32 size)
+{
+	STREAM* s;
+	uint8* data;
+
+	s = stream_new(0);
+
+	if (size > 0)
+	{
+		data = (uint8*) xmalloc(size);
+		stream_attach(s, data, size);
+	}
+
+	return s;
+}
+
 static void svc_plugin_process_received(rdpSvcPlugin* plugin, void* pData, uint32 dataLength,
 	uint32 totalLength, uint32 dataFlags)
 {
 	STREAM* data_in;
-	svc_data_in_item* item;
-	
+
 	if ( (dataFlags & CHANNEL_FLAG_SUSPEND) || (dataFlags & CHANNEL_FLAG_RESUME))
 	{
 		/* According to MS-RDPBCGR 2.2.6.1, "All virtual channel traffic MUST be suspended.
@@ -154,50 +299,62 @@ static void svc_plugin_process_received(rdpSvcPlugin* plugin, void* pData, uint3
 		return;
 	}
 
-	if (dataFlags & CHANNEL_FLAG_FIRST)
+	if ((dataFlags & CHANNEL_FLAG_FIRST) && (dataFlags & CHANNEL_FLAG_LAST) && dataLength == totalLength)
 	{
-		if (plugin->priv->data_in != NULL)
-			stream_free(plugin->priv->data_in);
-		plugin->priv->data_in = stream_new(totalLength);
+		/* unfragmented, leave a reassembly in progress alone */
+		data_in = svc_plugin_stream_new(dataLength);
+		stream_write(data_in, pData, dataLength);
+		stream_set_pos(data_in, 0);
 	}
+	else
+	{
+		if (dataFlags & CHANNEL_FLAG_FIRST)
+		{
+			if (plugin->priv->data_in != NULL)
+				stream_free(plugin->priv->data_in);
+			plugin->priv->data_in = svc_plugin_stream_new(totalLength);
+		}
 
-	data_in = plugin->priv->data_in;
-	stream_check_size(data_in, (int) dataLength);
-	stream_write(data_in, pData, dataLength);
+		data_in = plugin->priv->data_in;
 
-	if (dataFlags & CHANNEL_FLAG_LAST)
-	{
-		if (stream_get_size(data_in) != stream_get_length(data_in))
+		if (data_in == NULL)
 		{
-			printf("svc_plugin_process_received: read error\n");
+			printf("svc_plugin_process_received: chunk without first chunk\n");
+			return;
 		}
 
+		stream_check_size(data_in, (int) dataLength);
+		stream_write(data_in, pData, dataLength);
+
+		if (!(dataFlags & CHANNEL_FLAG_LAST))
+			return;
+
 		plugin->priv->data_in = NULL;
-		stream_set_pos(data_in, 0);
 
-		item = xnew(svc_data_in_item);
-		item->data_in = data_in;
+		if (stream_get_size(data_in) != stream_get_length(data_in))
+		{
+			printf("svc_plugin_process_received: read error\n");
+			stream_free(data_in);
+			return;
+		}
 
-		freerdp_thread_lock(plugin->priv->thread);
-		list_enqueue(plugin->priv->data_in_list, item);
-		freerdp_thread_unlock(plugin->priv->thread);
+		stream_set_pos(data_in, 0);
+	}
 
+	if (svc_data_in_ring_push(&plugin->priv->data_in_ring, data_in, NULL))
 		freerdp_thread_signal(plugin->priv->thread);
-	}
 }
 
 static void svc_plugin_process_event(rdpSvcPlugin* plugin, RDP_EVENT* event_in)
 {
-	svc_data_in_item* item;
+	boolean signal;
 
-	item = xnew(svc_data_in_item);
-	item->event_in = event_in;
-
-	freerdp_thread_lock(plugin->priv->thread);
-	list_enqueue(plugin->priv->data_in_list, item);
-	freerdp_thread_unlock(plugin->priv->thread);
+	freerdp_mutex_lock(plugin->priv->event_mutex);
+	signal = svc_data_in_ring_push(&plugin->priv->event_in_ring, NULL, event_in);
+	freerdp_mutex_unlock(plugin->priv->event_mutex);
 
-	freerdp_thread_signal(plugin->priv->thread);
+	if (signal)
+		freerdp_thread_signal(plugin->priv->thread);
 }
 
 static void svc_plugin_open_event(uint32 openHandle, uint32 event, void* pData, uint32 dataLength,
@@ -230,30 +387,31 @@ static void svc_plugin_open_event(uint32 openHandle, uint32 event, void* pData,
 
 static void svc_plugin_process_data_in(rdpSvcPlugin* plugin)
 {
-	svc_data_in_item* item;
+	boolean more;
+	svc_data_in_item item;
 
-	while (1)
+	do
 	{
+		more = false;
+
 		/* terminate signal */
 		if (freerdp_thread_is_stopped(plugin->priv->thread))
 			break;
 
-		freerdp_thread_lock(plugin->priv->thread);
-		item = list_dequeue(plugin->priv->data_in_list);
-		freerdp_thread_unlock(plugin->priv->thread);
+		/* the ownership of the data is passed to the callback */
+		if (svc_data_in_ring_pop(&plugin->priv->data_in_ring, &item))
+		{
+			IFCALL(plugin->receive_callback, plugin, item.data_in);
+			more = true;
+		}
 
-		if (item != NULL)
+		if (svc_data_in_ring_pop(&plugin->priv->event_in_ring, &item))
 		{
-			/* the ownership of the data is passed to the callback */
-			if (item->data_in)
-				IFCALL(plugin->receive_callback, plugin, item->data_in);
-			if (item->event_in)
-				IFCALL(plugin->event_callback, plugin, item->event_in);
-			xfree(item);
+			IFCALL(plugin->event_callback, plugin, item.event_in);
+			more = true;
 		}
-		else
-			break;
 	}
+	while (more);
 }
 
 static void* svc_plugin_thread_func(void* arg)
@@ -301,7 +459,9 @@ static void svc_plugin_process_connected(rdpSvcPlugin* plugin, void* pData, uint
 		return;
 	}
 
-	plugin->priv->data_in_list = list_new();
+	svc_data_in_ring_init(&plugin->priv->data_in_ring);
+	svc_data_in_ring_init(&plugin->priv->event_in_ring);
+	plugin->priv->event_mutex = freerdp_mutex_new();
 	plugin->priv->thread = freerdp_thread_new();
 
 	freerdp_thread_start(plugin->priv->thread, svc_plugin_thread_func, plugin);
@@ -309,7 +469,7 @@ static void svc_plugin_process_connected(rdpSvcPlugin* plugin, void* pData, uint
 
 static void svc_plugin_process_terminated(rdpSvcPlugin* plugin)
 {
-	svc_data_in_item* item;
+	svc_data_in_item item;
 
 	freerdp_thread_stop(plugin->priv->thread);
 	freerdp_thread_free(plugin->priv->thread);
@@ -319,9 +479,13 @@ static void svc_plugin_process_terminated(rdpSvcPlugin* plugin)
 
 	svc_plugin_remove(plugin);
 
-	while ((item = list_dequeue(plugin->priv->data_in_list)) != NULL)
-		svc_data_in_item_free(item);
-	list_free(plugin->priv->data_in_list);
+	while (svc_data_in_ring_pop(&plugin->priv->data_in_ring, &item))
+		svc_data_in_item_free(&item);
+	while (svc_data_in_ring_pop(&plugin->priv->event_in_ring, &item))
+		svc_data_in_item_free(&item);
+	svc_data_in_ring_uninit(&plugin->priv->data_in_ring);
+	svc_data_in_ring_uninit(&plugin->priv->event_in_ring);
+	freerdp_mutex_free(plugin->priv->event_mutex);
 
 	if (plugin->priv->data_in != NULL)
 	{
@@ -0,0 +1,311 @@
+/**
+ * FreeRDP: A Remote Desktop Protocol Client
+ * X11 Shared Screen Capture
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * All peers look at the same display, so the damage is collected on a
+ * single connection and every tick the dirty area is captured once and
+ * encoded once per quantization profile. The TILESET is then handed out
+ * by reference to the event queue of every subscribed peer, which only
+ * wraps it into a message of its own.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <freerdp/utils/memory.h>
+
+#include "xf_event.h"
+#include "xf_encode.h"
+
+#include "xf_capture.h"
+
+static xfCaptureProfile* xf_capture_profile_new(RFX_COMPOSE_CONTEXT* rfx_context)
+{
+	xfCaptureProfile* profile;
+	RFX_COMPOSE_CONTEXT* context;
+
+	context = rfx_compose_context_new();
+	context->mode = rfx_context->mode;
+	context->flags = rfx_context->flags;
+	context->width = rfx_context->width;
+	context->height = rfx_context->height;
+
+	IFCALL(context->set_pixel_format, context, rfx_context->pixel_format);
+
+	if (rfx_context->num_quants > 0)
+	{
+		context->num_quants = rfx_context->num_quants;
+		context->quants = (uint32*) xmalloc(rfx_context->num_quants * 10 * sizeof(uint32));
+		memcpy(context->quants, rfx_context->quants, rfx_context->num_quants * 10 * sizeof(uint32));
+		context->quant_idx_y = rfx_context->quant_idx_y;
+		context->quant_idx_cb = rfx_context->quant_idx_cb;
+		context->quant_idx_cr = rfx_context->quant_idx_cr;
+	}
+
+	profile = xnew(xfCaptureProfile);
+	profile->rfx_context = context;
+
+	return profile;
+}
+
+static void xf_capture_profile_free(xfCaptureProfile* profile)
+{
+	rfx_compose_context_free(profile->rfx_context);
+	xfree(profile);
+}
+
+void xf_capture_frame_release(xfCaptureFrame* frame)
+{
+	int refcount;
+	xfCapture* capture = frame->capture;
+
+	pthread_mutex_lock(&(capture->frame_mutex));
+	refcount = --(frame->refcount);
+	pthread_mutex_unlock(&(capture->frame_mutex));
+
+	if (refcount > 0)
+		return;
+
+	stream_free(frame->tileset);
+	xfree(frame);
+}
+
+static void xf_capture_encode(xfCapture* capture, uint8* data, int stride, int x, int y, int width, int height)
+{
+	int i, j;
+	xfCaptureFrame* frame;
+	xfEventFrame* event;
+	xfCaptureProfile* profile;
+	xfCaptureSubscriber* subscriber;
+
+	pthread_mutex_lock(&(capture->mutex));
+
+	for (i = 0; i < capture->num_profiles; i++)
+	{
+		profile = capture->profiles[i];
+
+		if (profile->subscribers < 1)
+			continue;
+
+		frame = xnew(xfCaptureFrame);
+		frame->capture = capture;
+		frame->x = x;
+		frame->y = y;
+		frame->width = width;
+		frame->height = height;
+		frame->tileset = stream_new(65536);
+
+		rfx_compose_tileset(profile->rfx_context, frame->tileset,
+				data, width, height, stride);
+
+		/* hold a reference while handing out, a fast peer may release before we are done */
+		frame->refcount = 1;
+
+		for (j = 0; j < capture->num_subscribers; j++)
+		{
+			subscriber = &capture->subscribers[j];
+
+			if (subscriber->profile != profile)
+				continue;
+
+			pthread_mutex_lock(&(capture->frame_mutex));
+			frame->refcount++;
+			pthread_mutex_unlock(&(capture->frame_mutex));
+
+			event = xnew(xfEventFrame);
+			event->type = XF_EVENT_TYPE_FRAME;
+			event->frame = frame;
+
+			xf_event_push(((xfPeerContext*) subscriber->client->context)->event_queue, (xfEvent*) event);
+		}
+
+		xf_capture_frame_release(frame);
+	}
+
+	pthread_mutex_unlock(&(capture->mutex));
+}
+
+static void xf_capture_xevent_callback(freerdp_event_source* source, uint32 events, void* arg)
+{
+	xfCapture* capture = (xfCapture*) arg;
+
+	xf_process_xevents(capture->info, &(capture->mutex), capture->hdc);
+}
+
+static void xf_capture_frame_callback(freerdp_event_source* source, uint32 events, void* arg)
+{
+	uint8* data;
+	XImage* image;
+	HGDI_RGN invalid_region;
+	xfCapture* capture = (xfCapture*) arg;
+
+	xf_process_xevents(capture->info, &(capture->mutex), capture->hdc);
+
+	invalid_region = capture->hdc->hwnd->invalid;
+
+	/* with nobody watching the damage is only drained */
+	if (invalid_region->null == false && capture->num_subscribers > 0)
+	{
+		image = xf_snapshot(capture->info, &(capture->mutex), invalid_region->x, invalid_region->y,
+				invalid_region->w, invalid_region->h);
+
+		if (image != NULL && capture->info->use_xshm)
+		{
+			/* the shared image covers the whole screen and stays ours */
+			data = (uint8*) image->data;
+			data = &data[(invalid_region->y * image->bytes_per_line) +
+					(invalid_region->x * image->bits_per_pixel / 8)];
+
+			xf_capture_encode(capture, data, image->bytes_per_line, invalid_region->x,
+					invalid_region->y, invalid_region->w, invalid_region->h);
+		}
+		else if (image != NULL)
+		{
+			xf_capture_encode(capture, (uint8*) image->data, image->bytes_per_line,
+					invalid_region->x, invalid_region->y, invalid_region->w, invalid_region->h);
+			XDestroyImage(image);
+		}
+	}
+
+	invalid_region->null = 1;
+	capture->hdc->hwnd->ninvalid = 0;
+}
+
+/**
+ * Starts handing frames to the peer. The peer compose context must not
+ * change its profile while subscribed.
+ */
+void xf_capture_subscribe(xfCapture* capture, freerdp_peer* client)
+{
+	int i;
+	xfCaptureProfile* profile = NULL;
+	xfPeerContext* xfp = (xfPeerContext*) client->context;
+
+	pthread_mutex_lock(&(capture->mutex));
+
+	for (i = 0; i < capture->num_profiles; i++)
+	{
+		if (rfx_compose_context_same_profile(capture->profiles[i]->rfx_context, xfp->rfx_context))
+		{
+			profile = capture->profiles[i];
+			break;
+		}
+	}
+
+	if (profile == NULL)
+	{
+		profile = xf_capture_profile_new(xfp->rfx_context);
+
+		capture->profiles = (xfCaptureProfile**) xrealloc(capture->profiles,
+				sizeof(xfCaptureProfile*) * (capture->num_profiles + 1));
+		capture->profiles[capture->num_profiles++] = profile;
+	}
+
+	if (capture->num_subscribers >= capture->max_subscribers)
+	{
+		capture->max_subscribers = (capture->max_subscribers > 0) ? capture->max_subscribers * 2 : 8;
+		capture->subscribers = (xfCaptureSubscriber*) xrealloc(capture->subscribers,
+				sizeof(xfCaptureSubscriber) * capture->max_subscribers);
+	}
+
+	capture->subscribers[capture->num_subscribers].client = client;
+	capture->subscribers[capture->num_subscribers].profile = profile;
+	capture->num_subscribers++;
+	profile->subscribers++;
+
+	pthread_mutex_unlock(&(capture->mutex));
+}
+
+/**
+ * After this returns no more frames are pushed for the peer, frames
+ * already queued still have to be released by the peer.
+ */
+void xf_capture_unsubscribe(xfCapture* capture, freerdp_peer* client)
+{
+	int i;
+
+	pthread_mutex_lock(&(capture->mutex));
+
+	for (i = 0; i < capture->num_subscribers; i++)
+	{
+		if (capture->subscribers[i].client != client)
+			continue;
+
+		capture->subscribers[i].profile->subscribers--;
+		capture->subscribers[i] = capture->subscribers[--(capture->num_subscribers)];
+		break;
+	}
+
+	pthread_mutex_unlock(&(capture->mutex));
+}
+
+xfCapture* xf_capture_new(freerdp_event_loop* loop, int fps)
+{
+	xfCapture* capture;
+
+	capture = xnew(xfCapture);
+
+	capture->fps = fps;
+	capture->info = xf_info_init(true);
+	capture->hdc = gdi_CreateDC(capture->info->clrconv, capture->info->bpp);
+
+	pthread_mutex_init(&(capture->mutex), NULL);
+	pthread_mutex_init(&(capture->frame_mutex), NULL);
+
+	capture->xevent_source = freerdp_event_loop_add_fd(loop, capture->info->xfds,
+			FREERDP_EVENT_READ, xf_capture_xevent_callback, capture);
+	capture->frame_source = freerdp_event_loop_add_timer(loop, 1000 / fps,
+			xf_capture_frame_callback, capture);
+
+	if (capture->xevent_source == NULL || capture->frame_source == NULL)
+	{
+		printf("xf_capture_new: failed to add event sources\n");
+		xf_capture_free(capture);
+		return NULL;
+	}
+
+	return capture;
+}
+
+void xf_capture_free(xfCapture* capture)
+{
+	int i;
+
+	if (capture == NULL)
+		return;
+
+	freerdp_event_source_remove(capture->xevent_source);
+	freerdp_event_source_remove(capture->frame_source);
+
+	for (i = 0; i < capture->num_profiles; i++)
+		xf_capture_profile_free(capture->profiles[i]);
+
+	xfree(capture->profiles);
+	xfree(capture->subscribers);
+
+	gdi_DeleteDC(capture->hdc);
+	XCloseDisplay(capture->info->display);
+	freerdp_clrconv_free(capture->info->clrconv);
+	xfree(capture->info);
+
+	pthread_mutex_destroy(&(capture->mutex));
+	pthread_mutex_destroy(&(capture->frame_mutex));
+
+	xfree(capture);
+}
@@ -0,0 +1,94 @@
+/**
+ * FreeRDP: A Remote Desktop Protocol Client
+ * X11 Shared Screen Capture
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __XF_CAPTURE_H
+#define __XF_CAPTURE_H
+
+typedef struct xf_capture xfCapture;
+typedef struct xf_capture_frame xfCaptureFrame;
+typedef struct xf_capture_profile xfCaptureProfile;
+typedef struct xf_capture_subscriber xfCaptureSubscriber;
+typedef struct xf_event_frame xfEventFrame;
+
+#include <pthread.h>
+#include <freerdp/utils/reactor.h>
+
+#include "xfreerdp.h"
+#include "xf_peer.h"
+
+/**
+ * An encoded TILESET, shared by all subscribers of one profile.
+ * The frame is freed when the last subscriber released it.
+ */
+struct xf_capture_frame
+{
+	int refcount;
+	xfCapture* capture;
+
+	int x;
+	int y;
+	int width;
+	int height;
+	STREAM* tileset;
+};
+
+struct xf_capture_profile
+{
+	int subscribers;
+	RFX_COMPOSE_CONTEXT* rfx_context;
+};
+
+struct xf_capture_subscriber
+{
+	freerdp_peer* client;
+	xfCaptureProfile* profile;
+};
+
+struct xf_capture
+{
+	int fps;
+	HGDI_DC hdc;
+	xfInfo* info;
+	pthread_mutex_t mutex;
+	pthread_mutex_t frame_mutex;
+
+	int num_profiles;
+	xfCaptureProfile** profiles;
+
+	int num_subscribers;
+	int max_subscribers;
+	xfCaptureSubscriber* subscribers;
+
+	freerdp_event_source* xevent_source;
+	freerdp_event_source* frame_source;
+};
+
+struct xf_event_frame
+{
+	int type;
+
+	xfCaptureFrame* frame;
+};
+
+void xf_capture_subscribe(xfCapture* capture, freerdp_peer* client);
+void xf_capture_unsubscribe(xfCapture* capture, freerdp_peer* client);
+void xf_capture_frame_release(xfCaptureFrame* frame);
+
+xfCapture* xf_capture_new(freerdp_event_loop* loop, int fps);
+void xf_capture_free(xfCapture* capture);
+
+#endif /* __XF_CAPTURE_H */
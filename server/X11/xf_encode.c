@@ -22,14 +22,13 @@
 
 #include "xf_encode.h"
 
-XImage* xf_snapshot(xfPeerContext* xfp, int x, int y, int width, int height)
+XImage* xf_snapshot(xfInfo* xfi, pthread_mutex_t* mutex, int x, int y, int width, int height)
 {
 	XImage* image;
-	xfInfo* xfi = xfp->info;
 
 	if (xfi->use_xshm)
 	{
-		pthread_mutex_lock(&(xfp->mutex));
+		pthread_mutex_lock(mutex);
 
 		XCopyArea(xfi->display, xfi->root_window, xfi->fb_pixmap,
 				xfi->xdamage_gc, x, y, width, height, x, y);
@@ -38,25 +37,24 @@ XImage* xf_snapshot(xfPeerContext* xfp, int x, int y, int width, int height)
 
 		image = xfi->fb_image;
 
-		pthread_mutex_unlock(&(xfp->mutex));
+		pthread_mutex_unlock(mutex);
 	}
 	else
 	{
-		pthread_mutex_lock(&(xfp->mutex));
+		pthread_mutex_lock(mutex);
 
 		image = XGetImage(xfi->display, xfi->root_window,
 				x, y, width, height, AllPlanes, ZPixmap);
 
-		pthread_mutex_unlock(&(xfp->mutex));
+		pthread_mutex_unlock(mutex);
 	}
 
 	return image;
 }
 
-void xf_xdamage_subtract_region(xfPeerContext* xfp, int x, int y, int width, int height)
+void xf_xdamage_subtract_region(xfInfo* xfi, pthread_mutex_t* mutex, int x, int y, int width, int height)
 {
 	XRectangle region;
-	xfInfo* xfi = xfp->info;
 
 	region.x = x;
 	region.y = y;
@@ -64,13 +62,57 @@ void xf_xdamage_subtract_region(xfPeerContext* xfp, int x, int y, int width, int
 	region.height = height;
 
 #ifdef WITH_XFIXES
-	pthread_mutex_lock(&(xfp->mutex));
+	pthread_mutex_lock(mutex);
 	XFixesSetRegion(xfi->display, xfi->xdamage_region, &region, 1);
 	XDamageSubtract(xfi->display, xfi->xdamage, xfi->xdamage_region, None);
-	pthread_mutex_unlock(&(xfp->mutex));
+	pthread_mutex_unlock(mutex);
 #endif
 }
 
+/**
+ * Drains the pending events of a display. Used when the display is served
+ * by an event loop: damage goes straight into the invalid region of the dc
+ * instead of going through an event queue.
+ */
+void xf_process_xevents(xfInfo* xfi, pthread_mutex_t* mutex, HGDI_DC hdc)
+{
+	XEvent xevent;
+	int pending_events;
+	int x, y, width, height;
+	XDamageNotifyEvent* notify;
+
+	while (1)
+	{
+		pthread_mutex_lock(mutex);
+
+		pending_events = XPending(xfi->display);
+
+		if (pending_events > 0)
+		{
+			memset(&xevent, 0, sizeof(xevent));
+			XNextEvent(xfi->display, &xevent);
+		}
+
+		pthread_mutex_unlock(mutex);
+
+		if (pending_events < 1)
+			break;
+
+		if (xevent.type == xfi->xdamage_notify_event)
+		{
+			notify = (XDamageNotifyEvent*) &xevent;
+
+			x = notify->area.x;
+			y = notify->area.y;
+			width = notify->area.width;
+			height = notify->area.height;
+
+			xf_xdamage_subtract_region(xfi, mutex, x, y, width, height);
+			gdi_InvalidateRegion(hdc, x, y, width, height);
+		}
+	}
+}
+
 void* xf_frame_rate_thread(void* param)
 {
 	xfInfo* xfi;
@@ -163,7 +205,7 @@ void* xf_monitor_updates(void* param)
 				width = notify->area.width;
 				height = notify->area.height;
 
-				xf_xdamage_subtract_region(xfp, x, y, width, height);
+				xf_xdamage_subtract_region(xfi, &(xfp->mutex), x, y, width, height);
 
 				event_region = xf_event_region_new(x, y, width, height);
 				xf_event_push(xfp->event_queue, (xfEvent*) event_region);
@@ -25,8 +25,9 @@
 
 #include "xf_peer.h"
 
-XImage* xf_snapshot(xfPeerContext* xfp, int x, int y, int width, int height);
-void xf_xdamage_subtract_region(xfPeerContext* xfp, int x, int y, int width, int height);
+XImage* xf_snapshot(xfInfo* xfi, pthread_mutex_t* mutex, int x, int y, int width, int height);
+void xf_xdamage_subtract_region(xfInfo* xfi, pthread_mutex_t* mutex, int x, int y, int width, int height);
 void* xf_monitor_updates(void* param);
+void xf_process_xevents(xfInfo* xfi, pthread_mutex_t* mutex, HGDI_DC hdc);
 
 #endif /* __XF_ENCODE_H */
@@ -124,7 +124,10 @@ xfEvent* xf_event_pop(xfEventQueue* event_queue)
 	pthread_mutex_lock(&(event_queue->mutex));
 
 	if (event_queue->count < 1)
+	{
+		pthread_mutex_unlock(&(event_queue->mutex));
 		return NULL;
+	}
 
 	/* remove event signal */
 	xf_clear_event(event_queue);
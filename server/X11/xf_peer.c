@@ -40,9 +40,12 @@ extern boolean xf_pcap_dump_realtime;
 #include "xf_event.h"
 #include "xf_input.h"
 #include "xf_encode.h"
+#include "xf_capture.h"
 
 #include "xf_peer.h"
 
+extern xfCapture* xf_shared_capture;
+
 #ifdef WITH_XDAMAGE
 
 void xf_xdamage_init(xfInfo* xfi)
@@ -159,7 +162,11 @@ void xf_xshm_init(xfInfo* xfi)
 			xfi->fb_image->width, xfi->fb_image->height, xfi->fb_image->depth);
 }
 
-xfInfo* xf_info_init()
+/**
+ * A display used for capture watches the root window for damage,
+ * the others are only used for input and private snapshots.
+ */
+xfInfo* xf_info_init(boolean monitor)
 {
 	int i;
 	xfInfo* xfi;
@@ -239,13 +246,16 @@ xfInfo* xf_info_init()
 
 	xfi->clrconv = freerdp_clrconv_new(CLRCONV_ALPHA | CLRCONV_INVERT);
 
-	XSelectInput(xfi->display, xfi->root_window, SubstructureNotifyMask);
+	if (monitor)
+	{
+		XSelectInput(xfi->display, xfi->root_window, SubstructureNotifyMask);
 
 #ifdef WITH_XDAMAGE
-	xf_xdamage_init(xfi);
+		xf_xdamage_init(xfi);
 #endif
 
-	xf_xshm_init(xfi);
+		xf_xshm_init(xfi);
+	}
 
 	xfi->bytesPerPixel = 4;
 
@@ -256,7 +266,8 @@ xfInfo* xf_info_init()
 
 void xf_peer_context_new(freerdp_peer* client, xfPeerContext* context)
 {
-	context->info = xf_info_init();
+	/* with a shared capture the damage of the display is watched only once */
+	context->info = xf_info_init(xf_shared_capture == NULL);
 	context->rfx_context = rfx_compose_context_new();
 	context->rfx_context->mode = RLGR3;
 	context->rfx_context->width = context->info->width;
@@ -306,12 +317,87 @@ STREAM* xf_peer_stream_init(xfPeerContext* context)
 	return context->s;
 }
 
+static void xf_peer_xevent_callback(freerdp_event_source* source, uint32 events, void* arg)
+{
+	freerdp_peer* client = (freerdp_peer*) arg;
+	xfPeerContext* xfp = (xfPeerContext*) client->context;
+
+	xf_process_xevents(xfp->info, &(xfp->mutex), xfp->hdc);
+}
+
+static void xf_peer_frame_callback(freerdp_event_source* source, uint32 events, void* arg)
+{
+	freerdp_peer* client = (freerdp_peer*) arg;
+	xfPeerContext* xfp = (xfPeerContext*) client->context;
+
+	xf_peer_send_frame(client);
+	client->UpdateWriteInterest(client);
+
+	/* the snapshot syncs with the X server, which may have queued more damage */
+	if (xfp->xevent_source != NULL)
+		xf_process_xevents(xfp->info, &(xfp->mutex), xfp->hdc);
+}
+
+static void xf_peer_send_shared_frame(freerdp_peer* client, xfCaptureFrame* frame);
+
+static void xf_peer_queue_callback(freerdp_event_source* source, uint32 events, void* arg)
+{
+	xfEvent* event;
+	freerdp_peer* client = (freerdp_peer*) arg;
+	xfPeerContext* xfp = (xfPeerContext*) client->context;
+
+	while (xf_event_peek(xfp->event_queue) != NULL)
+	{
+		event = xf_event_pop(xfp->event_queue);
+
+		if (event->type == XF_EVENT_TYPE_FRAME)
+		{
+			xf_peer_send_shared_frame(client, ((xfEventFrame*) event)->frame);
+			xf_capture_frame_release(((xfEventFrame*) event)->frame);
+		}
+
+		xf_event_free(event);
+	}
+
+	client->UpdateWriteInterest(client);
+}
+
 void xf_peer_live_rfx(freerdp_peer* client)
 {
 	xfPeerContext* xfp = (xfPeerContext*) client->context;
 
-	if (xfp->activations == 1)
+	if (xfp->activations != 1)
+		return;
+
+	if (client->loop != NULL && xf_shared_capture != NULL)
+	{
+		/**
+		 * Frames arrive encoded from the shared capture. The first frame and
+		 * whatever is missed while the client lags behind are captured
+		 * privately on the peer's own frame clock.
+		 */
+		xfp->queue_source = freerdp_event_loop_add_fd(client->loop, xfp->event_queue->pipe_fd[0],
+				FREERDP_EVENT_READ, xf_peer_queue_callback, client);
+		xfp->frame_source = freerdp_event_loop_add_timer(client->loop, 1000 / xfp->fps,
+				xf_peer_frame_callback, client);
+
+		gdi_InvalidateRegion(xfp->hdc, 0, 0, xfp->info->width, xfp->info->height);
+		xf_capture_subscribe(xf_shared_capture, client);
+	}
+	else if (client->loop != NULL)
+	{
+		/* the display and the frame clock are served by the peer's event loop */
+		xfp->xevent_source = freerdp_event_loop_add_fd(client->loop, xfp->info->xfds,
+				FREERDP_EVENT_READ, xf_peer_xevent_callback, client);
+		xfp->frame_source = freerdp_event_loop_add_timer(client->loop, 1000 / xfp->fps,
+				xf_peer_frame_callback, client);
+
+		xf_process_xevents(xfp->info, &(xfp->mutex), xfp->hdc);
+	}
+	else
+	{
 		pthread_create(&(xfp->thread), 0, xf_monitor_updates, (void*) client);
+	}
 }
 
 static boolean xf_peer_sleep_tsdiff(uint32 *old_sec, uint32 *old_usec, uint32 new_sec, uint32 new_usec)
@@ -389,6 +475,28 @@ void xf_peer_dump_rfx(freerdp_peer* client)
 	}
 }
 
+static void xf_peer_send_surface_bits(freerdp_peer* client, STREAM* s, int x, int y, int width, int height)
+{
+	uint32 frame_id;
+	rdpUpdate* update = client->update;
+	SURFACE_BITS_COMMAND* cmd = &update->surface_bits_command;
+
+	cmd->destLeft = x;
+	cmd->destTop = y;
+	cmd->destRight = x + width;
+	cmd->destBottom = y + height;
+	cmd->bpp = 32;
+	cmd->codecID = client->settings->rfx_codec_id;
+	cmd->width = width;
+	cmd->height = height;
+	cmd->bitmapDataLength = stream_get_length(s);
+	cmd->bitmapData = stream_get_head(s);
+
+	frame_id = client->BeginFrame(client);
+	update->SurfaceBits(update->context, cmd);
+	client->EndFrame(client, frame_id);
+}
+
 void xf_peer_rfx_update(freerdp_peer* client, int x, int y, int width, int height)
 {
 	STREAM* s;
@@ -396,13 +504,9 @@ void xf_peer_rfx_update(freerdp_peer* client, int x, int y, int width, int heigh
 	xfInfo* xfi;
 	RFX_RECT rect;
 	XImage* image;
-	rdpUpdate* update;
 	xfPeerContext* xfp;
-	SURFACE_BITS_COMMAND* cmd;
 
-	update = client->update;
 	xfp = (xfPeerContext*) client->context;
-	cmd = &update->surface_bits_command;
 	xfi = xfp->info;
 
 	if (width * height <= 0)
@@ -421,18 +525,13 @@ void xf_peer_rfx_update(freerdp_peer* client, int x, int y, int width, int heigh
 		rect.width = width;
 		rect.height = height;
 
-		image = xf_snapshot(xfp, x, y, width, height);
+		image = xf_snapshot(xfi, &(xfp->mutex), x, y, width, height);
 
 		data = (uint8*) image->data;
 		data = &data[(y * image->bytes_per_line) + (x * image->bits_per_pixel / 8)];
 
 		rfx_compose_message(xfp->rfx_context, s, &rect, 1, data,
 				width, height, image->bytes_per_line);
-
-		cmd->destLeft = x;
-		cmd->destTop = y;
-		cmd->destRight = x + width;
-		cmd->destBottom = y + height;
 	}
 	else
 	{
@@ -441,27 +540,46 @@ void xf_peer_rfx_update(freerdp_peer* client, int x, int y, int width, int heigh
 		rect.width = width;
 		rect.height = height;
 
-		image = xf_snapshot(xfp, x, y, width, height);
+		image = xf_snapshot(xfi, &(xfp->mutex), x, y, width, height);
 
 		rfx_compose_message(xfp->rfx_context, s, &rect, 1,
 				(uint8*) image->data, width, height, width * xfi->bytesPerPixel);
 
-		cmd->destLeft = x;
-		cmd->destTop = y;
-		cmd->destRight = x + width;
-		cmd->destBottom = y + height;
-
 		XDestroyImage(image);
 	}
 
-	cmd->bpp = 32;
-	cmd->codecID = client->settings->rfx_codec_id;
-	cmd->width = width;
-	cmd->height = height;
-	cmd->bitmapDataLength = stream_get_length(s);
-	cmd->bitmapData = stream_get_head(s);
+	xf_peer_send_surface_bits(client, s, x, y, width, height);
+}
 
-	update->SurfaceBits(update->context, cmd);
+/**
+ * Wraps a TILESET encoded by the shared capture into a message of our own.
+ * While private damage is pending the shared frames are folded into it
+ * and go out with the next private snapshot instead.
+ */
+static void xf_peer_send_shared_frame(freerdp_peer* client, xfCaptureFrame* frame)
+{
+	STREAM* s;
+	RFX_RECT rect;
+	xfPeerContext* xfp = (xfPeerContext*) client->context;
+
+	if (client->IsWriteBlocked(client) || client->CanSendFrame(client) != true ||
+		xfp->hdc->hwnd->invalid->null == false)
+	{
+		gdi_InvalidateRegion(xfp->hdc, frame->x, frame->y, frame->width, frame->height);
+		return;
+	}
+
+	rect.x = 0;
+	rect.y = 0;
+	rect.width = frame->width;
+	rect.height = frame->height;
+
+	s = xf_peer_stream_init(xfp);
+
+	rfx_compose_message_with_tileset(xfp->rfx_context, s, &rect, 1,
+			stream_get_head(frame->tileset), stream_get_length(frame->tileset));
+
+	xf_peer_send_surface_bits(client, s, frame->x, frame->y, frame->width, frame->height);
 }
 
 boolean xf_peer_get_fds(freerdp_peer* client, void** rfds, int* rcount)
@@ -477,12 +595,44 @@ boolean xf_peer_get_fds(freerdp_peer* client, void** rfds, int* rcount)
 	return true;
 }
 
+void xf_peer_send_frame(freerdp_peer* client)
+{
+	HGDI_RGN invalid_region;
+	xfPeerContext* xfp = (xfPeerContext*) client->context;
+
+	/**
+	 * The client is not keeping up, let the damage accumulate until the socket
+	 * drained or a frame was acknowledged, it then goes out as one fresh frame.
+	 */
+	if (client->IsWriteBlocked(client) || client->CanSendFrame(client) != true)
+		return;
+
+	invalid_region = xfp->hdc->hwnd->invalid;
+
+	if (invalid_region->null == false)
+	{
+		xf_peer_rfx_update(client, invalid_region->x, invalid_region->y,
+			invalid_region->w, invalid_region->h);
+	}
+
+	invalid_region->null = 1;
+	xfp->hdc->hwnd->ninvalid = 0;
+}
+
+static void xf_peer_frame_acknowledge(freerdp_peer* client, uint32 frame_id)
+{
+	xfPeerContext* xfp = (xfPeerContext*) client->context;
+
+	/* damage merged while the window was full does not have to wait for the next tick */
+	if (xfp->activated && client->update->dump_rfx != true)
+		xf_peer_send_frame(client);
+}
+
 boolean xf_peer_check_fds(freerdp_peer* client)
 {
 	xfInfo* xfi;
 	xfEvent* event;
 	xfPeerContext* xfp;
-	HGDI_RGN invalid_region;
 
 	xfp = (xfPeerContext*) client->context;
 	xfi = xfp->info;
@@ -503,17 +653,7 @@ boolean xf_peer_check_fds(freerdp_peer* client)
 		else if (event->type == XF_EVENT_TYPE_FRAME_TICK)
 		{
 			event = xf_event_pop(xfp->event_queue);
-			invalid_region = xfp->hdc->hwnd->invalid;
-
-			if (invalid_region->null == false)
-			{
-				xf_peer_rfx_update(client, invalid_region->x, invalid_region->y,
-					invalid_region->w, invalid_region->h);
-			}
-
-			invalid_region->null = 1;
-			xfp->hdc->hwnd->ninvalid = 0;
-
+			xf_peer_send_frame(client);
 			xf_event_free(event);
 		}
 	}
@@ -593,25 +733,14 @@ boolean xf_peer_activate(freerdp_peer* client)
 	return true;
 }
 
-void* xf_peer_main_loop(void* arg)
+static void xf_peer_setup(freerdp_peer* client)
 {
-	int i;
-	int fds;
-	int max_fds;
-	int rcount;
-	void* rfds[32];
-	fd_set rfds_set;
 	rdpSettings* settings;
 	char* server_file_path;
-	freerdp_peer* client = (freerdp_peer*) arg;
-	xfPeerContext* xfp;
-
-	memset(rfds, 0, sizeof(rfds));
 
 	printf("We've got a client %s\n", client->hostname);
 
 	xf_peer_init(client);
-	xfp = (xfPeerContext*) client->context;
 
 	settings = client->settings;
 
@@ -641,10 +770,29 @@ void* xf_peer_main_loop(void* arg)
 	client->Capabilities = xf_peer_capabilities;
 	client->PostConnect = xf_peer_post_connect;
 	client->Activate = xf_peer_activate;
+	client->FrameAcknowledge = xf_peer_frame_acknowledge;
 
 	xf_input_register_callbacks(client->input);
 
 	client->Initialize(client);
+}
+
+void* xf_peer_main_loop(void* arg)
+{
+	int i;
+	int fds;
+	int max_fds;
+	int rcount;
+	void* rfds[32];
+	fd_set rfds_set;
+	fd_set wfds_set;
+	freerdp_peer* client = (freerdp_peer*) arg;
+	xfPeerContext* xfp;
+
+	memset(rfds, 0, sizeof(rfds));
+
+	xf_peer_setup(client);
+	xfp = (xfPeerContext*) client->context;
 
 	while (1)
 	{
@@ -677,7 +825,18 @@ void* xf_peer_main_loop(void* arg)
 		if (max_fds == 0)
 			break;
 
-		if (select(max_fds + 1, &rfds_set, NULL, NULL, NULL) == -1)
+		/* wait for the socket to drain queued output instead of blocking in a write */
+		FD_ZERO(&wfds_set);
+
+		if (client->IsWriteBlocked(client))
+		{
+			FD_SET(client->sockfd, &wfds_set);
+
+			if (client->sockfd > max_fds)
+				max_fds = client->sockfd;
+		}
+
+		if (select(max_fds + 1, &rfds_set, &wfds_set, NULL, NULL) == -1)
 		{
 			/* these are not really errors */
 			if (!((errno == EAGAIN) ||
@@ -718,9 +877,60 @@ void* xf_peer_main_loop(void* arg)
 	return NULL;
 }
 
+static void xf_peer_disconnected(freerdp_peer* client)
+{
+	xfEvent* event;
+	xfPeerContext* xfp = (xfPeerContext*) client->context;
+
+	printf("Client %s disconnected.\n", client->hostname);
+
+	freerdp_event_source_remove(xfp->xevent_source);
+	freerdp_event_source_remove(xfp->frame_source);
+	freerdp_event_source_remove(xfp->queue_source);
+
+	if (xfp->queue_source != NULL)
+	{
+		/* give back the frames that were handed out before we left */
+		xf_capture_unsubscribe(xf_shared_capture, client);
+
+		while (xf_event_peek(xfp->event_queue) != NULL)
+		{
+			event = xf_event_pop(xfp->event_queue);
+
+			if (event->type == XF_EVENT_TYPE_FRAME)
+				xf_capture_frame_release(((xfEventFrame*) event)->frame);
+
+			xf_event_free(event);
+		}
+	}
+
+	client->Disconnect(client);
+
+	freerdp_peer_context_free(client);
+	freerdp_peer_free(client);
+}
+
 void xf_peer_accepted(freerdp_listener* instance, freerdp_peer* client)
 {
 	pthread_t th;
+	freerdp_reactor* reactor = (freerdp_reactor*) instance->param1;
+
+	if (reactor != NULL)
+	{
+		/* no thread of its own, the peer is served by one of the reactor loops */
+		xf_peer_setup(client);
+		client->Disconnected = xf_peer_disconnected;
+
+		if (client->AttachEventLoop(client, freerdp_reactor_get_loop(reactor)) != true)
+		{
+			printf("Failed to attach client %s to an event loop\n", client->hostname);
+			client->Disconnect(client);
+			freerdp_peer_context_free(client);
+			freerdp_peer_free(client);
+		}
+
+		return;
+	}
 
 	pthread_create(&th, 0, xf_peer_main_loop, client);
 	pthread_detach(th);
@@ -47,8 +47,14 @@ struct xf_peer_context
 	RFX_COMPOSE_CONTEXT* rfx_context;
 	xfEventQueue* event_queue;
 	pthread_t frame_rate_thread;
+	freerdp_event_source* xevent_source;
+	freerdp_event_source* frame_source;
+	freerdp_event_source* queue_source;
 };
 
+xfInfo* xf_info_init(boolean monitor);
+
+void xf_peer_send_frame(freerdp_peer* client);
 void xf_peer_accepted(freerdp_listener* instance, freerdp_peer* client);
 
 #endif /* __XF_PEER_H */
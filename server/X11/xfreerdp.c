@@ -27,12 +27,15 @@
 #include <sys/signal.h>
 
 #include <freerdp/utils/memory.h>
+#include <freerdp/utils/reactor.h>
 
 #include "xf_peer.h"
+#include "xf_capture.h"
 #include "xfreerdp.h"
 
 char* xf_pcap_file = NULL;
 boolean xf_pcap_dump_realtime = true;
+xfCapture* xf_shared_capture = NULL;
 
 void xf_server_main_loop(freerdp_listener* instance)
 {
@@ -96,6 +99,7 @@ void xf_server_main_loop(freerdp_listener* instance)
 
 int main(int argc, char* argv[])
 {
+	freerdp_reactor* reactor;
 	freerdp_listener* instance;
 
 	/* ignore SIGPIPE, otherwise an SSL_write failure could crash the server */
@@ -113,8 +117,46 @@ int main(int argc, char* argv[])
 	/* Open the server socket and start listening. */
 	if (instance->Open(instance, NULL, 3389))
 	{
-		/* Entering the server main loop. In a real server the listener can be run in its own thread. */
-		xf_server_main_loop(instance);
+		/* Serve all peers from a pool of event loops, one per processor. */
+		reactor = freerdp_reactor_new(0);
+
+		if (reactor && freerdp_reactor_start(reactor))
+		{
+			/* Everything peers look at is set up before the first one can be accepted. */
+			instance->param1 = (void*) reactor;
+
+			/* Capture and encode the display once for all peers. */
+			if (xf_pcap_file == NULL)
+				xf_shared_capture = xf_capture_new(freerdp_reactor_get_loop(reactor), 24);
+
+			if (instance->AttachEventLoop(instance, freerdp_reactor_get_loop(reactor)) != true)
+			{
+				freerdp_reactor_stop(reactor);
+				freerdp_reactor_wait(reactor);
+
+				xf_capture_free(xf_shared_capture);
+				xf_shared_capture = NULL;
+				instance->param1 = NULL;
+			}
+		}
+
+		if (instance->param1 != NULL)
+		{
+			freerdp_reactor_wait(reactor);
+			instance->Close(instance);
+
+			xf_capture_free(xf_shared_capture);
+			xf_shared_capture = NULL;
+		}
+		else
+		{
+			/* Entering the server main loop. In a real server the listener can be run in its own thread. */
+			freerdp_reactor_free(reactor);
+			reactor = NULL;
+			xf_server_main_loop(instance);
+		}
+
+		freerdp_reactor_free(reactor);
 	}
 
 	freerdp_listener_free(instance);
@@ -0,0 +1,583 @@
+/**
+ * FreeRDP: A Remote Desktop Protocol Client
+ * FreeRDP Loopback Benchmark
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * Replays a recorded RemoteFX pcap from a server process over loopback into
+ * a headless client decoding with the software GDI, and reports throughput,
+ * decode time, end-to-end latency and peak memory. The server stamps every
+ * surface command before sending it into a shared mapping, the client takes
+ * the latency once the command is decoded.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <sys/select.h>
+#include <sys/resource.h>
+#include <freerdp/freerdp.h>
+#include <freerdp/listener.h>
+#include <freerdp/constants.h>
+#include <freerdp/gdi/gdi.h>
+#include <freerdp/utils/pcap.h>
+#include <freerdp/utils/sleep.h>
+#include <freerdp/utils/memory.h>
+#include <freerdp/utils/stream.h>
+
+struct bench_shared
+{
+	uint32 sent;
+	uint64 sent_time[1];
+};
+typedef struct bench_shared benchShared;
+
+static char* bench_pcap_file = NULL;
+static char* bench_cert_file = "server.crt";
+static char* bench_key_file = "server.key";
+static int bench_port = 3390;
+static int bench_iterations = 10;
+static int bench_width = 1024;
+static int bench_height = 768;
+static boolean bench_realtime = false;
+
+static int bench_num_records = 0;
+static STREAM** bench_records = NULL;
+static uint64* bench_record_times = NULL;
+static benchShared* bench_shared = NULL;
+
+static boolean bench_server_done = false;
+
+static uint32 bench_received = 0;
+static uint32 bench_frames = 0;
+static uint64 bench_bytes = 0;
+static uint64 bench_decode_time = 0;
+static uint64 bench_first_time = 0;
+static uint64 bench_last_time = 0;
+static uint32* bench_latency = NULL;
+static pSurfaceBits bench_gdi_surface_bits = NULL;
+
+static uint64 bench_get_time(void)
+{
+	struct timeval tp;
+
+	gettimeofday(&tp, 0);
+
+	return ((uint64) tp.tv_sec) * 1000000 + tp.tv_usec;
+}
+
+static int bench_total_records(void)
+{
+	return bench_num_records * bench_iterations;
+}
+
+/**
+ * The whole capture is loaded before forking, so that the replay is not
+ * slowed down by file reads and the client knows what is coming.
+ */
+static boolean bench_load_pcap(char* name)
+{
+	STREAM* s;
+	rdpPcap* pcap;
+	pcap_record record;
+	int max_records = 0;
+
+	pcap = pcap_open(name, false);
+
+	if (pcap == NULL)
+		return false;
+
+	while (pcap_has_next_record(pcap))
+	{
+		pcap_get_next_record_header(pcap, &record);
+
+		s = stream_new(record.length);
+		record.data = stream_get_head(s);
+		pcap_get_next_record_content(pcap, &record);
+		stream_seek(s, record.length);
+
+		if (bench_num_records >= max_records)
+		{
+			max_records = (max_records > 0) ? max_records * 2 : 256;
+			bench_records = (STREAM**) xrealloc(bench_records, sizeof(STREAM*) * max_records);
+			bench_record_times = (uint64*) xrealloc(bench_record_times, sizeof(uint64) * max_records);
+		}
+
+		bench_record_times[bench_num_records] = ((uint64) record.header.ts_sec) * 1000000 + record.header.ts_usec;
+		bench_records[bench_num_records++] = s;
+	}
+
+	pcap_close(pcap);
+
+	return (bench_num_records > 0) ? true : false;
+}
+
+static boolean bench_peer_activate(freerdp_peer* client)
+{
+	int i, j;
+	uint32 index;
+	uint64 start;
+	uint64 offset;
+	rdpUpdate* update = client->update;
+
+	for (i = 0; i < bench_iterations; i++)
+	{
+		start = bench_get_time();
+
+		for (j = 0; j < bench_num_records; j++)
+		{
+			if (bench_realtime)
+			{
+				/* keep the recorded pace relative to the first record of the pass */
+				offset = bench_record_times[j] - bench_record_times[0];
+
+				while (bench_get_time() < start + offset)
+					freerdp_usleep((start + offset) - bench_get_time());
+			}
+
+			index = i * bench_num_records + j;
+			bench_shared->sent_time[index] = bench_get_time();
+			bench_shared->sent = index + 1;
+
+			update->SurfaceCommand(update->context, bench_records[j]);
+		}
+	}
+
+	return true;
+}
+
+static void bench_peer_main_loop(freerdp_peer* client)
+{
+	int i;
+	int fds;
+	int max_fds;
+	int rcount;
+	void* rfds[32];
+	fd_set rfds_set;
+	fd_set wfds_set;
+
+	memset(rfds, 0, sizeof(rfds));
+
+	freerdp_peer_context_new(client);
+
+	client->settings->cert_file = xstrdup(bench_cert_file);
+	client->settings->privatekey_file = xstrdup(bench_key_file);
+	client->settings->nla_security = false;
+	client->settings->rfx_codec = true;
+
+	client->Activate = bench_peer_activate;
+
+	client->Initialize(client);
+
+	while (1)
+	{
+		rcount = 0;
+
+		if (client->GetFileDescriptor(client, rfds, &rcount) != true)
+			break;
+
+		max_fds = 0;
+		FD_ZERO(&rfds_set);
+
+		for (i = 0; i < rcount; i++)
+		{
+			fds = (int)(long)(rfds[i]);
+
+			if (fds > max_fds)
+				max_fds = fds;
+
+			FD_SET(fds, &rfds_set);
+		}
+
+		if (max_fds == 0)
+			break;
+
+		/* the replay outruns the socket, keep draining what was queued */
+		FD_ZERO(&wfds_set);
+
+		if (client->IsWriteBlocked(client))
+		{
+			FD_SET(client->sockfd, &wfds_set);
+
+			if (client->sockfd > max_fds)
+				max_fds = client->sockfd;
+		}
+
+		if (select(max_fds + 1, &rfds_set, &wfds_set, NULL, NULL) == -1)
+		{
+			/* these are not really errors */
+			if (!((errno == EAGAIN) ||
+				(errno == EWOULDBLOCK) ||
+				(errno == EINPROGRESS) ||
+				(errno == EINTR))) /* signal occurred */
+			{
+				printf("select failed\n");
+				break;
+			}
+		}
+
+		if (client->CheckFileDescriptor(client) != true)
+			break;
+	}
+
+	client->Disconnect(client);
+	freerdp_peer_context_free(client);
+	freerdp_peer_free(client);
+}
+
+static void bench_peer_accepted(freerdp_listener* instance, freerdp_peer* client)
+{
+	/* a single client per run, served from the listener loop */
+	bench_peer_main_loop(client);
+	bench_server_done = true;
+}
+
+static void bench_server_main_loop(freerdp_listener* instance)
+{
+	int i;
+	int fds;
+	int max_fds;
+	int rcount;
+	void* rfds[32];
+	fd_set rfds_set;
+
+	memset(rfds, 0, sizeof(rfds));
+
+	while (bench_server_done != true)
+	{
+		rcount = 0;
+
+		if (instance->GetFileDescriptor(instance, rfds, &rcount) != true)
+			break;
+
+		max_fds = 0;
+		FD_ZERO(&rfds_set);
+
+		for (i = 0; i < rcount; i++)
+		{
+			fds = (int)(long)(rfds[i]);
+
+			if (fds > max_fds)
+				max_fds = fds;
+
+			FD_SET(fds, &rfds_set);
+		}
+
+		if (max_fds == 0)
+			break;
+
+		if (select(max_fds + 1, &rfds_set, NULL, NULL, NULL) == -1)
+		{
+			if (errno != EINTR)
+				break;
+		}
+
+		if (instance->CheckFileDescriptor(instance) != true)
+			break;
+	}
+
+	instance->Close(instance);
+}
+
+static void bench_record_received(void)
+{
+	uint64 now;
+	uint32 index;
+
+	now = bench_get_time();
+	index = bench_received++;
+
+	if (index == 0)
+		bench_first_time = now;
+
+	bench_last_time = now;
+	bench_bytes += stream_get_length(bench_records[index % bench_num_records]);
+
+	if (index < (uint32) bench_total_records())
+		bench_latency[index] = (uint32) (now - bench_shared->sent_time[index]);
+}
+
+static void bench_surface_bits(rdpContext* context, SURFACE_BITS_COMMAND* surface_bits_command)
+{
+	uint64 start;
+
+	start = bench_get_time();
+	bench_gdi_surface_bits(context, surface_bits_command);
+	bench_decode_time += bench_get_time() - start;
+	bench_frames++;
+
+	bench_record_received();
+}
+
+static void bench_surface_frame_marker(rdpContext* context, SURFACE_FRAME_MARKER* surface_frame_marker)
+{
+	bench_record_received();
+}
+
+static boolean bench_pre_connect(freerdp* instance)
+{
+	return true;
+}
+
+static boolean bench_post_connect(freerdp* instance)
+{
+	gdi_init(instance, CLRCONV_ALPHA | CLRCONV_INVERT | CLRBUF_32BPP, NULL);
+
+	bench_gdi_surface_bits = instance->update->SurfaceBits;
+	instance->update->SurfaceBits = bench_surface_bits;
+	instance->update->SurfaceFrameMarker = bench_surface_frame_marker;
+
+	return true;
+}
+
+static boolean bench_client_run(freerdp* instance)
+{
+	int i;
+	int fds;
+	int max_fds;
+	int rcount;
+	int wcount;
+	void* rfds[32];
+	void* wfds[32];
+	fd_set rfds_set;
+	fd_set wfds_set;
+
+	memset(rfds, 0, sizeof(rfds));
+	memset(wfds, 0, sizeof(wfds));
+
+	if (freerdp_connect(instance) != true)
+	{
+		printf("bench: failed to connect\n");
+		return false;
+	}
+
+	while (bench_received < (uint32) bench_total_records())
+	{
+		rcount = 0;
+		wcount = 0;
+
+		if (freerdp_get_fds(instance, rfds, &rcount, wfds, &wcount) != true)
+			break;
+
+		max_fds = 0;
+		FD_ZERO(&rfds_set);
+		FD_ZERO(&wfds_set);
+
+		for (i = 0; i < rcount; i++)
+		{
+			fds = (int)(long)(rfds[i]);
+
+			if (fds > max_fds)
+				max_fds = fds;
+
+			FD_SET(fds, &rfds_set);
+		}
+
+		for (i = 0; i < wcount; i++)
+		{
+			fds = (int)(long)(wfds[i]);
+
+			if (fds > max_fds)
+				max_fds = fds;
+
+			FD_SET(fds, &wfds_set);
+		}
+
+		if (max_fds == 0)
+			break;
+
+		if (select(max_fds + 1, &rfds_set, &wfds_set, NULL, NULL) == -1)
+		{
+			if (errno != EINTR)
+				break;
+		}
+
+		if (freerdp_check_fds(instance) != true)
+			break;
+	}
+
+	freerdp_disconnect(instance);
+
+	return (bench_received == (uint32) bench_total_records()) ? true : false;
+}
+
+static int bench_compare_uint32(const void* a, const void* b)
+{
+	uint32 x = *((uint32*) a);
+	uint32 y = *((uint32*) b);
+
+	return (x > y) - (x < y);
+}
+
+static void bench_report(struct rusage* server_usage)
+{
+	double elapsed;
+	struct rusage usage;
+
+	elapsed = (bench_last_time - bench_first_time) / 1000000.0;
+
+	if (elapsed <= 0)
+		elapsed = 0.000001;
+
+	qsort(bench_latency, bench_received, sizeof(uint32), bench_compare_uint32);
+	getrusage(RUSAGE_SELF, &usage);
+
+	printf("records:    %u (%d x %d), %.3f s\n", bench_received, bench_iterations, bench_num_records, elapsed);
+	printf("throughput: %.1f PDUs/s, %.2f MB/s\n", bench_received / elapsed, bench_bytes / elapsed / 1000000.0);
+	printf("decode:     %.3f ms/frame (%u frames)\n",
+		bench_frames ? (bench_decode_time / 1000.0) / bench_frames : 0.0, bench_frames);
+	printf("latency:    p50 %.3f ms, p99 %.3f ms\n",
+		bench_latency[bench_received / 2] / 1000.0, bench_latency[(bench_received * 99) / 100] / 1000.0);
+	printf("peak rss:   client %ld KB, server %ld KB\n", usage.ru_maxrss, server_usage->ru_maxrss);
+}
+
+static void bench_usage(char* name)
+{
+	printf("usage: %s [-n iterations] [-p port] [-w width] [-h height] [--realtime]\n"
+		"          [--cert file] [--key file] capture.pcap\n"
+		"Without --realtime the capture is replayed as fast as the client takes it,\n"
+		"the latency then includes the time spent queued.\n", name);
+}
+
+int main(int argc, char* argv[])
+{
+	int i;
+	pid_t pid;
+	int status;
+	size_t shared_size;
+	freerdp* instance;
+	freerdp_listener* listener;
+	struct rusage server_usage;
+
+	for (i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+			bench_iterations = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-p") == 0 && i + 1 < argc)
+			bench_port = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-w") == 0 && i + 1 < argc)
+			bench_width = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-h") == 0 && i + 1 < argc)
+			bench_height = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--cert") == 0 && i + 1 < argc)
+			bench_cert_file = argv[++i];
+		else if (strcmp(argv[i], "--key") == 0 && i + 1 < argc)
+			bench_key_file = argv[++i];
+		else if (strcmp(argv[i], "--realtime") == 0)
+			bench_realtime = true;
+		else if (argv[i][0] != '-')
+			bench_pcap_file = argv[i];
+		else
+		{
+			bench_usage(argv[0]);
+			return 1;
+		}
+	}
+
+	if (bench_pcap_file == NULL || bench_iterations < 1)
+	{
+		bench_usage(argv[0]);
+		return 1;
+	}
+
+	if (bench_load_pcap(bench_pcap_file) != true)
+	{
+		printf("bench: failed to load %s\n", bench_pcap_file);
+		return 1;
+	}
+
+	shared_size = sizeof(benchShared) + sizeof(uint64) * bench_total_records();
+	bench_shared = (benchShared*) mmap(NULL, shared_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+
+	if (bench_shared == MAP_FAILED)
+	{
+		perror("mmap");
+		return 1;
+	}
+
+	bench_latency = (uint32*) xzalloc(sizeof(uint32) * bench_total_records());
+
+	signal(SIGPIPE, SIG_IGN);
+
+	/* listen before forking so that the client never races the server */
+	listener = freerdp_listener_new();
+	listener->PeerAccepted = bench_peer_accepted;
+
+	if (listener->Open(listener, "127.0.0.1", bench_port) != true)
+	{
+		printf("bench: failed to listen on port %d\n", bench_port);
+		return 1;
+	}
+
+	pid = fork();
+
+	if (pid < 0)
+	{
+		perror("fork");
+		return 1;
+	}
+
+	if (pid == 0)
+	{
+		bench_server_main_loop(listener);
+		freerdp_listener_free(listener);
+		_exit(0);
+	}
+
+	listener->Close(listener);
+	freerdp_listener_free(listener);
+
+	instance = freerdp_new();
+	instance->PreConnect = bench_pre_connect;
+	instance->PostConnect = bench_post_connect;
+	freerdp_context_new(instance);
+
+	instance->settings->hostname = xstrdup("127.0.0.1");
+	instance->settings->port = bench_port;
+	instance->settings->width = bench_width;
+	instance->settings->height = bench_height;
+	instance->settings->color_depth = 32;
+	instance->settings->rfx_codec = true;
+	instance->settings->fastpath_output = true;
+	instance->settings->ignore_certificate = true;
+	instance->settings->nla_security = false;
+	instance->settings->tls_security = true;
+	instance->settings->rdp_security = false;
+
+	if (bench_client_run(instance) != true)
+		printf("bench: received %u of %d records\n", bench_received, bench_total_records());
+
+	memset(&server_usage, 0, sizeof(server_usage));
+
+	if (wait4(pid, &status, 0, &server_usage) < 0)
+		perror("wait4");
+
+	if (bench_received > 0)
+		bench_report(&server_usage);
+
+	freerdp_context_free(instance);
+	freerdp_free(instance);
+
+	munmap(bench_shared, shared_size);
+	xfree(bench_latency);
+
+	return (bench_received == (uint32) bench_total_records()) ? 0 : 1;
+}